@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# 编译并运行 C 核心的基准测试，结果以 JSON 格式保存，便于比较不同版本
+# 用法: ./bench.sh [输出文件] [benchmark 的其他参数...]
+# 例如: ./bench.sh bench_output.json --min-time 500 --filter query_
+# 只测量计算的开销: ./bench.sh bench_memory.json --db :memory:
+# 并发压力测试: ./bench.sh --stress [stress_test 的其他参数...]，例如 ./bench.sh --stress --threads 32 --iterations 2000
+# 并发交卷测试: ./bench.sh --stress --writers 200（单进程 200 个写线程）
+#               ./bench.sh --stress --writers 200 --processes 4（分到 4 个进程，只支持 POSIX 系统）
+
+set -e
+
+# 使用仓库中的 SQLite 源码，没有时链接系统的 libsqlite3
+SQLITE_SOURCE="lib/sqlite3.c"
+SQLITE_LIBS=""
+if [ ! -f "$SQLITE_SOURCE" ]; then
+    SQLITE_SOURCE=""
+    SQLITE_LIBS="-lsqlite3"
+fi
+
+EXTRA_LIBS="-lpthread -lm"
+case "$(uname -s)" in
+    MINGW*|MSYS*|CYGWIN*)
+        EXTRA_LIBS="-lbcrypt"
+        ;;
+esac
+
+CORE_SOURCES="include/utils.c include/database.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c"
+
+# 压力测试用 ThreadSanitizer 编译（MinGW 不支持，需要在 Linux 或 macOS 上运行），
+# 多个线程同时执行查询、交卷和缓存失效，发现数据竞争、导出函数出错或者交卷丢失时以非0退出码结束
+if [ "$1" = "--stress" ]; then
+    shift
+    gcc -O1 -g -fsanitize=thread -DINITIALIZER_NO_MAIN \
+        utils/stress_test.c utils/initializer.c $SQLITE_SOURCE $CORE_SOURCES \
+        $SQLITE_LIBS $EXTRA_LIBS -o stress_test
+    rm -rf stress_data
+    ./stress_test --dir stress_data "$@"
+    exit 0
+fi
+
+OUTPUT=${1:-bench_output.json}
+shift || true
+
+# 通过链接器的 --wrap 统计内存分配次数，见 utils/benchmark.c。
+# --wrap 只对静态链接的目标文件生效，链接系统的 libsqlite3 时 SQLite 内部的分配不会被统计
+gcc -O2 -g -DINITIALIZER_NO_MAIN -DBENCH_COUNT_ALLOCATIONS \
+    -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free \
+    utils/benchmark.c utils/initializer.c $SQLITE_SOURCE $CORE_SOURCES \
+    $SQLITE_LIBS $EXTRA_LIBS -o benchmark
+
+# 每次都在新的工作目录中生成合成数据
+rm -rf bench_data
+./benchmark --output "$OUTPUT" --dir bench_data "$@"
+echo "结果已保存到 $OUTPUT"
@@ -144,22 +144,33 @@ Write-Log -Level "INFO" -Message "开始编译 dll 文件..."
 # 编译 initializer.dll
 Execute-Step -StepName "编译 initializer.dll" -StepScript {
     gcc -fdiagnostics-color=always -g -shared utils/initializer.c lib/sqlite3.c `
-    include/utils.c include/database.c include/app.c include/model.c `
-    -o initializer.dll
+    include/utils.c include/database.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c `
+    -lbcrypt -o initializer.dll
 }
 
 # 编译 database.dll
 Execute-Step -StepName "编译 database.dll" -StepScript {
     gcc -fdiagnostics-color=always -g -shared include/database.c lib/sqlite3.c `
-    include/utils.c include/app.c include/model.c `
-    -o database.dll
+    include/utils.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c `
+    -lbcrypt -o database.dll
 }
 
 # 编译 app.dll
 Execute-Step -StepName "编译 app.dll" -StepScript {
     gcc -fdiagnostics-color=always -g -shared include/app.c lib/sqlite3.c `
-    include/utils.c include/database.c include/model.c `
-    -o app.dll
+    include/utils.c include/database.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c `
+    -lbcrypt -o app.dll
+}
+
+# 编译 mentalcore 核心模块（CPython 扩展），整个进程只加载这一份 SQLite 和缓存，找不到时程序回退到上面三个 dll
+$pyInclude = python -c "import sysconfig; print(sysconfig.get_paths()['include'])"
+$pyLibs = python -c "import os, sys; print(os.path.join(sys.base_prefix, 'libs'))"
+$pyVersion = python -c "import sys; print(f'{sys.version_info[0]}{sys.version_info[1]}')"
+$coreModule = "mentalcore" + (python -c "import sysconfig; print(sysconfig.get_config_var('EXT_SUFFIX'))")
+Execute-Step -StepName "编译 $coreModule" -StepScript {
+    gcc -fdiagnostics-color=always -g -shared include/pymodule.c lib/sqlite3.c utils/initializer.c `
+    include/utils.c include/database.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c `
+    -I"$pyInclude" -L"$pyLibs" -lpython$pyVersion "-Wl,--export-all-symbols" -lbcrypt -o $coreModule
 }
 
 # 编译 Python 程序
@@ -169,6 +180,7 @@ Execute-Step -StepName "编译 Flask 服务器组件" -StepScript {
     --include-data-file=database.dll=database.dll `
     --include-data-file=app.dll=app.dll `
     --include-data-file=initializer.dll=initializer.dll `
+    --include-data-file="$coreModule=$coreModule" `
     --output-dir=build --remove-output --show-progress `
     --windows-icon-from-ico=ui/static/img/favicon.ico `
     --windows-company-name=GamerNoTitle `
@@ -127,25 +127,54 @@ execute_step "安装依赖" "
 # 编译 C 文件
 write_log "INFO" "开始编译 dll 文件..."
 
+# Windows 下 UUID 生成需要链接 bcrypt 以使用系统随机数发生器
+EXTRA_LIBS=""
+case "$(uname -s)" in
+    MINGW*|MSYS*|CYGWIN*)
+        EXTRA_LIBS="-lbcrypt"
+        ;;
+esac
+
 # 编译 initializer.dll
 execute_step "编译 initializer.dll" "
     gcc -fdiagnostics-color=always -g -shared utils/initializer.c lib/sqlite3.c \
-    include/utils.c include/database.c include/app.c include/model.c \
-    -o initializer.dll
+    include/utils.c include/database.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c \
+    $EXTRA_LIBS -o initializer.dll
 "
 
 # 编译 database.dll
 execute_step "编译 database.dll" "
     gcc -fdiagnostics-color=always -g -shared include/database.c lib/sqlite3.c \
-    include/utils.c include/app.c include/model.c \
-    -o database.dll
+    include/utils.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c \
+    $EXTRA_LIBS -o database.dll
 "
 
 # 编译 app.dll
 execute_step "编译 app.dll" "
     gcc -fdiagnostics-color=always -g -shared include/app.c lib/sqlite3.c \
-    include/utils.c include/database.c include/model.c \
-    -o app.dll
+    include/utils.c include/database.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c \
+    $EXTRA_LIBS -o app.dll
+"
+
+# 编译 mentalcore 核心模块（CPython 扩展），整个进程只加载这一份 SQLite 和缓存，找不到时程序回退到上面三个 dll
+PY_INCLUDE=$(python -c "import sysconfig; print(sysconfig.get_paths()['include'])")
+CORE_MODULE="mentalcore$(python -c "import sysconfig; print(sysconfig.get_config_var('EXT_SUFFIX'))")"
+case "$(uname -s)" in
+    MINGW*|MSYS*|CYGWIN*)
+        # Windows 下需要链接 python3x.dll，并导出所有函数供 ctypes 调用
+        PY_LIBS=$(python -c "import os, sys; print(os.path.join(sys.base_prefix, 'libs'))")
+        PY_VERSION=$(python -c "import sys; print(f'{sys.version_info[0]}{sys.version_info[1]}')")
+        CORE_LIBS="-L\"$PY_LIBS\" -lpython$PY_VERSION -Wl,--export-all-symbols"
+        ;;
+    *)
+        CORE_LIBS="-fPIC"
+        ;;
+esac
+
+execute_step "编译 $CORE_MODULE" "
+    gcc -fdiagnostics-color=always -g -shared include/pymodule.c lib/sqlite3.c utils/initializer.c \
+    include/utils.c include/database.c include/app.c include/model.c include/uuid.c include/user_cache.c include/revocation.c include/exam_cache.c include/metrics.c include/answer_log.c include/item_analysis.c \
+    -I\"$PY_INCLUDE\" $CORE_LIBS $EXTRA_LIBS -o $CORE_MODULE
 "
 
 # 编译 Python 程序
@@ -155,6 +184,7 @@ execute_step "编译 Flask 服务器组件" "
     --include-data-file=database.dll=database.dll \
     --include-data-file=app.dll=app.dll \
     --include-data-file=initializer.dll=initializer.dll \
+    --include-data-file=$CORE_MODULE=$CORE_MODULE \
     --output-dir=build \
     --lto=yes --assume-yes-for-downloads ui/app.py
 "
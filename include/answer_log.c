@@ -0,0 +1,230 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: answer_log.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了答题记录的编码和解码，记录格式见 answer_log.h 中的 AnswerLogHeader
+Others:         本文件只处理内存中的记录，不访问数据库，没有全局状态，可以在多个线程中同时调用
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了答题记录的编码和解码
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "answer_log.h"
+
+#define ANSWER_LOG_MAX_ABS_ANSWER 1e15 // 答案绝对值的上限，超出的答案按上限保存（必然是错的），避免乘以100后溢出
+
+/**
+ * @brief 写入一个无符号 LEB128 变长整数
+ *
+ * @return int 写入的字节数，缓冲区不够时返回0
+ */
+static int write_varint(uint64_t value, unsigned char *buffer, int capacity)
+{
+    int length = 0;
+    do
+    {
+        if (length >= capacity)
+        {
+            return 0;
+        }
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        buffer[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    return length;
+}
+
+/**
+ * @brief 读取一个无符号 LEB128 变长整数
+ *
+ * @return int 读取的字节数，记录在变长整数中间结束或者超过 64 位时返回0
+ */
+static int read_varint(const unsigned char *buffer, int length, uint64_t *value_to_return)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < length && i < ANSWER_LOG_VARINT_MAX; i++)
+    {
+        value |= (uint64_t)(buffer[i] & 0x7F) << (7 * i);
+        if (!(buffer[i] & 0x80))
+        {
+            *value_to_return = value;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 把答案编码为一个无符号整数，0 表示没有作答
+ */
+static uint64_t encode_answer(float answer)
+{
+    if (!isfinite(answer))
+    {
+        return 0;
+    }
+    double value = answer;
+    if (fabs(value) > ANSWER_LOG_MAX_ABS_ANSWER)
+    {
+        value = value > 0 ? ANSWER_LOG_MAX_ABS_ANSWER : -ANSWER_LOG_MAX_ABS_ANSWER;
+    }
+    int64_t hundredths = llround(value * 100.0);
+    int fractional = hundredths % 100 != 0;
+    int64_t v = fractional ? hundredths : hundredths / 100;
+    uint64_t zigzag = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+    return ((zigzag << 1) | (uint64_t)fractional) + 1;
+}
+
+/**
+ * @brief 把 encode_answer 的结果还原为答案，没有作答时返回 NaN
+ */
+static float decode_answer(uint64_t code)
+{
+    if (code == 0)
+    {
+        return NAN;
+    }
+    code -= 1;
+    int fractional = code & 1;
+    uint64_t zigzag = code >> 1;
+    int64_t v = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+    return fractional ? (float)((double)v / 100.0) : (float)v;
+}
+
+int answer_log_encode(unsigned int seed, int question_count, const unsigned char *correct, const float *answers,
+                      unsigned char *buffer, int capacity, int *length_to_return)
+{
+    if (question_count < 0 || question_count > ANSWER_LOG_MAX_QUESTIONS || buffer == NULL || length_to_return == NULL ||
+        (question_count > 0 && (correct == NULL || answers == NULL)))
+    {
+        return 1;
+    }
+    int bitmap_bytes = (question_count + 7) / 8;
+    int length = 0;
+    int written;
+
+    if (capacity < 1)
+    {
+        return 1;
+    }
+    buffer[length++] = ANSWER_LOG_FORMAT_VERSION;
+    if ((written = write_varint((uint64_t)question_count, buffer + length, capacity - length)) == 0)
+    {
+        return 1;
+    }
+    length += written;
+    if ((written = write_varint(seed, buffer + length, capacity - length)) == 0)
+    {
+        return 1;
+    }
+    length += written;
+
+    if (capacity - length < bitmap_bytes)
+    {
+        return 1;
+    }
+    unsigned char *bitmap = buffer + length;
+    memset(bitmap, 0, (size_t)bitmap_bytes);
+    for (int i = 0; i < question_count; i++)
+    {
+        if (correct[i])
+        {
+            bitmap[i >> 3] |= (unsigned char)(1u << (i & 7));
+        }
+    }
+    length += bitmap_bytes;
+
+    for (int i = 0; i < question_count; i++)
+    {
+        if (correct[i])
+        {
+            continue;
+        }
+        if ((written = write_varint(encode_answer(answers[i]), buffer + length, capacity - length)) == 0)
+        {
+            return 1;
+        }
+        length += written;
+    }
+    *length_to_return = length;
+    return 0;
+}
+
+int answer_log_decode_header(const unsigned char *record, int length, struct AnswerLogHeader *header_to_return)
+{
+    if (record == NULL || header_to_return == NULL || length < 1 || record[0] != ANSWER_LOG_FORMAT_VERSION)
+    {
+        return 1;
+    }
+    memset(header_to_return, 0, sizeof(*header_to_return));
+    header_to_return->version = record[0];
+    int offset = 1;
+    uint64_t value;
+    int read;
+
+    if ((read = read_varint(record + offset, length - offset, &value)) == 0 || value > ANSWER_LOG_MAX_QUESTIONS)
+    {
+        return 1;
+    }
+    header_to_return->question_count = (int)value;
+    offset += read;
+    if ((read = read_varint(record + offset, length - offset, &value)) == 0 || value > UINT32_MAX)
+    {
+        return 1;
+    }
+    header_to_return->seed = (unsigned int)value;
+    offset += read;
+
+    int bitmap_bytes = (header_to_return->question_count + 7) / 8;
+    if (length - offset < bitmap_bytes)
+    {
+        return 1;
+    }
+    header_to_return->bitmap_offset = offset;
+    int correct_count = 0;
+    for (int i = 0; i < bitmap_bytes; i++)
+    {
+        correct_count += __builtin_popcount(record[offset + i]);
+    }
+    header_to_return->correct_count = correct_count;
+    return 0;
+}
+
+int answer_log_decode(const unsigned char *record, int length, struct AnswerLogHeader *header_to_return,
+                      unsigned char *correct_to_return, float *answers_to_return, int capacity)
+{
+    if (answer_log_decode_header(record, length, header_to_return) || capacity < 0 ||
+        (capacity > 0 && (correct_to_return == NULL || answers_to_return == NULL)))
+    {
+        return 1;
+    }
+    const unsigned char *bitmap = record + header_to_return->bitmap_offset;
+    int offset = header_to_return->bitmap_offset + (header_to_return->question_count + 7) / 8;
+    for (int i = 0; i < header_to_return->question_count; i++)
+    {
+        int correct = (bitmap[i >> 3] >> (i & 7)) & 1;
+        float answer = NAN;
+        if (!correct)
+        {
+            uint64_t code;
+            int read = read_varint(record + offset, length - offset, &code);
+            if (read == 0)
+            {
+                return 1;
+            }
+            offset += read;
+            answer = decode_answer(code);
+        }
+        if (i < capacity)
+        {
+            correct_to_return[i] = (unsigned char)correct;
+            answers_to_return[i] = answer;
+        }
+    }
+    return offset != length; // 记录末尾不应该有多余的字节
+}
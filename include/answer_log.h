@@ -0,0 +1,101 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: answer_log.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了答题记录的编码和解码。每次交卷保存一条紧凑的二进制记录：题目顺序的随机种子、
+                每道题是否答对的位图，以及答错（或没有作答）的题目的答案，答对的题目只占一位
+Others:         记录保存在成绩数据库的 answer_log 表中，读写数据库的函数见 database.h
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了答题记录的格式以及编码、解码函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了逐条读取答题记录的回调函数类型 answer_log_visitor
+ */
+
+#ifndef ANSWER_LOG_H
+#define ANSWER_LOG_H
+
+#include <stdint.h>
+
+/*** 记录格式部分 ***/
+#define ANSWER_LOG_FORMAT_VERSION 1  // 记录格式的版本号，保存在记录的第一个字节
+#define ANSWER_LOG_MAX_QUESTIONS 999 // 一条记录最多的题目数量，与 exam_cache.h 中的 EXAM_PAPER_MAX_QUESTIONS 一致
+#define ANSWER_LOG_VARINT_MAX 10     // 一个 64 位变长整数最多占用的字节数
+// 一条记录最多占用的字节数：版本号、题目数量、随机种子，位图，以及每道题一个答案
+#define ANSWER_LOG_MAX_RECORD_SIZE (1 + 2 * ANSWER_LOG_VARINT_MAX + (ANSWER_LOG_MAX_QUESTIONS + 7) / 8 + ANSWER_LOG_MAX_QUESTIONS * ANSWER_LOG_VARINT_MAX)
+
+/**
+ * @brief 答题记录的头部，由 answer_log_decode 返回
+ *
+ * @details 记录的格式（整数都是无符号 LEB128 变长编码）：
+ *          1. 版本号，一个字节
+ *          2. 题目数量 n
+ *          3. 题目顺序的随机种子，0 表示没有打乱，学生看到的顺序由 generate_question_permutation 得到
+ *          4. 位图，(n + 7) / 8 个字节，第 i 题（按考卷中的原始顺序）答对时第 i / 8 个字节的第 i % 8 位为1
+ *          5. 每道答错的题目按原始顺序各一个答案编码：0 表示没有作答；否则为 (zigzag(v) << 1 | f) + 1，
+ *             答案为整数时 f 为0、v 为答案本身，否则 f 为1、v 为答案乘以100后四舍五入（判题只比较两位小数）。
+ *             答对的题目不保存答案，它等于题目的正确答案
+ */
+struct AnswerLogHeader
+{
+    int version;            // 记录格式的版本号
+    int question_count;     // 题目数量
+    unsigned int seed;      // 题目顺序的随机种子
+    int correct_count;      // 答对的题目数量
+    int bitmap_offset;      // 位图在记录中的偏移，位图可以直接按字节读取，不需要解码整条记录
+};
+
+/**
+ * @brief 逐条读取答题记录时的回调函数，见 database.h 中的 scan_answer_logs
+ *
+ * @param record 记录，只在回调期间有效
+ * @param length 记录的长度
+ * @param context 调用者传入的上下文
+ * @return int 返回0继续读取，非0时停止读取
+ */
+typedef int (*answer_log_visitor)(const unsigned char *record, int length, void *context);
+
+/**
+ * @brief 编码一条答题记录
+ *
+ * @param seed 题目顺序的随机种子，0 表示没有打乱
+ * @param question_count 题目数量，不超过 ANSWER_LOG_MAX_QUESTIONS
+ * @param correct 每道题是否答对（非0为答对），按考卷中的原始顺序
+ * @param answers 每道题的答案，按考卷中的原始顺序，NaN 或无穷大表示没有作答；答对的题目的答案被忽略
+ * @param buffer 输出缓冲区，大小为 ANSWER_LOG_MAX_RECORD_SIZE 时总是足够
+ * @param capacity 输出缓冲区的大小
+ * @param length_to_return 返回记录的长度
+ * @return int 成功返回0，参数非法或者缓冲区不够时返回1
+ */
+int answer_log_encode(unsigned int seed, int question_count, const unsigned char *correct, const float *answers,
+                      unsigned char *buffer, int capacity, int *length_to_return);
+
+/**
+ * @brief 只解码答题记录的头部，并统计答对的题目数量
+ *
+ * @param record 记录
+ * @param length 记录的长度
+ * @param header_to_return 返回的头部
+ * @return int 成功返回0，记录损坏或者版本不支持时返回1
+ */
+int answer_log_decode_header(const unsigned char *record, int length, struct AnswerLogHeader *header_to_return);
+
+/**
+ * @brief 解码一条完整的答题记录
+ *
+ * @param record 记录
+ * @param length 记录的长度
+ * @param header_to_return 返回的头部
+ * @param correct_to_return 返回每道题是否答对（1或0），按原始顺序，至少要有 capacity 个元素
+ * @param answers_to_return 返回每道答错的题目的答案，按原始顺序；答对和没有作答的题目为 NaN，至少要有 capacity 个元素
+ * @param capacity 两个数组的大小，小于题目数量时只返回前 capacity 道题
+ * @return int 成功返回0，记录损坏或者版本不支持时返回1
+ */
+int answer_log_decode(const unsigned char *record, int length, struct AnswerLogHeader *header_to_return,
+                      unsigned char *correct_to_return, float *answers_to_return, int capacity);
+
+#endif
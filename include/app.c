@@ -17,15 +17,33 @@ History:        暂无
         Author: 吴沛熹
         ID: GamerNoTitle
         Modification:   [*] 完成了问题列表相关操作函数
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 generate_question_permutation 函数，由随机种子确定地生成题目顺序，
+                            下发考卷和判分时共用同一个函数，保证两边的题目顺序一致
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [-] 删除了 generate_question_list 中对全局 srand 的调用
+                        [*] randomize_question_list 改用每个线程独立的随机数发生器，不再使用全局的 rand，多线程调用时互不干扰
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] app.h 中导出的函数（free_question_list 除外）的实现改名为 xxx_impl，
+                            原函数名改为统计调用次数、失败次数和耗时的包装函数，统计数据见 metrics.h
  */
 
 #include <math.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include "../include/database.h"
+#include "../include/metrics.h"
 #include "../include/model.h"
 #include "../include/utils.h"
+#include "../include/uuid.h"
 
 /*** 日志等级 ***/
 #define LOGLEVEL_ERROR "ERROR" // 错误级别日志
@@ -41,7 +59,7 @@ History:        暂无
  * @param op   运算符标识，0123分别对应+-×÷
  * @return float 正确答案
  */
-float calculate_result(int num1, int num2, int op)
+static float calculate_result_impl(int num1, int num2, int op)
 {
     log_message(LOGLEVEL_INFO, "计算结果: num1=%d, num2=%d, op=%d", num1, num2, op);
     float result;
@@ -74,6 +92,14 @@ float calculate_result(int num1, int num2, int op)
     }
 }
 
+float calculate_result(int num1, int num2, int op)
+{
+    uint64_t start = metrics_now_ns();
+    float result = calculate_result_impl(num1, num2, op);
+    metrics_record_call(METRIC_CALCULATE_RESULT, start, 0);
+    return result;
+}
+
 /**
  * @brief 判断用户输入与计算机计算的结果是否一致
  *
@@ -81,7 +107,7 @@ float calculate_result(int num1, int num2, int op)
  * @param user_input 用户输入的结果
  * @return int  正确返回1，否则返回0
  */
-int judge(float result, float user_input)
+static int judge_impl(float result, float user_input)
 {
     log_message(LOGLEVEL_INFO, "判断结果: 计算结果=%.2f, 用户输入=%.2f", result, user_input);
     // 将结果限定在小数点后两位
@@ -100,8 +126,78 @@ int judge(float result, float user_input)
     }
 }
 
+int judge(float result, float user_input)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = judge_impl(result, user_input);
+    metrics_record_call(METRIC_JUDGE, start, 0);
+    return rc;
+}
+
 /**************************** 问题模型部分结束 ****************************/
 
+/**************************** 随机数部分开始 ****************************/
+
+static APP_THREAD_LOCAL uint64_t thread_random_state; // 每个线程独立的随机数发生器状态
+static APP_THREAD_LOCAL int thread_random_seeded;     // 当前线程的发生器是否已经播种
+
+/**
+ * @brief splitmix64 伪随机数发生器，由种子确定地生成随机数序列
+ *
+ * @param state 发生器状态，每次调用后更新
+ * @return uint64_t 下一个随机数
+ */
+static uint64_t splitmix64_next(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief 在 [0, bound) 中均匀地取一个随机数
+ *
+ * @details 通过拒绝采样得到，没有取模带来的偏差
+ *
+ * @param state 发生器状态，每次调用后更新
+ * @param bound 上界，必须大于0
+ * @return uint64_t 取到的随机数
+ */
+static uint64_t splitmix64_below(uint64_t *state, uint64_t bound)
+{
+    uint64_t limit = UINT64_MAX - UINT64_MAX % bound;
+    uint64_t r;
+    do
+    {
+        r = splitmix64_next(state);
+    } while (r >= limit);
+    return r % bound;
+}
+
+/**
+ * @brief 获取当前线程的随机数发生器状态，第一次使用时从操作系统的密码学安全随机数发生器播种
+ *
+ * @details 状态保存在线程局部变量中，线程之间互不影响，不需要加锁。
+ *          系统随机数不可用时退化为当前时间和线程局部变量地址的组合，保证不同线程的序列不同
+ *
+ * @return uint64_t* 当前线程的发生器状态
+ */
+static uint64_t *thread_random(void)
+{
+    if (!thread_random_seeded)
+    {
+        if (fill_random_bytes((unsigned char *)&thread_random_state, sizeof(thread_random_state)))
+        {
+            thread_random_state = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)&thread_random_state;
+        }
+        thread_random_seeded = 1;
+    }
+    return &thread_random_state;
+}
+
+/**************************** 随机数部分结束 ****************************/
+
 /**************************** 考试问题生成模块部分开始 ****************************/
 
 /**
@@ -112,7 +208,7 @@ int judge(float result, float user_input)
  * @param count 需要生成的问题数量
  * @return int 成功返回 0，否则返回 1
  */
-int generate_question_list(const char *exam_id, struct Question *question_list_to_return, int count)
+static int generate_question_list_impl(const char *exam_id, struct Question *question_list_to_return, int count)
 {
     void free_question_list(struct Question *head_ptr);
     log_message(LOGLEVEL_INFO, "生成问题链表: exam_id=%s, count=%d", exam_id, count);
@@ -139,10 +235,6 @@ int generate_question_list(const char *exam_id, struct Question *question_list_t
         return 1;
     }
 
-    // 初始化随机数生成器
-    srand((unsigned int)time(NULL));
-    log_message(LOGLEVEL_INFO, "随机数生成器已初始化");
-
     // 遍历查询结果，构建问题链表
     int i = 0;
     struct Question *current = question_list_to_return;
@@ -178,6 +270,14 @@ int generate_question_list(const char *exam_id, struct Question *question_list_t
     return 0;
 }
 
+int generate_question_list(const char *exam_id, struct Question *question_list_to_return, int count)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = generate_question_list_impl(exam_id, question_list_to_return, count);
+    metrics_record_call(METRIC_GENERATE_QUESTION_LIST, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 将问题链表随机顺序化
  *
@@ -185,7 +285,7 @@ int generate_question_list(const char *exam_id, struct Question *question_list_t
  * @param original_question_list 原来的问题链表
  * @return int 成功返回 0，否则返回 1
  */
-int randomize_question_list(struct Question *question_list_to_return, struct Question *original_question_list)
+static int randomize_question_list_impl(struct Question *question_list_to_return, struct Question *original_question_list)
 {
     void free_question_list(struct Question *head_ptr);
     log_message(LOGLEVEL_INFO, "开始随机化问题链表");
@@ -229,10 +329,11 @@ int randomize_question_list(struct Question *question_list_to_return, struct Que
         current = current->next_question;
     }
 
-    // 使用 Fisher-Yates 算法打乱数组
+    // 使用 Fisher-Yates 算法打乱数组，随机数来自当前线程自己的发生器
+    uint64_t *state = thread_random();
     for (int i = count - 1; i > 0; i--)
     {
-        int j = rand() % (i + 1);
+        int j = (int)splitmix64_below(state, (uint64_t)i + 1);
         // 交换 question_array[i] 和 question_array[j]
         struct Question *temp = question_array[i];
         question_array[i] = question_array[j];
@@ -272,6 +373,14 @@ int randomize_question_list(struct Question *question_list_to_return, struct Que
     return 0;
 }
 
+int randomize_question_list(struct Question *question_list_to_return, struct Question *original_question_list)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = randomize_question_list_impl(question_list_to_return, original_question_list);
+    metrics_record_call(METRIC_RANDOMIZE_QUESTION_LIST, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 释放问题链表的内存
  *
@@ -295,7 +404,7 @@ void free_question_list(struct Question *head_ptr)
  *
  * @param head 链表头指针
  */
-void print_question_list(struct Question *head)
+static void print_question_list_impl(struct Question *head)
 {
     if (head == NULL)
     {
@@ -334,4 +443,64 @@ void print_question_list(struct Question *head)
     log_message(LOGLEVEL_INFO, "问题链表打印完成");
 }
 
+void print_question_list(struct Question *head)
+{
+    uint64_t start = metrics_now_ns();
+    print_question_list_impl(head);
+    metrics_record_call(METRIC_PRINT_QUESTION_LIST, start, 0);
+}
+
 /**************************** 考试问题生成模块部分结束 ****************************/
+
+/**************************** 题目顺序生成部分开始 ****************************/
+
+/**
+ * @brief 由随机种子生成题目的排列顺序
+ *
+ * @details 使用 Fisher-Yates 算法，随机下标通过拒绝采样得到，没有取模带来的偏差。
+ *          同一个种子和题目数量总是得到同一个排列，所以判分时只需要客户端回传种子
+ *
+ * @param seed 随机种子，0 表示不打乱顺序
+ * @param count 题目数量
+ * @param permutation_to_return 返回的排列，第 i 个位置的题目是原题目列表中的第 permutation_to_return[i] 题
+ * @return int 成功返回0，否则返回1
+ */
+static int generate_question_permutation_impl(unsigned int seed, int count, int *permutation_to_return)
+{
+    if (count < 0 || (permutation_to_return == NULL && count > 0))
+    {
+        log_message(LOGLEVEL_ERROR, "参数 count 非法或 permutation_to_return 为 NULL");
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        permutation_to_return[i] = i;
+    }
+    if (seed == 0)
+    {
+        return 0;
+    }
+
+    uint64_t state = seed;
+    for (int i = count - 1; i > 0; i--)
+    {
+        // 在 [0, i] 中均匀地取一个下标
+        int j = (int)splitmix64_below(&state, (uint64_t)i + 1);
+
+        int temp = permutation_to_return[i];
+        permutation_to_return[i] = permutation_to_return[j];
+        permutation_to_return[j] = temp;
+    }
+    return 0;
+}
+
+int generate_question_permutation(unsigned int seed, int count, int *permutation_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = generate_question_permutation_impl(seed, count, permutation_to_return);
+    metrics_record_call(METRIC_GENERATE_QUESTION_PERMUTATION, start, rc != 0);
+    return rc;
+}
+
+/**************************** 题目顺序生成部分结束 ****************************/
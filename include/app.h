@@ -14,6 +14,10 @@ History:        暂无
         ID: GamerNoTitle
         Modification:   [+] 添加了头文件包含保护
                         [+] 添加了一些函数的声明
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 generate_question_permutation 函数的声明
  */
  
 #ifndef APP_H
@@ -86,4 +90,20 @@ void free_question_list(struct Question *head_ptr);
 
 /**************************** 考试问题生成模块部分结束 ****************************/
 
+/**************************** 题目顺序生成部分开始 ****************************/
+
+/**
+ * @brief 由随机种子生成题目的排列顺序。
+ *
+ * 同一个种子和题目数量总是得到同一个排列，下发考卷和判分共用此函数。
+ *
+ * @param seed 随机种子，0 表示不打乱顺序
+ * @param count 题目数量
+ * @param permutation_to_return 返回的排列，第 i 个位置的题目是原题目列表中的第 permutation_to_return[i] 题
+ * @return int 成功返回0，失败返回1
+ */
+int generate_question_permutation(unsigned int seed, int count, int *permutation_to_return);
+
+/**************************** 题目顺序生成部分结束 ****************************/
+
 #endif
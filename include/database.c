@@ -43,6 +43,94 @@ History:        暂无
         ID: GamerNoTitle
         Modification:   [-] 删除了错误的初始化过程
                         [*] 将学生的分数全部改为int类型存储，不在引入小数点
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] query_user_info 和按 id 查询的 query_users_info_all 优先读取用户缓存，未命中时将查询结果写入缓存
+                        [*] insert_user_data、del_user_data、edit_user_data 成功后使对应用户的缓存失效
+                        [*] 考试信息和题目被新增、修改、删除之后使对应考试的考卷缓存失效
+    8.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了列式查询函数 query_scores_columnar、query_users_columnar 以及 free_columnar_result，
+                            查询结果以整数列数组加字符串区的形式返回，便于 Python 端零拷贝读取
+    9.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] open_database 打开的连接只在当前线程内使用，改为以 SQLITE_OPEN_NOMUTEX 打开，
+                            并且在 SQLite 编译为单线程模式时拒绝打开
+    10. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了连接配置 configure_connection，每个连接都开启 WAL 日志模式、synchronous=NORMAL 并设置忙等待超时
+                        [+] 添加了 step_with_retry，写冲突（SQLITE_BUSY / SQLITE_LOCKED）时按带抖动的指数退避重试，
+                            重试情况计入 get_database_retry_stats 的统计
+                        [*] 增删改函数不再直接调用 sqlite3_open，统一通过 open_database 打开数据库
+    11. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] database.h 中导出的查询和增删改函数的实现改名为 xxx_impl，原函数名改为统计调用次数、
+                            失败次数和耗时的包装函数；批量查询和列式查询还会记录返回的行数和复制的字节数，统计数据见 metrics.h
+                        [*] 每个数据库保留一个常驻连接，只在第一次打开时设置 WAL 模式，避免每次关闭连接都触发检查点并删除 -wal 文件
+    12. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] open_database 为每个连接注册 sqlite3_trace_v2（SQLITE_TRACE_PROFILE），耗时超过阈值的语句
+                            连同展开参数后的 SQL 写入 logs/slow_query.log，可选附带 EXPLAIN QUERY PLAN
+                        [+] 添加了 set_slow_query_log 用于设置慢查询阈值和是否记录查询计划
+    13. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 只在 Windows 下引入 windows.h，本文件可以在 Linux 下编译
+    14. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 set_database_location，可以在运行时把数据库放到其他目录（如 tmpfs）或共享缓存的内存数据库中
+                        [+] 添加了 initialize_schema，在当前位置按 schema.h 建立缺少的表
+                        [*] 数据库路径不再是固定的宏，所有函数改为使用当前位置下的路径；打开数据库时允许使用 URI 文件名
+    15. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 backup_databases，使用 sqlite3_backup_step 分批在线备份三个数据库，三者取同一时刻的快照
+                        [+] 添加了 get_backup_progress，返回备份进度以及备份期间写入函数的耗时变化
+                        [*] 创建文件夹的代码提取为 make_folder，数据库位置和备份共用
+    16. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了报表副本：refresh_reporting_replica 把 score.db 和 user.db 复制到两个轮流使用的副本中，
+                            set_reporting_reads 开启后当前线程的成绩、用户批量查询改为读取副本
+                        [+] 添加了 get_reporting_replica_stats
+    17. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_exam_stats、rebuild_exam_stats 和 check_exam_stats，成绩统计由 scores 表上的触发器维护
+                        [*] initialize_schema 同时建立成绩统计表和触发器，已有成绩但还没有统计时计算一次
+    18. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 score_rank，由分数直方图计算名次和百分位；添加了 top_scores，按 (exam_id, score DESC, id) 索引读取排行榜
+                        [*] initialize_schema 同时建立 scores 表的索引
+    19. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了班级统计：query_class_cube 读取按 (教师, 班级, 考试) 预先汇总的成绩，rebuild_class_cube 重新计算，
+                            成绩写入时由触发器维护，用户写入之后由 sync_class_member 同步学生所在的班级
+                        [*] initialize_schema 同时建立班级统计表和触发器，已有学生但还没有班级统计时计算一次
+    20. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 insert_answer_log 和 query_answer_log，保存和读取每次交卷的答题记录
+                        [*] initialize_schema 同时建立答题记录表 answer_log 和同步它的触发器
+    21. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 scan_answer_logs，在同一个读事务中读取一场考试答题记录的版本号和全部记录，供逐题分析使用
+                        [*] initialize_schema 同时建立答题记录版本表 answer_log_versions 和维护它的触发器
+                        [*] 切换数据库位置时清空逐题分析的缓存
+    22. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 get_database_folder，吊销列表等数据库之外的持久化文件跟随数据库位置保存
  */
 
 #include <stdio.h>
@@ -50,16 +138,48 @@ History:        暂无
 #include <errno.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
 #include <windows.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 #include "model.h"
 #include "utils.h"
+#include "uuid.h"
+#include "user_cache.h"
+#include "exam_cache.h"
+#include "metrics.h"
+#include "schema.h" // 默认的数据库路径和建表语句
+#include "answer_log.h"
+#include "item_analysis.h"
+#include "revocation.h"
 #include "../lib/sqlite3.h"
 
-/*** 数据库部分 ***/
-#define DB_FOLDER "db"                     // 数据库保存文件夹名
-#define EXAMINATION_DB "db/examination.db" // 考试数据库
-#define SCORES_DB "db/score.db"            // 成绩数据库
-#define USER_DB "db/user.db"               // 用户数据库
+/*** 数据库位置部分 ***/
+#define DB_PATH_MAX 260                          // 数据库路径（或 URI）的最大长度
+#define DB_MEMORY_DEFAULT_NAME "mental"          // 内存数据库的默认名称前缀
+#define DB_LOCATION_ENV "MENTAL_DB_LOCATION"     // 指定数据库位置的环境变量，见 set_database_location
+
+/*** 连接配置部分 ***/
+#define DB_BUSY_TIMEOUT_MS 5000    // 等待其他连接释放锁的最长时间
+#define DB_RETRY_MAX_ATTEMPTS 8    // 写冲突时的最大重试次数
+#define DB_RETRY_BASE_DELAY_MS 2   // 第一次重试前的退避时间
+#define DB_RETRY_MAX_DELAY_MS 250  // 单次退避时间的上限
+#define DB_KEEPER_CAPACITY 8       // 最多为多少个数据库文件保留常驻连接
+
+/*** 在线备份部分 ***/
+#define BACKUP_DEFAULT_PAGES_PER_STEP 64 // 每一步默认复制的页数，每步持有源数据库读锁的时间很短
+#define BACKUP_DEFAULT_SLEEP_MS 10       // 两步之间默认暂停的毫秒数
+
+/*** 报表副本部分 ***/
+#define REPLICA_SLOT_COUNT 2     // 副本的份数，刷新时写入没有在用的一份，写完后再切换，正在读取的查询不受影响
+#define REPLICA_DATABASE_COUNT 2 // 有副本的数据库数量：score.db 和 user.db
+
+/*** 慢查询日志部分 ***/
+#define SLOW_QUERY_LOG_FILE "logs/slow_query.log" // 慢查询日志文件路径
+#define SLOW_QUERY_DEFAULT_THRESHOLD_MS 100       // 默认的慢查询阈值
 
 /*** 日志等级 ***/
 #define LOGLEVEL_ERROR "ERROR" // 错误级别日志
@@ -93,235 +213,1900 @@ typedef enum BINDING
     BIND_TYPE_FLOAT  // 绑定浮点数类型
 } BindType;
 
+/**************************** 连接配置与重试部分开始 ****************************/
+
+static char examination_db_path[DB_PATH_MAX] = EXAMINATION_DB; // 考试数据库的当前路径，见 set_database_location
+static char scores_db_path[DB_PATH_MAX] = SCORES_DB;           // 成绩数据库的当前路径
+static char user_db_path[DB_PATH_MAX] = USER_DB;               // 用户数据库的当前路径
+static char database_folder[DB_PATH_MAX] = DB_FOLDER;          // 数据库所在的文件夹，数据库在内存中时为空字符串
+
+static struct DatabaseRetryStats retry_stats;                   // 写冲突重试的统计信息
+static app_mutex_t retry_stats_lock = APP_MUTEX_INITIALIZER; // 保护 retry_stats 的互斥锁
+
 /**
- * @brief 打开数据库并处理错误
+ * @brief 常驻连接，每个数据库文件一个，在进程结束之前不会关闭
  *
- * @param db_path 数据库路径
- * @param db 输出参数，数据库指针
- * @return int 成功返回0，否则返回1
+ * @details WAL 模式下最后一个连接关闭时 SQLite 会做一次检查点并删除 -wal 和 -shm 文件，
+ *          下一个连接又要重新创建它们。每次调用都打开、关闭自己的连接时，这会让每次查询多花 100 多微秒。
+ *          保留一个不做任何事的连接，其他连接关闭时就不再是最后一个
+ */
+struct KeeperConnection
+{
+    char path[DB_PATH_MAX]; // 数据库路径
+    sqlite3 *db;            // 常驻连接
+};
+
+static struct KeeperConnection keepers[DB_KEEPER_CAPACITY];  // 已经打开常驻连接的数据库
+static int keeper_count;                                     // 常驻连接数量
+static app_mutex_t keeper_lock = APP_MUTEX_INITIALIZER;      // 保护 keepers 和 keeper_count 的互斥锁
+
+/**
+ * @brief 第一次打开某个数据库时为它开启 WAL 模式并打开常驻连接
  *
- * @details 此函数尝试打开指定路径的 SQLite 数据库。
- *          如果打开失败，则记录错误日志并关闭数据库连接。
+ * @details 日志模式保存在数据库文件中，只需要设置一次。其他进程正在切换日志模式时会失败，
+ *          此时保持原来的模式即可，不影响正确性
+ *
+ * @param db_path 数据库路径
  */
-int open_database(const char *db_path, sqlite3 **db)
+static void ensure_keeper_connection(const char *db_path)
 {
-    // 尝试打开数据库
-    int rc = sqlite3_open(db_path, db);
-    if (rc != SQLITE_OK)
+    app_mutex_lock(&keeper_lock);
+    for (int i = 0; i < keeper_count; i++)
     {
-        // 记录错误日志，包含数据库路径和错误消息
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", db_path, sqlite3_errmsg(*db));
-        sqlite3_close(*db); // 关闭数据库连接
-        return 1;           // 返回错误代码
+        if (strcmp(keepers[i].path, db_path) == 0)
+        {
+            app_mutex_unlock(&keeper_lock);
+            return;
+        }
     }
 
-    // 记录成功打开数据库的信息
-    log_message(LOGLEVEL_INFO, "成功打开数据库 '%s'", db_path);
-    return 0; // 成功返回0
+    sqlite3 *db = NULL;
+    if (keeper_count >= DB_KEEPER_CAPACITY || strlen(db_path) >= sizeof(keepers[0].path) ||
+        sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI, NULL) != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_INFO, "无法为数据库 '%s' 打开常驻连接", db_path);
+        sqlite3_close(db);
+        app_mutex_unlock(&keeper_lock);
+        return;
+    }
+    sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT_MS);
+    if (sqlite3_exec(db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL) != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_INFO, "无法切换到 WAL 日志模式：%s", sqlite3_errmsg(db));
+    }
+    // 刚从回滚日志切换过来时常驻连接还没有打开 WAL 文件，读一次让它持有 -wal 和 -shm，
+    // 否则最后一个普通连接关闭时仍然会检查点并删除它们
+    sqlite3_exec(db, "SELECT count(*) FROM sqlite_master;", NULL, NULL, NULL);
+    snprintf(keepers[keeper_count].path, sizeof(keepers[keeper_count].path), "%s", db_path);
+    keepers[keeper_count].db = db;
+    keeper_count++;
+    app_mutex_unlock(&keeper_lock);
 }
 
-/**************************** 单条数据查询开始 ****************************/
-
 /**
- * @brief 按照特定标准查询数据库 db/user.db 中符合条件的用户信息（只返回第一条）
+ * @brief 关闭所有常驻连接
  *
- * @param key 查询标准列名，可选值为 "id", "number", "name", "username"
- * @param content 查询内容，根据key进行匹配
- * @param user_to_return 返回的User结构体
- * @return int 执行成功返回0，否则返回1
+ * @details 切换数据库位置时调用。内存数据库在最后一个连接关闭时被释放，旧位置的内存数据库也随之释放
  */
-int query_user_info(const char *key, const char *content, struct User *user_to_return)
+static void close_keeper_connections(void)
 {
-    sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 验证查询键是否合法
-    if (strcmp(key, "id") != 0 && strcmp(key, "number") != 0 && strcmp(key, "name") != 0 && strcmp(key, "username") != 0)
+    app_mutex_lock(&keeper_lock);
+    for (int i = 0; i < keeper_count; i++)
     {
-        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
-        return 1;
+        sqlite3_close_v2(keepers[i].db);
+        keepers[i].db = NULL;
+        keepers[i].path[0] = '\0';
     }
+    keeper_count = 0;
+    app_mutex_unlock(&keeper_lock);
+}
 
-    // 构建SQL语句
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT id, username, hashpass, salt, role, name, class_name, number, belong_to FROM users WHERE %s = ? LIMIT 1;", key);
-
-    // 打开数据库
-    if (open_database(USER_DB, &db))
+/**
+ * @brief 配置新打开的数据库连接
+ *
+ * @details WAL 模式下读写互不阻塞，多个写入者之间也只在提交的一瞬间互斥。WAL 模式下 synchronous=NORMAL 不会损坏数据库，
+ *          只是掉电时可能丢失最后几个事务。忙等待超时让 SQLite 在遇到锁时先自行等待，而不是立刻返回 SQLITE_BUSY。
+ *          共享缓存的内存数据库使用表级锁，忙等待对它无效，读连接开启 read_uncommitted 后不再加表级读锁，
+ *          读写之间不会互相返回 SQLITE_LOCKED，写入者之间的冲突仍由 step_with_retry 重试
+ *
+ * @param db 已经打开的数据库连接
+ * @param db_path 数据库路径
+ * @return int 成功返回0，否则返回1
+ */
+static int configure_connection(sqlite3 *db, const char *db_path)
+{
+    ensure_keeper_connection(db_path);
+    if (sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT_MS) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", USER_DB);
-        return 1; // 打开数据库失败
+        return 1;
     }
-
-    // 准备查询语句
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
+    if (strstr(db_path, "mode=memory") != NULL &&
+        sqlite3_exec(db, "PRAGMA read_uncommitted = 1;", NULL, NULL, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
+    return sqlite3_exec(db, "PRAGMA synchronous = NORMAL;", NULL, NULL, NULL) != SQLITE_OK;
+}
 
-    // 绑定查询参数
-    rc = sqlite3_bind_text(stmt, 1, content, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+/**
+ * @brief 暂停当前线程指定的毫秒数
+ *
+ * @param milliseconds 暂停的毫秒数
+ */
+static void sleep_milliseconds(int milliseconds)
+{
+#ifdef _WIN32
+    Sleep((DWORD)milliseconds);
+#else
+    struct timespec ts = {milliseconds / 1000, (long)(milliseconds % 1000) * 1000000L};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
     {
-        log_message(LOGLEVEL_ERROR, "绑定查询内容参数失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return 1;
     }
+#endif
+}
 
-    // 执行查询并获取结果
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW)
+/**
+ * @brief 执行一条语句，遇到写冲突时重试
+ *
+ * @details 忙等待超时覆盖了大部分锁等待，但 SQLite 在可能死锁的情况下（例如 WAL 模式下读事务升级为写事务、
+ *          共享缓存的表锁）会直接返回 SQLITE_BUSY 或 SQLITE_LOCKED，不会调用忙等待处理函数。
+ *          这时重置语句（绑定的参数会保留）后按指数退避重试，退避时间在 [delay/2, delay] 中随机选取，
+ *          避免同时冲突的写入者在同一时刻再次冲突。只适用于自动提交模式下的单条语句
+ *
+ * @param db 语句所属的数据库连接
+ * @param stmt 已经绑定好参数的语句
+ * @return int 最后一次 sqlite3_step 的返回值
+ */
+static int step_with_retry(sqlite3 *db, sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_step(stmt);
+    int attempt = 0;
+    int busy = 0;
+    int locked = 0;
+
+    while ((rc & 0xFF) == SQLITE_BUSY || (rc & 0xFF) == SQLITE_LOCKED)
     {
-        // 从查询结果中提取数据
-        strncpy(user_to_return->id, (const char *)sqlite3_column_text(stmt, 0), sizeof(user_to_return->id) - 1);
-        strncpy(user_to_return->username, (const char *)sqlite3_column_text(stmt, 1), sizeof(user_to_return->username) - 1);
+        if ((rc & 0xFF) == SQLITE_BUSY)
+        {
+            busy++;
+        }
+        else
+        {
+            locked++;
+        }
+        if (attempt >= DB_RETRY_MAX_ATTEMPTS)
+        {
+            break;
+        }
 
-        // hashpass和salt不在User结构体中使用，略过
-        // sqlite3_column_text(stmt, 2) => hashpass
-        // sqlite3_column_text(stmt, 3) => salt
+        int delay = DB_RETRY_BASE_DELAY_MS << attempt;
+        if (delay > DB_RETRY_MAX_DELAY_MS)
+        {
+            delay = DB_RETRY_MAX_DELAY_MS;
+        }
+        unsigned int jitter = 0;
+        fill_random_bytes((unsigned char *)&jitter, sizeof(jitter)); // 失败时 jitter 为0，退避时间取下限
+        sleep_milliseconds(delay / 2 + (int)(jitter % (unsigned int)(delay - delay / 2 + 1)));
 
-        user_to_return->role = sqlite3_column_int(stmt, 4);
-        strncpy(user_to_return->name, (const char *)sqlite3_column_text(stmt, 5), sizeof(user_to_return->name) - 1);
-        strncpy(user_to_return->class_name, (const char *)sqlite3_column_text(stmt, 6), sizeof(user_to_return->class_name) - 1);
-        user_to_return->number = (unsigned int)sqlite3_column_int(stmt, 7);
-        strncpy(user_to_return->belong_to, (const char *)sqlite3_column_text(stmt, 8), sizeof(user_to_return->belong_to) - 1);
+        attempt++;
+        sqlite3_reset(stmt);
+        rc = sqlite3_step(stmt);
+    }
 
-        // 获取用户权限
-        user_to_return->permission = get_permission(*user_to_return);
+    if (busy || locked)
+    {
+        int exhausted = (rc & 0xFF) == SQLITE_BUSY || (rc & 0xFF) == SQLITE_LOCKED;
+        app_mutex_lock(&retry_stats_lock);
+        retry_stats.conflicts++;
+        retry_stats.retries += (unsigned long long)attempt;
+        retry_stats.busy += (unsigned long long)busy;
+        retry_stats.locked += (unsigned long long)locked;
+        if (exhausted)
+        {
+            retry_stats.exhausted++;
+        }
+        app_mutex_unlock(&retry_stats_lock);
 
-        log_message(LOGLEVEL_INFO, "成功查询到用户信息，用户ID：%s", user_to_return->id);
+        if (exhausted)
+        {
+            log_message(LOGLEVEL_ERROR, "重试 %d 次后仍然存在写冲突：%s", attempt, sqlite3_errmsg(db));
+        }
     }
-    else
+    return rc;
+}
+
+/**
+ * @brief 获取写冲突重试的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_database_retry_stats(struct DatabaseRetryStats *stats_to_return)
+{
+    if (stats_to_return == NULL)
     {
-        // 没有查询到结果
-        log_message(LOGLEVEL_INFO, "没有找到符合条件的用户信息，条件：%s = %s", key, content);
+        log_message(LOGLEVEL_ERROR, "参数 stats_to_return 为 NULL");
+        return 1;
     }
-
-    // 清理和关闭数据库
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    app_mutex_lock(&retry_stats_lock);
+    *stats_to_return = retry_stats;
+    app_mutex_unlock(&retry_stats_lock);
     return 0;
 }
 
+/**************************** 连接配置与重试部分结束 ****************************/
+
+/**************************** 慢查询日志部分开始 ****************************/
+
+static int slow_query_threshold_ms = SLOW_QUERY_DEFAULT_THRESHOLD_MS; // 慢查询阈值，小于0时不记录
+static int slow_query_explain;                                       // 是否同时记录 EXPLAIN QUERY PLAN
+static app_mutex_t slow_query_lock = APP_MUTEX_INITIALIZER;          // 保护上面两个设置以及慢查询日志文件的写入
+
 /**
- * @brief 按照特定标准查询数据库 db/examination.db 中符合条件的考试条目（只返回第一条）
+ * @brief 设置慢查询日志
  *
- * @param key 查询的标准，合法的范围为 id(考试唯一标识符), name(考试名称)
- * @param content 查询的内容，依据提供的查询标准，需要查询的内容需要填入content
- * @param exam_to_return 查询结果返回的 SqlResponseExam 结构体类型变量
+ * @param threshold_ms 慢查询阈值（毫秒），执行时间不少于该值的语句会被记录，小于0时关闭慢查询日志
+ * @param explain 非0时同时记录语句的 EXPLAIN QUERY PLAN
+ * @return int 成功返回0，否则返回1
  *
- * @return int 函数执行成功与否，成功返回0，否则为1
+ * @details 只影响之后打开的连接是否注册跟踪回调，已经打开的连接按新的阈值判断
  */
-int query_exam_info(const char *key, const char *content, struct SqlResponseExam *exam_to_return)
+int set_slow_query_log(int threshold_ms, int explain)
 {
-    sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 验证查询键是否合法
-    if (strcmp(key, "id") != 0 && strcmp(key, "name") != 0)
+    app_mutex_lock(&slow_query_lock);
+    slow_query_threshold_ms = threshold_ms;
+    slow_query_explain = explain != 0;
+    app_mutex_unlock(&slow_query_lock);
+    if (threshold_ms < 0)
     {
-        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
-        return 1;
+        log_message(LOGLEVEL_INFO, "慢查询日志已关闭");
     }
-
-    // 动态构建SQL语句
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT id, name, start_time, end_time, allow_answer_when_expired, random_question FROM examinations WHERE %s = ? LIMIT 1;", key);
-
-    // 打开数据库
-    if (open_database(EXAMINATION_DB, &db))
+    else
     {
-        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", EXAMINATION_DB);
-        return 1;
+        log_message(LOGLEVEL_INFO, "慢查询阈值设置为 %d 毫秒，%s记录查询计划", threshold_ms, explain ? "" : "不");
     }
+    return 0;
+}
 
-    // 准备查询语句
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
+/**
+ * @brief 将语句的 EXPLAIN QUERY PLAN 写入慢查询日志
+ *
+ * @param log_file 已经打开的慢查询日志文件
+ * @param db_path 语句所属的数据库文件
+ * @param sql 语句的原始 SQL（参数为 ?）
+ *
+ * @details 跟踪回调中不能在原来的连接上执行其他语句，所以另外以只读方式打开一个连接来生成查询计划。
+ *          查询计划与参数的具体取值无关，未绑定的参数按 NULL 处理即可。只有慢查询才会走到这里，多打开一个连接的开销可以接受
+ */
+static void write_query_plan(FILE *log_file, const char *db_path, const char *sql)
+{
+    if (db_path == NULL || db_path[0] == '\0')
     {
-        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return 1;
+        return;
     }
 
-    // 绑定查询内容
-    rc = sqlite3_bind_text(stmt, 1, content, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(db_path, &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定查询内容参数失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+        fprintf(log_file, "    无法打开数据库生成查询计划：%s\n", sqlite3_errmsg(db));
         sqlite3_close(db);
-        return 1;
+        return;
     }
 
-    // 执行查询并获取结果
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW)
+    char *explain_sql = sqlite3_mprintf("EXPLAIN QUERY PLAN %s", sql);
+    sqlite3_stmt *stmt = NULL;
+    if (explain_sql == NULL || sqlite3_prepare_v2(db, explain_sql, -1, &stmt, 0) != SQLITE_OK)
     {
-        // 填充SqlResponseExam结构体
-        strncpy(exam_to_return->id, (const char *)sqlite3_column_text(stmt, 0), sizeof(exam_to_return->id) - 1);
-        strncpy(exam_to_return->name, (const char *)sqlite3_column_text(stmt, 1), sizeof(exam_to_return->name) - 1);
-        exam_to_return->start_time = sqlite3_column_int(stmt, 2);
-        exam_to_return->end_time = sqlite3_column_int(stmt, 3);
-        exam_to_return->allow_answer_when_expired = sqlite3_column_int(stmt, 4);
-        exam_to_return->random_question = sqlite3_column_int(stmt, 5);
-
-        log_message(LOGLEVEL_INFO, "成功查询到考试信息，考试ID：%s", exam_to_return->id);
+        fprintf(log_file, "    无法生成查询计划：%s\n", sqlite3_errmsg(db));
     }
     else
     {
-        log_message(LOGLEVEL_INFO, "没有找到符合条件的考试信息，条件：%s = %s", key, content);
+        // 每一行为 (id, parent, notused, detail)，按 parent 缩进还原成树形
+        int ids[64];
+        int depths[64];
+        int count = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            int id = sqlite3_column_int(stmt, 0);
+            int parent = sqlite3_column_int(stmt, 1);
+            int depth = 0;
+            for (int i = count - 1; i >= 0; i--)
+            {
+                if (ids[i] == parent)
+                {
+                    depth = depths[i] + 1;
+                    break;
+                }
+            }
+            if (count < 64)
+            {
+                ids[count] = id;
+                depths[count] = depth;
+                count++;
+            }
+            const unsigned char *detail = sqlite3_column_text(stmt, 3);
+            fprintf(log_file, "    %*s%s\n", depth * 2, "", detail ? (const char *)detail : "");
+        }
     }
-
-    // 清理和关闭数据库
     sqlite3_finalize(stmt);
+    sqlite3_free(explain_sql);
     sqlite3_close(db);
-    return 0;
 }
 
 /**
- * @brief 按照特定标准查询数据库 db/examination.db 中符合条件的题目信息（只返回第一条）
- *
- * @param key 查询的标准，合法的范围为 id(题目唯一标识符), exam_id(考试ID)
- * @param content 查询的内容，依据提供的查询标准，需要查询的内容需要填入content
- * @param question_to_return 查询结果返回的 SqlResponseQuestion 结构体类型变量
+ * @brief sqlite3_trace_v2 的回调，记录执行时间超过阈值的语句
  *
- * @return int 函数执行成功与否，成功返回0，否则为1
+ * @param type 跟踪事件类型，只注册了 SQLITE_TRACE_PROFILE
+ * @param context 注册时传入的上下文，未使用
+ * @param p 执行完毕的语句
+ * @param x 语句的执行时间（纳秒，sqlite3_int64）
+ * @return int 总是返回0
  */
-int query_question_info(const char *key, const char *content, struct SqlResponseQuestion *question_to_return)
+static int slow_query_trace(unsigned type, void *context, void *p, void *x)
 {
-    sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 验证查询键是否合法
-    if (strcmp(key, "id") != 0 && strcmp(key, "exam_id") != 0)
+    (void)context;
+    if (type != SQLITE_TRACE_PROFILE)
     {
-        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
-        return 1;
+        return 0;
     }
 
-    // 动态构建SQL语句
-    char sql[256];
-    snprintf(sql, sizeof(sql), "SELECT id, exam_id, num1, op, num2 FROM questions WHERE %s = ? LIMIT 1;", key);
+    sqlite3_stmt *stmt = (sqlite3_stmt *)p;
+    sqlite3_int64 elapsed_ns = *(sqlite3_int64 *)x;
 
-    // 打开数据库
-    if (open_database(EXAMINATION_DB, &db))
+    app_mutex_lock(&slow_query_lock);
+    int threshold_ms = slow_query_threshold_ms;
+    int explain = slow_query_explain;
+    app_mutex_unlock(&slow_query_lock);
+    if (threshold_ms < 0 || elapsed_ns < (sqlite3_int64)threshold_ms * 1000000)
     {
-        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", EXAMINATION_DB);
-        return 1;
+        return 0;
     }
 
-    // 准备查询语句
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
-    {
+    sqlite3 *db = sqlite3_db_handle(stmt);
+    const char *db_path = sqlite3_db_filename(db, "main");
+    char *expanded_sql = sqlite3_expanded_sql(stmt);
+    char current_time[20];
+    get_current_time(current_time, sizeof(current_time));
+
+    app_mutex_lock(&slow_query_lock);
+    FILE *log_file = fopen(SLOW_QUERY_LOG_FILE, "a");
+    if (log_file != NULL)
+    {
+        fprintf(log_file, "%s [SLOW] %.3f ms %s: %s\n", current_time, (double)elapsed_ns / 1e6,
+                db_path ? db_path : "", expanded_sql ? expanded_sql : sqlite3_sql(stmt));
+        if (explain)
+        {
+            write_query_plan(log_file, db_path, sqlite3_sql(stmt));
+        }
+        fclose(log_file);
+    }
+    app_mutex_unlock(&slow_query_lock);
+
+    sqlite3_free(expanded_sql);
+    return 0;
+}
+
+/**
+ * @brief 为新打开的连接注册慢查询跟踪回调
+ *
+ * @param db 已经打开的数据库连接
+ */
+static void register_slow_query_trace(sqlite3 *db)
+{
+    app_mutex_lock(&slow_query_lock);
+    int enabled = slow_query_threshold_ms >= 0;
+    app_mutex_unlock(&slow_query_lock);
+    if (enabled)
+    {
+        sqlite3_trace_v2(db, SQLITE_TRACE_PROFILE, slow_query_trace, NULL);
+    }
+}
+
+/**************************** 慢查询日志部分结束 ****************************/
+
+/**
+ * @brief 打开数据库并处理错误
+ *
+ * @param db_path 数据库路径
+ * @param db 输出参数，数据库指针
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 此函数尝试打开指定路径的 SQLite 数据库。
+ *          如果打开失败，则记录错误日志并关闭数据库连接。
+ *          连接只能在打开它的线程内使用，所以不需要 SQLite 为每个连接再加一把互斥锁（SQLITE_OPEN_NOMUTEX），
+ *          但 SQLite 本身必须以多线程模式编译，否则多个线程同时打开连接并不安全。
+ *          慢查询日志开启时还会为连接注册跟踪回调，见 set_slow_query_log
+ */
+static int open_database_impl(const char *db_path, sqlite3 **db)
+{
+    if (sqlite3_threadsafe() == 0)
+    {
+        log_message(LOGLEVEL_ERROR, "SQLite 以单线程模式编译（SQLITE_THREADSAFE=0），无法安全地打开数据库 '%s'", db_path);
+        *db = NULL;
+        return 1;
+    }
+
+    // 尝试打开数据库
+    int rc = sqlite3_open_v2(db_path, db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX | SQLITE_OPEN_URI, NULL);
+    if (rc != SQLITE_OK)
+    {
+        // 记录错误日志，包含数据库路径和错误消息
+        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", db_path, sqlite3_errmsg(*db));
+        sqlite3_close(*db); // 关闭数据库连接
+        return 1;           // 返回错误代码
+    }
+
+    if (configure_connection(*db, db_path))
+    {
+        log_message(LOGLEVEL_ERROR, "无法配置数据库连接 '%s'：%s", db_path, sqlite3_errmsg(*db));
+        sqlite3_close(*db);
+        return 1;
+    }
+    register_slow_query_trace(*db);
+
+    // 记录成功打开数据库的信息
+    log_message(LOGLEVEL_INFO, "成功打开数据库 '%s'", db_path);
+    return 0; // 成功返回0
+}
+
+int open_database(const char *db_path, sqlite3 **db)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = open_database_impl(db_path, db);
+    metrics_record_call(METRIC_OPEN_DATABASE, start, rc != 0);
+    return rc;
+}
+
+/**************************** 报表副本部分开始 ****************************/
+
+/**
+ * @brief 报表副本
+ *
+ * @details 教师的成绩列表、成绩导出、学生列表需要扫描整张表，与学生交卷写入的是同一个数据库。
+ *          报表副本是 score.db 和 user.db 的定期复制品，开启 set_reporting_reads 的线程中的批量查询改为读取副本，
+ *          长时间的报表查询不会与考试期间的写入争用同一个数据库。
+ *
+ *          副本有两份，刷新时写入没有在用的一份，写完后再切换为在用，刷新和读取互不等待。
+ *          每个源数据库保留一个只用来读取的连接，PRAGMA data_version 在其他连接提交之后才会改变，
+ *          某一份副本中的某个数据库与源数据库的版本相同时跳过复制，只有发生过变化的数据库才会被复制。
+ *          副本与源数据库放在同一个位置：磁盘上为 score.replica0.db 这样的文件，内存数据库为同名的共享缓存内存数据库。
+ *          副本只在 refresh_reporting_replica 时更新，读取副本的查询看到的是最近一次刷新时的数据
+ */
+struct ReportingReplica
+{
+    sqlite3 *sources[REPLICA_DATABASE_COUNT];                                    // 只用来读取源数据库的连接
+    char paths[REPLICA_SLOT_COUNT][REPLICA_DATABASE_COUNT][DB_PATH_MAX];         // 每一份副本中每个数据库的路径
+    long long versions[REPLICA_SLOT_COUNT][REPLICA_DATABASE_COUNT];              // 每一份副本中每个数据库复制时源数据库的 data_version，-1 为还没有复制过
+    int active_slot;                                                             // 在用的一份，-1 为还没有刷新过
+};
+
+static struct ReportingReplica replica = {.active_slot = -1};
+static struct ReplicaStats replica_stats;                          // 报表副本的统计信息
+static app_mutex_t replica_lock = APP_MUTEX_INITIALIZER;           // 保护 replica 和 replica_stats，同一时刻只有一个线程刷新
+static APP_THREAD_LOCAL int reporting_reads;                       // 当前线程的批量查询是否读取副本
+
+/**
+ * @brief 由源数据库路径得到副本路径，在扩展名 .db 或 URI 的查询参数之前插入 .replicaN
+ *
+ * @param source 源数据库路径，如 db/score.db 或 file:mental-score?mode=memory&cache=shared
+ * @param slot 第几份副本
+ * @param path_to_return 返回的副本路径
+ * @return int 成功返回0，路径太长时返回1
+ */
+static int build_replica_path(const char *source, int slot, char *path_to_return)
+{
+    const char *query = strchr(source, '?');
+    size_t stem = query != NULL ? (size_t)(query - source) : strlen(source);
+    const char *suffix = source + stem;
+    if (stem >= 3 && strncmp(source + stem - 3, ".db", 3) == 0)
+    {
+        stem -= 3;
+        suffix -= 3;
+    }
+    int written = snprintf(path_to_return, DB_PATH_MAX, "%.*s.replica%d%s", (int)stem, source, slot, suffix);
+    return written < 0 || written >= DB_PATH_MAX;
+}
+
+/**
+ * @brief 丢弃报表副本，之后的批量查询重新读取源数据库，直到下一次刷新
+ *
+ * @details 切换数据库位置时调用，调用者不能持有 replica_lock。副本文件留在原来的位置，下一次刷新时覆盖
+ */
+static void reset_reporting_replica(void)
+{
+    app_mutex_lock(&replica_lock);
+    for (int i = 0; i < REPLICA_DATABASE_COUNT; i++)
+    {
+        sqlite3_close(replica.sources[i]);
+        replica.sources[i] = NULL;
+    }
+    replica.active_slot = -1;
+    app_mutex_unlock(&replica_lock);
+}
+
+/**
+ * @brief 把源数据库当前的内容整个复制到目标数据库
+ *
+ * @details 复制在一步中完成，期间持有源数据库的读事务。WAL 模式下读事务不会阻塞写入者，
+ *          一步复制也避免了源数据库在两步之间被修改时整个复制重新开始。目标数据库被仍在读取旧副本的查询锁住时稍后重试
+ *
+ * @param source 源数据库连接
+ * @param target 目标数据库连接
+ * @return int 复制的页数，失败返回-1
+ */
+static int copy_database(sqlite3 *source, sqlite3 *target)
+{
+    sqlite3_backup *backup = sqlite3_backup_init(target, "main", source, "main");
+    if (backup == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "无法开始复制报表副本：%s", sqlite3_errmsg(target));
+        return -1;
+    }
+    int rc;
+    for (int attempt = 0;; attempt++)
+    {
+        rc = sqlite3_backup_step(backup, -1);
+        if ((rc != SQLITE_BUSY && rc != SQLITE_LOCKED) || attempt >= DB_RETRY_MAX_ATTEMPTS)
+        {
+            break;
+        }
+        sleep_milliseconds(DB_RETRY_BASE_DELAY_MS << attempt);
+    }
+    int pages = sqlite3_backup_pagecount(backup);
+    sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "复制报表副本失败：%s", sqlite3_errstr(rc));
+        return -1;
+    }
+    return pages;
+}
+
+/**
+ * @brief 刷新报表副本
+ *
+ * @return int 成功返回0（包括源数据库没有变化、不需要刷新的情况），否则返回1，失败时继续使用原来的副本
+ *
+ * @details 把 score.db 和 user.db 复制到没有在用的一份副本中，然后切换为在用。
+ *          该份副本中与源数据库版本相同的数据库不会被复制；两个源数据库自上次刷新以来都没有变化时什么都不做。
+ *          第一次调用时才创建副本，之前 set_reporting_reads 不起作用，查询仍然读取源数据库。
+ *          通常由后台线程定期调用，两次刷新之间的间隔就是报表数据最多落后的时间
+ */
+int refresh_reporting_replica(void)
+{
+    const char *source_paths[REPLICA_DATABASE_COUNT] = {scores_db_path, user_db_path};
+    uint64_t start = metrics_now_ns();
+    int rc = 0;
+
+    app_mutex_lock(&replica_lock);
+    int slot = replica.active_slot < 0 ? 0 : (replica.active_slot + 1) % REPLICA_SLOT_COUNT;
+    if (replica.active_slot < 0)
+    {
+        for (int s = 0; s < REPLICA_SLOT_COUNT; s++)
+        {
+            for (int i = 0; i < REPLICA_DATABASE_COUNT && rc == 0; i++)
+            {
+                replica.versions[s][i] = -1;
+                rc = build_replica_path(source_paths[i], s, replica.paths[s][i]);
+            }
+        }
+        if (rc != 0)
+        {
+            log_message(LOGLEVEL_ERROR, "数据库路径太长，无法创建报表副本");
+        }
+    }
+
+    int changed = 0;
+    int copied_databases = 0;
+    unsigned long long copied_pages = 0;
+    for (int i = 0; i < REPLICA_DATABASE_COUNT && rc == 0; i++)
+    {
+        if (replica.sources[i] == NULL && open_database(source_paths[i], &replica.sources[i]))
+        {
+            replica.sources[i] = NULL;
+            rc = 1;
+            break;
+        }
+        sqlite3 *source = replica.sources[i];
+
+        // 在读事务中读取版本和复制，两者对应同一份数据
+        sqlite3_stmt *stmt = NULL;
+        long long version = -1;
+        if (sqlite3_exec(source, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK ||
+            sqlite3_prepare_v2(source, "PRAGMA data_version;", -1, &stmt, NULL) != SQLITE_OK ||
+            sqlite3_step(stmt) != SQLITE_ROW)
+        {
+            log_message(LOGLEVEL_ERROR, "无法读取数据库 '%s' 的版本：%s", source_paths[i], sqlite3_errmsg(source));
+            rc = 1;
+        }
+        else
+        {
+            version = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+
+        if (rc == 0 && (replica.active_slot < 0 || replica.versions[replica.active_slot][i] != version))
+        {
+            changed = 1;
+        }
+        if (rc == 0 && replica.versions[slot][i] != version)
+        {
+            sqlite3 *target = NULL;
+            int pages = -1;
+            if (open_database(replica.paths[slot][i], &target) == 0)
+            {
+                pages = copy_database(source, target);
+                sqlite3_close(target);
+            }
+            replica.versions[slot][i] = pages < 0 ? -1 : version;
+            rc = pages < 0;
+            copied_pages += pages < 0 ? 0 : (unsigned long long)pages;
+            copied_databases++;
+        }
+        sqlite3_exec(source, "COMMIT;", NULL, NULL, NULL);
+    }
+
+    if (rc == 0 && changed)
+    {
+        replica.active_slot = slot;
+        replica_stats.refreshes++;
+        replica_stats.copied_databases += copied_databases;
+        replica_stats.copied_pages += copied_pages;
+        replica_stats.last_refresh_at = (long long)time(NULL);
+    }
+    else if (rc == 0)
+    {
+        replica_stats.skipped++;
+    }
+    else
+    {
+        replica_stats.failures++;
+    }
+    replica_stats.active_slot = replica.active_slot;
+    uint64_t elapsed_ns = metrics_now_ns() - start;
+    replica_stats.last_refresh_ns = elapsed_ns;
+    if (elapsed_ns > replica_stats.max_refresh_ns)
+    {
+        replica_stats.max_refresh_ns = elapsed_ns;
+    }
+    app_mutex_unlock(&replica_lock);
+    return rc;
+}
+
+/**
+ * @brief 设置当前线程的批量查询是否读取报表副本
+ *
+ * @param enabled 非0表示读取副本，0表示读取源数据库
+ * @return int 设置之前的值，便于嵌套使用时恢复
+ *
+ * @details 只影响 query_scores_info_all、query_users_info_all、query_scores_columnar 和 query_users_columnar。
+ *          还没有刷新过副本时这些查询仍然读取源数据库
+ */
+int set_reporting_reads(int enabled)
+{
+    int previous = reporting_reads;
+    reporting_reads = enabled != 0;
+    return previous;
+}
+
+/**
+ * @brief 为批量查询选择数据库路径
+ *
+ * @param db_path 源数据库路径，只能是 scores_db_path 或 user_db_path
+ * @return const char* 当前线程开启了 set_reporting_reads 并且副本可用时返回在用副本的路径，否则返回 db_path
+ *
+ * @details 副本路径在切换数据库位置之前不会改变，返回的指针在刷新之后仍然有效；
+ *          刷新只会覆盖另一份副本，刚拿到路径的查询读取的仍然是一份完整的副本
+ */
+static const char *reporting_path(const char *db_path)
+{
+    if (!reporting_reads)
+    {
+        return db_path;
+    }
+    const char *path = db_path;
+    app_mutex_lock(&replica_lock);
+    if (replica.active_slot >= 0)
+    {
+        path = replica.paths[replica.active_slot][db_path == scores_db_path ? 0 : 1];
+        replica_stats.routed_reads++;
+    }
+    app_mutex_unlock(&replica_lock);
+    return path;
+}
+
+/**
+ * @brief 获取报表副本的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_reporting_replica_stats(struct ReplicaStats *stats_to_return)
+{
+    if (stats_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 stats_to_return 为 NULL");
+        return 1;
+    }
+    app_mutex_lock(&replica_lock);
+    *stats_to_return = replica_stats;
+    stats_to_return->active_slot = replica.active_slot;
+    app_mutex_unlock(&replica_lock);
+    return 0;
+}
+
+/**************************** 报表副本部分结束 ****************************/
+
+/**************************** 数据库位置部分开始 ****************************/
+
+/**
+ * @brief 创建文件夹，文件夹已经存在时什么都不做
+ *
+ * @param folder 文件夹路径，只创建最后一级
+ * @return int 成功返回0，否则返回1
+ */
+static int make_folder(const char *folder)
+{
+#ifdef _WIN32
+    int created = _mkdir(folder);
+#else
+    int created = mkdir(folder, 0755);
+#endif
+    if (created != 0 && errno != EEXIST)
+    {
+        log_message(LOGLEVEL_ERROR, "无法创建文件夹 '%s'：%s", folder, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 设置数据库的位置
+ *
+ * @param location 数据库位置，取值如下：
+ *                 - 目录路径：三个数据库文件放在该目录下，目录不存在时创建（只创建最后一级），可以指向 tmpfs（如 /dev/shm/mental）
+ *                 - ":memory:" 或 "file::memory:"：使用名为 mental 的共享缓存内存数据库
+ *                 - "memory:名称"：使用指定名称的共享缓存内存数据库，同一进程内不同名称的数据库互相隔离，名称只能包含字母、数字、'-' 和 '_'
+ *                 - NULL 或空字符串：使用环境变量 MENTAL_DB_LOCATION 指定的位置，没有设置时恢复默认的 db 文件夹
+ * @return int 成功返回0，否则返回1，失败时保持原来的位置
+ *
+ * @details 内存数据库由常驻连接保持，在进程结束或者再次切换位置之前一直存在。切换位置时关闭所有常驻连接，
+ *          清空用户缓存和考卷缓存，并丢弃报表副本，它们的数据属于旧的位置。
+ *          与 initialize 一样只能在启动时、其他线程开始访问数据库之前调用；切换后通常还需要调用 initialize_schema 建表
+ */
+int set_database_location(const char *location)
+{
+    if (location == NULL || location[0] == '\0')
+    {
+        location = getenv(DB_LOCATION_ENV);
+        if (location == NULL || location[0] == '\0')
+        {
+            location = DB_FOLDER;
+        }
+    }
+
+    char examination[DB_PATH_MAX];
+    char scores[DB_PATH_MAX];
+    char users[DB_PATH_MAX];
+    char folder[DB_PATH_MAX] = "";
+    int written;
+    const char *memory_name = NULL;
+    if (strcmp(location, ":memory:") == 0 || strcmp(location, "file::memory:") == 0)
+    {
+        memory_name = DB_MEMORY_DEFAULT_NAME;
+    }
+    else if (strncmp(location, "memory:", 7) == 0)
+    {
+        memory_name = location + 7;
+        if (memory_name[0] == '\0' || strspn(memory_name, "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_") != strlen(memory_name))
+        {
+            log_message(LOGLEVEL_ERROR, "内存数据库名称 '%s' 无效", memory_name);
+            return 1;
+        }
+    }
+
+    if (memory_name != NULL)
+    {
+        // 每个数据库使用一个独立的命名内存数据库，三者之间与磁盘上的数据库一样互相独立
+        written = snprintf(examination, sizeof(examination), "file:%s-examination?mode=memory&cache=shared", memory_name);
+        snprintf(scores, sizeof(scores), "file:%s-score?mode=memory&cache=shared", memory_name);
+        snprintf(users, sizeof(users), "file:%s-user?mode=memory&cache=shared", memory_name);
+    }
+    else
+    {
+        // 去掉末尾的路径分隔符
+        size_t length = strlen(location);
+        while (length > 1 && (location[length - 1] == '/' || location[length - 1] == '\\'))
+        {
+            length--;
+        }
+        written = snprintf(examination, sizeof(examination), "%.*s/examination.db", (int)length, location);
+        snprintf(scores, sizeof(scores), "%.*s/score.db", (int)length, location);
+        snprintf(users, sizeof(users), "%.*s/user.db", (int)length, location);
+    }
+    if (written < 0 || written >= (int)sizeof(examination))
+    {
+        log_message(LOGLEVEL_ERROR, "数据库位置 '%s' 太长", location);
+        return 1;
+    }
+
+    if (memory_name == NULL)
+    {
+        snprintf(folder, sizeof(folder), "%.*s", (int)(strlen(examination) - strlen("/examination.db")), examination);
+        if (make_folder(folder))
+        {
+            return 1;
+        }
+    }
+
+    reset_reporting_replica();
+    close_keeper_connections();
+    user_cache_clear();
+    exam_cache_clear();
+    item_analysis_cache_clear();
+    snprintf(examination_db_path, sizeof(examination_db_path), "%s", examination);
+    snprintf(scores_db_path, sizeof(scores_db_path), "%s", scores);
+    snprintf(user_db_path, sizeof(user_db_path), "%s", users);
+    snprintf(database_folder, sizeof(database_folder), "%s", folder);
+    // 吊销列表在下次使用时从新位置的文件重新加载
+    revocation_clear();
+    log_message(LOGLEVEL_INFO, "数据库位置设置为 '%s'", location);
+    return 0;
+}
+
+int get_database_folder(char *folder_to_return, int size)
+{
+    if (folder_to_return == NULL || size <= 0)
+    {
+        log_message(LOGLEVEL_ERROR, "get_database_folder 的参数不能为 NULL");
+        return 1;
+    }
+    if ((int)strlen(database_folder) >= size)
+    {
+        log_message(LOGLEVEL_ERROR, "数据库文件夹 '%s' 的路径太长", database_folder);
+        return 1;
+    }
+    snprintf(folder_to_return, (size_t)size, "%s", database_folder);
+    return 0;
+}
+
+/**
+ * @brief 在一个数据库中执行建表语句
+ *
+ * @param db_path 数据库路径
+ * @param schemas 建表语句数组
+ * @param count 建表语句数量
+ * @return int 成功返回0，否则返回1
+ */
+static int apply_schema(const char *db_path, const char *const *schemas, int count)
+{
+    sqlite3 *db;
+    if (open_database(db_path, &db))
+    {
+        return 1;
+    }
+    int rc = 0;
+    for (int i = 0; i < count && rc == 0; i++)
+    {
+        char *err_msg = NULL;
+        if (sqlite3_exec(db, schemas[i], NULL, NULL, &err_msg) != SQLITE_OK)
+        {
+            log_message(LOGLEVEL_ERROR, "在数据库 '%s' 中建表失败：%s", db_path, err_msg);
+            sqlite3_free(err_msg);
+            rc = 1;
+        }
+    }
+    sqlite3_close(db);
+    return rc;
+}
+
+/**
+ * @brief 由 scores 表重新计算 exam_stats 和 exam_score_histogram
+ *
+ * @param only_if_missing 非0时只在统计表为空而 scores 表不为空时计算
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 在 BEGIN IMMEDIATE 事务中完成，期间其他写入者等待，计算完成后的统计与 scores 表一致，之后由触发器维护
+ */
+static int run_exam_stats_rebuild(int only_if_missing)
+{
+    sqlite3 *db;
+    if (open_database(scores_db_path, &db))
+    {
+        return 1;
+    }
+    int rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK;
+    int needed = 1;
+    if (rc == 0 && only_if_missing)
+    {
+        sqlite3_stmt *stmt = NULL;
+        rc = sqlite3_prepare_v2(db, "SELECT EXISTS (SELECT 1 FROM scores) AND NOT EXISTS (SELECT 1 FROM exam_stats);", -1, &stmt, NULL) != SQLITE_OK ||
+             sqlite3_step(stmt) != SQLITE_ROW;
+        needed = rc == 0 && sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    if (rc == 0 && needed)
+    {
+        char *err_msg = NULL;
+        if (sqlite3_exec(db, SQL_REBUILD_EXAM_STATS, NULL, NULL, &err_msg) != SQLITE_OK)
+        {
+            log_message(LOGLEVEL_ERROR, "计算成绩统计失败：%s", err_msg);
+            sqlite3_free(err_msg);
+            rc = 1;
+        }
+    }
+    rc |= sqlite3_exec(db, rc == 0 ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK;
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法重新计算成绩统计：%s", sqlite3_errmsg(db));
+    }
+    else if (needed)
+    {
+        log_message(LOGLEVEL_INFO, "已由成绩表重新计算成绩统计");
+    }
+    sqlite3_close(db);
+    return rc;
+}
+
+/**
+ * @brief 由用户表和 scores 表重新计算 class_members、class_cube 和 class_cube_histogram
+ *
+ * @param only_if_missing 非0时只在 class_members 为空而用户表中有学生时计算
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 把用户数据库附加到成绩数据库的连接上，在 BEGIN IMMEDIATE 事务中执行 SQL_REBUILD_CLASS_CUBE，
+ *          成绩与学生只分组连接一次。ATTACH 不能在事务中执行，所以先附加再开始事务
+ */
+static int run_class_cube_rebuild(int only_if_missing)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
+    {
+        return 1;
+    }
+    int rc = sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS user_db;", -1, &stmt, NULL) != SQLITE_OK;
+    if (rc == 0)
+    {
+        sqlite3_bind_text(stmt, 1, user_db_path, -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt) != SQLITE_DONE;
+    }
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法附加用户数据库 '%s'：%s", user_db_path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK;
+    int needed = 1;
+    if (rc == 0 && only_if_missing)
+    {
+        rc = sqlite3_prepare_v2(db,
+                                "SELECT NOT EXISTS (SELECT 1 FROM class_members) "
+                                "AND EXISTS (SELECT 1 FROM user_db.users WHERE coalesce(belong_to, '') <> '');",
+                                -1, &stmt, NULL) != SQLITE_OK ||
+             sqlite3_step(stmt) != SQLITE_ROW;
+        needed = rc == 0 && sqlite3_column_int(stmt, 0);
+        sqlite3_finalize(stmt);
+    }
+    if (rc == 0 && needed)
+    {
+        char *err_msg = NULL;
+        if (sqlite3_exec(db, SQL_REBUILD_CLASS_CUBE, NULL, NULL, &err_msg) != SQLITE_OK)
+        {
+            log_message(LOGLEVEL_ERROR, "计算班级统计失败：%s", err_msg);
+            sqlite3_free(err_msg);
+            rc = 1;
+        }
+    }
+    rc |= sqlite3_exec(db, rc == 0 ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK;
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法重新计算班级统计：%s", sqlite3_errmsg(db));
+    }
+    else if (needed)
+    {
+        log_message(LOGLEVEL_INFO, "已由用户表和成绩表重新计算班级统计");
+    }
+    sqlite3_exec(db, "DETACH DATABASE user_db;", NULL, NULL, NULL);
+    sqlite3_close(db);
+    return rc;
+}
+
+/**
+ * @brief 在当前的数据库位置建立缺少的表
+ *
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 建表语句来自 schema.h，都带有 IF NOT EXISTS，对已经初始化过的数据库重复调用没有影响。
+ *          initialize 只在默认的 db 文件夹不存在时建表，其他位置（尤其是内存数据库）需要调用本函数。
+ *          成绩统计表为空而 scores 表中已有成绩时（升级之前的数据库），由 scores 表计算一次统计，班级统计同理
+ */
+int initialize_schema(void)
+{
+    const char *const examination_schemas[] = {SCHEMA_EXAMINATIONS, SCHEMA_QUESTIONS};
+    const char *const score_schemas[] = {SCHEMA_SCORES, SCHEMA_SCORES_INDEXES, SCHEMA_EXAM_STATS, SCHEMA_EXAM_SCORE_HISTOGRAM, SCHEMA_EXAM_STATS_TRIGGERS,
+                                         SCHEMA_CLASS_MEMBERS, SCHEMA_CLASS_CUBE, SCHEMA_CLASS_CUBE_HISTOGRAM, SCHEMA_CLASS_CUBE_TRIGGERS,
+                                         SCHEMA_ANSWER_LOG, SCHEMA_ANSWER_LOG_TRIGGERS, SCHEMA_ANSWER_LOG_VERSIONS, SCHEMA_ANSWER_LOG_VERSION_TRIGGERS};
+    const char *const user_schemas[] = {SCHEMA_USERS};
+
+    int rc = apply_schema(examination_db_path, examination_schemas, 2);
+    rc |= apply_schema(scores_db_path, score_schemas, 13);
+    rc |= apply_schema(user_db_path, user_schemas, 1);
+    // 统计表是后来加入的，已有成绩的数据库第一次建立统计表时计算一次
+    rc |= rc == 0 && run_exam_stats_rebuild(1);
+    rc |= rc == 0 && run_class_cube_rebuild(1);
+    if (rc == 0)
+    {
+        log_message(LOGLEVEL_INFO, "数据库表结构初始化完成");
+    }
+    return rc;
+}
+
+/**************************** 数据库位置部分结束 ****************************/
+
+/**************************** 在线备份部分开始 ****************************/
+
+static struct BackupProgress backup_progress = {.result = -1}; // 最近一次备份的进度
+static app_mutex_t backup_lock = APP_MUTEX_INITIALIZER;         // 保护 backup_progress，同一时刻只能有一个备份
+
+/**
+ * @brief 统计写入函数（insert_*、del_*、edit_* 中的单条记录函数）在两次快照之间的调用情况
+ *
+ * @param before 较早的快照，为 NULL 时从进程启动开始统计
+ * @param after 较晚的快照
+ * @param calls_to_return 返回调用次数
+ * @param mean_ns_to_return 返回平均耗时（纳秒）
+ * @param p99_ns_to_return 返回耗时的 p99（纳秒，所在直方图桶的上界，最后一个桶取最大耗时）
+ */
+static void summarize_writer_latency(const struct MetricsSnapshot *before, const struct MetricsSnapshot *after,
+                                     unsigned long long *calls_to_return, unsigned long long *mean_ns_to_return,
+                                     unsigned long long *p99_ns_to_return)
+{
+    unsigned long long buckets[METRICS_BUCKET_COUNT] = {0};
+    unsigned long long calls = 0;
+    unsigned long long total_ns = 0;
+    unsigned long long max_ns = 0;
+    for (int f = METRIC_INSERT_EXAM_DATA; f <= METRIC_EDIT_QUESTION_DATA; f++)
+    {
+        const struct FunctionMetrics *a = &after->functions[f];
+        calls += a->calls - (before != NULL ? before->functions[f].calls : 0);
+        total_ns += a->total_ns - (before != NULL ? before->functions[f].total_ns : 0);
+        max_ns = a->max_ns > max_ns ? a->max_ns : max_ns;
+        for (int i = 0; i < METRICS_BUCKET_COUNT; i++)
+        {
+            buckets[i] += a->buckets[i] - (before != NULL ? before->functions[f].buckets[i] : 0);
+        }
+    }
+
+    *calls_to_return = calls;
+    *mean_ns_to_return = calls ? total_ns / calls : 0;
+    *p99_ns_to_return = 0;
+    unsigned long long rank = (calls * 99 + 99) / 100; // ceil(0.99 * calls)
+    unsigned long long seen = 0;
+    for (int i = 0; i < METRICS_BUCKET_COUNT && calls > 0; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            *p99_ns_to_return = i == METRICS_BUCKET_COUNT - 1 ? max_ns : after->bucket_upper_ns[i];
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 把一个数据库分批复制到目标文件
+ *
+ * @param source 已经开启读事务的源数据库连接，复制的是这个事务看到的快照
+ * @param target_path 目标文件路径，先写入 target_path.partial，完成后再改名，失败时不会留下看起来完整的备份
+ * @param pages_per_step 每一步复制的页数
+ * @param sleep_ms 两步之间暂停的毫秒数
+ * @return int 成功返回0，否则返回1
+ */
+static int backup_one_database(sqlite3 *source, const char *target_path, int pages_per_step, int sleep_ms)
+{
+    char partial_path[DB_PATH_MAX + 16];
+    snprintf(partial_path, sizeof(partial_path), "%s.partial", target_path);
+    remove(partial_path);
+
+    sqlite3 *target = NULL;
+    if (sqlite3_open_v2(partial_path, &target, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "无法创建备份文件 '%s'：%s", partial_path, sqlite3_errmsg(target));
+        sqlite3_close(target);
+        return 1;
+    }
+    sqlite3_backup *backup = sqlite3_backup_init(target, "main", source, "main");
+    if (backup == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "无法开始备份到 '%s'：%s", partial_path, sqlite3_errmsg(target));
+        sqlite3_close(target);
+        return 1;
+    }
+
+    unsigned long long copied_before = 0;
+    app_mutex_lock(&backup_lock);
+    copied_before = backup_progress.copied_pages;
+    app_mutex_unlock(&backup_lock);
+
+    int rc;
+    do
+    {
+        uint64_t step_start = metrics_now_ns();
+        rc = sqlite3_backup_step(backup, pages_per_step);
+        uint64_t step_ns = metrics_now_ns() - step_start;
+
+        app_mutex_lock(&backup_lock);
+        backup_progress.steps++;
+        if (step_ns > backup_progress.max_step_ns)
+        {
+            backup_progress.max_step_ns = step_ns;
+        }
+        backup_progress.copied_pages = copied_before + (unsigned long long)(sqlite3_backup_pagecount(backup) - sqlite3_backup_remaining(backup));
+        app_mutex_unlock(&backup_lock);
+
+        // SQLITE_BUSY / SQLITE_LOCKED 时暂停一下再重试这一步
+        if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+        {
+            sleep_milliseconds(sleep_ms);
+        }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+
+    sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "备份到 '%s' 失败：%s", partial_path, sqlite3_errstr(rc));
+        sqlite3_close(target);
+        remove(partial_path);
+        return 1;
+    }
+    sqlite3_close(target);
+
+    // Windows 下 rename 不会覆盖已有文件
+    remove(target_path);
+    if (rename(partial_path, target_path) != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法把 '%s' 改名为 '%s'：%s", partial_path, target_path, strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 在线备份三个数据库
+ *
+ * @param target_dir 备份保存的文件夹，不存在时创建（只创建最后一级），其中同名的文件会被覆盖
+ * @param pages_per_step 每一步复制的页数，小于等于0时使用默认值 64
+ * @param sleep_ms 两步之间暂停的毫秒数，小于0时使用默认值 10
+ * @return int 成功返回0，否则返回1，已经有备份在进行时也返回1
+ *
+ * @details 备份分为两个阶段：
+ *          1. 取快照：按固定顺序对三个数据库各开启一个写事务（BEGIN IMMEDIATE），挡住所有写入者，
+ *             然后为每个数据库打开一个读连接并开启读事务，再立即回滚写事务。WAL 模式下读事务看到的是开启时的数据，
+ *             三个读事务都在写入被挡住期间开启，看到的是同一时刻的数据。写入者只被挡住这一瞬间，时长记录在 freeze_ns 中
+ *          2. 复制：用 sqlite3_backup_step 每次复制 pages_per_step 页，两步之间暂停 sleep_ms 毫秒。
+ *             源连接上的读事务一直保持到复制结束，期间的写入不会打断备份，也不会让备份重新开始；
+ *             代价是这段时间内 WAL 文件无法检查点回数据库，会一直增长到备份结束
+ *
+ *          共享缓存的内存数据库没有 WAL，读事务不能隔离其他连接的写入，备份仍然正确（SQLite 会把备份期间修改的页重新复制），
+ *          但不再是取快照那一刻的数据。
+ *          备份在调用者的线程中完成，耗时与数据库大小成正比，调用者通常应在后台线程中调用，通过 get_backup_progress 查看进度
+ */
+int backup_databases(const char *target_dir, int pages_per_step, int sleep_ms)
+{
+    if (target_dir == NULL || target_dir[0] == '\0')
+    {
+        log_message(LOGLEVEL_ERROR, "参数 target_dir 为空");
+        return 1;
+    }
+    if (pages_per_step <= 0)
+    {
+        pages_per_step = BACKUP_DEFAULT_PAGES_PER_STEP;
+    }
+    if (sleep_ms < 0)
+    {
+        sleep_ms = BACKUP_DEFAULT_SLEEP_MS;
+    }
+
+    app_mutex_lock(&backup_lock);
+    if (backup_progress.running)
+    {
+        app_mutex_unlock(&backup_lock);
+        log_message(LOGLEVEL_ERROR, "已经有备份正在进行，无法同时备份到 '%s'", target_dir);
+        return 1;
+    }
+    memset(&backup_progress, 0, sizeof(backup_progress));
+    backup_progress.running = 1;
+    backup_progress.result = -1;
+    backup_progress.database_count = 3;
+    backup_progress.started_at = (long long)time(NULL);
+    snprintf(backup_progress.target_dir, sizeof(backup_progress.target_dir), "%s", target_dir);
+    app_mutex_unlock(&backup_lock);
+
+    const char *paths[3] = {examination_db_path, scores_db_path, user_db_path};
+    const char *names[3] = {"examination.db", "score.db", "user.db"};
+    sqlite3 *writers[3] = {NULL, NULL, NULL};
+    sqlite3 *sources[3] = {NULL, NULL, NULL};
+    struct MetricsSnapshot *metrics_before = (struct MetricsSnapshot *)malloc(sizeof(struct MetricsSnapshot));
+    struct MetricsSnapshot *metrics_after = (struct MetricsSnapshot *)malloc(sizeof(struct MetricsSnapshot));
+    unsigned long long total_pages = 0;
+    int rc = metrics_before == NULL || metrics_after == NULL || get_metrics_snapshot(metrics_before) || make_folder(target_dir);
+
+    // 第一阶段：挡住写入者，在同一时刻为三个数据库开启读事务
+    uint64_t freeze_start = metrics_now_ns();
+    for (int i = 0; i < 3 && rc == 0; i++)
+    {
+        rc = open_database(paths[i], &writers[i]) || sqlite3_exec(writers[i], "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK;
+    }
+    for (int i = 0; i < 3 && rc == 0; i++)
+    {
+        sqlite3_stmt *stmt = NULL;
+        rc = open_database(paths[i], &sources[i]) ||
+             sqlite3_exec(sources[i], "BEGIN;", NULL, NULL, NULL) != SQLITE_OK ||
+             sqlite3_prepare_v2(sources[i], "PRAGMA page_count;", -1, &stmt, NULL) != SQLITE_OK ||
+             sqlite3_step(stmt) != SQLITE_ROW;
+        if (rc == 0)
+        {
+            total_pages += (unsigned long long)sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法为备份取得数据库快照");
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        if (writers[i] != NULL)
+        {
+            sqlite3_exec(writers[i], "ROLLBACK;", NULL, NULL, NULL);
+            sqlite3_close(writers[i]);
+        }
+    }
+    uint64_t freeze_ns = metrics_now_ns() - freeze_start;
+
+    app_mutex_lock(&backup_lock);
+    backup_progress.freeze_ns = freeze_ns;
+    backup_progress.total_pages = total_pages;
+    app_mutex_unlock(&backup_lock);
+
+    // 第二阶段：分批复制
+    for (int i = 0; i < 3 && rc == 0; i++)
+    {
+        char target_path[DB_PATH_MAX];
+        snprintf(target_path, sizeof(target_path), "%s/%s", target_dir, names[i]);
+        app_mutex_lock(&backup_lock);
+        backup_progress.current_database = i;
+        app_mutex_unlock(&backup_lock);
+        rc = backup_one_database(sources[i], target_path, pages_per_step, sleep_ms);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        if (sources[i] != NULL)
+        {
+            sqlite3_exec(sources[i], "COMMIT;", NULL, NULL, NULL);
+            sqlite3_close(sources[i]);
+        }
+    }
+
+    app_mutex_lock(&backup_lock);
+    if (metrics_before != NULL && metrics_after != NULL && get_metrics_snapshot(metrics_after) == 0)
+    {
+        summarize_writer_latency(NULL, metrics_before, &backup_progress.baseline_writer_calls,
+                                 &backup_progress.baseline_writer_mean_ns, &backup_progress.baseline_writer_p99_ns);
+        summarize_writer_latency(metrics_before, metrics_after, &backup_progress.writer_calls,
+                                 &backup_progress.writer_mean_ns, &backup_progress.writer_p99_ns);
+    }
+    backup_progress.running = 0;
+    backup_progress.result = rc != 0;
+    backup_progress.finished_at = (long long)time(NULL);
+    app_mutex_unlock(&backup_lock);
+    free(metrics_before);
+    free(metrics_after);
+
+    if (rc == 0)
+    {
+        log_message(LOGLEVEL_INFO, "数据库已备份到 '%s'，共 %llu 页，写入者被挡住 %llu 微秒", target_dir, total_pages,
+                    (unsigned long long)(freeze_ns / 1000));
+    }
+    return rc != 0;
+}
+
+/**
+ * @brief 获取最近一次备份的进度
+ *
+ * @param progress_to_return 返回的进度
+ * @return int 成功返回0，否则返回1
+ */
+int get_backup_progress(struct BackupProgress *progress_to_return)
+{
+    if (progress_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 progress_to_return 为 NULL");
+        return 1;
+    }
+    app_mutex_lock(&backup_lock);
+    *progress_to_return = backup_progress;
+    app_mutex_unlock(&backup_lock);
+    return 0;
+}
+
+/**************************** 在线备份部分结束 ****************************/
+
+/**************************** 班级统计部分开始 ****************************/
+
+// 把一名学生（?1）的全部成绩计入（SIGN 为空）或者移出（SIGN 为 -）他在 class_members 中所在的单元格
+#define CLASS_MEMBER_APPLY_CUBE(SIGN)                                                                                          \
+    "INSERT INTO class_cube (teacher_id, class_name, exam_id, count, sum, sumsq, pass_count)\n"                               \
+    "SELECT m.teacher_id, m.class_name, s.exam_id, " SIGN "count(*), " SIGN "sum(s.score), " SIGN "sum(s.score * s.score),\n" \
+    SIGN "sum(s.score >= " EXAM_STATS_PASS_SQL ") FROM scores AS s JOIN class_members AS m ON m.user_id = s.user_id\n"        \
+    "WHERE s.user_id = ?1 GROUP BY s.exam_id\n"                                                                               \
+    "ON CONFLICT (teacher_id, class_name, exam_id) DO UPDATE SET count = count + excluded.count, sum = sum + excluded.sum,\n" \
+    "sumsq = sumsq + excluded.sumsq, pass_count = pass_count + excluded.pass_count;"
+#define CLASS_MEMBER_APPLY_HISTOGRAM(SIGN)                                                                         \
+    "INSERT INTO class_cube_histogram (teacher_id, class_name, exam_id, score, count)\n"                          \
+    "SELECT m.teacher_id, m.class_name, s.exam_id, s.score, " SIGN "count(*) FROM scores AS s\n"                  \
+    "JOIN class_members AS m ON m.user_id = s.user_id WHERE s.user_id = ?1 GROUP BY s.exam_id, s.score\n"         \
+    "ON CONFLICT (teacher_id, class_name, exam_id, score) DO UPDATE SET count = count + excluded.count;"
+
+// 学生离开原来的班级：移出成绩、删除减到0的行，最后删除镜像中的记录
+static const char *const CLASS_MEMBER_LEAVE_SQL[] = {
+    CLASS_MEMBER_APPLY_CUBE("-"),
+    CLASS_MEMBER_APPLY_HISTOGRAM("-"),
+    "DELETE FROM class_cube WHERE count <= 0 AND (teacher_id, class_name) IN "
+    "(SELECT teacher_id, class_name FROM class_members WHERE user_id = ?1);",
+    "DELETE FROM class_cube_histogram WHERE count <= 0 AND (teacher_id, class_name) IN "
+    "(SELECT teacher_id, class_name FROM class_members WHERE user_id = ?1);",
+    "DELETE FROM class_members WHERE user_id = ?1;",
+};
+
+// 学生加入新的班级：写入镜像（?2 为教师ID，?3 为班级），再计入已有的成绩
+static const char *const CLASS_MEMBER_JOIN_SQL[] = {
+    "INSERT INTO class_members (user_id, teacher_id, class_name) VALUES (?1, ?2, ?3);",
+    CLASS_MEMBER_APPLY_CUBE(""),
+    CLASS_MEMBER_APPLY_HISTOGRAM(""),
+};
+
+/**
+ * @brief 依次执行一组语句，每条语句按需要绑定用户ID、教师ID和班级
+ *
+ * @return int 成功返回0，否则返回1
+ */
+static int run_class_member_statements(sqlite3 *db, const char *const *sqls, int count, const char *user_id, const char *teacher_id, const char *class_name)
+{
+    for (int i = 0; i < count; i++)
+    {
+        sqlite3_stmt *stmt = NULL;
+        if (sqlite3_prepare_v2(db, sqls[i], -1, &stmt, NULL) != SQLITE_OK)
+        {
+            return 1;
+        }
+        const char *values[] = {user_id, teacher_id, class_name};
+        for (int p = 1; p <= sqlite3_bind_parameter_count(stmt); p++)
+        {
+            sqlite3_bind_text(stmt, p, values[p - 1], -1, SQLITE_STATIC);
+        }
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 在 users 表写入之后，同步成绩数据库中学生所在的班级，并把他的成绩从原来的单元格移到新的单元格
+ *
+ * @param user_id 用户ID
+ * @param class_name 用户现在的班级，NULL 视为空字符串
+ * @param belong_to 用户现在归属的教师，NULL 或空字符串表示不是学生（或者已经被删除），从镜像中移除
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 在成绩数据库的一个 BEGIN IMMEDIATE 事务中完成，班级没有变化时什么都不做。
+ *          users 表和成绩数据库不在同一个事务中，同步失败时班级统计会与用户表不一致，
+ *          调用方只记录日志而不让用户的写入失败，可以调用 rebuild_class_cube 重新计算
+ */
+static int sync_class_member(const char *user_id, const char *class_name, const char *belong_to)
+{
+    const char *teacher_id = (belong_to != NULL && belong_to[0] != '\0') ? belong_to : NULL;
+    if (class_name == NULL)
+    {
+        class_name = "";
+    }
+
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
+    {
+        return 1;
+    }
+    int rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK;
+    int unchanged = 0;
+    int was_member = 0;
+    if (rc == 0)
+    {
+        rc = sqlite3_prepare_v2(db,
+                                "SELECT EXISTS (SELECT 1 FROM class_members WHERE user_id = ?1 AND teacher_id = ?2 AND class_name = ?3), "
+                                "EXISTS (SELECT 1 FROM class_members WHERE user_id = ?1);",
+                                -1, &stmt, NULL) != SQLITE_OK;
+        if (rc == 0)
+        {
+            sqlite3_bind_text(stmt, 1, user_id, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, teacher_id, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 3, class_name, -1, SQLITE_STATIC);
+            rc = sqlite3_step(stmt) != SQLITE_ROW;
+            unchanged = rc == 0 && sqlite3_column_int(stmt, 0);
+            was_member = rc == 0 && sqlite3_column_int(stmt, 1);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (rc == 0 && !unchanged && was_member)
+    {
+        rc = run_class_member_statements(db, CLASS_MEMBER_LEAVE_SQL, sizeof(CLASS_MEMBER_LEAVE_SQL) / sizeof(CLASS_MEMBER_LEAVE_SQL[0]),
+                                         user_id, teacher_id, class_name);
+    }
+    if (rc == 0 && !unchanged && teacher_id != NULL)
+    {
+        rc = run_class_member_statements(db, CLASS_MEMBER_JOIN_SQL, sizeof(CLASS_MEMBER_JOIN_SQL) / sizeof(CLASS_MEMBER_JOIN_SQL[0]),
+                                         user_id, teacher_id, class_name);
+    }
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "同步用户 '%s' 的班级失败：%s，班级统计可能与用户表不一致，可以调用 rebuild_class_cube 重新计算",
+                    user_id, sqlite3_errmsg(db));
+    }
+    rc |= sqlite3_exec(db, rc == 0 ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK;
+    sqlite3_close(db);
+    return rc;
+}
+
+/**
+ * @brief 查询一位教师各个班级在各场考试中的成绩汇总
+ *
+ * @param teacher_id 教师ID
+ * @param class_name 只查询这个班级，NULL 或空字符串表示所有班级
+ * @param exam_id 只查询这场考试，NULL 或空字符串表示所有考试
+ * @param with_histogram 非0时同时读取每个单元格的分数直方图，并由它得到最低分和最高分
+ * @param cells_to_return 返回的单元格数组，按班级、考试ID排序
+ * @param length 数组的大小，最多返回这么多个单元格
+ * @param count_to_return 返回实际的单元格数量
+ * @return int 成功返回0，否则返回1
+ *
+ * @details class_cube 以 (teacher_id, class_name, exam_id) 为主键，查询只读取这位教师的单元格，
+ *          耗时与单元格数量成正比，与成绩条数无关。直方图按单元格的主键逐个读取，每个单元格最多 101 行。
+ *          所有读取在同一个读事务中
+ */
+static int query_class_cube_impl(const char *teacher_id, const char *class_name, const char *exam_id, int with_histogram,
+                                 struct ClassCubeCell *cells_to_return, int length, int *count_to_return)
+{
+    if (teacher_id == NULL || cells_to_return == NULL || count_to_return == NULL || length < 0)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 teacher_id、cells_to_return 或 count_to_return 为 NULL，或者 length 小于0");
+        return 1;
+    }
+    *count_to_return = 0;
+    int filter_class = class_name != NULL && class_name[0] != '\0';
+    int filter_exam = exam_id != NULL && exam_id[0] != '\0';
+
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT class_name, exam_id, count, sum, sumsq, pass_count FROM class_cube WHERE teacher_id = ?1%s%s "
+                               "ORDER BY class_name, exam_id LIMIT ?4;",
+             filter_class ? " AND class_name = ?2" : "", filter_exam ? " AND exam_id = ?3" : "");
+
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
+        return 1;
+    }
+    int rc = sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK;
+
+    sqlite3_stmt *histogram_stmt = NULL;
+    if (rc == 0 && with_histogram)
+    {
+        rc = sqlite3_prepare_v2(db, "SELECT score, count FROM class_cube_histogram "
+                                    "WHERE teacher_id = ?1 AND class_name = ?2 AND exam_id = ?3 ORDER BY score;",
+                                -1, &histogram_stmt, NULL) != SQLITE_OK;
+    }
+
+    int count = 0;
+    if (rc == 0 && sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK)
+    {
+        sqlite3_bind_text(stmt, 1, teacher_id, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, class_name, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, exam_id, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, length);
+        int step = SQLITE_DONE;
+        while (rc == 0 && (step = sqlite3_step(stmt)) == SQLITE_ROW && count < length)
+        {
+            struct ClassCubeCell *cell = &cells_to_return[count++];
+            memset(cell, 0, sizeof(*cell));
+            snprintf(cell->class_name, sizeof(cell->class_name), "%s", (const char *)sqlite3_column_text(stmt, 0));
+            snprintf(cell->exam_id, sizeof(cell->exam_id), "%s", (const char *)sqlite3_column_text(stmt, 1));
+            cell->count = sqlite3_column_int64(stmt, 2);
+            cell->sum = sqlite3_column_int64(stmt, 3);
+            cell->sumsq = sqlite3_column_int64(stmt, 4);
+            cell->pass_count = sqlite3_column_int64(stmt, 5);
+            if (cell->count > 0)
+            {
+                double n = (double)cell->count;
+                cell->mean = (double)cell->sum / n;
+                double variance = (double)cell->sumsq / n - cell->mean * cell->mean;
+                cell->stddev = variance > 0 ? sqrt(variance) : 0;
+                cell->pass_rate = (double)cell->pass_count / n;
+            }
+            if (histogram_stmt != NULL)
+            {
+                // 用查询到的原始文本绑定，结构体中的班级名可能被截断
+                sqlite3_reset(histogram_stmt);
+                sqlite3_bind_text(histogram_stmt, 1, teacher_id, -1, SQLITE_STATIC);
+                sqlite3_bind_value(histogram_stmt, 2, sqlite3_column_value(stmt, 0));
+                sqlite3_bind_value(histogram_stmt, 3, sqlite3_column_value(stmt, 1));
+                int first = 1;
+                int histogram_step;
+                while ((histogram_step = sqlite3_step(histogram_stmt)) == SQLITE_ROW)
+                {
+                    int score = sqlite3_column_int(histogram_stmt, 0);
+                    if (first)
+                    {
+                        cell->min_score = score;
+                        first = 0;
+                    }
+                    cell->max_score = score;
+                    int bin = score < 0 ? 0 : (score >= EXAM_STATS_BIN_COUNT ? EXAM_STATS_BIN_COUNT - 1 : score);
+                    cell->histogram[bin] += sqlite3_column_int64(histogram_stmt, 1);
+                }
+                rc = histogram_step != SQLITE_DONE;
+            }
+        }
+        rc |= step != SQLITE_ROW && step != SQLITE_DONE;
+    }
+    else
+    {
+        rc = 1;
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_finalize(histogram_stmt);
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "查询教师 '%s' 的班级统计失败：%s", teacher_id, sqlite3_errmsg(db));
+    }
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    sqlite3_close(db);
+    *count_to_return = count;
+    metrics_record_rows(METRIC_QUERY_CLASS_CUBE, count, (size_t)count * sizeof(struct ClassCubeCell));
+    return rc;
+}
+
+int query_class_cube(const char *teacher_id, const char *class_name, const char *exam_id, int with_histogram,
+                     struct ClassCubeCell *cells_to_return, int length, int *count_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_class_cube_impl(teacher_id, class_name, exam_id, with_histogram, cells_to_return, length, count_to_return);
+    metrics_record_call(METRIC_QUERY_CLASS_CUBE, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 由用户表和 scores 表重新计算所有班级统计
+ *
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 用于绕过 database.c 直接修改了用户表（如批量导入学生），或者 sync_class_member 同步失败之后。
+ *          把用户数据库附加到成绩数据库上，成绩与学生只分组连接一次，在一个写事务中完成
+ */
+int rebuild_class_cube(void)
+{
+    return run_class_cube_rebuild(0);
+}
+
+/**************************** 班级统计部分结束 ****************************/
+
+/**
+ * @brief 查询某道题目当前所属的考试ID
+ *
+ * @param db 已经打开的 db/examination.db 连接
+ * @param question_id 题目ID
+ * @param exam_id_to_return 返回的考试ID，长度至少为37，查不到时为空字符串
+ *
+ * @details 修改或删除题目的时候调用方只知道题目ID，需要先查出题目原来所属的考试，才能使对应的考卷缓存失效
+ */
+static void query_question_exam_id(sqlite3 *db, const char *question_id, char *exam_id_to_return)
+{
+    sqlite3_stmt *stmt;
+    exam_id_to_return[0] = '\0';
+    if (sqlite3_prepare_v2(db, "SELECT exam_id FROM questions WHERE id = ?;", -1, &stmt, 0) != SQLITE_OK)
+    {
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, question_id, -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0))
+    {
+        strncpy(exam_id_to_return, (const char *)sqlite3_column_text(stmt, 0), 36);
+        exam_id_to_return[36] = '\0';
+    }
+    sqlite3_finalize(stmt);
+}
+
+/**************************** 单条数据查询开始 ****************************/
+
+/**
+ * @brief 将用户整行数据和权限复制到 User 结构体中
+ *
+ * @param user 用户整行数据
+ * @param permission 用户权限
+ * @param user_to_return 返回的User结构体
+ */
+static void copy_cached_user(const struct SqlResponseUser *user, const struct Permission *permission, struct User *user_to_return)
+{
+    memcpy(user_to_return->id, user->id, sizeof(user_to_return->id));
+    memcpy(user_to_return->username, user->username, sizeof(user_to_return->username));
+    user_to_return->role = user->role;
+    memcpy(user_to_return->name, user->name, sizeof(user_to_return->name));
+    memcpy(user_to_return->class_name, user->class_name, sizeof(user_to_return->class_name));
+    user_to_return->number = user->number;
+    memcpy(user_to_return->belong_to, user->belong_to, sizeof(user_to_return->belong_to));
+    user_to_return->permission = *permission;
+}
+
+/**
+ * @brief 从查询结果的当前行读取用户整行数据
+ *
+ * @param stmt 已经 step 到 SQLITE_ROW 的查询语句，列顺序为 id, username, hashpass, salt, role, name, class_name, number, belong_to
+ * @param user 返回的用户整行数据
+ * @return int 成功返回0，存在空字段返回1
+ */
+static int read_user_row(sqlite3_stmt *stmt, struct SqlResponseUser *user)
+{
+    const char *columns[9];
+    for (int i = 0; i < 9; i++)
+    {
+        columns[i] = (const char *)sqlite3_column_text(stmt, i);
+    }
+    if (!columns[0] || !columns[1] || !columns[2] || !columns[3] || !columns[5] || !columns[6] || !columns[8])
+    {
+        return 1;
+    }
+
+    memset(user, 0, sizeof(*user));
+    strncpy(user->id, columns[0], sizeof(user->id) - 1);
+    strncpy(user->username, columns[1], sizeof(user->username) - 1);
+    strncpy(user->hashpass, columns[2], sizeof(user->hashpass) - 1);
+    strncpy(user->salt, columns[3], sizeof(user->salt) - 1);
+    user->role = sqlite3_column_int(stmt, 4);
+    strncpy(user->name, columns[5], sizeof(user->name) - 1);
+    strncpy(user->class_name, columns[6], sizeof(user->class_name) - 1);
+    user->number = (unsigned int)sqlite3_column_int(stmt, 7);
+    strncpy(user->belong_to, columns[8], sizeof(user->belong_to) - 1);
+    return 0;
+}
+
+static int query_user_info_impl(const char *key, const char *content, struct User *user_to_return)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+    struct SqlResponseUser cached_user;
+    struct Permission cached_permission;
+
+    // 验证查询键是否合法
+    if (strcmp(key, "id") != 0 && strcmp(key, "number") != 0 && strcmp(key, "name") != 0 && strcmp(key, "username") != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
+        return 1;
+    }
+
+    // 按 id 查询时优先读取缓存
+    if (strcmp(key, "id") == 0 && user_cache_get(content, &cached_user, &cached_permission) == 0)
+    {
+        copy_cached_user(&cached_user, &cached_permission, user_to_return);
+        return 0;
+    }
+    unsigned long long cache_generation = user_cache_generation();
+
+    // 构建SQL语句
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT id, username, hashpass, salt, role, name, class_name, number, belong_to FROM users WHERE %s = ? LIMIT 1;", key);
+
+    // 打开数据库
+    if (open_database(user_db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", user_db_path);
+        return 1; // 打开数据库失败
+    }
+
+    // 准备查询语句
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 绑定查询参数
+    rc = sqlite3_bind_text(stmt, 1, content, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定查询内容参数失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 执行查询并获取结果
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW && read_user_row(stmt, &cached_user) == 0)
+    {
+        // 从查询结果中提取数据，hashpass和salt不在User结构体中使用，只保存在缓存里
+        memset(&cached_permission, 0, sizeof(cached_permission));
+        copy_cached_user(&cached_user, &cached_permission, user_to_return);
+
+        // 获取用户权限
+        user_to_return->permission = get_permission(*user_to_return);
+
+        // 写入缓存，后续按 id 的查询不再访问数据库
+        user_cache_put(&cached_user, &user_to_return->permission, cache_generation);
+
+        log_message(LOGLEVEL_INFO, "成功查询到用户信息，用户ID：%s", user_to_return->id);
+    }
+    else
+    {
+        // 没有查询到结果
+        log_message(LOGLEVEL_INFO, "没有找到符合条件的用户信息，条件：%s = %s", key, content);
+    }
+
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return 0;
+}
+
+/**
+ * @brief 按照特定标准查询数据库 db/user.db 中符合条件的用户信息（只返回第一条）
+ *
+ * @param key 查询标准列名，可选值为 "id", "number", "name", "username"
+ * @param content 查询内容，根据key进行匹配
+ * @param user_to_return 返回的User结构体
+ * @return int 执行成功返回0，否则返回1
+ */
+int query_user_info(const char *key, const char *content, struct User *user_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_user_info_impl(key, content, user_to_return);
+    metrics_record_call(METRIC_QUERY_USER_INFO, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 按照特定标准查询数据库 db/examination.db 中符合条件的考试条目（只返回第一条）
+ *
+ * @param key 查询的标准，合法的范围为 id(考试唯一标识符), name(考试名称)
+ * @param content 查询的内容，依据提供的查询标准，需要查询的内容需要填入content
+ * @param exam_to_return 查询结果返回的 SqlResponseExam 结构体类型变量
+ *
+ * @return int 函数执行成功与否，成功返回0，否则为1
+ */
+static int query_exam_info_impl(const char *key, const char *content, struct SqlResponseExam *exam_to_return)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+
+    // 验证查询键是否合法
+    if (strcmp(key, "id") != 0 && strcmp(key, "name") != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
+        return 1;
+    }
+
+    // 动态构建SQL语句
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT id, name, start_time, end_time, allow_answer_when_expired, random_question FROM examinations WHERE %s = ? LIMIT 1;", key);
+
+    // 打开数据库
+    if (open_database(examination_db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", examination_db_path);
+        return 1;
+    }
+
+    // 准备查询语句
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 绑定查询内容
+    rc = sqlite3_bind_text(stmt, 1, content, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定查询内容参数失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 执行查询并获取结果
+    rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW)
+    {
+        // 填充SqlResponseExam结构体
+        strncpy(exam_to_return->id, (const char *)sqlite3_column_text(stmt, 0), sizeof(exam_to_return->id) - 1);
+        strncpy(exam_to_return->name, (const char *)sqlite3_column_text(stmt, 1), sizeof(exam_to_return->name) - 1);
+        exam_to_return->start_time = sqlite3_column_int(stmt, 2);
+        exam_to_return->end_time = sqlite3_column_int(stmt, 3);
+        exam_to_return->allow_answer_when_expired = sqlite3_column_int(stmt, 4);
+        exam_to_return->random_question = sqlite3_column_int(stmt, 5);
+
+        log_message(LOGLEVEL_INFO, "成功查询到考试信息，考试ID：%s", exam_to_return->id);
+    }
+    else
+    {
+        log_message(LOGLEVEL_INFO, "没有找到符合条件的考试信息，条件：%s = %s", key, content);
+    }
+
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return 0;
+}
+
+int query_exam_info(const char *key, const char *content, struct SqlResponseExam *exam_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_exam_info_impl(key, content, exam_to_return);
+    metrics_record_call(METRIC_QUERY_EXAM_INFO, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 按照特定标准查询数据库 db/examination.db 中符合条件的题目信息（只返回第一条）
+ *
+ * @param key 查询的标准，合法的范围为 id(题目唯一标识符), exam_id(考试ID)
+ * @param content 查询的内容，依据提供的查询标准，需要查询的内容需要填入content
+ * @param question_to_return 查询结果返回的 SqlResponseQuestion 结构体类型变量
+ *
+ * @return int 函数执行成功与否，成功返回0，否则为1
+ */
+static int query_question_info_impl(const char *key, const char *content, struct SqlResponseQuestion *question_to_return)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+
+    // 验证查询键是否合法
+    if (strcmp(key, "id") != 0 && strcmp(key, "exam_id") != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "查询条件 %s 不合法！", key);
+        return 1;
+    }
+
+    // 动态构建SQL语句
+    char sql[256];
+    snprintf(sql, sizeof(sql), "SELECT id, exam_id, num1, op, num2 FROM questions WHERE %s = ? LIMIT 1;", key);
+
+    // 打开数据库
+    if (open_database(examination_db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", examination_db_path);
+        return 1;
+    }
+
+    // 准备查询语句
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
         log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
         sqlite3_close(db);
         return 1;
@@ -361,6 +2146,14 @@ int query_question_info(const char *key, const char *content, struct SqlResponse
     return 0;
 }
 
+int query_question_info(const char *key, const char *content, struct SqlResponseQuestion *question_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_question_info_impl(key, content, question_to_return);
+    metrics_record_call(METRIC_QUERY_QUESTION_INFO, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 根据用户传递的key和content查询成绩信息，并将结果存储到 SqlResponseScore 结构体中
  *
@@ -370,7 +2163,7 @@ int query_question_info(const char *key, const char *content, struct SqlResponse
  *
  * @return int 函数执行成功与否，成功返回0，否则为1
  */
-int query_score_info(const char *key, const char *content, struct SqlResponseScore *score_to_return)
+static int query_score_info_impl(const char *key, const char *content, struct SqlResponseScore *score_to_return)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
@@ -398,9 +2191,9 @@ int query_score_info(const char *key, const char *content, struct SqlResponseSco
     }
 
     // 打开数据库
-    if (open_database(SCORES_DB, &db))
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", SCORES_DB);
+        log_message(LOGLEVEL_ERROR, "打开数据库失败：%s", scores_db_path);
         return 1;
     }
 
@@ -450,6 +2243,14 @@ int query_score_info(const char *key, const char *content, struct SqlResponseSco
     return 0;
 }
 
+int query_score_info(const char *key, const char *content, struct SqlResponseScore *score_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_score_info_impl(key, content, score_to_return);
+    metrics_record_call(METRIC_QUERY_SCORE_INFO, start, rc != 0);
+    return rc;
+}
+
 /**************************** 单条数据查询结束 ****************************/
 
 /**************************** 多条数据查询开始 ****************************/
@@ -464,7 +2265,7 @@ int query_score_info(const char *key, const char *content, struct SqlResponseSco
  *
  * @return int 函数执行成功与否，成功返回0，否则为1
  */
-int query_exams_info_all(struct SqlResponseExam *exams_to_return, int length, const char *key, const char *content)
+static int query_exams_info_all_impl(struct SqlResponseExam *exams_to_return, int length, const char *key, const char *content)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
@@ -494,7 +2295,7 @@ int query_exams_info_all(struct SqlResponseExam *exams_to_return, int length, co
     }
 
     // 打开数据库
-    if (open_database(EXAMINATION_DB, &db))
+    if (open_database(examination_db_path, &db))
     {
         return 1;
     }
@@ -564,19 +2365,33 @@ int query_exams_info_all(struct SqlResponseExam *exams_to_return, int length, co
         log_message(LOGLEVEL_INFO, "没有找到任何考试信息");
     }
 
+    metrics_record_rows(METRIC_QUERY_EXAMS_INFO_ALL, count, (size_t)count * sizeof(struct SqlResponseExam));
+
     // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
     return 0;
 }
 
-int query_users_info_all(struct SqlResponseUser *users_to_return, int length, const char *key, const char *content)
+int query_exams_info_all(struct SqlResponseExam *exams_to_return, int length, const char *key, const char *content)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_exams_info_all_impl(exams_to_return, length, key, content);
+    metrics_record_call(METRIC_QUERY_EXAMS_INFO_ALL, start, rc != 0);
+    return rc;
+}
+
+static int query_users_info_all_impl(struct SqlResponseUser *users_to_return, int length, const char *key, const char *content)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
     int count = 0;
     char sql[512];
+    const char *db_path = reporting_path(user_db_path);
+    // 读取报表副本时不使用用户缓存，副本中的数据可能比缓存旧
+    int by_id = key && strcmp(key, "id") == 0 && content && strlen(content) > 0 && db_path == user_db_path;
+    unsigned long long cache_generation = 0;
 
     // 构建SQL语句
     if (key && strlen(key) > 0 && content && strlen(content) > 0)
@@ -593,22 +2408,33 @@ int query_users_info_all(struct SqlResponseUser *users_to_return, int length, co
                  "SELECT id, username, hashpass, salt, role, name, class_name, number, belong_to FROM users LIMIT ?;");
     }
 
+    // 初始化传入的 users_to_return，避免返回出错
+    for (int i = 0; i < length; i++)
+    {
+        strcpy(users_to_return[i].id, "");
+    }
+
+    // 按 id 查询最多只有一条结果，优先读取缓存
+    if (by_id && length > 0)
+    {
+        if (user_cache_get(content, &users_to_return[0], NULL) == 0)
+        {
+            metrics_record_rows(METRIC_QUERY_USERS_INFO_ALL, 1, sizeof(struct SqlResponseUser));
+            return 0;
+        }
+        cache_generation = user_cache_generation();
+    }
+
     // 打开数据库
-    if (open_database(USER_DB, &db))
+    if (open_database(db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 %s", USER_DB);
+        log_message(LOGLEVEL_ERROR, "无法打开数据库 %s", db_path);
         return 1; // 打开数据库失败
     }
 
     // 启用外键支持
     sqlite3_exec(db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
 
-    // 初始化传入的 users_to_return，避免返回出错
-    for (int i = 0; i < length; i++)
-    {
-        strcpy(users_to_return[i].id, "");
-    }
-
     // 准备查询语句
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
@@ -696,6 +2522,16 @@ int query_users_info_all(struct SqlResponseUser *users_to_return, int length, co
                         users_to_return[count].number,
                         users_to_return[count].belong_to);
 
+            // 写入缓存
+            if (by_id)
+            {
+                struct User user;
+                memset(&user, 0, sizeof(user));
+                copy_cached_user(&users_to_return[count], &user.permission, &user);
+                user.permission = get_permission(user);
+                user_cache_put(&users_to_return[count], &user.permission, cache_generation);
+            }
+
             count++;
         }
         else
@@ -713,12 +2549,22 @@ int query_users_info_all(struct SqlResponseUser *users_to_return, int length, co
         log_message(LOGLEVEL_INFO, "没有找到任何用户信息");
     }
 
+    metrics_record_rows(METRIC_QUERY_USERS_INFO_ALL, count, (size_t)count * sizeof(struct SqlResponseUser));
+
     // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
     return 0; // 执行成功
 }
 
+int query_users_info_all(struct SqlResponseUser *users_to_return, int length, const char *key, const char *content)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_users_info_all_impl(users_to_return, length, key, content);
+    metrics_record_call(METRIC_QUERY_USERS_INFO_ALL, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 查询数据库 db/examination.db 中所有问题信息（返回多条数据），可按指定键和值进行过滤
  *
@@ -729,7 +2575,7 @@ int query_users_info_all(struct SqlResponseUser *users_to_return, int length, co
  *
  * @return int 函数执行成功与否，成功返回0，否则为1
  */
-int query_questions_info_all(struct SqlResponseQuestion *questions_to_return, int length, const char *key, const char *content)
+static int query_questions_info_all_impl(struct SqlResponseQuestion *questions_to_return, int length, const char *key, const char *content)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
@@ -753,7 +2599,7 @@ int query_questions_info_all(struct SqlResponseQuestion *questions_to_return, in
     }
 
     // 打开数据库
-    if (open_database(EXAMINATION_DB, &db))
+    if (open_database(examination_db_path, &db))
     {
         return 1;
     }
@@ -825,12 +2671,22 @@ int query_questions_info_all(struct SqlResponseQuestion *questions_to_return, in
         log_message(LOGLEVEL_INFO, "没有找到任何问题信息");
     }
 
+    metrics_record_rows(METRIC_QUERY_QUESTIONS_INFO_ALL, count, (size_t)count * sizeof(struct SqlResponseQuestion));
+
     // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
     return 0;
 }
 
+int query_questions_info_all(struct SqlResponseQuestion *questions_to_return, int length, const char *key, const char *content)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_questions_info_all_impl(questions_to_return, length, key, content);
+    metrics_record_call(METRIC_QUERY_QUESTIONS_INFO_ALL, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 查询数据库 db/scores.db 中所有成绩信息（返回多条数据），可按指定键和值进行过滤
  *
@@ -841,7 +2697,7 @@ int query_questions_info_all(struct SqlResponseQuestion *questions_to_return, in
  *
  * @return int 函数执行成功与否，成功返回0，否则为1
  */
-int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length, const char *key, const char *content)
+static int query_scores_info_all_impl(struct SqlResponseScore *scores_to_return, int length, const char *key, const char *content)
 {
     sqlite3 *db = NULL;
     sqlite3_stmt *stmt = NULL;
@@ -873,44 +2729,343 @@ int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length,
     }
 
     // 构建SQL语句
-    if (is_valid_key && content && strlen(content) > 0)
+    if (is_valid_key && content && strlen(content) > 0)
+    {
+        // 使用 WHERE 子句进行过滤
+        snprintf(sql, sizeof(sql),
+                 "SELECT id, exam_id, user_id, score, expired_flag FROM scores WHERE %s = ? LIMIT ?;",
+                 key);
+    }
+    else
+    {
+        // 无条件查询
+        snprintf(sql, sizeof(sql),
+                 "SELECT id, exam_id, user_id, score, expired_flag FROM scores LIMIT ?;");
+    }
+
+    // 打开数据库，开启 set_reporting_reads 时读取报表副本
+    const char *db_path = reporting_path(scores_db_path);
+    if (open_database(db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", db_path);
+        return 1;
+    }
+
+    // 启用外键支持
+    rc = sqlite3_exec(db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "启用外键支持失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 初始化传入的 scores_to_return，避免返回出错
+    for (int i = 0; i < length; i++)
+    {
+        strcpy(scores_to_return[i].id, "");
+        strcpy(scores_to_return[i].exam_id, "");
+        strcpy(scores_to_return[i].user_id, "");
+        scores_to_return[i].score = 0.0f;
+        scores_to_return[i].expired_flag = 0;
+    }
+
+    // 准备查询语句
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 绑定参数
+    int param_index = 1;
+    if (is_valid_key && content && strlen(content) > 0)
+    {
+        // 根据 key 的数据类型选择绑定函数
+        if (strcmp(key, "score") == 0)
+        {
+            // 假设 content 是浮点数
+            float float_content = atof(content);
+            rc = sqlite3_bind_double(stmt, param_index++, (double)float_content);
+        }
+        else if (strcmp(key, "expired_flag") == 0)
+        {
+            // 假设 expired_flag 是整数
+            int int_content = atoi(content);
+            rc = sqlite3_bind_int(stmt, param_index++, int_content);
+        }
+        else
+        {
+            // 其他字段作为字符串处理
+            rc = sqlite3_bind_text(stmt, param_index++, content, -1, SQLITE_STATIC);
+        }
+
+        if (rc != SQLITE_OK)
+        {
+            log_message(LOGLEVEL_ERROR, "绑定 content 参数失败：%s", sqlite3_errmsg(db));
+            sqlite3_finalize(stmt);
+            sqlite3_close(db);
+            return 1;
+        }
+    }
+
+    // 绑定 LIMIT 参数
+    rc = sqlite3_bind_int(stmt, param_index, length);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定 LIMIT 参数失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 执行查询并填充结果
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW && count < length)
+    {
+        // 提取查询结果并确保字符串正确终止
+        const unsigned char *id_text = sqlite3_column_text(stmt, 0);
+        const unsigned char *exam_id_text = sqlite3_column_text(stmt, 1);
+        const unsigned char *user_id_text = sqlite3_column_text(stmt, 2);
+
+        if (id_text && exam_id_text && user_id_text)
+        {
+            strncpy(scores_to_return[count].id, (const char *)id_text, sizeof(scores_to_return[count].id) - 1);
+            scores_to_return[count].id[sizeof(scores_to_return[count].id) - 1] = '\0'; // 确保字符串终止
+
+            strncpy(scores_to_return[count].exam_id, (const char *)exam_id_text, sizeof(scores_to_return[count].exam_id) - 1);
+            scores_to_return[count].exam_id[sizeof(scores_to_return[count].exam_id) - 1] = '\0'; // 确保字符串终止
+
+            strncpy(scores_to_return[count].user_id, (const char *)user_id_text, sizeof(scores_to_return[count].user_id) - 1);
+            scores_to_return[count].user_id[sizeof(scores_to_return[count].user_id) - 1] = '\0'; // 确保字符串终止
+
+            scores_to_return[count].score = (float)sqlite3_column_double(stmt, 3);
+            scores_to_return[count].expired_flag = sqlite3_column_int(stmt, 4);
+            count++;
+        }
+    }
+
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+    {
+        log_message(LOGLEVEL_ERROR, "执行查询失败：%s", sqlite3_errmsg(db));
+    }
+
+    if (count > 0)
+    {
+        log_message(LOGLEVEL_INFO, "成功查询到 %d 条成绩信息", count);
+    }
+    else
+    {
+        log_message(LOGLEVEL_INFO, "没有找到任何成绩信息");
+    }
+
+    metrics_record_rows(METRIC_QUERY_SCORES_INFO_ALL, count, (size_t)count * sizeof(struct SqlResponseScore));
+
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return 0;
+}
+
+int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length, const char *key, const char *content)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_scores_info_all_impl(scores_to_return, length, key, content);
+    metrics_record_call(METRIC_QUERY_SCORES_INFO_ALL, start, rc != 0);
+    return rc;
+}
+/**************************** 多条数据查询结束 ****************************/
+
+/**************************** 列式查询开始 ****************************/
+
+#define COLUMNAR_INITIAL_ROWS 64      // 列式查询结果初始可以容纳的行数
+#define COLUMNAR_INITIAL_STRINGS 4096 // 列式查询结果字符串区的初始大小
+
+void free_columnar_result(struct ColumnarResult *result)
+{
+    if (result == NULL)
+    {
+        return;
+    }
+    for (int c = 0; c < COLUMNAR_MAX_INT_COLUMNS; c++)
+    {
+        free(result->int_columns[c]);
+    }
+    free(result->text_offsets);
+    free(result->strings);
+    free(result);
+}
+
+/**
+ * @brief 保证列式查询结果至少可以容纳 rows 行，不够时扩大一倍
+ *
+ * @param result 列式查询结果
+ * @param rows 需要容纳的行数
+ * @return int 成功返回0，否则返回1
+ */
+static int columnar_reserve_rows(struct ColumnarResult *result, int rows)
+{
+    if (rows <= result->capacity)
+    {
+        return 0;
+    }
+    int capacity = result->capacity ? result->capacity * 2 : COLUMNAR_INITIAL_ROWS;
+    while (capacity < rows)
+    {
+        capacity *= 2;
+    }
+    for (int c = 0; c < result->int_column_count; c++)
+    {
+        int32_t *column = realloc(result->int_columns[c], sizeof(int32_t) * capacity);
+        if (column == NULL)
+        {
+            return 1;
+        }
+        result->int_columns[c] = column;
+    }
+    int32_t *offsets = realloc(result->text_offsets, sizeof(int32_t) * ((size_t)capacity * result->text_column_count + 1));
+    if (offsets == NULL)
+    {
+        return 1;
+    }
+    result->text_offsets = offsets;
+    result->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief 向列式查询结果的字符串区追加一个文本字段
+ *
+ * @param result 列式查询结果
+ * @param text 文本，可以为 NULL（按空字符串处理），字符串区还没有分配时会先分配
+ * @param length 文本的字节数
+ * @return int 成功返回0，否则返回1
+ */
+static int columnar_append_text(struct ColumnarResult *result, const unsigned char *text, int length)
+{
+    if (result->strings == NULL || result->strings_length + length > result->strings_capacity)
+    {
+        int capacity = result->strings_capacity ? result->strings_capacity : COLUMNAR_INITIAL_STRINGS;
+        while (result->strings_length + length > capacity)
+        {
+            capacity *= 2;
+        }
+        char *strings = realloc(result->strings, capacity);
+        if (strings == NULL)
+        {
+            return 1;
+        }
+        result->strings = strings;
+        result->strings_capacity = capacity;
+    }
+    if (length > 0)
+    {
+        memcpy(result->strings + result->strings_length, text, length);
+        result->strings_length += length;
+    }
+    return 0;
+}
+
+/**
+ * @brief 执行列式查询的通用函数，查询的列必须先列出所有文本列，再列出所有整数列
+ *
+ * @param db_path 数据库路径
+ * @param table 表名
+ * @param columns 查询的列，以逗号分隔
+ * @param text_column_count 文本列数量
+ * @param int_column_count 整数列数量
+ * @param allowed_keys 允许的过滤键，以防止 SQL 注入
+ * @param num_allowed_keys 允许的过滤键数量
+ * @param int_keys 需要按整数绑定的过滤键
+ * @param num_int_keys 需要按整数绑定的过滤键数量
+ * @param length 查询结果的限制数量
+ * @param key 可选的过滤键，如果为 NULL 或空字符串，则不进行过滤
+ * @param content 可选的过滤值，与 key 对应
+ * @param result_to_return 返回新分配的列式查询结果，由调用方使用 free_columnar_result 释放
+ * @param metric 记录返回行数和字节数时使用的统计项
+ * @return int 成功返回0，否则返回1
+ */
+static int query_columnar(const char *db_path, const char *table, const char *columns, int text_column_count, int int_column_count,
+                          const char *const *allowed_keys, int num_allowed_keys, const char *const *int_keys, int num_int_keys,
+                          int length, const char *key, const char *content, struct ColumnarResult **result_to_return,
+                          enum MetricFunction metric)
+{
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    char sql[512];
+    int rc;
+    int filtered = key && strlen(key) > 0 && content && strlen(content) > 0;
+    int int_key = 0;
+
+    if (result_to_return == NULL || length < 0)
+    {
+        log_message(LOGLEVEL_ERROR, "列式查询的参数不合法");
+        return 1;
+    }
+    *result_to_return = NULL;
+
+    // 验证 key 是否为允许的列名
+    if (key && strlen(key) > 0)
+    {
+        int is_valid_key = 0;
+        for (int i = 0; i < num_allowed_keys; i++)
+        {
+            if (strcmp(key, allowed_keys[i]) == 0)
+            {
+                is_valid_key = 1;
+                break;
+            }
+        }
+        if (!is_valid_key)
+        {
+            log_message(LOGLEVEL_ERROR, "无效的查询键：%s", key);
+            return 1;
+        }
+        for (int i = 0; i < num_int_keys; i++)
+        {
+            if (strcmp(key, int_keys[i]) == 0)
+            {
+                int_key = 1;
+                break;
+            }
+        }
+    }
+
+    // 构建SQL语句
+    if (filtered)
     {
-        // 使用 WHERE 子句进行过滤
-        snprintf(sql, sizeof(sql),
-                 "SELECT id, exam_id, user_id, score, expired_flag FROM scores WHERE %s = ? LIMIT ?;",
-                 key);
+        snprintf(sql, sizeof(sql), "SELECT %s FROM %s WHERE %s = ? LIMIT ?;", columns, table, key);
     }
     else
     {
-        // 无条件查询
-        snprintf(sql, sizeof(sql),
-                 "SELECT id, exam_id, user_id, score, expired_flag FROM scores LIMIT ?;");
+        snprintf(sql, sizeof(sql), "SELECT %s FROM %s LIMIT ?;", columns, table);
     }
 
-    // 打开数据库
-    if (open_database(SCORES_DB, &db))
+    struct ColumnarResult *result = calloc(1, sizeof(struct ColumnarResult));
+    if (result == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", SCORES_DB);
+        log_message(LOGLEVEL_ERROR, "为列式查询结果分配内存失败");
         return 1;
     }
-
-    // 启用外键支持
-    rc = sqlite3_exec(db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
-    if (rc != SQLITE_OK)
+    result->text_column_count = text_column_count;
+    result->int_column_count = int_column_count;
+    // 即使 length 为0也要分配 text_offsets，第一个偏移量总是需要写入
+    if (columnar_reserve_rows(result, COLUMNAR_INITIAL_ROWS) ||
+        columnar_append_text(result, NULL, 0))
     {
-        log_message(LOGLEVEL_ERROR, "启用外键支持失败：%s", sqlite3_errmsg(db));
-        sqlite3_close(db);
+        log_message(LOGLEVEL_ERROR, "为列式查询结果分配内存失败");
+        free_columnar_result(result);
         return 1;
     }
+    result->text_offsets[0] = 0;
 
-    // 初始化传入的 scores_to_return，避免返回出错
-    for (int i = 0; i < length; i++)
+    // 打开数据库
+    if (open_database(db_path, &db))
     {
-        strcpy(scores_to_return[i].id, "");
-        strcpy(scores_to_return[i].exam_id, "");
-        strcpy(scores_to_return[i].user_id, "");
-        scores_to_return[i].score = 0.0f;
-        scores_to_return[i].expired_flag = 0;
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", db_path);
+        free_columnar_result(result);
+        return 1;
     }
 
     // 准备查询语句
@@ -918,97 +3073,117 @@ int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length,
     if (rc != SQLITE_OK)
     {
         log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return 1;
+        goto fail;
     }
 
     // 绑定参数
     int param_index = 1;
-    if (is_valid_key && content && strlen(content) > 0)
+    if (filtered)
     {
-        // 根据 key 的数据类型选择绑定函数
-        if (strcmp(key, "score") == 0)
-        {
-            // 假设 content 是浮点数
-            float float_content = atof(content);
-            rc = sqlite3_bind_double(stmt, param_index++, (double)float_content);
-        }
-        else if (strcmp(key, "expired_flag") == 0)
+        if (int_key)
         {
-            // 假设 expired_flag 是整数
-            int int_content = atoi(content);
-            rc = sqlite3_bind_int(stmt, param_index++, int_content);
+            rc = sqlite3_bind_int64(stmt, param_index++, atoll(content));
         }
         else
         {
-            // 其他字段作为字符串处理
             rc = sqlite3_bind_text(stmt, param_index++, content, -1, SQLITE_STATIC);
         }
-
         if (rc != SQLITE_OK)
         {
             log_message(LOGLEVEL_ERROR, "绑定 content 参数失败：%s", sqlite3_errmsg(db));
-            sqlite3_finalize(stmt);
-            sqlite3_close(db);
-            return 1;
+            goto fail;
         }
     }
-
-    // 绑定 LIMIT 参数
     rc = sqlite3_bind_int(stmt, param_index, length);
     if (rc != SQLITE_OK)
     {
         log_message(LOGLEVEL_ERROR, "绑定 LIMIT 参数失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return 1;
+        goto fail;
     }
 
-    // 执行查询并填充结果
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW && count < length)
+    // 执行查询，逐行追加到各列的末尾
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        // 提取查询结果并确保字符串正确终止
-        const unsigned char *id_text = sqlite3_column_text(stmt, 0);
-        const unsigned char *exam_id_text = sqlite3_column_text(stmt, 1);
-        const unsigned char *user_id_text = sqlite3_column_text(stmt, 2);
-
-        if (id_text && exam_id_text && user_id_text)
+        if (columnar_reserve_rows(result, result->count + 1))
         {
-            strncpy(scores_to_return[count].id, (const char *)id_text, sizeof(scores_to_return[count].id) - 1);
-            scores_to_return[count].id[sizeof(scores_to_return[count].id) - 1] = '\0'; // 确保字符串终止
-
-            strncpy(scores_to_return[count].exam_id, (const char *)exam_id_text, sizeof(scores_to_return[count].exam_id) - 1);
-            scores_to_return[count].exam_id[sizeof(scores_to_return[count].exam_id) - 1] = '\0'; // 确保字符串终止
-
-            strncpy(scores_to_return[count].user_id, (const char *)user_id_text, sizeof(scores_to_return[count].user_id) - 1);
-            scores_to_return[count].user_id[sizeof(scores_to_return[count].user_id) - 1] = '\0'; // 确保字符串终止
-
-            scores_to_return[count].score = (float)sqlite3_column_double(stmt, 3);
-            scores_to_return[count].expired_flag = sqlite3_column_int(stmt, 4);
-            count++;
+            log_message(LOGLEVEL_ERROR, "为列式查询结果分配内存失败");
+            goto fail;
+        }
+        int32_t *offsets = result->text_offsets + (size_t)result->count * text_column_count;
+        for (int j = 0; j < text_column_count; j++)
+        {
+            const unsigned char *text = sqlite3_column_text(stmt, j);
+            if (columnar_append_text(result, text, sqlite3_column_bytes(stmt, j)))
+            {
+                log_message(LOGLEVEL_ERROR, "为列式查询结果分配内存失败");
+                goto fail;
+            }
+            offsets[j + 1] = result->strings_length;
+        }
+        for (int c = 0; c < int_column_count; c++)
+        {
+            result->int_columns[c][result->count] = (int32_t)sqlite3_column_int64(stmt, text_column_count + c);
         }
+        result->count++;
     }
-
-    if (rc != SQLITE_DONE && rc != SQLITE_ROW)
+    if (rc != SQLITE_DONE)
     {
         log_message(LOGLEVEL_ERROR, "执行查询失败：%s", sqlite3_errmsg(db));
+        goto fail;
     }
 
-    if (count > 0)
-    {
-        log_message(LOGLEVEL_INFO, "成功查询到 %d 条成绩信息", count);
-    }
-    else
-    {
-        log_message(LOGLEVEL_INFO, "没有找到任何成绩信息");
-    }
-
-    // 清理和关闭数据库
+    log_message(LOGLEVEL_INFO, "列式查询 %s 得到 %d 条记录", table, result->count);
+    metrics_record_rows(metric, result->count,
+                        (size_t)result->strings_length + sizeof(int32_t) * ((size_t)result->count * (text_column_count + int_column_count) + 1));
     sqlite3_finalize(stmt);
     sqlite3_close(db);
+    *result_to_return = result;
     return 0;
+
+fail:
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    free_columnar_result(result);
+    return 1;
 }
-/**************************** 多条数据查询结束 ****************************/
+
+static int query_scores_columnar_impl(int length, const char *key, const char *content, struct ColumnarResult **result_to_return)
+{
+    static const char *const allowed_keys[] = {"id", "exam_id", "user_id", "score", "expired_flag"};
+    static const char *const int_keys[] = {"score", "expired_flag"};
+    return query_columnar(reporting_path(scores_db_path), "scores", "id, exam_id, user_id, score, expired_flag", 3, 2,
+                          allowed_keys, sizeof(allowed_keys) / sizeof(allowed_keys[0]),
+                          int_keys, sizeof(int_keys) / sizeof(int_keys[0]),
+                          length, key, content, result_to_return, METRIC_QUERY_SCORES_COLUMNAR);
+}
+
+int query_scores_columnar(int length, const char *key, const char *content, struct ColumnarResult **result_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_scores_columnar_impl(length, key, content, result_to_return);
+    metrics_record_call(METRIC_QUERY_SCORES_COLUMNAR, start, rc != 0);
+    return rc;
+}
+
+static int query_users_columnar_impl(int length, const char *key, const char *content, struct ColumnarResult **result_to_return)
+{
+    static const char *const allowed_keys[] = {"id", "username", "role", "name", "class_name", "number", "belong_to"};
+    static const char *const int_keys[] = {"role", "number"};
+    return query_columnar(reporting_path(user_db_path), "users", "id, username, hashpass, salt, name, class_name, belong_to, role, number", 7, 2,
+                          allowed_keys, sizeof(allowed_keys) / sizeof(allowed_keys[0]),
+                          int_keys, sizeof(int_keys) / sizeof(int_keys[0]),
+                          length, key, content, result_to_return, METRIC_QUERY_USERS_COLUMNAR);
+}
+
+int query_users_columnar(int length, const char *key, const char *content, struct ColumnarResult **result_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_users_columnar_impl(length, key, content, result_to_return);
+    metrics_record_call(METRIC_QUERY_USERS_COLUMNAR, start, rc != 0);
+    return rc;
+}
+
+/**************************** 列式查询结束 ****************************/
 
 /**************************** 单条数据插入开始 ****************************/
 
@@ -1022,18 +3197,15 @@ int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length,
  * @param num_bindings 绑定参数的数量
  * @return int 成功返回0，否则返回1
  */
-int insert_data_to_db(const char *db_path, const char *sql, const void **bindings, const BindType *types, int num_bindings)
+static int insert_data_to_db_impl(const char *db_path, const char *sql, const void **bindings, const BindType *types, int num_bindings)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
 
     // 打开数据库
-    rc = sqlite3_open(db_path, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", db_path, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
@@ -1081,7 +3253,7 @@ int insert_data_to_db(const char *db_path, const char *sql, const void **binding
     }
 
     // 执行SQL语句
-    rc = sqlite3_step(stmt);
+    rc = step_with_retry(db, stmt);
     if (rc != SQLITE_DONE)
     {
         log_message(LOGLEVEL_ERROR, "执行插入操作失败：%s", sqlite3_errmsg(db));
@@ -1100,6 +3272,14 @@ int insert_data_to_db(const char *db_path, const char *sql, const void **binding
     return 0;
 }
 
+int insert_data_to_db(const char *db_path, const char *sql, const void **bindings, const BindType *types, int num_bindings)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_data_to_db_impl(db_path, sql, bindings, types, num_bindings);
+    metrics_record_call(METRIC_INSERT_DATA_TO_DB, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 向考试表中插入新的考试数据
  *
@@ -1111,7 +3291,7 @@ int insert_data_to_db(const char *db_path, const char *sql, const void **binding
  * @param random_question 是否开启随机问题顺序，0表示关闭，1表示开启
  * @return int 函数是否成功执行，成功返回0，否则返回1
  */
-int insert_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
+static int insert_exam_data_impl(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
 {
     char current_time[20];
     const char *sql = "INSERT INTO examinations (id, name, start_time, end_time, allow_answer_when_expired, random_question) VALUES (?, ?, ?, ?, ?, ?);";
@@ -1135,11 +3315,19 @@ int insert_exam_data(const char *exam_id, const char *name, int start_time, int
     const BindType types[] = {BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_INT, BIND_TYPE_INT, BIND_TYPE_INT, BIND_TYPE_INT};
 
     // 调用通用插入函数
-    int result = insert_data_to_db(EXAMINATION_DB, sql, bindings, types, 6);
+    int result = insert_data_to_db(examination_db_path, sql, bindings, types, 6);
 
     return result;
 }
 
+int insert_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_exam_data_impl(exam_id, name, start_time, end_time, allow_answer_when_expired, random_question);
+    metrics_record_call(METRIC_INSERT_EXAM_DATA, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 向考试数据库的 questions 表插入新的问题
  *
@@ -1150,7 +3338,7 @@ int insert_exam_data(const char *exam_id, const char *name, int start_time, int
  * @param num2 第二个操作数
  * @return int 函数是否成功执行，成功返回0，否则返回1
  */
-int insert_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2)
+static int insert_question_data_impl(const char *question_id, const char *exam_id, int num1, int op, int num2)
 {
     char current_time[20];
     const char *sql = "INSERT INTO questions (id, exam_id, num1, op, num2) VALUES (?, ?, ?, ?, ?);";
@@ -1168,11 +3356,20 @@ int insert_question_data(const char *question_id, const char *exam_id, int num1,
     const BindType types[] = {BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_INT, BIND_TYPE_INT, BIND_TYPE_INT};
 
     // 调用通用插入函数
-    int result = insert_data_to_db(EXAMINATION_DB, sql, bindings, types, 5);
+    int result = insert_data_to_db(examination_db_path, sql, bindings, types, 5);
+    exam_cache_invalidate(exam_id); // 考卷新增了题目
 
     return result;
 }
 
+int insert_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_question_data_impl(question_id, exam_id, num1, op, num2);
+    metrics_record_call(METRIC_INSERT_QUESTION_DATA, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 向成绩数据库的 scores 表插入新的成绩
  *
@@ -1183,7 +3380,7 @@ int insert_question_data(const char *question_id, const char *exam_id, int num1,
  * @param expired_flag 逾期作答标记，只有0和1合法
  * @return int 函数是否成功执行，成功返回0，否则返回1
  */
-int insert_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
+static int insert_score_data_impl(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
 {
     char current_time[20];
     const char *sql = "INSERT INTO scores (id, exam_id, user_id, score, expired_flag) VALUES (?, ?, ?, ?, ?);";
@@ -1201,7 +3398,7 @@ int insert_score_data(const char *score_id, const char *exam_id, const char *use
     const BindType types[] = {BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_INT, BIND_TYPE_INT};
 
     // 调用通用插入函数
-    int result = insert_data_to_db(SCORES_DB, sql, bindings, types, 5);
+    int result = insert_data_to_db(scores_db_path, sql, bindings, types, 5);
     if (result == 0)
     {
         log_message(LOGLEVEL_INFO, "成功插入了用户ID为 %s 的成绩 %d", user_id, score);
@@ -1210,6 +3407,14 @@ int insert_score_data(const char *score_id, const char *exam_id, const char *use
     return result;
 }
 
+int insert_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_score_data_impl(score_id, exam_id, user_id, score, expired_flag);
+    metrics_record_call(METRIC_INSERT_SCORE_DATA, start, rc != 0);
+    return rc;
+}
+
 /**
  * @brief 向用户数据库的 users 表插入新的用户
  *
@@ -1224,7 +3429,7 @@ int insert_score_data(const char *score_id, const char *exam_id, const char *use
  * @param belong_to 归属教师（UUID，可空）
  * @return int 函数是否成功执行，成功返回0，否则返回1
  */
-int insert_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, int number, const char *belong_to)
+static int insert_user_data_impl(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, int number, const char *belong_to)
 {
     const char *sql = "INSERT INTO users (id, username, hashpass, salt, role, name, class_name, number, belong_to) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
@@ -1240,42 +3445,184 @@ int insert_user_data(const char *user_id, const char *username, const char *hash
     const BindType types[] = {BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_INT, BIND_TYPE_TEXT, BIND_TYPE_TEXT, BIND_TYPE_UINT, BIND_TYPE_TEXT};
 
     // 调用通用插入函数
-    int result = insert_data_to_db(USER_DB, sql, bindings, types, 9);
+    int result = insert_data_to_db(user_db_path, sql, bindings, types, 9);
+    user_cache_invalidate(user_id); // 同一ID不应该残留旧的缓存
     if (result == 0)
     {
         log_message(LOGLEVEL_INFO, "成功插入了用户ID为 %s 的用户数据", user_id);
+        sync_class_member(user_id, class_name, belong_to); // 失败时只记录日志，见 sync_class_member
     }
 
     return result;
 }
 
+int insert_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, int number, const char *belong_to)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_user_data_impl(user_id, username, hashpass, salt, role, name, class_name, number, belong_to);
+    metrics_record_call(METRIC_INSERT_USER_DATA, start, rc != 0);
+    return rc;
+}
+
 /**************************** 单条数据插入结束 ****************************/
 
 /**************************** 单条数据删除开始 ****************************/
 
 /**
- * @brief 删除用户数据库中指定ID的用户数据
+ * @brief 删除用户数据库中指定ID的用户数据
+ *
+ * @param user_id 要删除的用户的唯一ID（UUID）
+ * @return int 函数执行成功返回0，否则返回1
+ */
+static int del_user_data_impl(const char *user_id)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+    
+    // 打开数据库
+    if (open_database(user_db_path, &db))
+    {
+        return 1;
+    }
+
+    // 准备SQL语句
+    const char *sql = "DELETE FROM users WHERE id = ?;";
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 绑定用户ID参数
+    rc = sqlite3_bind_text(stmt, 1, user_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 执行删除操作
+    rc = step_with_retry(db, stmt);
+    user_cache_invalidate(user_id); // 使该用户的缓存失效
+    if (rc != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "删除用户数据失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+    else
+    {
+        log_message(LOGLEVEL_INFO, "成功删除用户数据，用户ID：%s", user_id);
+        sync_class_member(user_id, NULL, NULL); // 学生的成绩移出班级统计
+    }
+
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return 0;
+}
+
+int del_user_data(const char *user_id)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = del_user_data_impl(user_id);
+    metrics_record_call(METRIC_DEL_USER_DATA, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 删除考试数据库中指定ID的考试数据
+ *
+ * @param exam_id 要删除的考试的唯一ID（UUID）
+ * @return int 函数执行成功返回0，否则返回1
+ */
+static int del_exam_data_impl(const char *exam_id)
+{
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+    
+    // 打开数据库
+    if (open_database(examination_db_path, &db))
+    {
+        return 1;
+    }
+
+    // 准备SQL语句
+    const char *sql = "DELETE FROM examinations WHERE id = ?;";
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 绑定考试ID参数
+    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 执行删除操作
+    rc = step_with_retry(db, stmt);
+    exam_cache_invalidate(exam_id); // 使该考试的考卷缓存失效
+    if (rc != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "删除考试数据失败：%s", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+    else
+    {
+        log_message(LOGLEVEL_INFO, "成功删除考试数据，考试ID：%s", exam_id);
+    }
+
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return 0;
+}
+
+int del_exam_data(const char *exam_id)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = del_exam_data_impl(exam_id);
+    metrics_record_call(METRIC_DEL_EXAM_DATA, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 删除成绩数据库中指定ID的成绩数据
  *
- * @param user_id 要删除的用户的唯一ID（UUID）
+ * @param score_id 要删除的成绩的唯一ID（UUID）
  * @return int 函数执行成功返回0，否则返回1
  */
-int del_user_data(const char *user_id)
+static int del_score_data_impl(const char *score_id)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
     
     // 打开数据库
-    rc = sqlite3_open(USER_DB, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", USER_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
     // 准备SQL语句
-    const char *sql = "DELETE FROM users WHERE id = ?;";
+    const char *sql = "DELETE FROM scores WHERE id = ?;";
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
     {
@@ -1284,28 +3631,28 @@ int del_user_data(const char *user_id)
         return 1;
     }
 
-    // 绑定用户ID参数
-    rc = sqlite3_bind_text(stmt, 1, user_id, -1, SQLITE_STATIC);
+    // 绑定成绩ID参数
+    rc = sqlite3_bind_text(stmt, 1, score_id, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定成绩ID参数失败：%s", sqlite3_errmsg(db));
         sqlite3_finalize(stmt);
         sqlite3_close(db);
         return 1;
     }
 
     // 执行删除操作
-    rc = sqlite3_step(stmt);
+    rc = step_with_retry(db, stmt);
     if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "删除用户数据失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "删除成绩数据失败：%s", sqlite3_errmsg(db));
         sqlite3_finalize(stmt);
         sqlite3_close(db);
         return 1;
     }
     else
     {
-        log_message(LOGLEVEL_INFO, "成功删除用户数据，用户ID：%s", user_id);
+        log_message(LOGLEVEL_INFO, "成功删除成绩数据，成绩ID：%s", score_id);
     }
 
     // 清理和关闭数据库
@@ -1314,29 +3661,34 @@ int del_user_data(const char *user_id)
     return 0;
 }
 
+int del_score_data(const char *score_id)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = del_score_data_impl(score_id);
+    metrics_record_call(METRIC_DEL_SCORE_DATA, start, rc != 0);
+    return rc;
+}
+
 /**
- * @brief 删除考试数据库中指定ID的考试数据
+ * @brief 删除问题数据库中指定ID的问题数据
  *
- * @param exam_id 要删除的考试的唯一ID（UUID）
+ * @param question_id 要删除的问题的唯一ID（UUID）
  * @return int 函数执行成功返回0，否则返回1
  */
-int del_exam_data(const char *exam_id)
+static int del_question_data_impl(const char *question_id)
 {
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
     
     // 打开数据库
-    rc = sqlite3_open(EXAMINATION_DB, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(examination_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", EXAMINATION_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
     // 准备SQL语句
-    const char *sql = "DELETE FROM examinations WHERE id = ?;";
+    const char *sql = "DELETE FROM questions WHERE id = ?;";
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
     {
@@ -1345,28 +3697,31 @@ int del_exam_data(const char *exam_id)
         return 1;
     }
 
-    // 绑定考试ID参数
-    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    // 绑定问题ID参数
+    rc = sqlite3_bind_text(stmt, 1, question_id, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定问题ID参数失败：%s", sqlite3_errmsg(db));
         sqlite3_finalize(stmt);
         sqlite3_close(db);
         return 1;
     }
 
     // 执行删除操作
-    rc = sqlite3_step(stmt);
+    char exam_id[37];
+    query_question_exam_id(db, question_id, exam_id);
+    rc = step_with_retry(db, stmt);
+    exam_cache_invalidate(exam_id); // 使题目所属考试的考卷缓存失效
     if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "删除考试数据失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "删除问题数据失败：%s", sqlite3_errmsg(db));
         sqlite3_finalize(stmt);
         sqlite3_close(db);
         return 1;
     }
     else
     {
-        log_message(LOGLEVEL_INFO, "成功删除考试数据，考试ID：%s", exam_id);
+        log_message(LOGLEVEL_INFO, "成功删除问题数据，问题ID：%s", question_id);
     }
 
     // 清理和关闭数据库
@@ -1375,29 +3730,53 @@ int del_exam_data(const char *exam_id)
     return 0;
 }
 
+int del_question_data(const char *question_id)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = del_question_data_impl(question_id);
+    metrics_record_call(METRIC_DEL_QUESTION_DATA, start, rc != 0);
+    return rc;
+}
+
+/**************************** 单条数据删除结束 ****************************/
+
+/**************************** 单条数据修改开始 ****************************/
+
 /**
- * @brief 删除成绩数据库中指定ID的成绩数据
+ * @brief 修改用户数据库中指定ID的用户数据
  *
- * @param score_id 要删除的成绩的唯一ID（UUID）
+ * @param user_id 要修改的用户的唯一ID（UUID）
+ * @param username 新的用户名，范围为[a-zA-Z0-9]{3,24}
+ * @param hashpass 新的密码哈希值，sha512(salt + passwd)
+ * @param salt 新的盐值，16字节
+ * @param role 新的用户角色
+ * @param name 新的真实姓名
+ * @param class_name 新的班级名称（可为空）
+ * @param number 新的学号/工号
+ * @param belong_to 新的归属教师ID（UUID，可为空）
  * @return int 函数执行成功返回0，否则返回1
  */
-int del_score_data(const char *score_id)
+static int edit_user_data_impl(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, unsigned int number, const char *belong_to)
 {
+    // 数据校验
+    if (strlen(username) < 3 || strlen(username) > 24)
+    {
+        log_message(LOGLEVEL_ERROR, "用户名长度不符合要求：%s", username);
+        return 1;
+    }
+
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
-    
+
     // 打开数据库
-    rc = sqlite3_open(SCORES_DB, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(user_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", SCORES_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
     // 准备SQL语句
-    const char *sql = "DELETE FROM scores WHERE id = ?;";
+    const char *sql = "UPDATE users SET username = ?, hashpass = ?, salt = ?, role = ?, name = ?, class_name = ?, number = ?, belong_to = ? WHERE id = ?;";
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
     {
@@ -1406,59 +3785,246 @@ int del_score_data(const char *score_id)
         return 1;
     }
 
-    // 绑定成绩ID参数
-    rc = sqlite3_bind_text(stmt, 1, score_id, -1, SQLITE_STATIC);
+    // 绑定参数
+    rc = sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定成绩ID参数失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return 1;
+        log_message(LOGLEVEL_ERROR, "绑定用户名参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
     }
 
-    // 执行删除操作
-    rc = sqlite3_step(stmt);
+    rc = sqlite3_bind_text(stmt, 2, hashpass, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定密码哈希参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 3, salt, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定盐值参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 4, role);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定角色参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 5, name, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定姓名参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 6, class_name, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定班级名称参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int64(stmt, 7, number);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定学号/工号参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 8, belong_to, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定归属教师参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 9, user_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    // 执行更新操作
+    rc = step_with_retry(db, stmt);
     if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "删除成绩数据失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+        log_message(LOGLEVEL_ERROR, "更新用户数据失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+    else
+    {
+        log_message(LOGLEVEL_INFO, "成功更新用户数据，用户ID：%s", user_id);
+        sync_class_member(user_id, class_name, belong_to); // 班级或归属教师变化时移动学生的成绩
+    }
+
+cleanup:
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    user_cache_invalidate(user_id); // 用户数据可能已经改变，使缓存失效
+    return (rc == SQLITE_DONE) ? 0 : 1;
+}
+
+int edit_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, unsigned int number, const char *belong_to)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = edit_user_data_impl(user_id, username, hashpass, salt, role, name, class_name, number, belong_to);
+    metrics_record_call(METRIC_EDIT_USER_DATA, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 修改考试数据库中指定ID的考试数据
+ *
+ * @param exam_id 要修改的考试的唯一ID（UUID）
+ * @param name 新的考试名称
+ * @param start_time 新的开始时间（时间戳）
+ * @param end_time 新的结束时间（时间戳）
+ * @param allow_answer_when_expired 是否允许逾期作答（0或1）
+ * @param random_question 是否开启问题乱序（0或1）
+ * @return int 函数执行成功返回0，否则返回1
+ */
+static int edit_exam_data_impl(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
+{
+    // 数据校验
+    if (allow_answer_when_expired != 0 && allow_answer_when_expired != 1)
+    {
+        log_message(LOGLEVEL_ERROR, "对考试数据库执行插入操作的时候遇到了问题: 逾期作答值非法！%d", allow_answer_when_expired);
+        return 1;
+    }
+    if (random_question != 0 && random_question != 1)
+    {
+        log_message(LOGLEVEL_ERROR, "对考试数据库执行插入操作的时候遇到了问题: 随机问题值非法！%d", random_question);
+        return 1;
+    }
+
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    int rc;
+
+    // 打开数据库
+    if (open_database(examination_db_path, &db))
+    {
+        return 1;
+    }
+
+    // 准备SQL语句
+    const char *sql = "UPDATE examinations SET name = ?, start_time = ?, end_time = ?, allow_answer_when_expired = ?, random_question = ? WHERE id = ?;";
+    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
         sqlite3_close(db);
         return 1;
     }
+
+    // 绑定参数
+    rc = sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定考试名称参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 2, start_time);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定开始时间参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 3, end_time);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定结束时间参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 4, allow_answer_when_expired);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定允许逾期作答参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 5, random_question);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定问题乱序参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 6, exam_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    // 执行更新操作
+    rc = step_with_retry(db, stmt);
+    if (rc != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "更新考试数据失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
     else
     {
-        log_message(LOGLEVEL_INFO, "成功删除成绩数据，成绩ID：%s", score_id);
+        log_message(LOGLEVEL_INFO, "成功更新考试数据，考试ID：%s", exam_id);
     }
 
+cleanup:
     // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
-    return 0;
+    exam_cache_invalidate(exam_id); // 考试信息可能已经改变，使考卷缓存失效
+    return (rc == SQLITE_DONE) ? 0 : 1;
+}
+
+int edit_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = edit_exam_data_impl(exam_id, name, start_time, end_time, allow_answer_when_expired, random_question);
+    metrics_record_call(METRIC_EDIT_EXAM_DATA, start, rc != 0);
+    return rc;
 }
 
 /**
- * @brief 删除问题数据库中指定ID的问题数据
+ * @brief 修改成绩数据库中指定ID的成绩数据
  *
- * @param question_id 要删除的问题的唯一ID（UUID）
+ * @param score_id 要修改的成绩的唯一ID（UUID）
+ * @param exam_id 新的考试ID（UUID）
+ * @param user_id 新的用户ID（UUID）
+ * @param score 新的成绩值
+ * @param expired_flag 是否逾期作答（0或1）
  * @return int 函数执行成功返回0，否则返回1
  */
-int del_question_data(const char *question_id)
+static int edit_score_data_impl(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
 {
+    // 数据校验
+    if (expired_flag != 0 && expired_flag != 1)
+    {
+        log_message(LOGLEVEL_ERROR, "对成绩数据库执行插入操作的时候遇到了问题: 逾期作答标记值非法！%d", expired_flag);
+        return 1;
+    }
+
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
-    
+
     // 打开数据库
-    rc = sqlite3_open(EXAMINATION_DB, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", EXAMINATION_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
     // 准备SQL语句
-    const char *sql = "DELETE FROM questions WHERE id = ?;";
+    const char *sql = "UPDATE scores SET exam_id = ?, user_id = ?, score = ?, expired_flag = ? WHERE id = ?;";
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
     {
@@ -1467,78 +4033,101 @@ int del_question_data(const char *question_id)
         return 1;
     }
 
-    // 绑定问题ID参数
-    rc = sqlite3_bind_text(stmt, 1, question_id, -1, SQLITE_STATIC);
+    // 绑定参数
+    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定问题ID参数失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return 1;
+        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
     }
 
-    // 执行删除操作
-    rc = sqlite3_step(stmt);
+    rc = sqlite3_bind_text(stmt, 2, user_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 3, score);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定成绩参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_int(stmt, 4, expired_flag);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定逾期标志参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    rc = sqlite3_bind_text(stmt, 5, score_id, -1, SQLITE_STATIC);
+    if (rc != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "绑定成绩ID参数失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    // 执行更新操作
+    rc = step_with_retry(db, stmt);
     if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "删除问题数据失败：%s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return 1;
+        log_message(LOGLEVEL_ERROR, "更新成绩数据失败：%s", sqlite3_errmsg(db));
+        goto cleanup;
     }
     else
     {
-        log_message(LOGLEVEL_INFO, "成功删除问题数据，问题ID：%s", question_id);
+        log_message(LOGLEVEL_INFO, "成功更新成绩数据，成绩ID：%s，用户ID：%s，分数：%d", score_id, user_id, score);
     }
 
+cleanup:
     // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
-    return 0;
+    return (rc == SQLITE_DONE) ? 0 : 1;
 }
 
-/**************************** 单条数据删除结束 ****************************/
-
-/**************************** 单条数据修改开始 ****************************/
+int edit_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = edit_score_data_impl(score_id, exam_id, user_id, score, expired_flag);
+    metrics_record_call(METRIC_EDIT_SCORE_DATA, start, rc != 0);
+    return rc;
+}
 
 /**
- * @brief 修改用户数据库中指定ID的用户数据
+ * @brief 修改问题数据库中指定ID的问题数据
  *
- * @param user_id 要修改的用户的唯一ID（UUID）
- * @param username 新的用户名，范围为[a-zA-Z0-9]{3,24}
- * @param hashpass 新的密码哈希值，sha512(salt + passwd)
- * @param salt 新的盐值，16字节
- * @param role 新的用户角色
- * @param name 新的真实姓名
- * @param class_name 新的班级名称（可为空）
- * @param number 新的学号/工号
- * @param belong_to 新的归属教师ID（UUID，可为空）
+ * @param question_id 要修改的问题的唯一ID（UUID）
+ * @param exam_id 新的考试ID（UUID）
+ * @param num1 新的第一个操作数
+ * @param op 新的运算符（0: +, 1: -, 2: *, 3: /）
+ * @param num2 新的第二个操作数
  * @return int 函数执行成功返回0，否则返回1
  */
-int edit_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, unsigned int number, const char *belong_to)
+static int edit_question_data_impl(const char *question_id, const char *exam_id, int num1, int op, int num2)
 {
     // 数据校验
-    if (strlen(username) < 3 || strlen(username) > 24)
+    if (op != 0 && op != 1 && op != 2 && op != 3)
     {
-        log_message(LOGLEVEL_ERROR, "用户名长度不符合要求：%s", username);
+        log_message(LOGLEVEL_ERROR, "对问题数据库执行插入操作的时候遇到了问题: 运算符值非法！%d", op);
         return 1;
     }
 
     sqlite3 *db;
     sqlite3_stmt *stmt;
     int rc;
+    char old_exam_id[37] = "";
 
     // 打开数据库
-    rc = sqlite3_open(USER_DB, &db);
-    if (rc != SQLITE_OK)
+    if (open_database(examination_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", USER_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
         return 1;
     }
 
     // 准备SQL语句
-    const char *sql = "UPDATE users SET username = ?, hashpass = ?, salt = ?, role = ?, name = ?, class_name = ?, number = ?, belong_to = ? WHERE id = ?;";
+    const char *sql = "UPDATE questions SET exam_id = ?, num1 = ?, op = ?, num2 = ? WHERE id = ?;";
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
     if (rc != SQLITE_OK)
     {
@@ -1548,390 +4137,650 @@ int edit_user_data(const char *user_id, const char *username, const char *hashpa
     }
 
     // 绑定参数
-    rc = sqlite3_bind_text(stmt, 1, username, -1, SQLITE_STATIC);
+    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定用户名参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
 
-    rc = sqlite3_bind_text(stmt, 2, hashpass, -1, SQLITE_STATIC);
+    rc = sqlite3_bind_int(stmt, 2, num1);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定密码哈希参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定第一个操作数参数失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
 
-    rc = sqlite3_bind_text(stmt, 3, salt, -1, SQLITE_STATIC);
+    rc = sqlite3_bind_int(stmt, 3, op);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定盐值参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定运算符参数失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
 
-    rc = sqlite3_bind_int(stmt, 4, role);
+    rc = sqlite3_bind_int(stmt, 4, num2);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定角色参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定第二个操作数参数失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
 
-    rc = sqlite3_bind_text(stmt, 5, name, -1, SQLITE_STATIC);
+    rc = sqlite3_bind_text(stmt, 5, question_id, -1, SQLITE_STATIC);
     if (rc != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定姓名参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "绑定问题ID参数失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
 
-    rc = sqlite3_bind_text(stmt, 6, class_name, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    // 执行更新操作，题目可能从原来的考试移到了新的考试，两边的考卷缓存都要失效
+    query_question_exam_id(db, question_id, old_exam_id);
+    rc = step_with_retry(db, stmt);
+    if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "绑定班级名称参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "更新问题数据失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
-
-    rc = sqlite3_bind_int64(stmt, 7, number);
-    if (rc != SQLITE_OK)
+    else
     {
-        log_message(LOGLEVEL_ERROR, "绑定学号/工号参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_INFO, "成功更新问题数据，问题ID：%s", question_id);
     }
 
-    rc = sqlite3_bind_text(stmt, 8, belong_to, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+cleanup:
+    // 清理和关闭数据库
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    exam_cache_invalidate(old_exam_id);
+    exam_cache_invalidate(exam_id);
+    return (rc == SQLITE_DONE) ? 0 : 1;
+}
+
+int edit_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = edit_question_data_impl(question_id, exam_id, num1, op, num2);
+    metrics_record_call(METRIC_EDIT_QUESTION_DATA, start, rc != 0);
+    return rc;
+}
+
+/**************************** 单条数据修改结束 ****************************/
+
+/**************************** 成绩统计部分开始 ****************************/
+
+/**
+ * @brief 查询一场考试的成绩统计
+ *
+ * @param exam_id 考试ID
+ * @param stats_to_return 返回的统计，没有成绩时各项均为0
+ * @return int 成功返回0，否则返回1
+ *
+ * @details exam_stats 和 exam_score_histogram 由 scores 表上的触发器维护（见 schema.h），与成绩在同一个事务中提交。
+ *          查询只按主键读取一行统计和这场考试出现过的分数（最多 101 行），耗时与成绩条数无关。
+ *          两次读取在同一个读事务中，看到的是同一时刻的数据
+ */
+static int query_exam_stats_impl(const char *exam_id, struct ExamStats *stats_to_return)
+{
+    if (exam_id == NULL || stats_to_return == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "绑定归属教师参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "参数 exam_id 或 stats_to_return 为 NULL");
+        return 1;
     }
+    memset(stats_to_return, 0, sizeof(*stats_to_return));
 
-    rc = sqlite3_bind_text(stmt, 9, user_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
+        return 1;
     }
+    int rc = sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK;
 
-    // 执行更新操作
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+    if (rc == 0 && sqlite3_prepare_v2(db, "SELECT count, sum, sumsq, pass_count FROM exam_stats WHERE exam_id = ?;", -1, &stmt, NULL) == SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "更新用户数据失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+        int step = sqlite3_step(stmt);
+        if (step == SQLITE_ROW)
+        {
+            stats_to_return->count = sqlite3_column_int64(stmt, 0);
+            stats_to_return->sum = sqlite3_column_int64(stmt, 1);
+            stats_to_return->sumsq = sqlite3_column_int64(stmt, 2);
+            stats_to_return->pass_count = sqlite3_column_int64(stmt, 3);
+        }
+        rc = step != SQLITE_ROW && step != SQLITE_DONE;
     }
     else
     {
-        log_message(LOGLEVEL_INFO, "成功更新用户数据，用户ID：%s", user_id);
+        rc = 1;
     }
-
-cleanup:
-    // 清理和关闭数据库
     sqlite3_finalize(stmt);
+    stmt = NULL;
+
+    if (rc == 0 && stats_to_return->count > 0)
+    {
+        if (sqlite3_prepare_v2(db, "SELECT score, count FROM exam_score_histogram WHERE exam_id = ? ORDER BY score;", -1, &stmt, NULL) == SQLITE_OK)
+        {
+            sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+            int first = 1;
+            int step;
+            while ((step = sqlite3_step(stmt)) == SQLITE_ROW)
+            {
+                int score = sqlite3_column_int(stmt, 0);
+                if (first)
+                {
+                    stats_to_return->min_score = score;
+                    first = 0;
+                }
+                stats_to_return->max_score = score;
+                int bin = score < 0 ? 0 : (score >= EXAM_STATS_BIN_COUNT ? EXAM_STATS_BIN_COUNT - 1 : score);
+                stats_to_return->histogram[bin] += sqlite3_column_int64(stmt, 1);
+            }
+            rc = step != SQLITE_DONE;
+        }
+        else
+        {
+            rc = 1;
+        }
+        sqlite3_finalize(stmt);
+
+        double count = (double)stats_to_return->count;
+        stats_to_return->mean = (double)stats_to_return->sum / count;
+        double variance = (double)stats_to_return->sumsq / count - stats_to_return->mean * stats_to_return->mean;
+        stats_to_return->stddev = variance > 0 ? sqrt(variance) : 0;
+        stats_to_return->pass_rate = (double)stats_to_return->pass_count / count;
+    }
+    if (rc != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "查询考试 '%s' 的成绩统计失败：%s", exam_id, sqlite3_errmsg(db));
+    }
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
     sqlite3_close(db);
-    return (rc == SQLITE_DONE) ? 0 : 1;
+    return rc;
+}
+
+int query_exam_stats(const char *exam_id, struct ExamStats *stats_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_exam_stats_impl(exam_id, stats_to_return);
+    metrics_record_call(METRIC_QUERY_EXAM_STATS, start, rc != 0);
+    return rc;
 }
 
 /**
- * @brief 修改考试数据库中指定ID的考试数据
+ * @brief 由 scores 表重新计算所有考试的成绩统计
  *
- * @param exam_id 要修改的考试的唯一ID（UUID）
- * @param name 新的考试名称
- * @param start_time 新的开始时间（时间戳）
- * @param end_time 新的结束时间（时间戳）
- * @param allow_answer_when_expired 是否允许逾期作答（0或1）
- * @param random_question 是否开启问题乱序（0或1）
- * @return int 函数执行成功返回0，否则返回1
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 用于 check_exam_stats 发现不一致之后，或者绕过触发器（如删除触发器后批量导入）修改了 scores 表之后。
+ *          在一个写事务中完成，耗时与成绩条数成正比，期间其他写入者等待
  */
-int edit_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question)
+int rebuild_exam_stats(void)
 {
-    // 数据校验
-    if (allow_answer_when_expired != 0 && allow_answer_when_expired != 1)
+    return run_exam_stats_rebuild(0);
+}
+
+/**
+ * @brief 检查成绩统计与 scores 表是否一致
+ *
+ * @param mismatches_to_return 返回统计不一致的考试数量，包括统计中多出来或者缺少的考试
+ * @return int 检查完成返回0（无论是否一致），检查失败返回1
+ *
+ * @details 在一个读事务中由 scores 表重新分组计算，与 exam_stats、exam_score_histogram 逐行比较，
+ *          不一致的考试ID写入日志。耗时与成绩条数成正比，不影响写入者
+ */
+int check_exam_stats(int *mismatches_to_return)
+{
+    if (mismatches_to_return == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "对考试数据库执行插入操作的时候遇到了问题: 逾期作答值非法！%d", allow_answer_when_expired);
+        log_message(LOGLEVEL_ERROR, "参数 mismatches_to_return 为 NULL");
         return 1;
     }
-    if (random_question != 0 && random_question != 1)
+    *mismatches_to_return = 0;
+
+    static const char sql[] =
+        "WITH expected_stats AS (SELECT exam_id, count(*) AS count, sum(score) AS sum, sum(score * score) AS sumsq, "
+        "sum(score >= " EXAM_STATS_PASS_SQL ") AS pass_count FROM scores GROUP BY exam_id), "
+        "expected_histogram AS (SELECT exam_id, score, count(*) AS count FROM scores GROUP BY exam_id, score) "
+        "SELECT exam_id FROM (SELECT * FROM expected_stats EXCEPT SELECT exam_id, count, sum, sumsq, pass_count FROM exam_stats) "
+        "UNION SELECT exam_id FROM (SELECT exam_id, count, sum, sumsq, pass_count FROM exam_stats EXCEPT SELECT * FROM expected_stats) "
+        "UNION SELECT exam_id FROM (SELECT * FROM expected_histogram EXCEPT SELECT exam_id, score, count FROM exam_score_histogram) "
+        "UNION SELECT exam_id FROM (SELECT exam_id, score, count FROM exam_score_histogram EXCEPT SELECT * FROM expected_histogram);";
+
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
+    {
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
+        return 1;
+    }
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        log_message(LOGLEVEL_ERROR, "考试 '%s' 的成绩统计与成绩表不一致", (const char *)sqlite3_column_text(stmt, 0));
+        (*mismatches_to_return)++;
+    }
+    if (step != SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_ERROR, "检查成绩统计失败：%s", sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    if (step == SQLITE_DONE)
+    {
+        log_message(LOGLEVEL_INFO, "成绩统计检查完成，%d 场考试不一致", *mismatches_to_return);
+    }
+    return step != SQLITE_DONE;
+}
+
+/**
+ * @brief 查询考生在一场考试中的名次和百分位
+ *
+ * @param exam_id 考试ID
+ * @param user_id 考生的用户ID
+ * @param rank_to_return 返回的排名，考生没有成绩时 found 为0
+ * @return int 成功返回0（包括没有成绩的情况），否则返回1
+ *
+ * @details 考生的成绩由 scores_user_exam 索引直接找到；名次和百分位只需要比该成绩高、与之相同的条数，
+ *          由 exam_score_histogram 中这场考试最多 101 行求和得到，不需要扫描或排序成绩，考试期间不断有人交卷也不会变慢。
+ *          两次读取在同一个读事务中
+ */
+static int score_rank_impl(const char *exam_id, const char *user_id, struct ScoreRank *rank_to_return)
+{
+    if (exam_id == NULL || user_id == NULL || rank_to_return == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "对考试数据库执行插入操作的时候遇到了问题: 随机问题值非法！%d", random_question);
+        log_message(LOGLEVEL_ERROR, "参数 exam_id、user_id 或 rank_to_return 为 NULL");
         return 1;
     }
+    memset(rank_to_return, 0, sizeof(*rank_to_return));
 
     sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 打开数据库
-    rc = sqlite3_open(EXAMINATION_DB, &db);
-    if (rc != SQLITE_OK)
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", EXAMINATION_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
         return 1;
     }
+    int rc = sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK;
 
-    // 准备SQL语句
-    const char *sql = "UPDATE examinations SET name = ?, start_time = ?, end_time = ?, allow_answer_when_expired = ?, random_question = ? WHERE id = ?;";
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
+    // 考生的最高分
+    if (rc == 0 && sqlite3_prepare_v2(db, "SELECT max(score) FROM scores WHERE user_id = ? AND exam_id = ?;", -1, &stmt, NULL) == SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return 1;
+        sqlite3_bind_text(stmt, 1, user_id, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, exam_id, -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt) != SQLITE_ROW;
+        if (rc == 0 && sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+        {
+            rank_to_return->found = 1;
+            rank_to_return->score = sqlite3_column_int(stmt, 0);
+        }
     }
-
-    // 绑定参数
-    rc = sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    else
     {
-        log_message(LOGLEVEL_ERROR, "绑定考试名称参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        rc = 1;
     }
+    sqlite3_finalize(stmt);
+    stmt = NULL;
 
-    rc = sqlite3_bind_int(stmt, 2, start_time);
-    if (rc != SQLITE_OK)
+    if (rc == 0 && rank_to_return->found)
     {
-        log_message(LOGLEVEL_ERROR, "绑定开始时间参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        if (sqlite3_prepare_v2(db,
+                               "SELECT coalesce(sum(CASE WHEN score > ?2 THEN count END), 0), "
+                               "coalesce(sum(CASE WHEN score = ?2 THEN count END), 0), coalesce(sum(count), 0) "
+                               "FROM exam_score_histogram WHERE exam_id = ?1;",
+                               -1, &stmt, NULL) == SQLITE_OK)
+        {
+            sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, rank_to_return->score);
+            rc = sqlite3_step(stmt) != SQLITE_ROW;
+            if (rc == 0)
+            {
+                long long higher = sqlite3_column_int64(stmt, 0);
+                rank_to_return->ties = sqlite3_column_int64(stmt, 1);
+                rank_to_return->total = sqlite3_column_int64(stmt, 2);
+                rank_to_return->rank = higher + 1;
+                if (rank_to_return->total > 0)
+                {
+                    long long lower = rank_to_return->total - higher - rank_to_return->ties;
+                    rank_to_return->percentile = ((double)lower + (double)rank_to_return->ties / 2.0) / (double)rank_to_return->total * 100.0;
+                }
+            }
+        }
+        else
+        {
+            rc = 1;
+        }
+        sqlite3_finalize(stmt);
     }
-
-    rc = sqlite3_bind_int(stmt, 3, end_time);
-    if (rc != SQLITE_OK)
+    if (rc != 0)
     {
-        log_message(LOGLEVEL_ERROR, "绑定结束时间参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "查询考试 '%s' 中用户 '%s' 的排名失败：%s", exam_id, user_id, sqlite3_errmsg(db));
     }
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    sqlite3_close(db);
+    return rc;
+}
 
-    rc = sqlite3_bind_int(stmt, 4, allow_answer_when_expired);
-    if (rc != SQLITE_OK)
+int score_rank(const char *exam_id, const char *user_id, struct ScoreRank *rank_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = score_rank_impl(exam_id, user_id, rank_to_return);
+    metrics_record_call(METRIC_SCORE_RANK, start, rc != 0);
+    return rc;
+}
+
+/**
+ * @brief 查询一场考试分数最高的 k 条成绩
+ *
+ * @param exam_id 考试ID
+ * @param k 最多返回的条数，不超过 scores_to_return 的长度
+ * @param scores_to_return 返回的成绩，按分数从高到低排列，同分时按成绩ID（UUIDv7，即交卷时间）排列，没有用到的元素 id 为空字符串
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 查询按 scores_exam_score 索引的顺序读取，读到 k 条即停止，耗时只与 k 有关，与这场考试的成绩条数无关
+ */
+static int top_scores_impl(const char *exam_id, int k, struct SqlResponseScore *scores_to_return)
+{
+    if (exam_id == NULL || scores_to_return == NULL || k < 0)
     {
-        log_message(LOGLEVEL_ERROR, "绑定允许逾期作答参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "参数 exam_id 或 scores_to_return 为 NULL，或者 k 小于0");
+        return 1;
     }
-
-    rc = sqlite3_bind_int(stmt, 5, random_question);
-    if (rc != SQLITE_OK)
+    for (int i = 0; i < k; i++)
     {
-        log_message(LOGLEVEL_ERROR, "绑定问题乱序参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        strcpy(scores_to_return[i].id, "");
     }
 
-    rc = sqlite3_bind_text(stmt, 6, exam_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
+        return 1;
     }
+    if (sqlite3_prepare_v2(db,
+                           "SELECT id, exam_id, user_id, score, expired_flag FROM scores "
+                           "WHERE exam_id = ? ORDER BY score DESC, id LIMIT ?;",
+                           -1, &stmt, NULL) != SQLITE_OK)
+    {
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, k);
 
-    // 执行更新操作
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+    int count = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW && count < k)
     {
-        log_message(LOGLEVEL_ERROR, "更新考试数据失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        struct SqlResponseScore *score = &scores_to_return[count];
+        snprintf(score->id, sizeof(score->id), "%s", (const char *)sqlite3_column_text(stmt, 0));
+        snprintf(score->exam_id, sizeof(score->exam_id), "%s", (const char *)sqlite3_column_text(stmt, 1));
+        snprintf(score->user_id, sizeof(score->user_id), "%s", (const char *)sqlite3_column_text(stmt, 2));
+        score->score = sqlite3_column_int(stmt, 3);
+        score->expired_flag = sqlite3_column_int(stmt, 4);
+        count++;
     }
-    else
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW)
     {
-        log_message(LOGLEVEL_INFO, "成功更新考试数据，考试ID：%s", exam_id);
+        log_message(LOGLEVEL_ERROR, "查询考试 '%s' 的排行榜失败：%s", exam_id, sqlite3_errmsg(db));
     }
-
-cleanup:
-    // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
-    return (rc == SQLITE_DONE) ? 0 : 1;
+    metrics_record_rows(METRIC_TOP_SCORES, count, (size_t)count * sizeof(struct SqlResponseScore));
+    return rc != SQLITE_DONE && rc != SQLITE_ROW;
+}
+
+int top_scores(const char *exam_id, int k, struct SqlResponseScore *scores_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = top_scores_impl(exam_id, k, scores_to_return);
+    metrics_record_call(METRIC_TOP_SCORES, start, rc != 0);
+    return rc;
 }
 
+/**************************** 成绩统计部分结束 ****************************/
+
+/**************************** 答题记录部分开始 ****************************/
+
 /**
- * @brief 修改成绩数据库中指定ID的成绩数据
+ * @brief 保存一次交卷的答题记录
  *
- * @param score_id 要修改的成绩的唯一ID（UUID）
- * @param exam_id 新的考试ID（UUID）
- * @param user_id 新的用户ID（UUID）
- * @param score 新的成绩值
- * @param expired_flag 是否逾期作答（0或1）
- * @return int 函数执行成功返回0，否则返回1
+ * @param score_id 这次交卷的成绩ID
+ * @param exam_id 考试ID
+ * @param user_id 答题的用户ID
+ * @param seed 题目顺序的随机种子，0 表示没有打乱
+ * @param question_count 题目数量
+ * @param correct 每道题是否答对，按考卷中的原始顺序
+ * @param answers 每道题的答案，按考卷中的原始顺序，NaN 表示没有作答
+ * @return int 成功返回0，否则返回1
+ *
+ * @details 记录由 answer_log_encode 编码，答对的题目只占位图中的一位，答错的题目多保存一个变长编码的答案。
+ *          同一个成绩ID重复保存时覆盖原来的记录
  */
-int edit_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag)
+static int insert_answer_log_impl(const char *score_id, const char *exam_id, const char *user_id, unsigned int seed, int question_count,
+                                  const unsigned char *correct, const float *answers)
 {
-    // 数据校验
-    if (expired_flag != 0 && expired_flag != 1)
+    if (score_id == NULL || exam_id == NULL || user_id == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "对成绩数据库执行插入操作的时候遇到了问题: 逾期作答标记值非法！%d", expired_flag);
+        log_message(LOGLEVEL_ERROR, "参数 score_id、exam_id 或 user_id 为 NULL");
+        return 1;
+    }
+    unsigned char record[ANSWER_LOG_MAX_RECORD_SIZE];
+    int length = 0;
+    if (answer_log_encode(seed, question_count, correct, answers, record, sizeof(record), &length))
+    {
+        log_message(LOGLEVEL_ERROR, "无法编码成绩 '%s' 的答题记录，题目数量：%d", score_id, question_count);
         return 1;
     }
 
     sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 打开数据库
-    rc = sqlite3_open(SCORES_DB, &db);
-    if (rc != SQLITE_OK)
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", SCORES_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
         return 1;
     }
-
-    // 准备SQL语句
-    const char *sql = "UPDATE scores SET exam_id = ?, user_id = ?, score = ?, expired_flag = ? WHERE id = ?;";
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO answer_log (exam_id, score_id, user_id, record) VALUES (?, ?, ?, ?);",
+                           -1, &stmt, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
         sqlite3_close(db);
         return 1;
     }
-
-    // 绑定参数
-    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, score_id, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, user_id, -1, SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, 4, record, length, SQLITE_STATIC);
+    int rc = step_with_retry(db, stmt);
+    if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "保存成绩 '%s' 的答题记录失败：%s", score_id, sqlite3_errmsg(db));
     }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return rc != SQLITE_DONE;
+}
 
-    rc = sqlite3_bind_text(stmt, 2, user_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
-    {
-        log_message(LOGLEVEL_ERROR, "绑定用户ID参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
-    }
+int insert_answer_log(const char *score_id, const char *exam_id, const char *user_id, unsigned int seed, int question_count,
+                      const unsigned char *correct, const float *answers)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = insert_answer_log_impl(score_id, exam_id, user_id, seed, question_count, correct, answers);
+    metrics_record_call(METRIC_INSERT_ANSWER_LOG, start, rc != 0);
+    return rc;
+}
 
-    rc = sqlite3_bind_int(stmt, 3, score);
-    if (rc != SQLITE_OK)
+/**
+ * @brief 读取一次交卷的答题记录
+ *
+ * @param exam_id 考试ID
+ * @param score_id 成绩ID
+ * @param header_to_return 返回记录的头部，没有找到记录时 question_count 为 -1
+ * @param correct_to_return 返回每道题是否答对，按考卷中的原始顺序
+ * @param answers_to_return 返回每道答错的题目的答案，答对和没有作答的题目为 NaN
+ * @param capacity 两个数组的大小，小于题目数量时只返回前 capacity 道题
+ * @return int 成功返回0（包括没有找到记录的情况），否则返回1
+ */
+static int query_answer_log_impl(const char *exam_id, const char *score_id, struct AnswerLogHeader *header_to_return,
+                                 unsigned char *correct_to_return, float *answers_to_return, int capacity)
+{
+    if (exam_id == NULL || score_id == NULL || header_to_return == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "绑定成绩参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "参数 exam_id、score_id 或 header_to_return 为 NULL");
+        return 1;
     }
+    memset(header_to_return, 0, sizeof(*header_to_return));
+    header_to_return->question_count = -1;
 
-    rc = sqlite3_bind_int(stmt, 4, expired_flag);
-    if (rc != SQLITE_OK)
+    sqlite3 *db;
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "绑定逾期标志参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
+        return 1;
     }
-
-    rc = sqlite3_bind_text(stmt, 5, score_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    if (sqlite3_prepare_v2(db, "SELECT record FROM answer_log WHERE exam_id = ? AND score_id = ?;", -1, &stmt, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定成绩ID参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
     }
-
-    // 执行更新操作
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+    sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, score_id, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    int result = rc != SQLITE_ROW && rc != SQLITE_DONE;
+    if (rc == SQLITE_ROW)
     {
-        log_message(LOGLEVEL_ERROR, "更新成绩数据失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        const unsigned char *record = sqlite3_column_blob(stmt, 0);
+        int length = sqlite3_column_bytes(stmt, 0);
+        if (answer_log_decode(record, length, header_to_return, correct_to_return, answers_to_return, capacity))
+        {
+            log_message(LOGLEVEL_ERROR, "成绩 '%s' 的答题记录已损坏或者版本不支持", score_id);
+            header_to_return->question_count = -1;
+            result = 1;
+        }
     }
-    else
+    else if (result)
     {
-        log_message(LOGLEVEL_INFO, "成功更新成绩数据，成绩ID：%s，用户ID：%s，分数：%d", score_id, user_id, score);
+        log_message(LOGLEVEL_ERROR, "读取成绩 '%s' 的答题记录失败：%s", score_id, sqlite3_errmsg(db));
     }
-
-cleanup:
-    // 清理和关闭数据库
     sqlite3_finalize(stmt);
     sqlite3_close(db);
-    return (rc == SQLITE_DONE) ? 0 : 1;
+    return result;
+}
+
+int query_answer_log(const char *exam_id, const char *score_id, struct AnswerLogHeader *header_to_return,
+                     unsigned char *correct_to_return, float *answers_to_return, int capacity)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = query_answer_log_impl(exam_id, score_id, header_to_return, correct_to_return, answers_to_return, capacity);
+    metrics_record_call(METRIC_QUERY_ANSWER_LOG, start, rc != 0);
+    return rc;
 }
 
 /**
- * @brief 修改问题数据库中指定ID的问题数据
+ * @brief 读取一场考试答题记录的版本号，版本号与 known_version 不同时逐条读取这场考试的全部答题记录
  *
- * @param question_id 要修改的问题的唯一ID（UUID）
- * @param exam_id 新的考试ID（UUID）
- * @param num1 新的第一个操作数
- * @param op 新的运算符（0: +, 1: -, 2: *, 3: /）
- * @param num2 新的第二个操作数
- * @return int 函数执行成功返回0，否则返回1
+ * @param exam_id 考试ID
+ * @param known_version 调用者已经读取过的版本号，相同时不读取记录；传入 -1 时总是读取
+ * @param visitor 每条记录调用一次的回调函数，返回非0时停止读取
+ * @param context 传给回调函数的上下文
+ * @param version_to_return 返回当前的版本号，这场考试还没有答题记录时为0
+ * @return int 成功返回0（包括回调函数要求停止的情况），否则返回1
+ *
+ * @details 版本号和记录在同一个读事务中读取，返回的版本号一定对应读到的记录。
+ *          版本号由 answer_log 表上的触发器维护，见 schema.h 中的 SCHEMA_ANSWER_LOG_VERSION_TRIGGERS
  */
-int edit_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2)
+static int scan_answer_logs_impl(const char *exam_id, long long known_version, answer_log_visitor visitor, void *context,
+                                 long long *version_to_return)
 {
-    // 数据校验
-    if (op != 0 && op != 1 && op != 2 && op != 3)
+    if (exam_id == NULL || visitor == NULL || version_to_return == NULL)
     {
-        log_message(LOGLEVEL_ERROR, "对问题数据库执行插入操作的时候遇到了问题: 运算符值非法！%d", op);
+        log_message(LOGLEVEL_ERROR, "参数 exam_id、visitor 或 version_to_return 为 NULL");
         return 1;
     }
+    *version_to_return = 0;
 
     sqlite3 *db;
-    sqlite3_stmt *stmt;
-    int rc;
-
-    // 打开数据库
-    rc = sqlite3_open(EXAMINATION_DB, &db);
-    if (rc != SQLITE_OK)
+    sqlite3_stmt *stmt = NULL;
+    if (open_database(scores_db_path, &db))
     {
-        log_message(LOGLEVEL_ERROR, "无法打开数据库 '%s'：%s", EXAMINATION_DB, sqlite3_errmsg(db));
-        sqlite3_close(db);
+        log_message(LOGLEVEL_ERROR, "无法打开数据库：%s", scores_db_path);
         return 1;
     }
-
-    // 准备SQL语句
-    const char *sql = "UPDATE questions SET exam_id = ?, num1 = ?, op = ?, num2 = ? WHERE id = ?;";
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, 0);
-    if (rc != SQLITE_OK)
+    if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "无法准备SQL语句：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "开始读事务失败：%s", sqlite3_errmsg(db));
         sqlite3_close(db);
         return 1;
     }
 
-    // 绑定参数
-    rc = sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    int result = 1;
+    if (sqlite3_prepare_v2(db, "SELECT version FROM answer_log_versions WHERE exam_id = ?;", -1, &stmt, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定考试ID参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
-
-    rc = sqlite3_bind_int(stmt, 2, num1);
-    if (rc != SQLITE_OK)
+    sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW)
     {
-        log_message(LOGLEVEL_ERROR, "绑定第一个操作数参数失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        *version_to_return = sqlite3_column_int64(stmt, 0);
     }
-
-    rc = sqlite3_bind_int(stmt, 3, op);
-    if (rc != SQLITE_OK)
+    else if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_ERROR, "绑定运算符参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "读取考试 '%s' 的答题记录版本号失败：%s", exam_id, sqlite3_errmsg(db));
         goto cleanup;
     }
-
-    rc = sqlite3_bind_int(stmt, 4, num2);
-    if (rc != SQLITE_OK)
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    if (*version_to_return == known_version)
     {
-        log_message(LOGLEVEL_ERROR, "绑定第二个操作数参数失败：%s", sqlite3_errmsg(db));
+        result = 0;
         goto cleanup;
     }
 
-    rc = sqlite3_bind_text(stmt, 5, question_id, -1, SQLITE_STATIC);
-    if (rc != SQLITE_OK)
+    if (sqlite3_prepare_v2(db, "SELECT record FROM answer_log WHERE exam_id = ?;", -1, &stmt, NULL) != SQLITE_OK)
     {
-        log_message(LOGLEVEL_ERROR, "绑定问题ID参数失败：%s", sqlite3_errmsg(db));
+        log_message(LOGLEVEL_ERROR, "准备 SQL 语句失败：%s", sqlite3_errmsg(db));
         goto cleanup;
     }
-
-    // 执行更新操作
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+    sqlite3_bind_text(stmt, 1, exam_id, -1, SQLITE_STATIC);
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        log_message(LOGLEVEL_ERROR, "更新问题数据失败：%s", sqlite3_errmsg(db));
-        goto cleanup;
+        if (visitor(sqlite3_column_blob(stmt, 0), sqlite3_column_bytes(stmt, 0), context))
+        {
+            rc = SQLITE_DONE;
+            break;
+        }
     }
-    else
+    if (rc != SQLITE_DONE)
     {
-        log_message(LOGLEVEL_INFO, "成功更新问题数据，问题ID：%s", question_id);
+        log_message(LOGLEVEL_ERROR, "读取考试 '%s' 的答题记录失败：%s", exam_id, sqlite3_errmsg(db));
+        goto cleanup;
     }
+    result = 0;
 
 cleanup:
-    // 清理和关闭数据库
     sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
     sqlite3_close(db);
-    return (rc == SQLITE_DONE) ? 0 : 1;
+    return result;
 }
 
-/**************************** 单条数据修改结束 ****************************/
+int scan_answer_logs(const char *exam_id, long long known_version, answer_log_visitor visitor, void *context,
+                     long long *version_to_return)
+{
+    uint64_t start = metrics_now_ns();
+    int rc = scan_answer_logs_impl(exam_id, known_version, visitor, context, version_to_return);
+    metrics_record_call(METRIC_SCAN_ANSWER_LOGS, start, rc != 0);
+    return rc;
+}
+
+/**************************** 答题记录部分结束 ****************************/
@@ -16,6 +16,63 @@ History:        暂无
         ID: GamerNoTitle
         Modification:   [+] 添加了忘记添加的函数声明
                         [+] 添加了头文件包含保护
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了列式查询函数的声明
+                        [*] 修正了 query_user_info 的声明，与 database.c 中的定义保持一致
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 修正了 insert_score_data 的声明，成绩参数与 database.c 中的定义一样为 int
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 get_database_retry_stats 函数的声明
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 重复声明的 edit_score_data 改为原本遗漏的 edit_question_data
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 set_slow_query_log 函数的声明
+    8.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 set_database_location 和 initialize_schema 函数的声明
+    9.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 backup_databases 和 get_backup_progress 函数的声明
+    10. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 refresh_reporting_replica、set_reporting_reads 和 get_reporting_replica_stats 函数的声明
+    11. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_exam_stats、rebuild_exam_stats 和 check_exam_stats 函数的声明
+    12. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 score_rank 和 top_scores 函数的声明
+    13. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_class_cube 和 rebuild_class_cube 函数的声明
+    14. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 insert_answer_log 和 query_answer_log 函数的声明
+    15. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 scan_answer_logs 函数的声明
+    16. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 get_database_folder 函数的声明
  */
 
 #ifndef DATABASE_H
@@ -23,6 +80,7 @@ History:        暂无
 
 #include <stdio.h>
 #include "model.h"
+#include "answer_log.h"
 #include "../lib/sqlite3.h"
 
 typedef enum BINDING
@@ -33,7 +91,7 @@ typedef enum BINDING
 } BindType;
 
 int open_database(const char *db_path, sqlite3 **db);
-int query_user_info(const char key[], const char content[], struct User *user_to_return, FILE *log_file);
+int query_user_info(const char *key, const char *content, struct User *user_to_return);
 int query_exam_info(const char *key, const char *content, struct SqlResponseExam *exam_to_return);
 int query_question_info(const char *key, const char *content, struct SqlResponseQuestion *question_to_return);
 int query_score_info(const char *key, const char *content, struct SqlResponseScore *score_to_return);
@@ -44,7 +102,7 @@ int query_scores_info_all(struct SqlResponseScore *scores_to_return, int length,
 int insert_data_to_db(const char *db_path, const char *sql, const void **bindings, const BindType *types, int num_bindings);
 int insert_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question);
 int insert_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2);
-int insert_score_data(const char *score_id, const char *exam_id, const char *user_id, float score, int expired_flag);
+int insert_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag);
 int insert_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, int number, const char *belong_to);
 int del_user_data(const char *user_id);
 int del_exam_data(const char *exam_id);
@@ -53,7 +111,243 @@ int del_question_data(const char *question_id);
 int edit_user_data(const char *user_id, const char *username, const char *hashpass, const char *salt, int role, const char *name, const char *class_name, int number, const char *belong_to);
 int edit_exam_data(const char *exam_id, const char *name, int start_time, int end_time, int allow_answer_when_expired, int random_question);
 int edit_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag);
-int edit_score_data(const char *score_id, const char *exam_id, const char *user_id, int score, int expired_flag);
+int edit_question_data(const char *question_id, const char *exam_id, int num1, int op, int num2);
+
+/**
+ * @brief 按列查询成绩，文本列依次为 id、exam_id、user_id，整数列依次为 score、expired_flag
+ *
+ * @param length 查询结果的限制数量
+ * @param key 可选的过滤键，如果为 NULL 或空字符串，则不进行过滤
+ * @param content 可选的过滤值，与 key 对应
+ * @param result_to_return 返回新分配的列式查询结果，由调用方使用 free_columnar_result 释放
+ * @return int 成功返回0，否则返回1
+ */
+int query_scores_columnar(int length, const char *key, const char *content, struct ColumnarResult **result_to_return);
+
+/**
+ * @brief 按列查询用户，文本列依次为 id、username、hashpass、salt、name、class_name、belong_to，整数列依次为 role、number
+ *
+ * @details 不读取用户缓存，按 id 查询单个用户仍然使用 query_user_info 或 query_users_info_all
+ *
+ * @param length 查询结果的限制数量
+ * @param key 可选的过滤键，如果为 NULL 或空字符串，则不进行过滤
+ * @param content 可选的过滤值，与 key 对应
+ * @param result_to_return 返回新分配的列式查询结果，由调用方使用 free_columnar_result 释放
+ * @return int 成功返回0，否则返回1
+ */
+int query_users_columnar(int length, const char *key, const char *content, struct ColumnarResult **result_to_return);
+
+/**
+ * @brief 释放列式查询结果，result 为 NULL 时什么都不做
+ *
+ * @param result 列式查询结果
+ */
+void free_columnar_result(struct ColumnarResult *result);
+
+/**
+ * @brief 获取写冲突重试的统计信息
+ *
+ * @details 增删改语句遇到 SQLITE_BUSY 或 SQLITE_LOCKED 时会按带抖动的指数退避重试，这里返回累计的重试情况
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_database_retry_stats(struct DatabaseRetryStats *stats_to_return);
+
+/**
+ * @brief 设置慢查询日志
+ *
+ * @details 执行时间不少于阈值的语句会连同展开参数后的 SQL 和执行时间写入 logs/slow_query.log，
+ *          explain 非0时还会附带语句的 EXPLAIN QUERY PLAN。默认阈值为 100 毫秒，不记录查询计划。
+ *          执行时间由 SQLite 的 VFS 时钟测量，精度一般只有毫秒级
+ *
+ * @param threshold_ms 慢查询阈值（毫秒），小于0时关闭慢查询日志
+ * @param explain 非0时同时记录查询计划
+ * @return int 成功返回0，否则返回1
+ */
+int set_slow_query_log(int threshold_ms, int explain);
+
+/**
+ * @brief 设置数据库的位置
+ *
+ * @details location 可以是目录路径（三个数据库文件放在该目录下，可以指向 tmpfs），":memory:"、"file::memory:"
+ *          或 "memory:名称"（共享缓存的内存数据库，同一进程内不同名称互相隔离），NULL 或空字符串表示使用环境变量
+ *          MENTAL_DB_LOCATION，没有设置时恢复默认的 db 文件夹。只能在其他线程开始访问数据库之前调用
+ *
+ * @param location 数据库位置
+ * @return int 成功返回0，否则返回1
+ */
+int set_database_location(const char *location);
+
+/**
+ * @brief 获取当前数据库所在的文件夹，数据库之外需要持久化的文件（如吊销列表）保存在这里
+ *
+ * @param folder_to_return 返回的文件夹路径，数据库在内存中时为空字符串
+ * @param size folder_to_return 的大小
+ * @return int 成功返回0，缓冲区不够或者参数为 NULL 时返回1
+ */
+int get_database_folder(char *folder_to_return, int size);
+
+/**
+ * @brief 在当前的数据库位置建立缺少的表，对已经初始化过的数据库重复调用没有影响
+ *
+ * @return int 成功返回0，否则返回1
+ */
+int initialize_schema(void);
+
+/**
+ * @brief 在线备份三个数据库，备份期间其他线程可以照常读写
+ *
+ * @details 先在同一时刻为三个数据库取快照，再用 sqlite3_backup_step 分批复制，每批之间暂停一下，减少对写入者的影响。
+ *          备份先写入 NAME.partial，完成后改名为 examination.db、score.db、user.db
+ *
+ * @param target_dir 备份保存的文件夹
+ * @param pages_per_step 每一步复制的页数，小于等于0时使用默认值
+ * @param sleep_ms 两步之间暂停的毫秒数，小于0时使用默认值
+ * @return int 成功返回0，否则返回1
+ */
+int backup_databases(const char *target_dir, int pages_per_step, int sleep_ms);
+
+/**
+ * @brief 获取最近一次备份的进度
+ *
+ * @param progress_to_return 返回的进度
+ * @return int 成功返回0，否则返回1
+ */
+int get_backup_progress(struct BackupProgress *progress_to_return);
+
+/**
+ * @brief 刷新报表副本：把 score.db 和 user.db 中发生过变化的数据库复制到没有在用的一份副本，然后切换过去
+ *
+ * @return int 成功返回0（包括没有变化、不需要刷新的情况），否则返回1
+ */
+int refresh_reporting_replica(void);
+
+/**
+ * @brief 设置当前线程的成绩、用户批量查询是否读取报表副本，副本还没有刷新过时仍然读取源数据库
+ *
+ * @param enabled 非0表示读取副本
+ * @return int 设置之前的值
+ */
+int set_reporting_reads(int enabled);
+
+/**
+ * @brief 获取报表副本的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_reporting_replica_stats(struct ReplicaStats *stats_to_return);
+
+/**
+ * @brief 查询一场考试的成绩统计（平均分、最低分、最高分、标准差、及格率和分数直方图）
+ *
+ * @details 统计由 scores 表上的触发器在写入成绩的同一个事务中维护，查询只读取一行统计和最多 101 行直方图，与成绩条数无关
+ *
+ * @param exam_id 考试ID
+ * @param stats_to_return 返回的统计，没有成绩时各项均为0
+ * @return int 成功返回0，否则返回1
+ */
+int query_exam_stats(const char *exam_id, struct ExamStats *stats_to_return);
+
+/**
+ * @brief 由 scores 表重新计算所有考试的成绩统计
+ *
+ * @return int 成功返回0，否则返回1
+ */
+int rebuild_exam_stats(void);
+
+/**
+ * @brief 检查成绩统计与 scores 表是否一致
+ *
+ * @param mismatches_to_return 返回统计不一致的考试数量
+ * @return int 检查完成返回0（无论是否一致），检查失败返回1
+ */
+int check_exam_stats(int *mismatches_to_return);
+
+/**
+ * @brief 查询考生在一场考试中的名次和百分位
+ *
+ * @param exam_id 考试ID
+ * @param user_id 考生的用户ID
+ * @param rank_to_return 返回的排名，考生没有成绩时 found 为0
+ * @return int 成功返回0（包括没有成绩的情况），否则返回1
+ */
+int score_rank(const char *exam_id, const char *user_id, struct ScoreRank *rank_to_return);
+
+/**
+ * @brief 查询一场考试分数最高的 k 条成绩，同分时先交卷的在前
+ *
+ * @param exam_id 考试ID
+ * @param k 最多返回的条数，不超过 scores_to_return 的长度
+ * @param scores_to_return 返回的成绩，没有用到的元素 id 为空字符串
+ * @return int 成功返回0，否则返回1
+ */
+int top_scores(const char *exam_id, int k, struct SqlResponseScore *scores_to_return);
+
+/**
+ * @brief 查询一位教师各个班级在各场考试中的成绩汇总
+ *
+ * @param teacher_id 教师ID
+ * @param class_name 只查询这个班级，NULL 或空字符串表示所有班级
+ * @param exam_id 只查询这场考试，NULL 或空字符串表示所有考试
+ * @param with_histogram 非0时同时读取分数直方图、最低分和最高分
+ * @param cells_to_return 返回的单元格数组，按班级、考试ID排序
+ * @param length 数组的大小
+ * @param count_to_return 返回实际的单元格数量
+ * @return int 成功返回0，否则返回1
+ */
+int query_class_cube(const char *teacher_id, const char *class_name, const char *exam_id, int with_histogram,
+                     struct ClassCubeCell *cells_to_return, int length, int *count_to_return);
+
+/**
+ * @brief 由用户表和 scores 表重新计算所有班级统计
+ *
+ * @return int 成功返回0，否则返回1
+ */
+int rebuild_class_cube(void);
+
+/**
+ * @brief 保存一次交卷的答题记录，记录格式见 answer_log.h
+ *
+ * @param score_id 这次交卷的成绩ID
+ * @param exam_id 考试ID
+ * @param user_id 答题的用户ID
+ * @param seed 题目顺序的随机种子，0 表示没有打乱
+ * @param question_count 题目数量
+ * @param correct 每道题是否答对，按考卷中的原始顺序
+ * @param answers 每道题的答案，按考卷中的原始顺序，NaN 表示没有作答
+ * @return int 成功返回0，否则返回1
+ */
+int insert_answer_log(const char *score_id, const char *exam_id, const char *user_id, unsigned int seed, int question_count,
+                      const unsigned char *correct, const float *answers);
+
+/**
+ * @brief 读取一次交卷的答题记录
+ *
+ * @param exam_id 考试ID
+ * @param score_id 成绩ID
+ * @param header_to_return 返回记录的头部，没有找到记录时 question_count 为 -1
+ * @param correct_to_return 返回每道题是否答对，按考卷中的原始顺序
+ * @param answers_to_return 返回每道答错的题目的答案，答对和没有作答的题目为 NaN
+ * @param capacity 两个数组的大小
+ * @return int 成功返回0（包括没有找到记录的情况），否则返回1
+ */
+int query_answer_log(const char *exam_id, const char *score_id, struct AnswerLogHeader *header_to_return,
+                     unsigned char *correct_to_return, float *answers_to_return, int capacity);
+
+/**
+ * @brief 读取一场考试答题记录的版本号，版本号与 known_version 不同时逐条读取这场考试的全部答题记录
+ *
+ * @param exam_id 考试ID
+ * @param known_version 调用者已经读取过的版本号，相同时不读取记录；传入 -1 时总是读取
+ * @param visitor 每条记录调用一次的回调函数，返回非0时停止读取
+ * @param context 传给回调函数的上下文
+ * @param version_to_return 返回当前的版本号，这场考试还没有答题记录时为0
+ * @return int 成功返回0（包括回调函数要求停止的情况），否则返回1
+ */
+int scan_answer_logs(const char *exam_id, long long known_version, answer_log_visitor visitor, void *context,
+                     long long *version_to_return);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,618 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: exam_cache.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了考卷缓存。考试开始时同一个班的学生几乎同时请求同一张考卷，
+                缓存命中时直接从内存复制考试信息和题目，不再访问数据库，也不再重复计算正确答案
+Others:         cache_lock 保护缓存条目；load_lock 保证同一时间只有一个线程从数据库加载考卷，
+                其他同时未命中的线程拿到 load_lock 之后会先重新检查缓存，避免重复加载
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了考卷的加载、缓存、失效和统计
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 加载考卷时预先生成响应的 JSON 片段，添加了 render_exam_paper_json 函数，
+                            下发考卷时只需要按题目顺序复制片段，不再逐个字段编码
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 考卷版本号改为由考卷内容计算的哈希值，不再使用进程内的计数器，
+                            服务重启或者多个进程同时提供服务时，同样的版本号一定对应同样的考卷
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "exam_cache.h"
+#include "database.h"
+#include "app.h"
+#include "utils.h"
+
+/*** 版本号哈希部分 ***/
+#define VERSION_HASH_OFFSET 14695981039346656037ULL // FNV-1a 64 位的初始值
+#define VERSION_HASH_PRIME 1099511628211ULL         // FNV-1a 64 位的乘数
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/**
+ * @brief 缓存中的一张考卷
+ */
+struct ExamCacheEntry
+{
+    int used;                            // 条目是否有效
+    struct SqlResponseExam exam;         // 考试信息，exam.id 即缓存键
+    struct ExamPaperQuestion *questions; // 题目数组
+    int count;                           // 题目数量
+    unsigned long long version;          // 考卷版本号
+    unsigned long long last_used;        // 最近一次使用的时刻，用于淘汰
+    char *json;                          // 预先生成的 JSON，前 fragment_offsets[0] 字节是响应开头，之后依次是每道题目的片段
+    int *fragment_offsets;               // 第 i 道题目的片段为 json[fragment_offsets[i], fragment_offsets[i + 1])，每个片段以逗号结尾
+};
+
+/**
+ * @brief 可增长的字符串缓冲区，用于生成 JSON
+ */
+struct JsonBuilder
+{
+    char *data;   // 缓冲区
+    int length;   // 已写入的长度
+    int capacity; // 缓冲区大小
+    int failed;   // 分配内存是否失败过
+};
+
+static struct ExamCacheEntry entries[EXAM_CACHE_CAPACITY]; // 缓存条目
+static unsigned long long clock_tick;                       // 逻辑时钟，每次访问加一
+static unsigned long long generation;                       // 缓存代数，每次失效加一
+static struct ExamCacheStats stats;                         // 统计信息
+static app_mutex_t cache_lock = APP_MUTEX_INITIALIZER;      // 保护以上数据的互斥锁
+static app_mutex_t load_lock = APP_MUTEX_INITIALIZER;       // 保证同一时间只有一个线程加载考卷
+
+/**
+ * @brief 查找考试ID对应的缓存条目，调用前需要持有 cache_lock
+ *
+ * @param exam_id 考试ID
+ * @return struct ExamCacheEntry* 找到返回条目，否则返回 NULL
+ */
+static struct ExamCacheEntry *find_entry(const char *exam_id)
+{
+    for (int i = 0; i < EXAM_CACHE_CAPACITY; i++)
+    {
+        if (entries[i].used && strcmp(entries[i].exam.id, exam_id) == 0)
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 释放缓存条目，调用前需要持有 cache_lock
+ *
+ * @param entry 缓存条目
+ */
+static void release_entry(struct ExamCacheEntry *entry)
+{
+    free(entry->questions);
+    free(entry->json);
+    free(entry->fragment_offsets);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * @brief 将缓存条目中的考卷复制给调用方，调用前需要持有 cache_lock
+ */
+static void copy_out(const struct ExamCacheEntry *entry, struct SqlResponseExam *exam_to_return, struct ExamPaperQuestion *questions_to_return, int length, int *count_to_return, unsigned long long *version_to_return)
+{
+    *exam_to_return = entry->exam;
+    int n = entry->count < length ? entry->count : length;
+    if (n > 0)
+    {
+        memcpy(questions_to_return, entry->questions, sizeof(struct ExamPaperQuestion) * n);
+    }
+    *count_to_return = entry->count;
+    if (version_to_return)
+    {
+        *version_to_return = entry->version;
+    }
+}
+
+/**
+ * @brief 在缓存中查找考卷，命中时复制给调用方
+ *
+ * @return int 命中返回0，未命中返回1
+ */
+static int lookup(const char *exam_id, struct SqlResponseExam *exam_to_return, struct ExamPaperQuestion *questions_to_return, int length, int *count_to_return, unsigned long long *version_to_return)
+{
+    app_mutex_lock(&cache_lock);
+    struct ExamCacheEntry *entry = find_entry(exam_id);
+    if (entry)
+    {
+        entry->last_used = ++clock_tick;
+        stats.hits++;
+        copy_out(entry, exam_to_return, questions_to_return, length, count_to_return, version_to_return);
+    }
+    app_mutex_unlock(&cache_lock);
+    return entry ? 0 : 1;
+}
+
+/**
+ * @brief 从数据库加载考卷的题目并预先计算正确答案
+ *
+ * @param exam_id 考试ID
+ * @param questions_to_return 返回新分配的题目数组，由调用方释放
+ * @param count_to_return 返回题目数量
+ * @return int 成功返回0，否则返回1
+ */
+static int load_questions(const char *exam_id, struct ExamPaperQuestion **questions_to_return, int *count_to_return)
+{
+    // query_questions_info_all 不会清空没有用到的元素，以 id 为空判断结尾，所以这里要用 calloc
+    struct SqlResponseQuestion *rows = calloc(EXAM_PAPER_MAX_QUESTIONS, sizeof(struct SqlResponseQuestion));
+    if (rows == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为考卷 %s 的题目分配内存失败", exam_id);
+        return 1;
+    }
+    if (query_questions_info_all(rows, EXAM_PAPER_MAX_QUESTIONS, "exam_id", exam_id))
+    {
+        free(rows);
+        return 1;
+    }
+
+    int count = 0;
+    while (count < EXAM_PAPER_MAX_QUESTIONS && rows[count].id[0] != '\0')
+    {
+        count++;
+    }
+
+    struct ExamPaperQuestion *questions = malloc(sizeof(struct ExamPaperQuestion) * (count > 0 ? count : 1));
+    if (questions == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为考卷 %s 的题目分配内存失败", exam_id);
+        free(rows);
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        memcpy(questions[i].id, rows[i].id, sizeof(questions[i].id));
+        questions[i].num1 = rows[i].num1;
+        questions[i].op = rows[i].op;
+        questions[i].num2 = rows[i].num2;
+        questions[i].answer = calculate_result(rows[i].num1, rows[i].num2, rows[i].op);
+    }
+    free(rows);
+
+    *questions_to_return = questions;
+    *count_to_return = count;
+    return 0;
+}
+
+/**
+ * @brief 向缓冲区追加字节，缓冲区不够时扩大一倍
+ *
+ * @param builder 缓冲区
+ * @param text 要追加的字节
+ * @param length 字节数
+ */
+static void json_append(struct JsonBuilder *builder, const char *text, int length)
+{
+    if (builder->failed)
+    {
+        return;
+    }
+    if (builder->length + length > builder->capacity)
+    {
+        int capacity = builder->capacity ? builder->capacity : 1024;
+        while (builder->length + length > capacity)
+        {
+            capacity *= 2;
+        }
+        char *data = realloc(builder->data, capacity);
+        if (data == NULL)
+        {
+            builder->failed = 1;
+            return;
+        }
+        builder->data = data;
+        builder->capacity = capacity;
+    }
+    memcpy(builder->data + builder->length, text, length);
+    builder->length += length;
+}
+
+/**
+ * @brief 向缓冲区追加字符串常量，长度在编译期确定
+ */
+#define json_append_literal(builder, text) json_append((builder), (text), (int)sizeof(text) - 1)
+
+/**
+ * @brief 向缓冲区追加格式化的文本，只用于整数等不需要转义的内容
+ */
+static void json_append_format(struct JsonBuilder *builder, const char *format, long long value)
+{
+    char text[64];
+    int length = snprintf(text, sizeof(text), format, value);
+    json_append(builder, text, length);
+}
+
+/**
+ * @brief 向缓冲区追加一个 JSON 字符串（带引号），转义引号、反斜杠和控制字符
+ */
+static void json_append_string(struct JsonBuilder *builder, const char *text)
+{
+    json_append_literal(builder, "\"");
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            char escaped[2] = {'\\', (char)*p};
+            json_append(builder, escaped, 2);
+        }
+        else if (*p < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", *p);
+            json_append(builder, escaped, 6);
+        }
+        else
+        {
+            json_append(builder, (const char *)p, 1);
+        }
+    }
+    json_append_literal(builder, "\"");
+}
+
+/**
+ * @brief 将一段字节混入 FNV-1a 哈希值
+ *
+ * @param hash 当前的哈希值
+ * @param data 要混入的字节
+ * @param length 字节数
+ * @return unsigned long long 混入后的哈希值
+ */
+static unsigned long long hash_bytes(unsigned long long hash, const void *data, size_t length)
+{
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= VERSION_HASH_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 由考卷内容计算版本号，内容相同的考卷在任何进程中得到相同的版本号
+ *
+ * @details 逐个字段混入而不是整个结构体，避免结构体的填充字节影响结果。字符串连同结尾的 \0 一起混入，
+ *          使相邻字段的边界不会混淆。正确答案由题目计算得到，不需要单独混入
+ *
+ * @param entry 刚加载的考卷
+ * @return unsigned long long 版本号，不会为0（0 表示考试不存在）
+ */
+static unsigned long long content_version(const struct ExamCacheEntry *entry)
+{
+    unsigned long long hash = VERSION_HASH_OFFSET;
+    hash = hash_bytes(hash, entry->exam.id, strlen(entry->exam.id) + 1);
+    hash = hash_bytes(hash, entry->exam.name, strlen(entry->exam.name) + 1);
+    hash = hash_bytes(hash, &entry->exam.start_time, sizeof(entry->exam.start_time));
+    hash = hash_bytes(hash, &entry->exam.end_time, sizeof(entry->exam.end_time));
+    hash = hash_bytes(hash, &entry->exam.allow_answer_when_expired, sizeof(entry->exam.allow_answer_when_expired));
+    hash = hash_bytes(hash, &entry->exam.random_question, sizeof(entry->exam.random_question));
+    hash = hash_bytes(hash, &entry->count, sizeof(entry->count));
+    for (int i = 0; i < entry->count; i++)
+    {
+        hash = hash_bytes(hash, entry->questions[i].id, strlen(entry->questions[i].id) + 1);
+        hash = hash_bytes(hash, &entry->questions[i].num1, sizeof(entry->questions[i].num1));
+        hash = hash_bytes(hash, &entry->questions[i].op, sizeof(entry->questions[i].op));
+        hash = hash_bytes(hash, &entry->questions[i].num2, sizeof(entry->questions[i].num2));
+    }
+    return hash ? hash : 1;
+}
+
+/**
+ * @brief 为考卷预先生成响应的 JSON：响应开头（到 metadata 的最后一个固定字段为止）和每道题目的片段
+ *
+ * @details 题目片段不包含正确答案，字段与接口层原来下发的题目相同。失败时 entry->json 为 NULL，
+ *          render_exam_paper_json 会返回失败，由接口层回退到逐个字段编码
+ *
+ * @param entry 刚加载的考卷
+ */
+static void build_json(struct ExamCacheEntry *entry)
+{
+    struct JsonBuilder builder = {0};
+    int *offsets = malloc(sizeof(int) * (entry->count + 1));
+    if (offsets == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为考卷 %s 的 JSON 片段分配内存失败", entry->exam.id);
+        return;
+    }
+
+    json_append_literal(&builder, "{\"success\":true,\"metadata\":{\"id\":");
+    json_append_string(&builder, entry->exam.id);
+    json_append_literal(&builder, ",\"name\":");
+    json_append_string(&builder, entry->exam.name);
+    json_append_format(&builder, ",\"start_time\":%lld", entry->exam.start_time);
+    json_append_format(&builder, ",\"end_time\":%lld", entry->exam.end_time);
+    json_append_format(&builder, ",\"allow_answer_when_expired\":%lld", entry->exam.allow_answer_when_expired);
+    json_append_format(&builder, ",\"random_question\":%lld", entry->exam.random_question);
+    for (int i = 0; i < entry->count; i++)
+    {
+        offsets[i] = builder.length;
+        json_append_format(&builder, "{\"num1\":%lld", entry->questions[i].num1);
+        json_append_format(&builder, ",\"op\":%lld", entry->questions[i].op);
+        json_append_format(&builder, ",\"num2\":%lld", entry->questions[i].num2);
+        json_append_literal(&builder, ",\"id\":");
+        json_append_string(&builder, entry->questions[i].id);
+        json_append_literal(&builder, ",\"exam_id\":");
+        json_append_string(&builder, entry->exam.id);
+        json_append_literal(&builder, "},");
+    }
+    offsets[entry->count] = builder.length;
+
+    if (builder.failed)
+    {
+        log_message(LOGLEVEL_ERROR, "为考卷 %s 的 JSON 片段分配内存失败", entry->exam.id);
+        free(builder.data);
+        free(offsets);
+        return;
+    }
+    entry->json = builder.data;
+    entry->fragment_offsets = offsets;
+}
+
+int get_exam_paper(const char *exam_id, struct SqlResponseExam *exam_to_return, struct ExamPaperQuestion *questions_to_return, int length, int *count_to_return, unsigned long long *version_to_return)
+{
+    if (exam_id == NULL || exam_to_return == NULL || count_to_return == NULL || (questions_to_return == NULL && length > 0))
+    {
+        log_message(LOGLEVEL_ERROR, "get_exam_paper 的参数不能为 NULL");
+        return 1;
+    }
+
+    if (lookup(exam_id, exam_to_return, questions_to_return, length, count_to_return, version_to_return) == 0)
+    {
+        return 0;
+    }
+
+    app_mutex_lock(&load_lock);
+    // 等待 load_lock 的时候其他线程可能已经加载好了
+    if (lookup(exam_id, exam_to_return, questions_to_return, length, count_to_return, version_to_return) == 0)
+    {
+        app_mutex_unlock(&load_lock);
+        return 0;
+    }
+
+    app_mutex_lock(&cache_lock);
+    stats.misses++;
+    unsigned long long expected_generation = generation;
+    app_mutex_unlock(&cache_lock);
+
+    struct ExamCacheEntry loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    if (query_exam_info("id", exam_id, &loaded.exam))
+    {
+        app_mutex_unlock(&load_lock);
+        return 1;
+    }
+    if (loaded.exam.id[0] == '\0')
+    {
+        // 考试不存在，不缓存
+        app_mutex_unlock(&load_lock);
+        *exam_to_return = loaded.exam;
+        *count_to_return = 0;
+        if (version_to_return)
+        {
+            *version_to_return = 0;
+        }
+        return 0;
+    }
+    if (load_questions(exam_id, &loaded.questions, &loaded.count))
+    {
+        app_mutex_unlock(&load_lock);
+        return 1;
+    }
+    loaded.used = 1;
+    loaded.version = content_version(&loaded);
+    build_json(&loaded);
+
+    app_mutex_lock(&cache_lock);
+    loaded.last_used = ++clock_tick;
+    copy_out(&loaded, exam_to_return, questions_to_return, length, count_to_return, version_to_return);
+    if (expected_generation == generation)
+    {
+        // 优先使用空闲条目，没有空闲条目时淘汰最久未使用的考卷
+        struct ExamCacheEntry *slot = NULL;
+        for (int i = 0; i < EXAM_CACHE_CAPACITY; i++)
+        {
+            if (!entries[i].used)
+            {
+                slot = &entries[i];
+                break;
+            }
+            if (slot == NULL || entries[i].last_used < slot->last_used)
+            {
+                slot = &entries[i];
+            }
+        }
+        if (slot->used)
+        {
+            release_entry(slot);
+            stats.evictions++;
+        }
+        *slot = loaded;
+        stats.size++;
+        // 所有权转移给缓存
+        loaded.questions = NULL;
+        loaded.json = NULL;
+        loaded.fragment_offsets = NULL;
+    }
+    app_mutex_unlock(&cache_lock);
+    app_mutex_unlock(&load_lock);
+
+    // 加载期间考卷被修改过，结果只返回给本次调用，不放进缓存
+    free(loaded.questions);
+    free(loaded.json);
+    free(loaded.fragment_offsets);
+    log_message(LOGLEVEL_INFO, "从数据库加载了考卷 %s，共 %d 道题目", exam_id, loaded.count);
+    return 0;
+}
+
+/**
+ * @brief 按题目顺序把缓存中的 JSON 片段复制到调用方的缓冲区，调用前需要持有 cache_lock
+ *
+ * @return int 成功返回0，缓冲区不够或没有预先生成的 JSON 返回1
+ */
+static int render_entry(const struct ExamCacheEntry *entry, unsigned int seed, const int *permutation, char *buffer, int buffer_size, int *length_to_return)
+{
+    if (entry->json == NULL)
+    {
+        *length_to_return = 0;
+        return 1;
+    }
+    char seed_text[32] = "";
+    int seed_length = 0;
+    if (entry->exam.random_question)
+    {
+        seed_length = snprintf(seed_text, sizeof(seed_text), ",\"seed\":%u", seed);
+    }
+    int prefix_length = entry->fragment_offsets[0];
+    int fragments_length = entry->fragment_offsets[entry->count] - prefix_length;
+    static const char data_marker[] = "},\"data\":[";
+    int marker_length = (int)sizeof(data_marker) - 1;
+    // 响应开头 + 种子 + data_marker + 题目片段（最后一个逗号换成 ']'）+ "}"
+    int length = prefix_length + seed_length + marker_length + (fragments_length ? fragments_length : 1) + 1;
+    *length_to_return = length;
+    if (length > buffer_size)
+    {
+        return 1;
+    }
+
+    char *p = buffer;
+    memcpy(p, entry->json, prefix_length);
+    p += prefix_length;
+    memcpy(p, seed_text, seed_length);
+    p += seed_length;
+    memcpy(p, data_marker, marker_length);
+    p += marker_length;
+    if (permutation == NULL)
+    {
+        // 不打乱顺序时所有片段是连续的，一次复制完
+        memcpy(p, entry->json + prefix_length, fragments_length);
+        p += fragments_length;
+    }
+    else
+    {
+        for (int i = 0; i < entry->count; i++)
+        {
+            int start = entry->fragment_offsets[permutation[i]];
+            int fragment_length = entry->fragment_offsets[permutation[i] + 1] - start;
+            memcpy(p, entry->json + start, fragment_length);
+            p += fragment_length;
+        }
+    }
+    if (fragments_length)
+    {
+        p--; // 覆盖最后一个片段结尾的逗号
+    }
+    *p++ = ']';
+    *p++ = '}';
+    return 0;
+}
+
+int render_exam_paper_json(const char *exam_id, unsigned int seed, char *buffer, int buffer_size, int *length_to_return, unsigned long long *version_to_return)
+{
+    if (exam_id == NULL || length_to_return == NULL || (buffer == NULL && buffer_size > 0))
+    {
+        log_message(LOGLEVEL_ERROR, "render_exam_paper_json 的参数不能为 NULL");
+        return 1;
+    }
+    *length_to_return = 0;
+
+    // 第一次未命中时加载考卷，加载之后如果立刻被修改导致失效，再重试一次
+    int permutation[EXAM_PAPER_MAX_QUESTIONS];
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        app_mutex_lock(&cache_lock);
+        struct ExamCacheEntry *entry = find_entry(exam_id);
+        int result = 1;
+        if (entry)
+        {
+            entry->last_used = ++clock_tick;
+            stats.hits++;
+            // 生成排列只是几百次整数运算，放在锁内可以保证和题目数量一致
+            int shuffled = entry->exam.random_question && seed != 0;
+            if (!shuffled || generate_question_permutation(seed, entry->count, permutation) == 0)
+            {
+                result = render_entry(entry, seed, shuffled ? permutation : NULL, buffer, buffer_size, length_to_return);
+            }
+            if (version_to_return)
+            {
+                *version_to_return = entry->version;
+            }
+        }
+        app_mutex_unlock(&cache_lock);
+        if (entry)
+        {
+            return result;
+        }
+
+        struct SqlResponseExam exam;
+        int count = 0;
+        if (get_exam_paper(exam_id, &exam, NULL, 0, &count, NULL) || exam.id[0] == '\0')
+        {
+            return 1; // 查询失败或者考试不存在
+        }
+    }
+    return 1;
+}
+
+void exam_cache_invalidate(const char *exam_id)
+{
+    if (exam_id == NULL)
+    {
+        return;
+    }
+    app_mutex_lock(&cache_lock);
+    generation++;
+    struct ExamCacheEntry *entry = find_entry(exam_id);
+    if (entry)
+    {
+        release_entry(entry);
+        stats.size--;
+        stats.invalidations++;
+    }
+    app_mutex_unlock(&cache_lock);
+}
+
+void exam_cache_clear(void)
+{
+    app_mutex_lock(&cache_lock);
+    generation++;
+    for (int i = 0; i < EXAM_CACHE_CAPACITY; i++)
+    {
+        if (entries[i].used)
+        {
+            release_entry(&entries[i]);
+        }
+    }
+    stats.size = 0;
+    app_mutex_unlock(&cache_lock);
+}
+
+int get_exam_cache_stats(struct ExamCacheStats *stats_to_return)
+{
+    if (stats_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 stats_to_return 为 NULL");
+        return 1;
+    }
+    app_mutex_lock(&cache_lock);
+    *stats_to_return = stats;
+    stats_to_return->capacity = EXAM_CACHE_CAPACITY;
+    app_mutex_unlock(&cache_lock);
+    return 0;
+}
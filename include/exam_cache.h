@@ -0,0 +1,105 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: exam_cache.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了考卷缓存。考卷由考试信息和该考试的全部题目（附带预先计算好的正确答案）组成，
+                按照考试 ID 缓存，每次加载都会分配一个新的版本号，考试或题目被修改时缓存失效
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了考卷结构体以及考卷缓存的查询、失效和统计函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 render_exam_paper_json 函数的声明
+ */
+
+#ifndef EXAM_CACHE_H
+#define EXAM_CACHE_H
+
+#include "model.h"
+
+/*** 缓存容量部分 ***/
+#define EXAM_CACHE_CAPACITY 32      // 同时缓存的考卷数量上限，超出时淘汰最久未使用的考卷
+#define EXAM_PAPER_MAX_QUESTIONS 999 // 单张考卷的最大题目数量，与接口层查询题目时的上限一致
+
+/**
+ * @brief 考卷中的一道题目
+ *
+ * @details 在 SqlResponseQuestion 的基础上去掉了考试 ID（整张考卷共用），加上了正确答案
+ */
+struct ExamPaperQuestion
+{
+    char id[37];  // 题目的唯一ID
+    int num1;     // 第一个操作数
+    int op;       // 运算符，0123分别对应+-*/
+    int num2;     // 第二个操作数
+    float answer; // 由 calculate_result 预先计算好的正确答案
+};
+
+/**
+ * @brief 考卷缓存的统计信息
+ */
+struct ExamCacheStats
+{
+    unsigned long long hits;          // 命中次数
+    unsigned long long misses;        // 未命中次数（需要从数据库加载）
+    unsigned long long evictions;     // 因容量不足而淘汰的考卷数
+    unsigned long long invalidations; // 因考试或题目被修改而失效的次数
+    int size;                         // 当前缓存的考卷数
+    int capacity;                     // 最大缓存的考卷数
+};
+
+/**
+ * @brief 获取考卷，优先从缓存读取，未命中时从数据库加载并写入缓存
+ *
+ * @param exam_id 考试ID
+ * @param exam_to_return 返回的考试信息，考试不存在时 id 为空字符串
+ * @param questions_to_return 返回的题目数组，按照题目在数据库中的顺序排列
+ * @param length 题目数组的大小，超出的题目不会返回
+ * @param count_to_return 返回考卷的题目总数（可能大于 length）
+ * @param version_to_return 返回考卷的版本号，由考卷内容计算，重启或者换一个进程后同样的考卷版本号不变，内容变化后版本号随之改变，可以为 NULL
+ * @return int 成功返回0（包括考试不存在的情况），否则返回1
+ */
+int get_exam_paper(const char *exam_id, struct SqlResponseExam *exam_to_return, struct ExamPaperQuestion *questions_to_return, int length, int *count_to_return, unsigned long long *version_to_return);
+
+/**
+ * @brief 将考卷渲染为学生端获取考卷接口的 JSON 响应，优先使用缓存中预先生成的 JSON 片段
+ *
+ * @details 响应格式为 {"success":true,"metadata":{...},"data":[...]}，题目不包含正确答案。
+ *          开启随机题目顺序的考试会在 metadata 中加上 seed，并按照 generate_question_permutation 的排列输出题目，
+ *          渲染只是按顺序复制片段，不会重新编码题目
+ *
+ * @param exam_id 考试ID
+ * @param seed 随机种子，考试没有开启随机题目顺序时忽略
+ * @param buffer 输出缓冲区，结果不以 \0 结尾
+ * @param buffer_size 输出缓冲区的大小
+ * @param length_to_return 返回 JSON 的长度；缓冲区不够时返回需要的大小，考试不存在时返回0
+ * @param version_to_return 返回考卷的版本号，可以为 NULL
+ * @return int 成功返回0，考试不存在、缓冲区不够或者其他错误返回1
+ */
+int render_exam_paper_json(const char *exam_id, unsigned int seed, char *buffer, int buffer_size, int *length_to_return, unsigned long long *version_to_return);
+
+/**
+ * @brief 使指定考试的考卷缓存失效，考试信息或题目被修改、删除、新增之后调用
+ *
+ * @param exam_id 考试ID
+ */
+void exam_cache_invalidate(const char *exam_id);
+
+/**
+ * @brief 清空所有考卷缓存，统计信息保留
+ */
+void exam_cache_clear(void);
+
+/**
+ * @brief 获取考卷缓存的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_exam_cache_stats(struct ExamCacheStats *stats_to_return);
+
+#endif
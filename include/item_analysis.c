@@ -0,0 +1,459 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: item_analysis.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了逐题分析。一次计算只读取每条答题记录一次，把总分、逐题答对情况和错误答案累加到
+                每次调用自己分配的累加结果中，最后再由累加结果得到每道题的难度、区分度和最常见的错误答案
+Others:         cache_lock 只保护缓存条目和统计信息，只在查找和放入缓存时短暂持有。
+                读取答题记录和计算都在锁外进行，一场考试的计算不会挡住其他考试的查询；
+                同一场考试同时未命中时可能各自计算一次，放入缓存时保留版本号较新的结果
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了逐题分析的计算、缓存和统计
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 累加结果改为每次调用在堆上分配，读取答题记录和计算时不再持有 cache_lock
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "item_analysis.h"
+#include "answer_log.h"
+#include "database.h"
+#include "utils.h"
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/*** 累加部分 ***/
+#define ITEM_ANALYSIS_INITIAL_WRONG_ANSWERS 4096 // 错误答案数组的初始大小，不够时加倍
+
+/**
+ * @brief 一次计算的累加结果
+ *
+ * @details 答卷的题目数量可能不同，总分按答卷的题目数量 n 分组累加在 coverage_* 中，
+ *          第 q 道题的答卷数量、总分之和就是所有 n > q 的分组之和，计算结束时由后往前累加一次得到。
+ *          错误答案按 (题目序号 << 32 | 答案的排序键) 保存，排序后相同的答案连续出现
+ */
+struct ItemAnalysisAccumulator
+{
+    long long submission_count;                                // 有效的答卷数量
+    long long skipped_count;                                   // 被跳过的答卷数量
+    int question_count;                                        // 最多的题目数量
+    long long coverage_count[ANSWER_LOG_MAX_QUESTIONS + 1];    // 题目数量为 n 的答卷数量
+    long long coverage_sum[ANSWER_LOG_MAX_QUESTIONS + 1];      // 题目数量为 n 的答卷的总分之和
+    long long coverage_sumsq[ANSWER_LOG_MAX_QUESTIONS + 1];    // 题目数量为 n 的答卷的总分平方之和
+    long long correct_count[ANSWER_LOG_MAX_QUESTIONS];         // 每道题答对的答卷数量
+    long long correct_total_sum[ANSWER_LOG_MAX_QUESTIONS];     // 每道题答对的答卷的总分之和
+    long long unanswered_count[ANSWER_LOG_MAX_QUESTIONS];      // 每道题没有作答的答卷数量
+    uint64_t *wrong_answers;                                   // 错误答案数组
+    size_t wrong_answer_count;                                 // 错误答案数量
+    size_t wrong_answer_capacity;                              // 错误答案数组的大小
+    int failed;                                                // 分配内存是否失败过
+    unsigned char correct[ANSWER_LOG_MAX_QUESTIONS];           // 解码当前记录用的临时数组
+    float answers[ANSWER_LOG_MAX_QUESTIONS];                   // 解码当前记录用的临时数组
+};
+
+/**
+ * @brief 缓存中的一场考试的分析结果
+ */
+struct ItemAnalysisCacheEntry
+{
+    int used;                           // 条目是否有效
+    char exam_id[37];                   // 考试ID，即缓存键
+    struct ItemAnalysisSummary summary; // 分析汇总，summary.version 为计算时答题记录的版本号
+    struct ItemStats *items;            // 逐题结果，长度为 summary.question_count
+    unsigned long long last_used;       // 最近一次使用的时刻，用于淘汰
+};
+
+static struct ItemAnalysisCacheEntry entries[ITEM_ANALYSIS_CACHE_CAPACITY]; // 缓存条目
+static unsigned long long clock_tick;                                       // 逻辑时钟，每次访问加一
+static unsigned long long generation;                                       // 缓存代数，每次清空加一
+static struct ItemAnalysisCacheStats stats;                                 // 统计信息
+static app_mutex_t cache_lock = APP_MUTEX_INITIALIZER;                      // 保护以上数据的互斥锁
+
+/**
+ * @brief 把答案转换为排序键，排序键的无符号大小顺序与答案的大小顺序相同
+ */
+static uint32_t answer_to_key(float answer)
+{
+    uint32_t bits;
+    if (answer == 0)
+    {
+        answer = 0; // -0 与 0 视为同一个答案
+    }
+    memcpy(&bits, &answer, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+/**
+ * @brief answer_to_key 的逆运算
+ */
+static float key_to_answer(uint32_t key)
+{
+    uint32_t bits = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+    float answer;
+    memcpy(&answer, &bits, sizeof(answer));
+    return answer;
+}
+
+static int compare_wrong_answers(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 把一条答题记录累加到累加结果中，作为 scan_answer_logs 的回调函数
+ *
+ * @details 总分就是记录头部中位图的 popcount；逐题累加只遍历位图中为1的位，每次取最低位后清除。
+ *          损坏的记录计入 skipped_count 后跳过
+ *
+ * @return int 返回0继续读取，分配内存失败时返回1停止读取
+ */
+static int accumulate_record(const unsigned char *record, int length, void *context)
+{
+    struct ItemAnalysisAccumulator *acc = context;
+    struct AnswerLogHeader header;
+    if (answer_log_decode(record, length, &header, acc->correct, acc->answers, ANSWER_LOG_MAX_QUESTIONS))
+    {
+        acc->skipped_count++;
+        return 0;
+    }
+    int n = header.question_count;
+    long long total = header.correct_count;
+    acc->submission_count++;
+    if (n > acc->question_count)
+    {
+        acc->question_count = n;
+    }
+    acc->coverage_count[n]++;
+    acc->coverage_sum[n] += total;
+    acc->coverage_sumsq[n] += total * total;
+
+    const unsigned char *bitmap = record + header.bitmap_offset;
+    int bitmap_bytes = (n + 7) / 8;
+    for (int b = 0; b < bitmap_bytes; b++)
+    {
+        unsigned int bits = bitmap[b];
+        if (b == bitmap_bytes - 1 && (n & 7))
+        {
+            bits &= (1u << (n & 7)) - 1; // 最后一个字节中超出题目数量的位不计
+        }
+        while (bits)
+        {
+            int q = b * 8 + __builtin_ctz(bits);
+            acc->correct_count[q]++;
+            acc->correct_total_sum[q] += total;
+            bits &= bits - 1;
+        }
+    }
+
+    for (int q = 0; q < n; q++)
+    {
+        if (acc->correct[q])
+        {
+            continue;
+        }
+        if (isnan(acc->answers[q]))
+        {
+            acc->unanswered_count[q]++;
+            continue;
+        }
+        if (acc->wrong_answer_count == acc->wrong_answer_capacity)
+        {
+            size_t capacity = acc->wrong_answer_capacity ? acc->wrong_answer_capacity * 2 : ITEM_ANALYSIS_INITIAL_WRONG_ANSWERS;
+            uint64_t *grown = realloc(acc->wrong_answers, sizeof(uint64_t) * capacity);
+            if (grown == NULL)
+            {
+                acc->failed = 1;
+                return 1;
+            }
+            acc->wrong_answers = grown;
+            acc->wrong_answer_capacity = capacity;
+        }
+        acc->wrong_answers[acc->wrong_answer_count++] = ((uint64_t)q << 32) | answer_to_key(acc->answers[q]);
+    }
+    return 0;
+}
+
+/**
+ * @brief 由累加结果计算分析汇总和逐题结果，会对累加结果中的错误答案排序
+ *
+ * @param acc 累加结果
+ * @param summary_to_return 返回的分析汇总，version 不会被修改
+ * @param items_to_return 返回的逐题结果，长度至少为 acc->question_count
+ */
+static void finish_analysis(struct ItemAnalysisAccumulator *acc, struct ItemAnalysisSummary *summary_to_return, struct ItemStats *items_to_return)
+{
+    long long count = 0, sum = 0, sumsq = 0;
+    for (int n = 0; n <= acc->question_count; n++)
+    {
+        count += acc->coverage_count[n];
+        sum += acc->coverage_sum[n];
+        sumsq += acc->coverage_sumsq[n];
+    }
+    summary_to_return->submission_count = acc->submission_count;
+    summary_to_return->skipped_count = acc->skipped_count;
+    summary_to_return->question_count = acc->question_count;
+    summary_to_return->mean_correct = count ? (double)sum / count : 0;
+    double variance = count ? (double)sumsq / count - summary_to_return->mean_correct * summary_to_return->mean_correct : 0;
+    summary_to_return->stddev_correct = variance > 0 ? sqrt(variance) : 0;
+
+    // 由后往前累加，得到包含第 q 道题的答卷的数量、总分之和与总分平方之和
+    long long attempts = 0;
+    sum = 0;
+    sumsq = 0;
+    for (int q = acc->question_count - 1; q >= 0; q--)
+    {
+        attempts += acc->coverage_count[q + 1];
+        sum += acc->coverage_sum[q + 1];
+        sumsq += acc->coverage_sumsq[q + 1];
+
+        struct ItemStats *item = &items_to_return[q];
+        long long correct = acc->correct_count[q];
+        memset(item, 0, sizeof(*item));
+        item->question_index = q;
+        item->attempts = attempts;
+        item->correct_count = correct;
+        item->unanswered_count = acc->unanswered_count[q];
+        item->top_wrong_answer = NAN;
+        if (attempts == 0)
+        {
+            continue;
+        }
+        double p = (double)correct / attempts;
+        double mean = (double)sum / attempts;
+        double item_variance = (double)sumsq / attempts - mean * mean;
+        item->p_value = p;
+        if (correct > 0 && correct < attempts && item_variance > 0)
+        {
+            double mean_correct = (double)acc->correct_total_sum[q] / correct;
+            double mean_wrong = (double)(sum - acc->correct_total_sum[q]) / (attempts - correct);
+            item->point_biserial = (mean_correct - mean_wrong) / sqrt(item_variance) * sqrt(p * (1 - p));
+        }
+    }
+
+    // 排序后同一道题的同一个答案连续出现，按答案从小到大，次数相同时保留先出现的（较小的）答案
+    qsort(acc->wrong_answers, acc->wrong_answer_count, sizeof(uint64_t), compare_wrong_answers);
+    for (size_t i = 0, j; i < acc->wrong_answer_count; i = j)
+    {
+        for (j = i + 1; j < acc->wrong_answer_count && acc->wrong_answers[j] == acc->wrong_answers[i]; j++)
+        {
+        }
+        struct ItemStats *item = &items_to_return[acc->wrong_answers[i] >> 32];
+        if ((long long)(j - i) > item->top_wrong_count)
+        {
+            item->top_wrong_count = (long long)(j - i);
+            item->top_wrong_answer = key_to_answer((uint32_t)acc->wrong_answers[i]);
+        }
+    }
+}
+
+/**
+ * @brief 查找考试ID对应的缓存条目，调用前需要持有 cache_lock
+ *
+ * @param exam_id 考试ID
+ * @return struct ItemAnalysisCacheEntry* 找到返回条目，否则返回 NULL
+ */
+static struct ItemAnalysisCacheEntry *find_entry(const char *exam_id)
+{
+    for (int i = 0; i < ITEM_ANALYSIS_CACHE_CAPACITY; i++)
+    {
+        if (entries[i].used && strcmp(entries[i].exam_id, exam_id) == 0)
+        {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 释放缓存条目，调用前需要持有 cache_lock
+ *
+ * @param entry 缓存条目
+ */
+static void release_entry(struct ItemAnalysisCacheEntry *entry)
+{
+    free(entry->items);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * @brief 为考试分配一个缓存条目，没有空闲条目时淘汰最久未使用的条目，调用前需要持有 cache_lock
+ *
+ * @param exam_id 考试ID
+ * @return struct ItemAnalysisCacheEntry* 分配的条目
+ */
+static struct ItemAnalysisCacheEntry *allocate_entry(const char *exam_id)
+{
+    struct ItemAnalysisCacheEntry *victim = &entries[0];
+    for (int i = 0; i < ITEM_ANALYSIS_CACHE_CAPACITY; i++)
+    {
+        if (!entries[i].used)
+        {
+            victim = &entries[i];
+            break;
+        }
+        if (entries[i].last_used < victim->last_used)
+        {
+            victim = &entries[i];
+        }
+    }
+    if (victim->used)
+    {
+        release_entry(victim);
+        stats.evictions++;
+        stats.size--;
+    }
+    victim->used = 1;
+    snprintf(victim->exam_id, sizeof(victim->exam_id), "%s", exam_id);
+    stats.size++;
+    return victim;
+}
+
+/**
+ * @brief 把缓存中的结果复制给调用者，调用前需要持有 cache_lock
+ */
+static void copy_out(const struct ItemAnalysisSummary *summary, const struct ItemStats *items, struct ItemAnalysisSummary *summary_to_return,
+                     struct ItemStats *items_to_return, int capacity)
+{
+    *summary_to_return = *summary;
+    int n = summary->question_count < capacity ? summary->question_count : capacity;
+    if (n > 0)
+    {
+        memcpy(items_to_return, items, sizeof(struct ItemStats) * (size_t)n);
+    }
+}
+
+int query_item_analysis(const char *exam_id, struct ItemAnalysisSummary *summary_to_return, struct ItemStats *items_to_return, int capacity)
+{
+    if (exam_id == NULL || summary_to_return == NULL || (capacity > 0 && items_to_return == NULL))
+    {
+        log_message(LOGLEVEL_ERROR, "参数 exam_id、summary_to_return 或 items_to_return 为 NULL");
+        return 1;
+    }
+    if (strlen(exam_id) >= sizeof(entries[0].exam_id))
+    {
+        log_message(LOGLEVEL_ERROR, "考试ID '%s' 太长", exam_id);
+        return 1;
+    }
+
+    app_mutex_lock(&cache_lock);
+    struct ItemAnalysisCacheEntry *entry = find_entry(exam_id);
+    long long known_version = entry ? entry->summary.version : -1;
+    unsigned long long expected_generation = generation;
+    app_mutex_unlock(&cache_lock);
+
+    struct ItemAnalysisAccumulator *acc = calloc(1, sizeof(struct ItemAnalysisAccumulator));
+    if (acc == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为考试 '%s' 的逐题分析分配内存失败", exam_id);
+        return 1;
+    }
+    long long version = 0;
+    // 版本号与缓存一致时 scan_answer_logs 不读取记录；这期间缓存的结果可能已经被淘汰，此时再完整读取一次
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        if (scan_answer_logs(exam_id, known_version, accumulate_record, acc, &version) || acc->failed)
+        {
+            free(acc->wrong_answers);
+            free(acc);
+            log_message(LOGLEVEL_ERROR, "无法读取考试 '%s' 的答题记录", exam_id);
+            return 1;
+        }
+        if (version != known_version)
+        {
+            break;
+        }
+
+        app_mutex_lock(&cache_lock);
+        entry = find_entry(exam_id);
+        if (entry && entry->summary.version == version)
+        {
+            stats.hits++;
+            entry->last_used = ++clock_tick;
+            copy_out(&entry->summary, entry->items, summary_to_return, items_to_return, capacity);
+            app_mutex_unlock(&cache_lock);
+            free(acc);
+            return 0;
+        }
+        app_mutex_unlock(&cache_lock);
+        known_version = -1;
+    }
+
+    int count = acc->question_count;
+    struct ItemAnalysisSummary summary;
+    struct ItemStats *items = malloc(sizeof(struct ItemStats) * (size_t)(count > 0 ? count : 1));
+    if (items == NULL)
+    {
+        free(acc->wrong_answers);
+        free(acc);
+        log_message(LOGLEVEL_ERROR, "为考试 '%s' 的逐题分析分配内存失败", exam_id);
+        return 1;
+    }
+    memset(&summary, 0, sizeof(summary));
+    finish_analysis(acc, &summary, items);
+    summary.version = version;
+    free(acc->wrong_answers);
+    free(acc);
+
+    app_mutex_lock(&cache_lock);
+    stats.misses++;
+    copy_out(&summary, items, summary_to_return, items_to_return, capacity);
+    // 计算期间缓存被清空过（数据库位置改变）时结果只返回给本次调用；
+    // 其他线程可能在这期间放入了更新的结果，只有缓存中没有这场考试或者结果更旧时才替换
+    entry = find_entry(exam_id);
+    if (expected_generation == generation && (entry == NULL || entry->summary.version < version))
+    {
+        if (entry == NULL)
+        {
+            entry = allocate_entry(exam_id);
+        }
+        free(entry->items);
+        entry->items = items;
+        entry->summary = summary;
+        entry->last_used = ++clock_tick;
+        items = NULL;
+    }
+    app_mutex_unlock(&cache_lock);
+    free(items);
+    return 0;
+}
+
+void item_analysis_cache_clear(void)
+{
+    app_mutex_lock(&cache_lock);
+    for (int i = 0; i < ITEM_ANALYSIS_CACHE_CAPACITY; i++)
+    {
+        if (entries[i].used)
+        {
+            release_entry(&entries[i]);
+        }
+    }
+    stats.size = 0;
+    generation++;
+    app_mutex_unlock(&cache_lock);
+}
+
+int get_item_analysis_cache_stats(struct ItemAnalysisCacheStats *stats_to_return)
+{
+    if (stats_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 stats_to_return 为 NULL");
+        return 1;
+    }
+    app_mutex_lock(&cache_lock);
+    *stats_to_return = stats;
+    stats_to_return->capacity = ITEM_ANALYSIS_CACHE_CAPACITY;
+    app_mutex_unlock(&cache_lock);
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: item_analysis.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了逐题分析。由一场考试的全部答题记录计算每道题的难度（答对率）、区分度（点二列相关系数）
+                以及最常见的错误答案，结果按考试缓存，考试有新的答题记录时失效
+Others:         答题记录的格式见 answer_log.h，读取答题记录的函数见 database.h 中的 scan_answer_logs
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了逐题分析的结构体以及查询、清空缓存和统计函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 更新了 query_item_analysis 的并发说明
+ */
+
+#ifndef ITEM_ANALYSIS_H
+#define ITEM_ANALYSIS_H
+
+/*** 缓存容量部分 ***/
+#define ITEM_ANALYSIS_CACHE_CAPACITY 16 // 同时缓存的考试数量上限，超出时淘汰最久未使用的考试
+
+/**
+ * @brief 一道题目的分析结果
+ *
+ * @details 题目按考卷中的原始顺序编号，与 get_exam_paper 返回的题目顺序一致。
+ *          答卷的总分为答对的题目数量，区分度为这道题是否答对与总分的点二列相关系数
+ *          (M1 - M0) / s * sqrt(p * (1 - p))，其中 M1、M0 为答对、答错这道题的答卷的平均总分，s 为总分的总体标准差
+ */
+struct ItemStats
+{
+    int question_index;          // 题目在考卷中的序号，从0开始
+    long long attempts;          // 包含这道题的答卷数量
+    long long correct_count;     // 答对的答卷数量
+    long long unanswered_count;  // 没有作答的答卷数量，计入答错
+    long long top_wrong_count;   // 最常见的错误答案出现的次数，没有错误答案时为0
+    double p_value;              // 难度，即答对率，0 到 1，越大越容易
+    double point_biserial;       // 区分度，-1 到 1；所有人都答对、都答错或者总分都相同时为0
+    float top_wrong_answer;      // 最常见的错误答案（不含没有作答），次数相同时取较小的答案，没有错误答案时为 NaN
+};
+
+/**
+ * @brief 一场考试的分析汇总
+ */
+struct ItemAnalysisSummary
+{
+    long long version;          // 分析所用答题记录的版本号，见 scan_answer_logs
+    long long submission_count; // 参与分析的答卷数量
+    long long skipped_count;    // 记录损坏或者版本不支持而被跳过的答卷数量
+    int question_count;         // 题目数量，答卷的题目数量不同时（考试中途增加了题目）取最多的
+    double mean_correct;        // 每份答卷平均答对的题目数量
+    double stddev_correct;      // 答对的题目数量的总体标准差
+};
+
+/**
+ * @brief 逐题分析缓存的统计信息
+ */
+struct ItemAnalysisCacheStats
+{
+    unsigned long long hits;      // 命中次数（版本号没有变化，直接返回缓存的结果）
+    unsigned long long misses;    // 未命中次数（需要读取全部答题记录重新计算）
+    unsigned long long evictions; // 因容量不足而淘汰的考试数
+    int size;                     // 当前缓存的考试数
+    int capacity;                 // 最大缓存的考试数
+};
+
+/**
+ * @brief 获取一场考试的逐题分析，答题记录的版本号没有变化时直接返回缓存的结果
+ *
+ * @param exam_id 考试ID
+ * @param summary_to_return 返回的分析汇总，考试没有答题记录时 submission_count 和 question_count 为0
+ * @param items_to_return 返回的逐题结果，按题目序号排列
+ * @param capacity items_to_return 的大小，小于题目数量时只返回前 capacity 道题
+ * @return int 成功返回0（包括考试没有答题记录的情况），否则返回1
+ *
+ * @details 重新计算时只读取每条记录一次：总分由位图的 popcount 得到，逐题的累加只遍历位图中为1的位，
+ *          错误答案收集后排序一次统计众数。读取和计算都不持有缓存的锁，不同考试的查询互不阻塞；
+ *          同一场考试同时未命中时各自计算，缓存保留版本号较新的结果
+ */
+int query_item_analysis(const char *exam_id, struct ItemAnalysisSummary *summary_to_return, struct ItemStats *items_to_return, int capacity);
+
+/**
+ * @brief 清空所有逐题分析的缓存，统计信息保留
+ */
+void item_analysis_cache_clear(void);
+
+/**
+ * @brief 获取逐题分析缓存的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_item_analysis_cache_stats(struct ItemAnalysisCacheStats *stats_to_return);
+
+#endif
@@ -0,0 +1,297 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: metrics.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了 C 核心的性能统计，包括单调时钟、耗时直方图的分桶以及统计快照
+Others:         统计数据在每次调用时都会更新，为了不让多个线程在同一把锁上排队，计数器使用 C11 的原子操作（relaxed），
+                不使用互斥锁
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了函数调用的计数、耗时直方图、行数和字节数的统计以及统计快照
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 metrics_thread_calls，返回当前线程累计的调用次数，用于统计单个请求调用了多少次 C 函数
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_exam_stats 的函数名
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 score_rank 和 top_scores 的函数名
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_class_cube 的函数名
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 insert_answer_log 和 query_answer_log 的函数名
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 scan_answer_logs 的函数名
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "metrics.h"
+#include "utils.h"
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/**
+ * @brief 一个函数的计数器
+ */
+struct MetricSlot
+{
+    atomic_ullong calls;                           // 调用次数
+    atomic_ullong errors;                          // 返回失败的次数
+    atomic_ullong rows;                            // 返回的行数
+    atomic_ullong bytes;                           // 复制给调用者的字节数
+    atomic_ullong total_ns;                        // 总耗时（纳秒）
+    atomic_ullong max_ns;                          // 单次调用的最大耗时（纳秒）
+    atomic_ullong buckets[METRICS_BUCKET_COUNT];   // 耗时直方图
+};
+
+// 函数名表，顺序与 enum MetricFunction 一致
+static const char *const METRIC_NAMES[METRIC_FUNCTION_COUNT] = {
+    "open_database",
+    "query_user_info",
+    "query_exam_info",
+    "query_question_info",
+    "query_score_info",
+    "query_exams_info_all",
+    "query_users_info_all",
+    "query_questions_info_all",
+    "query_scores_info_all",
+    "query_scores_columnar",
+    "query_users_columnar",
+    "query_exam_stats",
+    "score_rank",
+    "top_scores",
+    "query_class_cube",
+    "query_answer_log",
+    "scan_answer_logs",
+    "insert_data_to_db",
+    "insert_exam_data",
+    "insert_question_data",
+    "insert_score_data",
+    "insert_user_data",
+    "insert_answer_log",
+    "del_user_data",
+    "del_exam_data",
+    "del_score_data",
+    "del_question_data",
+    "edit_user_data",
+    "edit_exam_data",
+    "edit_score_data",
+    "edit_question_data",
+    "calculate_result",
+    "judge",
+    "generate_question_list",
+    "randomize_question_list",
+    "print_question_list",
+    "generate_question_permutation",
+};
+
+static struct MetricSlot slots[METRIC_FUNCTION_COUNT]; // 每个函数的计数器，静态存储期的原子变量初始值为0
+static APP_THREAD_LOCAL unsigned long long thread_calls; // 当前线程累计的调用次数，只有本线程读写，不需要原子操作
+
+/**
+ * @brief 获取单调时钟的当前时间，用于计算耗时
+ *
+ * @return uint64_t 纳秒数，只有差值有意义
+ */
+uint64_t metrics_now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ULL +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * @brief 计算耗时落在直方图的哪个桶
+ *
+ * @param elapsed_ns 耗时（纳秒）
+ * @return int 桶的下标
+ */
+static int bucket_index(uint64_t elapsed_ns)
+{
+    if (elapsed_ns < (1ULL << METRICS_MIN_EXPONENT))
+    {
+        return 0;
+    }
+    int exponent = 63 - __builtin_clzll(elapsed_ns); // 最高位的位置，即 floor(log2(elapsed_ns))
+    if (exponent >= METRICS_MAX_EXPONENT)
+    {
+        return METRICS_BUCKET_COUNT - 1;
+    }
+    int sub_bucket = (int)((elapsed_ns >> (exponent - METRICS_SUB_BUCKET_BITS)) & ((1U << METRICS_SUB_BUCKET_BITS) - 1));
+    return 1 + ((exponent - METRICS_MIN_EXPONENT) << METRICS_SUB_BUCKET_BITS) + sub_bucket;
+}
+
+/**
+ * @brief 计算直方图某个桶的上界
+ *
+ * @param index 桶的下标
+ * @return unsigned long long 上界（纳秒，不含），最后一个桶为 UINT64_MAX
+ */
+static unsigned long long bucket_upper_bound(int index)
+{
+    if (index == 0)
+    {
+        return 1ULL << METRICS_MIN_EXPONENT;
+    }
+    if (index == METRICS_BUCKET_COUNT - 1)
+    {
+        return UINT64_MAX;
+    }
+    int exponent = METRICS_MIN_EXPONENT + ((index - 1) >> METRICS_SUB_BUCKET_BITS);
+    int sub_bucket = (index - 1) & ((1 << METRICS_SUB_BUCKET_BITS) - 1);
+    return (1ULL << exponent) + (unsigned long long)(sub_bucket + 1) * (1ULL << (exponent - METRICS_SUB_BUCKET_BITS));
+}
+
+/**
+ * @brief 记录一次函数调用
+ *
+ * @param function 被调用的函数
+ * @param start_ns 调用开始时 metrics_now_ns 的返回值
+ * @param failed 调用是否失败
+ */
+void metrics_record_call(enum MetricFunction function, uint64_t start_ns, int failed)
+{
+    if ((unsigned)function >= METRIC_FUNCTION_COUNT)
+    {
+        return;
+    }
+    uint64_t elapsed_ns = metrics_now_ns() - start_ns;
+    struct MetricSlot *slot = &slots[function];
+    thread_calls++;
+
+    atomic_fetch_add_explicit(&slot->calls, 1, memory_order_relaxed);
+    if (failed)
+    {
+        atomic_fetch_add_explicit(&slot->errors, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&slot->total_ns, elapsed_ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&slot->buckets[bucket_index(elapsed_ns)], 1, memory_order_relaxed);
+
+    unsigned long long max_ns = atomic_load_explicit(&slot->max_ns, memory_order_relaxed);
+    while (elapsed_ns > max_ns &&
+           !atomic_compare_exchange_weak_explicit(&slot->max_ns, &max_ns, elapsed_ns, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * @brief 记录批量查询返回的行数和复制的字节数
+ *
+ * @param function 被调用的函数
+ * @param rows 返回的行数
+ * @param bytes 复制给调用者的字节数
+ */
+void metrics_record_rows(enum MetricFunction function, int rows, size_t bytes)
+{
+    if ((unsigned)function >= METRIC_FUNCTION_COUNT || rows < 0)
+    {
+        return;
+    }
+    atomic_fetch_add_explicit(&slots[function].rows, (unsigned long long)rows, memory_order_relaxed);
+    atomic_fetch_add_explicit(&slots[function].bytes, (unsigned long long)bytes, memory_order_relaxed);
+}
+
+/**
+ * @brief 获取所有函数的统计快照
+ *
+ * @param snapshot_to_return 返回的统计快照
+ * @return int 成功返回0，否则返回1
+ */
+int get_metrics_snapshot(struct MetricsSnapshot *snapshot_to_return)
+{
+    if (snapshot_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 snapshot_to_return 为 NULL");
+        return 1;
+    }
+
+    snapshot_to_return->function_count = METRIC_FUNCTION_COUNT;
+    snapshot_to_return->bucket_count = METRICS_BUCKET_COUNT;
+    for (int i = 0; i < METRICS_BUCKET_COUNT; i++)
+    {
+        snapshot_to_return->bucket_upper_ns[i] = bucket_upper_bound(i);
+    }
+
+    for (int f = 0; f < METRIC_FUNCTION_COUNT; f++)
+    {
+        struct FunctionMetrics *out = &snapshot_to_return->functions[f];
+        struct MetricSlot *slot = &slots[f];
+        snprintf(out->name, sizeof(out->name), "%s", METRIC_NAMES[f]);
+        out->calls = atomic_load_explicit(&slot->calls, memory_order_relaxed);
+        out->errors = atomic_load_explicit(&slot->errors, memory_order_relaxed);
+        out->rows = atomic_load_explicit(&slot->rows, memory_order_relaxed);
+        out->bytes = atomic_load_explicit(&slot->bytes, memory_order_relaxed);
+        out->total_ns = atomic_load_explicit(&slot->total_ns, memory_order_relaxed);
+        out->max_ns = atomic_load_explicit(&slot->max_ns, memory_order_relaxed);
+        for (int i = 0; i < METRICS_BUCKET_COUNT; i++)
+        {
+            out->buckets[i] = atomic_load_explicit(&slot->buckets[i], memory_order_relaxed);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 获取当前线程累计的调用次数
+ *
+ * @details 一个请求由同一个线程处理，请求前后各取一次，差值就是这个请求调用被统计函数的次数。
+ *          不受 reset_metrics 影响
+ *
+ * @return unsigned long long 当前线程调用被统计函数的总次数
+ */
+unsigned long long metrics_thread_calls(void)
+{
+    return thread_calls;
+}
+
+/**
+ * @brief 清空所有统计数据
+ */
+void reset_metrics(void)
+{
+    for (int f = 0; f < METRIC_FUNCTION_COUNT; f++)
+    {
+        struct MetricSlot *slot = &slots[f];
+        atomic_store_explicit(&slot->calls, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->errors, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->rows, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&slot->max_ns, 0, memory_order_relaxed);
+        for (int i = 0; i < METRICS_BUCKET_COUNT; i++)
+        {
+            atomic_store_explicit(&slot->buckets[i], 0, memory_order_relaxed);
+        }
+    }
+    log_message(LOGLEVEL_INFO, "性能统计数据已清空");
+}
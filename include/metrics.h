@@ -0,0 +1,172 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: metrics.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了 C 核心的性能统计。database.h 和 app.h 中导出的每个函数都会记录调用次数、失败次数
+                和耗时直方图，批量查询函数还会记录返回的行数和复制的字节数
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了被统计的函数、耗时直方图的分桶方式以及统计快照的获取函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 metrics_thread_calls 函数的声明
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_exam_stats 的统计项
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 score_rank 和 top_scores 的统计项
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 query_class_cube 的统计项
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 insert_answer_log 和 query_answer_log 的统计项
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 scan_answer_logs 的统计项
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*** 直方图部分 ***/
+// 分桶方式与 HdrHistogram 相同：按 2 的幂分段，每段再均分为 2^METRICS_SUB_BUCKET_BITS 个桶，相对误差不超过 50%。
+// 第 0 个桶收集小于 2^METRICS_MIN_EXPONENT 纳秒的调用，最后一个桶收集超出范围的调用
+#define METRICS_SUB_BUCKET_BITS 1                                                                            // 每段的桶数量为 2 的多少次方
+#define METRICS_MIN_EXPONENT 10                                                                              // 第一段的起点为 2^10 纳秒，约 1 微秒
+#define METRICS_MAX_EXPONENT 35                                                                              // 超过 2^35 纳秒（约 34 秒）的调用都落在最后一个桶
+#define METRICS_BUCKET_COUNT (((METRICS_MAX_EXPONENT - METRICS_MIN_EXPONENT) << METRICS_SUB_BUCKET_BITS) + 2) // 桶的总数
+#define METRICS_NAME_LENGTH 40                                                                               // 函数名的最大长度（含 \0）
+
+/**
+ * @brief 被统计的函数，顺序与 metrics.c 中的函数名表一致
+ */
+enum MetricFunction
+{
+    METRIC_OPEN_DATABASE,
+    METRIC_QUERY_USER_INFO,
+    METRIC_QUERY_EXAM_INFO,
+    METRIC_QUERY_QUESTION_INFO,
+    METRIC_QUERY_SCORE_INFO,
+    METRIC_QUERY_EXAMS_INFO_ALL,
+    METRIC_QUERY_USERS_INFO_ALL,
+    METRIC_QUERY_QUESTIONS_INFO_ALL,
+    METRIC_QUERY_SCORES_INFO_ALL,
+    METRIC_QUERY_SCORES_COLUMNAR,
+    METRIC_QUERY_USERS_COLUMNAR,
+    METRIC_QUERY_EXAM_STATS,
+    METRIC_SCORE_RANK,
+    METRIC_TOP_SCORES,
+    METRIC_QUERY_CLASS_CUBE,
+    METRIC_QUERY_ANSWER_LOG,
+    METRIC_SCAN_ANSWER_LOGS,
+    METRIC_INSERT_DATA_TO_DB,
+    METRIC_INSERT_EXAM_DATA,
+    METRIC_INSERT_QUESTION_DATA,
+    METRIC_INSERT_SCORE_DATA,
+    METRIC_INSERT_USER_DATA,
+    METRIC_INSERT_ANSWER_LOG,
+    METRIC_DEL_USER_DATA,
+    METRIC_DEL_EXAM_DATA,
+    METRIC_DEL_SCORE_DATA,
+    METRIC_DEL_QUESTION_DATA,
+    METRIC_EDIT_USER_DATA,
+    METRIC_EDIT_EXAM_DATA,
+    METRIC_EDIT_SCORE_DATA,
+    METRIC_EDIT_QUESTION_DATA,
+    METRIC_CALCULATE_RESULT,
+    METRIC_JUDGE,
+    METRIC_GENERATE_QUESTION_LIST,
+    METRIC_RANDOMIZE_QUESTION_LIST,
+    METRIC_PRINT_QUESTION_LIST,
+    METRIC_GENERATE_QUESTION_PERMUTATION,
+    METRIC_FUNCTION_COUNT // 被统计的函数数量，不是一个函数
+};
+
+/**
+ * @brief 一个函数的统计数据
+ */
+struct FunctionMetrics
+{
+    char name[METRICS_NAME_LENGTH];                     // 函数名
+    unsigned long long calls;                           // 调用次数
+    unsigned long long errors;                          // 返回失败的次数
+    unsigned long long rows;                            // 返回的行数，只有批量查询函数会记录
+    unsigned long long bytes;                           // 复制给调用者的字节数，只有批量查询函数会记录
+    unsigned long long total_ns;                        // 总耗时（纳秒）
+    unsigned long long max_ns;                          // 单次调用的最大耗时（纳秒）
+    unsigned long long buckets[METRICS_BUCKET_COUNT];   // 耗时直方图，每个桶的调用次数（不累加）
+};
+
+/**
+ * @brief 所有函数的统计快照
+ */
+struct MetricsSnapshot
+{
+    int function_count;                                       // 函数数量，等于 METRIC_FUNCTION_COUNT
+    int bucket_count;                                         // 每个直方图的桶数量，等于 METRICS_BUCKET_COUNT
+    unsigned long long bucket_upper_ns[METRICS_BUCKET_COUNT]; // 每个桶的上界（纳秒，不含），最后一个桶为 UINT64_MAX
+    struct FunctionMetrics functions[METRIC_FUNCTION_COUNT];  // 每个函数的统计数据，下标为 MetricFunction
+};
+
+/**
+ * @brief 获取单调时钟的当前时间，用于计算耗时
+ *
+ * @return uint64_t 纳秒数，只有差值有意义
+ */
+uint64_t metrics_now_ns(void);
+
+/**
+ * @brief 记录一次函数调用
+ *
+ * @param function 被调用的函数
+ * @param start_ns 调用开始时 metrics_now_ns 的返回值
+ * @param failed 调用是否失败
+ */
+void metrics_record_call(enum MetricFunction function, uint64_t start_ns, int failed);
+
+/**
+ * @brief 记录批量查询返回的行数和复制的字节数
+ *
+ * @param function 被调用的函数
+ * @param rows 返回的行数
+ * @param bytes 复制给调用者的字节数
+ */
+void metrics_record_rows(enum MetricFunction function, int rows, size_t bytes);
+
+/**
+ * @brief 获取所有函数的统计快照
+ *
+ * @details 计数器各自原子地读取，快照不是严格的同一时刻，但每个计数器都不会被撕裂
+ *
+ * @param snapshot_to_return 返回的统计快照
+ * @return int 成功返回0，否则返回1
+ */
+int get_metrics_snapshot(struct MetricsSnapshot *snapshot_to_return);
+
+/**
+ * @brief 获取当前线程累计调用被统计函数的次数，请求前后的差值即为该请求的调用次数
+ *
+ * @return unsigned long long 当前线程的累计调用次数
+ */
+unsigned long long metrics_thread_calls(void);
+
+/**
+ * @brief 清空所有统计数据
+ */
+void reset_metrics(void);
+
+#endif
@@ -12,6 +12,11 @@ History:        暂无
                         [+] 移入get_permission函数，基于用户角色快速获取用户权限
                         [+] 移入calculate_result函数，用于计算式子的正确答案
                         [+] 移入judge函数，用于判断用户答案是否正确
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] get_permission 改为查询按角色预先计算好的权限位掩码表，去掉了每次调用时的两条日志
+                        [+] 添加了 get_permission_mask、has_permission、has_role_permission 函数
  */
 
 #include "model.h"
@@ -23,57 +28,80 @@ History:        暂无
 
 /**************************** 用户模型和权限部分 ****************************/
 
+/**
+ * @brief 各角色的权限位掩码表，下标为角色，0为学生，1为老师
+ */
+static const uint32_t ROLE_PERMISSION_MASKS[] = {
+    // 学生：回答问题、查看个人信息、查看考次信息、修改个人信息
+    PERM_STU_ANSWER | PERM_STU_INSPECT_PERSONAL_INFO | PERM_STU_INSPECT_EXAM_INFO | PERM_GENERAL_EDIT_INFO,
+    // 老师：管理考试、管理学生、查看学生信息、查看考试成绩、修改个人信息
+    PERM_TEA_MANAGE_EXAM | PERM_TEA_MANAGE_STUDENT | PERM_TEA_INSPECT_STUDENT_INFO | PERM_TEA_INSPECT_EXAM_SCORES | PERM_GENERAL_EDIT_INFO,
+};
+
+#define ROLE_COUNT ((int)(sizeof(ROLE_PERMISSION_MASKS) / sizeof(ROLE_PERMISSION_MASKS[0]))) // 已知角色的数量
+#define UNKNOWN_ROLE_MASK PERM_GENERAL_EDIT_INFO                                              // 未知角色的权限
+
+/**
+ * @brief 获取角色对应的权限位掩码
+ *
+ * @param role 用户角色，0为学生，1为老师
+ * @return uint32_t 权限位掩码，未知角色只有 PERM_GENERAL_EDIT_INFO
+ */
+uint32_t get_permission_mask(int role)
+{
+    return (role >= 0 && role < ROLE_COUNT) ? ROLE_PERMISSION_MASKS[role] : UNKNOWN_ROLE_MASK;
+}
+
+/**
+ * @brief 判断用户是否拥有指定的全部权限
+ *
+ * @param user 要判断的用户
+ * @param perm 需要的权限位，可以用 | 组合多个 PERM_*
+ * @return int 拥有返回1，否则返回0
+ */
+int has_permission(const struct User *user, uint32_t perm)
+{
+    return user != NULL && (get_permission_mask(user->role) & perm) == perm;
+}
+
+/**
+ * @brief 判断某个角色是否拥有指定的全部权限
+ *
+ * @param role 用户角色
+ * @param perm 需要的权限位，可以用 | 组合多个 PERM_*
+ * @return int 拥有返回1，否则返回0
+ */
+int has_role_permission(int role, uint32_t perm)
+{
+    return (get_permission_mask(role) & perm) == perm;
+}
+
 /**
  * @brief 定义函数get_permission，用于获取用户的权限，返回包含用户权限数据的Permission结构体
  *
+ * @details 由权限位掩码展开得到，保留此函数是为了兼容使用 Permission 结构体的代码
+ *
  * @param user 要获取权限的用户
  * @return struct Permission 用户的权限
  */
 struct Permission get_permission(struct User user)
 {
-    // 记录获取权限的操作
-    log_message(LOGLEVEL_INFO, "获取权限: 用户ID=%s, 角色=%d", user.id, user.role);
-
-    struct Permission current_permission;
-    switch (user.role) // 0为学生，1为老师
+    if (user.role < 0 || user.role >= ROLE_COUNT)
     {
-    case 0: // 学生权限
-        current_permission.stu_answer = 1;                // 学生：回答问题
-        current_permission.stu_inspect_personal_info = 1; // 学生：查看个人信息
-        current_permission.stu_inspect_exam_info = 1;     // 学生：查看考次信息
-        current_permission.tea_manage_exam = 0;
-        current_permission.tea_manage_student = 0;
-        current_permission.tea_inspect_student_info = 0;
-        current_permission.tea_inspect_exam_scores = 0;
-        current_permission.general_edit_info = 1;
-        // 记录分配学生权限
-        log_message(LOGLEVEL_INFO, "分配学生权限给用户ID=%s", user.id);
-        break;
-    case 1: // 老师权限
-        current_permission.stu_answer = 0;
-        current_permission.stu_inspect_personal_info = 0;
-        current_permission.stu_inspect_exam_info = 0;
-        current_permission.tea_manage_exam = 1;          // 教师：管理考试
-        current_permission.tea_manage_student = 1;       // 教师：管理学生（导入、删除、修改）
-        current_permission.tea_inspect_student_info = 1; // 教师：查看学生信息
-        current_permission.tea_inspect_exam_scores = 1;  // 教师：查看考试成绩
-        current_permission.general_edit_info = 1;        // 通用：修改个人信息
-        // 记录分配教师权限
-        log_message(LOGLEVEL_INFO, "分配教师权限给用户ID=%s", user.id);
-        break;
-    default: // 未知用户类型，记录错误
-        current_permission.stu_answer = 0;
-        current_permission.stu_inspect_personal_info = 0;
-        current_permission.stu_inspect_exam_info = 0;
-        current_permission.tea_manage_exam = 0;
-        current_permission.tea_manage_student = 0;
-        current_permission.tea_inspect_student_info = 0;
-        current_permission.tea_inspect_exam_scores = 0;
-        current_permission.general_edit_info = 1;
         // 记录未知用户类型错误
         log_message(LOGLEVEL_ERROR, "未知用户类型: 用户ID=%s, 角色=%d", user.id, user.role);
-        break;
     }
+
+    uint32_t mask = get_permission_mask(user.role);
+    struct Permission current_permission;
+    current_permission.stu_answer = (mask & PERM_STU_ANSWER) != 0;
+    current_permission.stu_inspect_personal_info = (mask & PERM_STU_INSPECT_PERSONAL_INFO) != 0;
+    current_permission.stu_inspect_exam_info = (mask & PERM_STU_INSPECT_EXAM_INFO) != 0;
+    current_permission.tea_manage_exam = (mask & PERM_TEA_MANAGE_EXAM) != 0;
+    current_permission.tea_manage_student = (mask & PERM_TEA_MANAGE_STUDENT) != 0;
+    current_permission.tea_inspect_student_info = (mask & PERM_TEA_INSPECT_STUDENT_INFO) != 0;
+    current_permission.tea_inspect_exam_scores = (mask & PERM_TEA_INSPECT_EXAM_SCORES) != 0;
+    current_permission.general_edit_info = (mask & PERM_GENERAL_EDIT_INFO) != 0;
     return current_permission;
 }
 /**************************** 用户模型和权限部分结束 ****************************/
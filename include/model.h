@@ -36,9 +36,43 @@ History:        暂无
         Modification:   [*] 修改了QuestionData结构体的数据类型（其实是忘记改了）
                         [*] 修改了SqlResponseScore的成绩类型，从float更改为int
                         [+] 添加了头文件包含保护，避免出现重复引用带来的重复定义问题
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 PERM_* 权限位定义，以及按角色查询权限位掩码的 get_permission_mask、
+                            has_permission、has_role_permission 函数
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了列式查询结果结构体 ColumnarResult
+    8.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了写冲突重试统计结构体 DatabaseRetryStats
+    9.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了在线备份进度结构体 BackupProgress
+    10. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了报表副本统计结构体 ReplicaStats
+    11. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了考试成绩统计结构体 ExamStats
+    12. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了考试排名结构体 ScoreRank
+    13. Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了班级统计单元格结构体 ClassCubeCell
  */
 
 #include <math.h>
+#include <stdint.h>
 
 #ifndef MODEL_H
 #define MODEL_H
@@ -81,6 +115,21 @@ struct User
     char belong_to[37];           // (仅学生) 属于哪一位老师，填入老师的UUID，可以为空
 };
 
+/**
+ * @brief 权限位定义，与 Permission 结构体中的字段一一对应
+ *
+ * @details 每个角色的权限以一个 32 位掩码保存在 model.c 的静态表中，
+ *          鉴权时只需要一次查表和一次按位与，不需要构造 Permission 结构体
+ */
+#define PERM_STU_ANSWER (1u << 0)                // 学生权限：答题
+#define PERM_STU_INSPECT_PERSONAL_INFO (1u << 1) // 学生权限：查看个人信息、成绩
+#define PERM_STU_INSPECT_EXAM_INFO (1u << 2)     // 学生权限：查看考试信息
+#define PERM_TEA_MANAGE_EXAM (1u << 3)           // 教师权限：管理考试
+#define PERM_TEA_MANAGE_STUDENT (1u << 4)        // 教师权限：管理学生
+#define PERM_TEA_INSPECT_STUDENT_INFO (1u << 5)  // 教师权限：查看学生信息
+#define PERM_TEA_INSPECT_EXAM_SCORES (1u << 6)   // 教师权限：查看成绩单
+#define PERM_GENERAL_EDIT_INFO (1u << 7)         // 通用：更改个人凭据
+
 /**
  * @brief 获取用户的权限结构
  *
@@ -89,6 +138,32 @@ struct User
  */
 struct Permission get_permission(struct User user);
 
+/**
+ * @brief 获取角色对应的权限位掩码
+ *
+ * @param role 用户角色，0为学生，1为老师
+ * @return uint32_t 权限位掩码，未知角色只有 PERM_GENERAL_EDIT_INFO
+ */
+uint32_t get_permission_mask(int role);
+
+/**
+ * @brief 判断用户是否拥有指定的全部权限
+ *
+ * @param user 要判断的用户
+ * @param perm 需要的权限位，可以用 | 组合多个 PERM_*
+ * @return int 拥有返回1，否则返回0
+ */
+int has_permission(const struct User *user, uint32_t perm);
+
+/**
+ * @brief 判断某个角色是否拥有指定的全部权限，供只知道角色（例如 JWT 中的 role）的调用方使用
+ *
+ * @param role 用户角色
+ * @param perm 需要的权限位，可以用 | 组合多个 PERM_*
+ * @return int 拥有返回1，否则返回0
+ */
+int has_role_permission(int role, uint32_t perm);
+
 /**************************** 用户模型和权限部分结束 ****************************/
 
 /**************************** 问题模型部分 ****************************/
@@ -185,4 +260,155 @@ struct SqlResponseUser
 
 /**************************** 数据库结果返回结束 ****************************/
 
+/**************************** 列式查询结果部分 ****************************/
+
+#define COLUMNAR_MAX_INT_COLUMNS 4 // 列式查询结果中整数列的最大数量
+
+/**
+ * @brief 列式查询结果，每个整数列是一段连续的 int32 数组，所有文本列共用一个字符串区
+ *
+ * @details 第 i 行第 j 个文本列为 strings[text_offsets[i * text_column_count + j], text_offsets[i * text_column_count + j + 1])，
+ *          不以 \0 结尾；第 i 行第 c 个整数列为 int_columns[c][i]。
+ *          结果由 query_*_columnar 分配，使用完之后必须调用 free_columnar_result 释放。
+ *          Python 端可以直接用 memoryview 包装这些数组，不需要逐行逐字段复制
+ */
+struct ColumnarResult
+{
+    int count;                                      // 行数
+    int text_column_count;                          // 文本列数量
+    int int_column_count;                           // 整数列数量
+    int32_t *int_columns[COLUMNAR_MAX_INT_COLUMNS]; // 整数列，每列 count 个元素
+    int32_t *text_offsets;                          // 文本列在字符串区中的偏移，共 count * text_column_count + 1 个元素
+    char *strings;                                  // 字符串区
+    int strings_length;                             // 字符串区已使用的长度
+    int capacity;                                   // 内部使用：整数列可以容纳的行数
+    int strings_capacity;                           // 内部使用：字符串区的大小
+};
+
+/**************************** 列式查询结果部分结束 ****************************/
+
+/**************************** 数据库连接统计部分 ****************************/
+
+/**
+ * @brief 写冲突重试的统计信息，由 database.c 中的 step_with_retry 累计
+ */
+struct DatabaseRetryStats
+{
+    unsigned long long conflicts; // 遇到过写冲突的语句数
+    unsigned long long retries;   // 重试的总次数
+    unsigned long long busy;      // 返回 SQLITE_BUSY 的次数
+    unsigned long long locked;    // 返回 SQLITE_LOCKED 的次数
+    unsigned long long exhausted; // 重试次数用完后仍然失败的语句数
+};
+
+/**************************** 数据库连接统计部分结束 ****************************/
+
+/**************************** 在线备份部分 ****************************/
+
+/**
+ * @brief 在线备份的进度，由 database.c 中的 backup_databases 更新
+ *
+ * @details 耗时都以纳秒为单位。writer_* 为备份期间写入函数（insert_*_data、del_*_data、edit_*_data）的调用情况，
+ *          baseline_writer_* 为备份开始前（从进程启动开始）的调用情况，两者对比可以看出备份对写入者的影响
+ */
+struct BackupProgress
+{
+    int running;                                   // 是否正在备份
+    int result;                                    // 备份结果：-1 为还没有完成过备份，0 为成功，1 为失败
+    int current_database;                          // 正在复制的数据库：0 为 examination.db，1 为 score.db，2 为 user.db
+    int database_count;                            // 数据库的总数
+    long long started_at;                          // 开始时间（UNIX 时间戳）
+    long long finished_at;                         // 结束时间（UNIX 时间戳），还没有结束时为0
+    unsigned long long total_pages;                // 三个数据库快照的总页数
+    unsigned long long copied_pages;               // 已经复制的页数
+    unsigned long long steps;                      // 调用 sqlite3_backup_step 的次数
+    unsigned long long max_step_ns;                // 单步的最大耗时
+    unsigned long long freeze_ns;                  // 取快照时挡住写入者的时长
+    unsigned long long writer_calls;               // 备份期间写入函数的调用次数
+    unsigned long long writer_mean_ns;             // 备份期间写入函数的平均耗时
+    unsigned long long writer_p99_ns;              // 备份期间写入函数耗时的 p99
+    unsigned long long baseline_writer_calls;      // 备份开始前写入函数的调用次数
+    unsigned long long baseline_writer_mean_ns;    // 备份开始前写入函数的平均耗时
+    unsigned long long baseline_writer_p99_ns;     // 备份开始前写入函数耗时的 p99
+    char target_dir[260];                          // 备份保存的文件夹
+};
+
+/**************************** 在线备份部分结束 ****************************/
+
+/**************************** 报表副本部分 ****************************/
+
+/**
+ * @brief 报表副本的统计信息，由 database.c 中的 refresh_reporting_replica 和批量查询累计
+ */
+struct ReplicaStats
+{
+    int active_slot;                        // 在用的一份副本，-1 为还没有刷新过
+    unsigned long long refreshes;           // 切换过副本的刷新次数
+    unsigned long long skipped;             // 源数据库没有变化、什么都没有做的刷新次数
+    unsigned long long failures;            // 失败的刷新次数
+    unsigned long long copied_databases;    // 复制过的数据库个数，没有变化的数据库不会被复制
+    unsigned long long copied_pages;        // 复制过的总页数
+    unsigned long long routed_reads;        // 改为读取副本的批量查询次数
+    long long last_refresh_at;              // 最近一次切换副本的时间（UNIX 时间戳）
+    unsigned long long last_refresh_ns;     // 最近一次刷新的耗时（纳秒）
+    unsigned long long max_refresh_ns;      // 单次刷新的最大耗时（纳秒）
+};
+
+/**************************** 报表副本部分结束 ****************************/
+
+/**************************** 成绩统计部分 ****************************/
+
+#define EXAM_STATS_BIN_COUNT 101 // 分数直方图的桶数，0 到 100 分每分一个桶，与 schema.h 中的 EXAM_STATS_MAX_SCORE 对应
+
+/**
+ * @brief 一场考试的成绩统计，由 database.c 中的 query_exam_stats 从 exam_stats 和 exam_score_histogram 表读取
+ */
+struct ExamStats
+{
+    long long count;                              // 成绩条数
+    long long sum;                                // 分数之和
+    long long sumsq;                              // 分数平方之和
+    long long pass_count;                         // 及格的成绩条数
+    int min_score;                                // 最低分，没有成绩时为0
+    int max_score;                                // 最高分，没有成绩时为0
+    double mean;                                  // 平均分
+    double stddev;                                // 标准差（总体标准差）
+    double pass_rate;                             // 及格率，0 到 1
+    long long histogram[EXAM_STATS_BIN_COUNT];    // 每个分数的成绩条数，低于0分的计入0分，高于100分的计入100分
+};
+
+/**
+ * @brief 一名考生在一场考试中的排名，由 database.c 中的 score_rank 计算
+ */
+struct ScoreRank
+{
+    int found;          // 是否找到该考生在这场考试中的成绩，没有找到时其余各项均为0
+    int score;          // 考生的成绩，有多条成绩时取最高分
+    long long rank;     // 名次，等于分数严格高于该成绩的条数加1，同分同名次
+    long long ties;     // 与该成绩同分的条数（包括考生自己）
+    long long total;    // 这场考试的成绩条数
+    double percentile;  // 百分位，等于 (低于该成绩的条数 + 同分条数 / 2) / 成绩条数 * 100
+};
+
+/**
+ * @brief 一位教师的一个班级在一场考试中的成绩汇总，由 database.c 中的 query_class_cube 从 class_cube 和 class_cube_histogram 表读取
+ */
+struct ClassCubeCell
+{
+    char class_name[31];                          // 班级，与 User 中的 class_name 长度相同
+    char exam_id[37];                             // 考试ID
+    long long count;                              // 成绩条数
+    long long sum;                                // 分数之和
+    long long sumsq;                              // 分数平方之和
+    long long pass_count;                         // 及格的成绩条数
+    int min_score;                                // 最低分，没有读取直方图时为0
+    int max_score;                                // 最高分，没有读取直方图时为0
+    double mean;                                  // 平均分
+    double stddev;                                // 标准差（总体标准差）
+    double pass_rate;                             // 及格率，0 到 1
+    long long histogram[EXAM_STATS_BIN_COUNT];    // 每个分数的成绩条数，没有读取直方图时全为0
+};
+
+/**************************** 成绩统计部分结束 ****************************/
+
 #endif
@@ -0,0 +1,418 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: pymodule.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了 CPython 扩展模块 mentalcore。模块与 include 目录下的所有 .c 文件、utils/initializer.c、lib/sqlite3.c
+                编译成同一个动态库，进程里只有一份 SQLite、一个堆以及一份用户缓存、考卷缓存和吊销列表。
+                常用的查询函数直接返回 Python 对象（PyStructSequence，文本字段为 bytes，与 ctypes 结构体的用法相同），
+                访问数据库的时候释放 GIL
+Others:         动态库导出了所有 C 函数，ui/utils/__init__.py 找到本模块时会用 ctypes 加载同一个动态库来调用其余函数，
+                找不到时回退到分别加载 app.dll、database.dll、initializer.dll
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，提供了 initialize、query_user_info、query_exam_info、
+                            query_exams_info_all、query_users_info_all、query_questions_info_all 的原生实现
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdlib.h>
+#include <string.h>
+#include "model.h"
+#include "database.h"
+
+/**
+ * @brief 程序初始化函数，定义在 utils/initializer.c
+ */
+void initialize();
+
+/**************************** 返回类型部分 ****************************/
+
+static PyStructSequence_Field permission_fields[] = {
+    {"stu_answer", "学生权限：答题"},
+    {"stu_inspect_personal_info", "学生权限：查看个人信息、成绩"},
+    {"stu_inspect_exam_info", "学生权限：查看考试信息"},
+    {"tea_manage_exam", "教师权限：管理考试"},
+    {"tea_manage_student", "教师权限：管理学生"},
+    {"tea_inspect_student_info", "教师权限：查看学生信息"},
+    {"tea_inspect_exam_scores", "教师权限：查看成绩单"},
+    {"general_edit_info", "通用：更改个人凭据"},
+    {NULL, NULL}};
+
+static PyStructSequence_Field user_fields[] = {
+    {"id", "用户的唯一ID"},
+    {"username", "用户名"},
+    {"hashpass", "密码哈希，只有 query_users_info_all 返回"},
+    {"salt", "密码的盐，只有 query_users_info_all 返回"},
+    {"role", "用户类型，0为学生，1为老师"},
+    {"name", "真实姓名"},
+    {"class_name", "班级名称"},
+    {"number", "学号/工号"},
+    {"belong_to", "学生归属的老师ID"},
+    {"permission", "用户的权限，只有 query_user_info 返回"},
+    {NULL, NULL}};
+
+static PyStructSequence_Field exam_fields[] = {
+    {"id", "考试的唯一ID"},
+    {"name", "考试名称"},
+    {"start_time", "开始时间"},
+    {"end_time", "结束时间"},
+    {"allow_answer_when_expired", "是否允许逾期作答"},
+    {"random_question", "是否开启随机题目顺序"},
+    {NULL, NULL}};
+
+static PyStructSequence_Field question_fields[] = {
+    {"id", "题目的唯一ID"},
+    {"exam_id", "题目对应的考试ID"},
+    {"num1", "第一个操作数"},
+    {"op", "运算符，0123对应加减乘除"},
+    {"num2", "第二个操作数"},
+    {NULL, NULL}};
+
+static PyStructSequence_Desc permission_desc = {"mentalcore.Permission", "用户的权限", permission_fields, 8};
+static PyStructSequence_Desc user_desc = {"mentalcore.User", "用户信息，文本字段为 bytes", user_fields, 10};
+static PyStructSequence_Desc exam_desc = {"mentalcore.Exam", "考试信息，文本字段为 bytes", exam_fields, 6};
+static PyStructSequence_Desc question_desc = {"mentalcore.Question", "题目信息，文本字段为 bytes", question_fields, 5};
+
+static PyTypeObject *permission_type;
+static PyTypeObject *user_type;
+static PyTypeObject *exam_type;
+static PyTypeObject *question_type;
+
+/**
+ * @brief 设置结构序列的第 index 个字段，value 为 NULL 时返回-1（调用方负责释放结构序列）
+ */
+static int set_item(PyObject *record, Py_ssize_t index, PyObject *value)
+{
+    if (value == NULL)
+    {
+        return -1;
+    }
+    PyStructSequence_SetItem(record, index, value);
+    return 0;
+}
+
+/**
+ * @brief 由以 \0 结尾的 C 字符串创建 bytes
+ */
+static PyObject *bytes_from(const char *text)
+{
+    return PyBytes_FromString(text);
+}
+
+static PyObject *build_permission(const struct Permission *permission)
+{
+    PyObject *record = PyStructSequence_New(permission_type);
+    if (record == NULL)
+    {
+        return NULL;
+    }
+    const int values[] = {permission->stu_answer, permission->stu_inspect_personal_info, permission->stu_inspect_exam_info,
+                          permission->tea_manage_exam, permission->tea_manage_student, permission->tea_inspect_student_info,
+                          permission->tea_inspect_exam_scores, permission->general_edit_info};
+    for (Py_ssize_t i = 0; i < 8; i++)
+    {
+        if (set_item(record, i, PyLong_FromLong(values[i])))
+        {
+            Py_DECREF(record);
+            return NULL;
+        }
+    }
+    return record;
+}
+
+/**
+ * @brief 创建用户对象，struct User 没有密码字段，hashpass 和 salt 为空 bytes
+ */
+static PyObject *build_user(const struct User *user)
+{
+    PyObject *record = PyStructSequence_New(user_type);
+    if (record == NULL)
+    {
+        return NULL;
+    }
+    if (set_item(record, 0, bytes_from(user->id)) ||
+        set_item(record, 1, bytes_from(user->username)) ||
+        set_item(record, 2, PyBytes_FromStringAndSize("", 0)) ||
+        set_item(record, 3, PyBytes_FromStringAndSize("", 0)) ||
+        set_item(record, 4, PyLong_FromLong(user->role)) ||
+        set_item(record, 5, bytes_from(user->name)) ||
+        set_item(record, 6, bytes_from(user->class_name)) ||
+        set_item(record, 7, PyLong_FromUnsignedLong(user->number)) ||
+        set_item(record, 8, bytes_from(user->belong_to)) ||
+        set_item(record, 9, build_permission(&user->permission)))
+    {
+        Py_DECREF(record);
+        return NULL;
+    }
+    return record;
+}
+
+/**
+ * @brief 由查询结果创建用户对象，permission 为 None
+ */
+static PyObject *build_sql_user(const struct SqlResponseUser *user)
+{
+    PyObject *record = PyStructSequence_New(user_type);
+    if (record == NULL)
+    {
+        return NULL;
+    }
+    if (set_item(record, 0, bytes_from(user->id)) ||
+        set_item(record, 1, bytes_from(user->username)) ||
+        set_item(record, 2, bytes_from(user->hashpass)) ||
+        set_item(record, 3, bytes_from(user->salt)) ||
+        set_item(record, 4, PyLong_FromLong(user->role)) ||
+        set_item(record, 5, bytes_from(user->name)) ||
+        set_item(record, 6, bytes_from(user->class_name)) ||
+        set_item(record, 7, PyLong_FromUnsignedLong(user->number)) ||
+        set_item(record, 8, bytes_from(user->belong_to)))
+    {
+        Py_DECREF(record);
+        return NULL;
+    }
+    Py_INCREF(Py_None);
+    PyStructSequence_SetItem(record, 9, Py_None);
+    return record;
+}
+
+static PyObject *build_exam(const struct SqlResponseExam *exam)
+{
+    PyObject *record = PyStructSequence_New(exam_type);
+    if (record == NULL)
+    {
+        return NULL;
+    }
+    if (set_item(record, 0, bytes_from(exam->id)) ||
+        set_item(record, 1, bytes_from(exam->name)) ||
+        set_item(record, 2, PyLong_FromLong(exam->start_time)) ||
+        set_item(record, 3, PyLong_FromLong(exam->end_time)) ||
+        set_item(record, 4, PyLong_FromLong(exam->allow_answer_when_expired)) ||
+        set_item(record, 5, PyLong_FromLong(exam->random_question)))
+    {
+        Py_DECREF(record);
+        return NULL;
+    }
+    return record;
+}
+
+static PyObject *build_question(const struct SqlResponseQuestion *question)
+{
+    PyObject *record = PyStructSequence_New(question_type);
+    if (record == NULL)
+    {
+        return NULL;
+    }
+    if (set_item(record, 0, bytes_from(question->id)) ||
+        set_item(record, 1, bytes_from(question->exam_id)) ||
+        set_item(record, 2, PyLong_FromLong(question->num1)) ||
+        set_item(record, 3, PyLong_FromLong(question->op)) ||
+        set_item(record, 4, PyLong_FromLong(question->num2)))
+    {
+        Py_DECREF(record);
+        return NULL;
+    }
+    return record;
+}
+
+/**************************** 返回类型部分结束 ****************************/
+
+/**************************** 模块函数部分 ****************************/
+
+static PyObject *core_initialize(PyObject *self, PyObject *args)
+{
+    Py_BEGIN_ALLOW_THREADS
+    initialize();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject *core_query_user_info(PyObject *self, PyObject *args)
+{
+    const char *key;
+    const char *content;
+    if (!PyArg_ParseTuple(args, "ss", &key, &content))
+    {
+        return NULL;
+    }
+    struct User user;
+    memset(&user, 0, sizeof(user));
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = query_user_info(key, content, &user);
+    Py_END_ALLOW_THREADS
+    if (result != 0)
+    {
+        Py_RETURN_NONE;
+    }
+    return build_user(&user);
+}
+
+static PyObject *core_query_exam_info(PyObject *self, PyObject *args)
+{
+    const char *key;
+    const char *content;
+    if (!PyArg_ParseTuple(args, "ss", &key, &content))
+    {
+        return NULL;
+    }
+    struct SqlResponseExam exam;
+    memset(&exam, 0, sizeof(exam));
+    int result;
+    Py_BEGIN_ALLOW_THREADS
+    result = query_exam_info(key, content, &exam);
+    Py_END_ALLOW_THREADS
+    if (result != 0)
+    {
+        Py_RETURN_NONE;
+    }
+    return build_exam(&exam);
+}
+
+/**
+ * @brief query_*_info_all 的通用实现：在不持有 GIL 的情况下分配结果数组并查询，然后把 id 非空的行转换为 Python 对象
+ *
+ * @param args Python 参数 (length, key=None, content=None)
+ * @param row_size 结果结构体的大小
+ * @param query 执行查询的函数
+ * @param build 将一行结果转换为 Python 对象的函数
+ * @return PyObject* 结果列表，查询失败时返回空列表
+ */
+static PyObject *query_all(PyObject *args, size_t row_size,
+                           int (*query)(void *rows, int length, const char *key, const char *content),
+                           PyObject *(*build)(const void *row))
+{
+    int length;
+    const char *key = NULL;
+    const char *content = NULL;
+    if (!PyArg_ParseTuple(args, "i|zz", &length, &key, &content))
+    {
+        return NULL;
+    }
+    if (length <= 0)
+    {
+        return PyList_New(0);
+    }
+
+    char *rows = NULL;
+    int result = 1;
+    Py_BEGIN_ALLOW_THREADS
+    rows = calloc((size_t)length, row_size);
+    if (rows)
+    {
+        result = query(rows, length, key, content);
+    }
+    Py_END_ALLOW_THREADS
+    if (rows == NULL)
+    {
+        return PyErr_NoMemory();
+    }
+
+    PyObject *list = PyList_New(0);
+    for (int i = 0; list && result == 0 && i < length; i++)
+    {
+        const char *row = rows + row_size * i;
+        if (row[0] == '\0')
+        {
+            continue; // 所有结果结构体的第一个字段都是 id，为空表示没有这一行
+        }
+        PyObject *record = build(row);
+        if (record == NULL || PyList_Append(list, record))
+        {
+            Py_XDECREF(record);
+            Py_CLEAR(list);
+            break;
+        }
+        Py_DECREF(record);
+    }
+    free(rows);
+    return list;
+}
+
+static int query_exams_rows(void *rows, int length, const char *key, const char *content)
+{
+    return query_exams_info_all(rows, length, key, content);
+}
+
+static int query_users_rows(void *rows, int length, const char *key, const char *content)
+{
+    return query_users_info_all(rows, length, key, content);
+}
+
+static int query_questions_rows(void *rows, int length, const char *key, const char *content)
+{
+    return query_questions_info_all(rows, length, key, content);
+}
+
+static PyObject *build_exam_row(const void *row)
+{
+    return build_exam(row);
+}
+
+static PyObject *build_user_row(const void *row)
+{
+    return build_sql_user(row);
+}
+
+static PyObject *build_question_row(const void *row)
+{
+    return build_question(row);
+}
+
+static PyObject *core_query_exams_info_all(PyObject *self, PyObject *args)
+{
+    return query_all(args, sizeof(struct SqlResponseExam), query_exams_rows, build_exam_row);
+}
+
+static PyObject *core_query_users_info_all(PyObject *self, PyObject *args)
+{
+    return query_all(args, sizeof(struct SqlResponseUser), query_users_rows, build_user_row);
+}
+
+static PyObject *core_query_questions_info_all(PyObject *self, PyObject *args)
+{
+    return query_all(args, sizeof(struct SqlResponseQuestion), query_questions_rows, build_question_row);
+}
+
+static PyMethodDef core_methods[] = {
+    {"initialize", core_initialize, METH_NOARGS, "initialize()\n\n初始化程序：建立文件夹和数据库表"},
+    {"query_user_info", core_query_user_info, METH_VARARGS, "query_user_info(key, content) -> User | None"},
+    {"query_exam_info", core_query_exam_info, METH_VARARGS, "query_exam_info(key, content) -> Exam | None"},
+    {"query_exams_info_all", core_query_exams_info_all, METH_VARARGS, "query_exams_info_all(length, key=None, content=None) -> list[Exam]"},
+    {"query_users_info_all", core_query_users_info_all, METH_VARARGS, "query_users_info_all(length, key=None, content=None) -> list[User]"},
+    {"query_questions_info_all", core_query_questions_info_all, METH_VARARGS, "query_questions_info_all(length, key=None, content=None) -> list[Question]"},
+    {NULL, NULL, 0, NULL}};
+
+/**************************** 模块函数部分结束 ****************************/
+
+static struct PyModuleDef core_module = {
+    PyModuleDef_HEAD_INIT,
+    "mentalcore",
+    "口算速算程序的原生核心模块",
+    -1,
+    core_methods};
+
+PyMODINIT_FUNC PyInit_mentalcore(void)
+{
+    PyObject *module = PyModule_Create(&core_module);
+    if (module == NULL)
+    {
+        return NULL;
+    }
+    permission_type = PyStructSequence_NewType(&permission_desc);
+    user_type = PyStructSequence_NewType(&user_desc);
+    exam_type = PyStructSequence_NewType(&exam_desc);
+    question_type = PyStructSequence_NewType(&question_desc);
+    if (permission_type == NULL || user_type == NULL || exam_type == NULL || question_type == NULL ||
+        PyModule_AddObject(module, "Permission", (PyObject *)permission_type) ||
+        PyModule_AddObject(module, "User", (PyObject *)user_type) ||
+        PyModule_AddObject(module, "Exam", (PyObject *)exam_type) ||
+        PyModule_AddObject(module, "Question", (PyObject *)question_type))
+    {
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
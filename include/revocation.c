@@ -0,0 +1,426 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: revocation.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了登录凭据（JWT）的吊销列表，使用链地址法的哈希集合保存被吊销的 token，
+                查询为 O(1)，过期条目定期清理，所有修改追加写入持久化文件，清理时重写文件去掉过期的行
+Others:         所有操作由一把互斥锁保护，第一次使用时从持久化文件加载。
+                持久化文件保存在 get_database_folder 返回的文件夹中，切换数据库位置后重新加载
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了吊销、查询、清理和持久化
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 持久化文件的路径由当前的数据库位置得到，数据库在内存中时不写文件
+                        [+] 添加了 revocation_clear 函数
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "revocation.h"
+#include "database.h"
+#include "utils.h"
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/*** 哈希集合部分 ***/
+#define REVOCATION_INITIAL_BUCKETS 64 // 初始哈希桶数量，必须为 2 的幂
+
+/**
+ * @brief 吊销列表中的一个条目
+ */
+struct RevokedToken
+{
+    char token[REVOCATION_TOKEN_LENGTH]; // JWT 中的 token 字段
+    long long expires_at;                // 过期时间戳（秒）
+    uint32_t hash;                       // token 的哈希值
+    struct RevokedToken *next;           // 同一个哈希桶中的下一个条目
+};
+
+static struct RevokedToken **buckets;                   // 哈希桶数组
+static int bucket_count;                                // 哈希桶数量
+static int size;                                        // 条目数量
+static int file_records;                                // 持久化文件中的行数，用于判断是否需要压缩
+static int loaded;                                      // 是否已经从持久化文件加载
+static char file_path[REVOCATION_PATH_MAX];             // 持久化文件的路径，加载时确定，为空字符串时不持久化
+static time_t last_sweep;                               // 上一次清理的时间
+static app_mutex_t revocation_lock = APP_MUTEX_INITIALIZER; // 保护以上所有数据的互斥锁
+
+/**
+ * @brief 计算 token 的 FNV-1a 哈希值
+ *
+ * @param token JWT 中的 token 字段
+ * @return uint32_t 哈希值
+ */
+static uint32_t hash_token(const char *token)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)token; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 检查 token 是否合法：非空、不超长、不含空白字符（持久化文件以空格分隔）
+ *
+ * @param token JWT 中的 token 字段
+ * @return int 合法返回1，否则返回0
+ */
+static int is_valid_token(const char *token)
+{
+    if (token == NULL || token[0] == '\0')
+    {
+        return 0;
+    }
+    size_t length = strlen(token);
+    if (length >= REVOCATION_TOKEN_LENGTH)
+    {
+        return 0;
+    }
+    return strpbrk(token, " \t\r\n") == NULL;
+}
+
+/**
+ * @brief 将哈希桶数量扩大一倍，调用前需要持有锁
+ *
+ * @return int 成功返回0，否则返回1
+ */
+static int grow_buckets(void)
+{
+    int new_count = bucket_count ? bucket_count * 2 : REVOCATION_INITIAL_BUCKETS;
+    struct RevokedToken **new_buckets = calloc((size_t)new_count, sizeof(*new_buckets));
+    if (new_buckets == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为吊销列表分配 %d 个哈希桶失败", new_count);
+        return 1;
+    }
+    for (int i = 0; i < bucket_count; i++)
+    {
+        struct RevokedToken *node = buckets[i];
+        while (node)
+        {
+            struct RevokedToken *next = node->next;
+            int index = node->hash & (new_count - 1);
+            node->next = new_buckets[index];
+            new_buckets[index] = node;
+            node = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+    return 0;
+}
+
+/**
+ * @brief 查找 token 对应的条目，调用前需要持有锁
+ *
+ * @param token JWT 中的 token 字段
+ * @param hash token 的哈希值
+ * @return struct RevokedToken* 找到返回条目，否则返回 NULL
+ */
+static struct RevokedToken *find_token(const char *token, uint32_t hash)
+{
+    if (bucket_count == 0)
+    {
+        return NULL;
+    }
+    for (struct RevokedToken *node = buckets[hash & (bucket_count - 1)]; node; node = node->next)
+    {
+        if (node->hash == hash && strcmp(node->token, token) == 0)
+        {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在内存中加入或更新一个条目，调用前需要持有锁
+ *
+ * @param token JWT 中的 token 字段
+ * @param expires_at 过期时间戳（秒）
+ * @return int 成功返回0，否则返回1
+ */
+static int insert_token(const char *token, long long expires_at)
+{
+    uint32_t hash = hash_token(token);
+    struct RevokedToken *node = find_token(token, hash);
+    if (node)
+    {
+        if (expires_at > node->expires_at)
+        {
+            node->expires_at = expires_at;
+        }
+        return 0;
+    }
+
+    if ((bucket_count == 0 || size >= bucket_count - bucket_count / 4) && grow_buckets())
+    {
+        return 1;
+    }
+    node = malloc(sizeof(*node));
+    if (node == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "为吊销列表条目分配内存失败");
+        return 1;
+    }
+    strcpy(node->token, token);
+    node->expires_at = expires_at;
+    node->hash = hash;
+    int index = hash & (bucket_count - 1);
+    node->next = buckets[index];
+    buckets[index] = node;
+    size++;
+    return 0;
+}
+
+/**
+ * @brief 第一次使用时从持久化文件加载吊销列表，跳过已经过期的行，调用前需要持有锁
+ */
+static void ensure_loaded(void)
+{
+    if (loaded)
+    {
+        return;
+    }
+    loaded = 1;
+    last_sweep = time(NULL);
+
+    char folder[REVOCATION_PATH_MAX];
+    file_path[0] = '\0';
+    if (get_database_folder(folder, (int)sizeof(folder)))
+    {
+        log_message(LOGLEVEL_ERROR, "无法获取数据库文件夹，吊销列表只保存在内存中");
+        return;
+    }
+    if (folder[0] == '\0')
+    {
+        log_message(LOGLEVEL_INFO, "数据库在内存中，吊销列表只保存在内存中");
+        return;
+    }
+    int written = snprintf(file_path, sizeof(file_path), "%s/%s", folder, REVOCATION_FILE_NAME);
+    if (written < 0 || written >= (int)sizeof(file_path))
+    {
+        log_message(LOGLEVEL_ERROR, "吊销列表文件的路径太长，吊销列表只保存在内存中");
+        file_path[0] = '\0';
+        return;
+    }
+
+    FILE *file = fopen(file_path, "r");
+    if (file == NULL)
+    {
+        return; // 文件不存在说明还没有吊销过任何凭据
+    }
+
+    char token[REVOCATION_TOKEN_LENGTH];
+    long long expires_at;
+    long long now = (long long)last_sweep;
+    int live = 0;
+    while (fscanf(file, "%64s %lld", token, &expires_at) == 2)
+    {
+        file_records++;
+        if (expires_at > now && insert_token(token, expires_at) == 0)
+        {
+            live++;
+        }
+    }
+    fclose(file);
+    log_message(LOGLEVEL_INFO, "从 %s 加载了 %d 条吊销记录（文件共 %d 行）", file_path, live, file_records);
+}
+
+/**
+ * @brief 用内存中的条目重写持久化文件，调用前需要持有锁
+ */
+static void rewrite_file(void)
+{
+    if (file_path[0] == '\0')
+    {
+        file_records = size;
+        return;
+    }
+    char temp_path[REVOCATION_PATH_MAX + 4]; // 再加上 .tmp 后缀
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", file_path);
+    FILE *file = fopen(temp_path, "w");
+    if (file == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "无法写入吊销列表文件 %s", temp_path);
+        return;
+    }
+    for (int i = 0; i < bucket_count; i++)
+    {
+        for (struct RevokedToken *node = buckets[i]; node; node = node->next)
+        {
+            fprintf(file, "%s %lld\n", node->token, node->expires_at);
+        }
+    }
+    fclose(file);
+
+#ifdef _WIN32
+    remove(file_path); // Windows 下 rename 不能覆盖已有文件
+#endif
+    if (rename(temp_path, file_path) != 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法替换吊销列表文件 %s", file_path);
+        remove(temp_path);
+        return;
+    }
+    file_records = size;
+}
+
+/**
+ * @brief 清理过期的条目，必要时压缩持久化文件，调用前需要持有锁
+ *
+ * @param now 当前时间戳（秒）
+ * @return int 清理掉的条目数量
+ */
+static int sweep_locked(time_t now)
+{
+    int removed = 0;
+    for (int i = 0; i < bucket_count; i++)
+    {
+        struct RevokedToken **link = &buckets[i];
+        while (*link)
+        {
+            struct RevokedToken *node = *link;
+            if (node->expires_at <= (long long)now)
+            {
+                *link = node->next;
+                free(node);
+                size--;
+                removed++;
+            }
+            else
+            {
+                link = &node->next;
+            }
+        }
+    }
+    last_sweep = now;
+
+    // 文件中的行数明显多于存活的条目时才重写，避免每次清理都写文件
+    if (file_records > size * 2 + 16)
+    {
+        rewrite_file();
+    }
+    if (removed > 0)
+    {
+        log_message(LOGLEVEL_INFO, "清理了 %d 条过期的吊销记录，剩余 %d 条", removed, size);
+    }
+    return removed;
+}
+
+/**
+ * @brief 距离上次清理超过 REVOCATION_SWEEP_INTERVAL 秒时进行清理，调用前需要持有锁
+ */
+static void maybe_sweep(void)
+{
+    time_t now = time(NULL);
+    if (now - last_sweep >= REVOCATION_SWEEP_INTERVAL)
+    {
+        sweep_locked(now);
+    }
+}
+
+int revoke_token(const char *token, long long expires_at)
+{
+    if (!is_valid_token(token))
+    {
+        log_message(LOGLEVEL_ERROR, "吊销的 token 不合法");
+        return 1;
+    }
+    if (expires_at <= (long long)time(NULL))
+    {
+        return 0; // 凭据已经过期，不需要吊销
+    }
+
+    app_mutex_lock(&revocation_lock);
+    ensure_loaded();
+    maybe_sweep();
+    int result = insert_token(token, expires_at);
+    if (result == 0 && file_path[0] != '\0')
+    {
+        FILE *file = fopen(file_path, "a");
+        if (file)
+        {
+            fprintf(file, "%s %lld\n", token, expires_at);
+            fclose(file);
+            file_records++;
+        }
+        else
+        {
+            log_message(LOGLEVEL_ERROR, "无法写入吊销列表文件 %s，本次吊销在重启后失效", file_path);
+        }
+    }
+    app_mutex_unlock(&revocation_lock);
+    return result;
+}
+
+int is_token_revoked(const char *token)
+{
+    if (!is_valid_token(token))
+    {
+        return 0;
+    }
+    uint32_t hash = hash_token(token);
+
+    app_mutex_lock(&revocation_lock);
+    ensure_loaded();
+    maybe_sweep();
+    struct RevokedToken *node = find_token(token, hash);
+    int revoked = node != NULL && node->expires_at > (long long)time(NULL);
+    app_mutex_unlock(&revocation_lock);
+    return revoked;
+}
+
+int sweep_revoked_tokens(void)
+{
+    app_mutex_lock(&revocation_lock);
+    ensure_loaded();
+    int removed = sweep_locked(time(NULL));
+    app_mutex_unlock(&revocation_lock);
+    return removed;
+}
+
+int count_revoked_tokens(void)
+{
+    app_mutex_lock(&revocation_lock);
+    ensure_loaded();
+    int count = size;
+    app_mutex_unlock(&revocation_lock);
+    return count;
+}
+
+void revocation_clear(void)
+{
+    app_mutex_lock(&revocation_lock);
+    for (int i = 0; i < bucket_count; i++)
+    {
+        struct RevokedToken *node = buckets[i];
+        while (node)
+        {
+            struct RevokedToken *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    free(buckets);
+    buckets = NULL;
+    bucket_count = 0;
+    size = 0;
+    file_records = 0;
+    loaded = 0;
+    file_path[0] = '\0';
+    app_mutex_unlock(&revocation_lock);
+}
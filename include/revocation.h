@@ -0,0 +1,69 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: revocation.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了登录凭据（JWT）的吊销列表。吊销列表是一个以 JWT 中随机的 token 字段为键的哈希集合，
+                每个条目带有与 JWT 相同的过期时间，过期的条目会被定期清理，并持久化到文件中以便重启后继续生效
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了吊销、查询和清理函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 持久化文件改为保存在当前的数据库文件夹中，跟随 set_database_location 变化
+                        [+] 添加了 revocation_clear 函数的声明
+ */
+
+#ifndef REVOCATION_H
+#define REVOCATION_H
+
+/*** 吊销列表部分 ***/
+#define REVOCATION_FILE_NAME "revoked_tokens.txt" // 吊销列表的持久化文件名，保存在数据库文件夹中，每行为 "<token> <过期时间戳>"
+#define REVOCATION_PATH_MAX 300                    // 持久化文件路径的最大长度
+#define REVOCATION_TOKEN_LENGTH 65                 // token 字段的最大长度，64 个字符再加上一个 \0
+#define REVOCATION_SWEEP_INTERVAL 60               // 两次自动清理之间的最短间隔，单位为秒
+
+/**
+ * @brief 吊销一个登录凭据
+ *
+ * @param token JWT 中的 token 字段
+ * @param expires_at 凭据的过期时间戳（秒），过了这个时间之后凭据本身就已失效，条目会被清理
+ * @return int 成功返回0，否则返回1
+ */
+int revoke_token(const char *token, long long expires_at);
+
+/**
+ * @brief 查询登录凭据是否已被吊销
+ *
+ * @param token JWT 中的 token 字段
+ * @return int 已吊销返回1，否则返回0
+ */
+int is_token_revoked(const char *token);
+
+/**
+ * @brief 立即清理已经过期的条目，并压缩持久化文件
+ *
+ * @details 吊销和查询的时候，距离上次清理超过 REVOCATION_SWEEP_INTERVAL 秒也会自动清理
+ *
+ * @return int 清理掉的条目数量
+ */
+int sweep_revoked_tokens(void);
+
+/**
+ * @brief 获取当前吊销列表中的条目数量
+ *
+ * @return int 条目数量
+ */
+int count_revoked_tokens(void);
+
+/**
+ * @brief 丢弃内存中的吊销列表，下次使用时从当前数据库文件夹中的持久化文件重新加载
+ *
+ * @details 由 set_database_location 在切换数据库位置时调用，数据库在内存中时吊销列表只保存在内存中
+ */
+void revocation_clear(void);
+
+#endif
@@ -0,0 +1,280 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: schema.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了各个数据库的建表语句，初始化程序和数据生成工具共用同一份表结构
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，将 initializer.c 中的建表语句挪入本文件
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] 建表语句改为 CREATE TABLE IF NOT EXISTS，database.c 的 initialize_schema 可以对已有的数据库重复执行
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了每场考试的成绩统计表 exam_stats、分数直方图表 exam_score_histogram，
+                            以及在 scores 表上维护它们的触发器和重建语句
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 scores 表上按考试排名和按用户查找成绩的索引
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了按 (教师, 班级, 考试) 预先汇总成绩的 class_cube、class_cube_histogram 表，
+                            学生所属班级的镜像表 class_members，以及维护它们的触发器和重建语句
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了保存每次交卷的答题记录的 answer_log 表，以及成绩被删除、修改时同步它的触发器
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了记录每场考试答题记录版本号的 answer_log_versions 表，以及在 answer_log 表上维护它的触发器
+ */
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+/*** 数据库部分 ***/
+#define DB_FOLDER "db"                     // 数据库保存文件夹名
+#define EXAMINATION_DB "db/examination.db" // 考试数据库
+#define SCORES_DB "db/score.db"            // 成绩数据库
+#define USER_DB "db/user.db"               // 用户数据库
+
+/*** 成绩统计部分 ***/
+#define EXAM_STATS_PASS_SCORE 60  // 及格线，分数不低于该值算作及格
+#define EXAM_STATS_MAX_SCORE 100  // 满分，直方图按 0 到满分逐分统计
+#define SCHEMA_STRINGIFY_(x) #x
+#define SCHEMA_STRINGIFY(x) SCHEMA_STRINGIFY_(x)
+#define EXAM_STATS_PASS_SQL SCHEMA_STRINGIFY(EXAM_STATS_PASS_SCORE)
+
+// 考试表，保存在 EXAMINATION_DB 中
+static const char SCHEMA_EXAMINATIONS[] = "CREATE TABLE IF NOT EXISTS examinations(\n"
+                                          "id TEXT PRIMARY KEY   NOT NULL,\n"             // 考试ID，UUID，唯一键
+                                          "name TEXT             NOT NULL,\n"             // 考次名称
+                                          "start_time INTEGER        NOT NULL,\n"         // 考试的开始时间，时间戳
+                                          "end_time INTEGER          NOT NULL,\n"         // 考试的结束时间，时间戳
+                                          "allow_answer_when_expired INTEGER NOT NULL,\n" // 是否允许逾期作答
+                                          "random_question INTEGER   NOT NULL\n"          // 是否开启问题乱序
+                                          ");\n";
+
+// 题目表，保存在 EXAMINATION_DB 中
+static const char SCHEMA_QUESTIONS[] = "CREATE TABLE IF NOT EXISTS questions(\n"
+                                       "id TEXT PRIMARY KEY    NOT NULL,\n" // 问题ID，UUID，唯一键
+                                       "exam_id TEXT           NOT NULL,\n" // 问题作用的考试ID，对应上面考次的UUID
+                                       "num1 INTEGER           NOT NULL,\n" // 第一个操作数字
+                                       "op INTEGER             NOT NULL,\n" // 运算符，0123对应加减乘除
+                                       "num2 INTEGER           NOT NULL\n"  // 第二个操作数字
+                                       ");\n";
+
+// 成绩表，保存在 SCORES_DB 中
+static const char SCHEMA_SCORES[] = "CREATE TABLE IF NOT EXISTS scores(\n"
+                                    "id TEXT PRIMARY KEY    NOT NULL,\n" // 成绩ID，UUID，唯一键
+                                    "exam_id TEXT           NOT NULL,\n" // 考试ID，对应上面考次的UUID
+                                    "user_id TEXT           NOT NULL,\n" // 用户ID，成绩所对应的用户的UUID
+                                    "score INTEGER          NOT NULL,\n" // 成绩
+                                    "expired_flag INTEGER   NOT NULL\n"  // 是否逾期作答，01分别代表否、是
+                                    ");\n";
+
+// scores 表的索引：按考试、分数从高到低排列，排行榜直接按索引顺序读取前 k 条，不需要排序；
+// 按用户、考试查找，学生查看自己的成绩和排名时不需要扫描整张表
+static const char SCHEMA_SCORES_INDEXES[] = "CREATE INDEX IF NOT EXISTS scores_exam_score ON scores (exam_id, score DESC, id);\n"
+                                            "CREATE INDEX IF NOT EXISTS scores_user_exam ON scores (user_id, exam_id, score);\n";
+
+// 每场考试的成绩统计，保存在 SCORES_DB 中，由下面的触发器在写入 scores 的同一个事务中维护
+static const char SCHEMA_EXAM_STATS[] = "CREATE TABLE IF NOT EXISTS exam_stats(\n"
+                                        "exam_id TEXT PRIMARY KEY NOT NULL,\n" // 考试ID
+                                        "count INTEGER          NOT NULL,\n"   // 成绩条数
+                                        "sum INTEGER            NOT NULL,\n"   // 分数之和
+                                        "sumsq INTEGER          NOT NULL,\n"   // 分数平方之和，用于计算标准差
+                                        "pass_count INTEGER     NOT NULL\n"    // 及格的成绩条数
+                                        ") WITHOUT ROWID;\n";
+
+// 每场考试每个分数的人数，保存在 SCORES_DB 中，人数为0的分数不保存，最低分、最高分和直方图都由它得到
+static const char SCHEMA_EXAM_SCORE_HISTOGRAM[] = "CREATE TABLE IF NOT EXISTS exam_score_histogram(\n"
+                                                  "exam_id TEXT           NOT NULL,\n" // 考试ID
+                                                  "score INTEGER          NOT NULL,\n" // 分数
+                                                  "count INTEGER          NOT NULL,\n" // 得到该分数的成绩条数
+                                                  "PRIMARY KEY (exam_id, score)\n"
+                                                  ") WITHOUT ROWID;\n";
+
+// 在 scores 表上维护 exam_stats 和 exam_score_histogram 的触发器，无论通过哪个函数或者工具写入 scores，统计都与成绩同时提交
+static const char SCHEMA_EXAM_STATS_TRIGGERS[] =
+    "CREATE TRIGGER IF NOT EXISTS exam_stats_after_insert AFTER INSERT ON scores BEGIN\n"
+    "INSERT INTO exam_stats (exam_id, count, sum, sumsq, pass_count)\n"
+    "VALUES (NEW.exam_id, 1, NEW.score, NEW.score * NEW.score, NEW.score >= " EXAM_STATS_PASS_SQL ")\n"
+    "ON CONFLICT (exam_id) DO UPDATE SET count = count + 1, sum = sum + excluded.sum,\n"
+    "sumsq = sumsq + excluded.sumsq, pass_count = pass_count + excluded.pass_count;\n"
+    "INSERT INTO exam_score_histogram (exam_id, score, count) VALUES (NEW.exam_id, NEW.score, 1)\n"
+    "ON CONFLICT (exam_id, score) DO UPDATE SET count = count + 1;\n"
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS exam_stats_after_delete AFTER DELETE ON scores BEGIN\n"
+    "UPDATE exam_stats SET count = count - 1, sum = sum - OLD.score, sumsq = sumsq - OLD.score * OLD.score,\n"
+    "pass_count = pass_count - (OLD.score >= " EXAM_STATS_PASS_SQL ") WHERE exam_id = OLD.exam_id;\n"
+    "DELETE FROM exam_stats WHERE exam_id = OLD.exam_id AND count <= 0;\n"
+    "UPDATE exam_score_histogram SET count = count - 1 WHERE exam_id = OLD.exam_id AND score = OLD.score;\n"
+    "DELETE FROM exam_score_histogram WHERE exam_id = OLD.exam_id AND score = OLD.score AND count <= 0;\n"
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS exam_stats_after_update AFTER UPDATE OF exam_id, score ON scores BEGIN\n"
+    "UPDATE exam_stats SET count = count - 1, sum = sum - OLD.score, sumsq = sumsq - OLD.score * OLD.score,\n"
+    "pass_count = pass_count - (OLD.score >= " EXAM_STATS_PASS_SQL ") WHERE exam_id = OLD.exam_id;\n"
+    "DELETE FROM exam_stats WHERE exam_id = OLD.exam_id AND count <= 0;\n"
+    "UPDATE exam_score_histogram SET count = count - 1 WHERE exam_id = OLD.exam_id AND score = OLD.score;\n"
+    "DELETE FROM exam_score_histogram WHERE exam_id = OLD.exam_id AND score = OLD.score AND count <= 0;\n"
+    "INSERT INTO exam_stats (exam_id, count, sum, sumsq, pass_count)\n"
+    "VALUES (NEW.exam_id, 1, NEW.score, NEW.score * NEW.score, NEW.score >= " EXAM_STATS_PASS_SQL ")\n"
+    "ON CONFLICT (exam_id) DO UPDATE SET count = count + 1, sum = sum + excluded.sum,\n"
+    "sumsq = sumsq + excluded.sumsq, pass_count = pass_count + excluded.pass_count;\n"
+    "INSERT INTO exam_score_histogram (exam_id, score, count) VALUES (NEW.exam_id, NEW.score, 1)\n"
+    "ON CONFLICT (exam_id, score) DO UPDATE SET count = count + 1;\n"
+    "END;\n";
+
+// 由 scores 表重新计算 exam_stats 和 exam_score_histogram，用于已有数据的迁移、批量导入之后以及一致性检查失败时
+static const char SQL_REBUILD_EXAM_STATS[] =
+    "DELETE FROM exam_stats;\n"
+    "DELETE FROM exam_score_histogram;\n"
+    "INSERT INTO exam_stats (exam_id, count, sum, sumsq, pass_count)\n"
+    "SELECT exam_id, count(*), sum(score), sum(score * score), sum(score >= " EXAM_STATS_PASS_SQL ") FROM scores GROUP BY exam_id;\n"
+    "INSERT INTO exam_score_histogram (exam_id, score, count)\n"
+    "SELECT exam_id, score, count(*) FROM scores GROUP BY exam_id, score;\n";
+
+// 学生所属教师和班级的镜像，保存在 SCORES_DB 中。触发器不能读取其他数据库，成绩写入时由它找到学生所在的班级，
+// 由 database.c 在写入 users 表之后同步（见 sync_class_member），没有归属教师的用户不在表中
+static const char SCHEMA_CLASS_MEMBERS[] = "CREATE TABLE IF NOT EXISTS class_members(\n"
+                                           "user_id TEXT PRIMARY KEY NOT NULL,\n" // 学生的用户ID
+                                           "teacher_id TEXT        NOT NULL,\n"   // 学生归属的教师ID
+                                           "class_name TEXT        NOT NULL\n"    // 学生的班级，没有班级时为空字符串
+                                           ") WITHOUT ROWID;\n";
+
+// 每位教师每个班级每场考试的成绩汇总，保存在 SCORES_DB 中，各项含义与 exam_stats 相同
+static const char SCHEMA_CLASS_CUBE[] = "CREATE TABLE IF NOT EXISTS class_cube(\n"
+                                        "teacher_id TEXT        NOT NULL,\n" // 教师ID
+                                        "class_name TEXT        NOT NULL,\n" // 班级
+                                        "exam_id TEXT           NOT NULL,\n" // 考试ID
+                                        "count INTEGER          NOT NULL,\n" // 成绩条数
+                                        "sum INTEGER            NOT NULL,\n" // 分数之和
+                                        "sumsq INTEGER          NOT NULL,\n" // 分数平方之和
+                                        "pass_count INTEGER     NOT NULL,\n" // 及格的成绩条数
+                                        "PRIMARY KEY (teacher_id, class_name, exam_id)\n"
+                                        ") WITHOUT ROWID;\n";
+
+// class_cube 每个单元格中每个分数的人数，保存在 SCORES_DB 中，人数为0的分数不保存
+static const char SCHEMA_CLASS_CUBE_HISTOGRAM[] = "CREATE TABLE IF NOT EXISTS class_cube_histogram(\n"
+                                                  "teacher_id TEXT        NOT NULL,\n" // 教师ID
+                                                  "class_name TEXT        NOT NULL,\n" // 班级
+                                                  "exam_id TEXT           NOT NULL,\n" // 考试ID
+                                                  "score INTEGER          NOT NULL,\n" // 分数
+                                                  "count INTEGER          NOT NULL,\n" // 得到该分数的成绩条数
+                                                  "PRIMARY KEY (teacher_id, class_name, exam_id, score)\n"
+                                                  ") WITHOUT ROWID;\n";
+
+// 把一条成绩计入（CLASS_CUBE_ADD）或者移出（CLASS_CUBE_REMOVE）它的学生所在的单元格，学生不在 class_members 中时什么都不做。
+// 移出时以负数做同样的累加，再删除减到0的行
+#define CLASS_CUBE_APPLY(ROW, SIGN)                                                                                            \
+    "INSERT INTO class_cube (teacher_id, class_name, exam_id, count, sum, sumsq, pass_count)\n"                               \
+    "SELECT teacher_id, class_name, " ROW ".exam_id, " SIGN "1, " SIGN ROW ".score, " SIGN ROW ".score * " ROW ".score,\n"    \
+    SIGN "(" ROW ".score >= " EXAM_STATS_PASS_SQL ") FROM class_members WHERE user_id = " ROW ".user_id\n"                     \
+    "ON CONFLICT (teacher_id, class_name, exam_id) DO UPDATE SET count = count + excluded.count, sum = sum + excluded.sum,\n" \
+    "sumsq = sumsq + excluded.sumsq, pass_count = pass_count + excluded.pass_count;\n"                                        \
+    "INSERT INTO class_cube_histogram (teacher_id, class_name, exam_id, score, count)\n"                                      \
+    "SELECT teacher_id, class_name, " ROW ".exam_id, " ROW ".score, " SIGN "1 FROM class_members WHERE user_id = " ROW ".user_id\n" \
+    "ON CONFLICT (teacher_id, class_name, exam_id, score) DO UPDATE SET count = count + excluded.count;\n"
+#define CLASS_CUBE_CLEANUP(ROW)                                                                                                \
+    "DELETE FROM class_cube WHERE exam_id = " ROW ".exam_id AND count <= 0\n"                                                 \
+    "AND (teacher_id, class_name) IN (SELECT teacher_id, class_name FROM class_members WHERE user_id = " ROW ".user_id);\n"   \
+    "DELETE FROM class_cube_histogram WHERE exam_id = " ROW ".exam_id AND score = " ROW ".score AND count <= 0\n"              \
+    "AND (teacher_id, class_name) IN (SELECT teacher_id, class_name FROM class_members WHERE user_id = " ROW ".user_id);\n"
+
+// 在 scores 表上维护 class_cube 和 class_cube_histogram 的触发器，与成绩在同一个事务中提交
+static const char SCHEMA_CLASS_CUBE_TRIGGERS[] =
+    "CREATE TRIGGER IF NOT EXISTS class_cube_after_insert AFTER INSERT ON scores BEGIN\n"
+    CLASS_CUBE_APPLY("NEW", "")
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS class_cube_after_delete AFTER DELETE ON scores BEGIN\n"
+    CLASS_CUBE_APPLY("OLD", "-")
+    CLASS_CUBE_CLEANUP("OLD")
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS class_cube_after_update AFTER UPDATE OF exam_id, user_id, score ON scores BEGIN\n"
+    CLASS_CUBE_APPLY("OLD", "-")
+    CLASS_CUBE_CLEANUP("OLD")
+    CLASS_CUBE_APPLY("NEW", "")
+    "END;\n";
+
+// 由用户表和 scores 表重新计算 class_members、class_cube 和 class_cube_histogram，执行前需要把 USER_DB 附加为 user_db。
+// 成绩与学生只做一次分组连接得到直方图，汇总行再由直方图求和得到
+static const char SQL_REBUILD_CLASS_CUBE[] =
+    "DELETE FROM class_members;\n"
+    "DELETE FROM class_cube;\n"
+    "DELETE FROM class_cube_histogram;\n"
+    "INSERT INTO class_members (user_id, teacher_id, class_name)\n"
+    "SELECT id, belong_to, coalesce(class_name, '') FROM user_db.users WHERE coalesce(belong_to, '') <> '';\n"
+    "INSERT INTO class_cube_histogram (teacher_id, class_name, exam_id, score, count)\n"
+    "SELECT m.teacher_id, m.class_name, s.exam_id, s.score, count(*) FROM scores AS s JOIN class_members AS m ON m.user_id = s.user_id\n"
+    "GROUP BY m.teacher_id, m.class_name, s.exam_id, s.score;\n"
+    "INSERT INTO class_cube (teacher_id, class_name, exam_id, count, sum, sumsq, pass_count)\n"
+    "SELECT teacher_id, class_name, exam_id, sum(count), sum(score * count), sum(score * score * count),\n"
+    "sum((score >= " EXAM_STATS_PASS_SQL ") * count) FROM class_cube_histogram GROUP BY teacher_id, class_name, exam_id;\n";
+
+// 每次交卷的答题记录，保存在 SCORES_DB 中，与 scores 表中的一条成绩对应。记录的二进制格式见 answer_log.h，
+// 同一场考试的记录按主键聚集存放，逐题统计时只需要顺序读取这场考试的记录
+static const char SCHEMA_ANSWER_LOG[] = "CREATE TABLE IF NOT EXISTS answer_log(\n"
+                                        "exam_id TEXT           NOT NULL,\n" // 考试ID
+                                        "score_id TEXT          NOT NULL,\n" // 成绩ID，对应 scores 表的 id
+                                        "user_id TEXT           NOT NULL,\n" // 答题的用户ID
+                                        "record BLOB            NOT NULL,\n" // 编码后的答题记录
+                                        "PRIMARY KEY (exam_id, score_id)\n"
+                                        ") WITHOUT ROWID;\n";
+
+// 成绩被删除时删除对应的答题记录，成绩改到其他考试或者其他用户名下时答题记录跟着修改
+static const char SCHEMA_ANSWER_LOG_TRIGGERS[] =
+    "CREATE TRIGGER IF NOT EXISTS answer_log_after_delete AFTER DELETE ON scores BEGIN\n"
+    "DELETE FROM answer_log WHERE exam_id = OLD.exam_id AND score_id = OLD.id;\n"
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS answer_log_after_update AFTER UPDATE OF id, exam_id, user_id ON scores BEGIN\n"
+    "UPDATE answer_log SET exam_id = NEW.exam_id, score_id = NEW.id, user_id = NEW.user_id\n"
+    "WHERE exam_id = OLD.exam_id AND score_id = OLD.id;\n"
+    "END;\n";
+
+// 每场考试答题记录的版本号，答题记录每次新增、删除、修改都加一，逐题分析的缓存据此判断是否失效。
+// 没有行的考试版本号视为0
+static const char SCHEMA_ANSWER_LOG_VERSIONS[] = "CREATE TABLE IF NOT EXISTS answer_log_versions(\n"
+                                                 "exam_id TEXT PRIMARY KEY  NOT NULL,\n" // 考试ID
+                                                 "version INTEGER           NOT NULL\n"  // 版本号
+                                                 ") WITHOUT ROWID;\n";
+
+#define ANSWER_LOG_BUMP_VERSION(ROW)                                               \
+    "INSERT INTO answer_log_versions (exam_id, version) VALUES (" ROW ".exam_id, 1)\n" \
+    "ON CONFLICT (exam_id) DO UPDATE SET version = version + 1;\n"
+
+// 在 answer_log 表上维护 answer_log_versions，由成绩触发器间接删除、修改答题记录时同样生效
+static const char SCHEMA_ANSWER_LOG_VERSION_TRIGGERS[] =
+    "CREATE TRIGGER IF NOT EXISTS answer_log_versions_after_insert AFTER INSERT ON answer_log BEGIN\n"
+    ANSWER_LOG_BUMP_VERSION("NEW")
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS answer_log_versions_after_delete AFTER DELETE ON answer_log BEGIN\n"
+    ANSWER_LOG_BUMP_VERSION("OLD")
+    "END;\n"
+    "CREATE TRIGGER IF NOT EXISTS answer_log_versions_after_update AFTER UPDATE ON answer_log BEGIN\n"
+    ANSWER_LOG_BUMP_VERSION("OLD")
+    ANSWER_LOG_BUMP_VERSION("NEW")
+    "END;\n";
+
+// 用户表，保存在 USER_DB 中
+static const char SCHEMA_USERS[] = "CREATE TABLE IF NOT EXISTS users(\n"
+                                   "id TEXT PRIMARY KEY        NOT NULL,\n" // 用户ID，UUID，唯一键
+                                   "username TEXT              NOT NULL,\n" // 用户名，范围为[a-zA-Z0-9]{3, 24}
+                                   "hashpass TEXT              NOT NULL,\n" // 哈希后的密码
+                                   "salt TEXT                  NOT NULL,\n" // 盐
+                                   "role INTEGER               NOT NULL,\n" // 用户角色
+                                   "name TEXT                  NOT NULL,\n" // 用户姓名
+                                   "class_name TEXT,\n"                     // 用户班级
+                                   "number INTEGER             NOT NULL,\n" // 用户学号/工号
+                                   "belong_to TEXT\n"                       // (仅学生) 属于哪一位老师，填入老师的UUID
+                                   ");\n";
+
+#endif
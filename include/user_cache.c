@@ -0,0 +1,296 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: user_cache.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了进程内的用户信息 LRU 缓存。缓存条目全部静态分配，
+                通过哈希表按用户 ID 定位，通过双向链表维护最近使用顺序，所有操作由一把互斥锁保护
+Others:         条目下标从 1 开始，0 表示空，这样静态数组不需要额外的初始化
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了用户缓存的查询、写入、失效和统计函数
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "user_cache.h"
+#include "utils.h"
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/**
+ * @brief 缓存条目
+ *
+ * @details prev / next 为 LRU 链表中的前后条目，hash_next 为同一个哈希桶中的下一个条目，
+ *          条目被释放后 hash_next 用于串起空闲链表
+ */
+struct UserCacheEntry
+{
+    struct SqlResponseUser user;   // 用户整行数据
+    struct Permission permission;  // 计算好的用户权限
+    uint32_t hash;                 // 用户 ID 的哈希值
+    int prev;                      // LRU 链表中更近使用的条目
+    int next;                      // LRU 链表中更久未使用的条目
+    int hash_next;                 // 哈希桶链表中的下一个条目
+};
+
+static struct UserCacheEntry entries[USER_CACHE_CAPACITY + 1]; // 条目数组，下标 0 不使用
+static int buckets[USER_CACHE_BUCKETS];                        // 哈希桶，保存桶内第一个条目的下标
+static int lru_head;                                           // 最近使用的条目
+static int lru_tail;                                           // 最久未使用的条目
+static int free_list;                                          // 被释放的条目
+static int allocated;                                          // 已经使用过的条目数量
+static int size;                                               // 当前缓存的条目数量
+static unsigned long long generation;                          // 缓存代数，每次失效加一
+static struct UserCacheStats stats;                            // 统计信息
+static app_mutex_t cache_lock = APP_MUTEX_INITIALIZER;         // 保护以上所有数据的互斥锁
+
+/**
+ * @brief 计算用户 ID 的 FNV-1a 哈希值
+ *
+ * @param user_id 用户 ID
+ * @return uint32_t 哈希值
+ */
+static uint32_t hash_user_id(const char *user_id)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)user_id; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 在哈希表中查找用户 ID 对应的条目，调用前需要持有锁
+ *
+ * @param user_id 用户 ID
+ * @param hash 用户 ID 的哈希值
+ * @return int 找到返回条目下标，否则返回0
+ */
+static int find_entry(const char *user_id, uint32_t hash)
+{
+    for (int i = buckets[hash & (USER_CACHE_BUCKETS - 1)]; i; i = entries[i].hash_next)
+    {
+        if (entries[i].hash == hash && strcmp(entries[i].user.id, user_id) == 0)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 将条目从 LRU 链表中摘下，调用前需要持有锁
+ *
+ * @param i 条目下标
+ */
+static void lru_unlink(int i)
+{
+    if (entries[i].prev)
+    {
+        entries[entries[i].prev].next = entries[i].next;
+    }
+    else
+    {
+        lru_head = entries[i].next;
+    }
+    if (entries[i].next)
+    {
+        entries[entries[i].next].prev = entries[i].prev;
+    }
+    else
+    {
+        lru_tail = entries[i].prev;
+    }
+    entries[i].prev = entries[i].next = 0;
+}
+
+/**
+ * @brief 将条目放到 LRU 链表的头部，调用前需要持有锁
+ *
+ * @param i 条目下标
+ */
+static void lru_push_front(int i)
+{
+    entries[i].prev = 0;
+    entries[i].next = lru_head;
+    if (lru_head)
+    {
+        entries[lru_head].prev = i;
+    }
+    lru_head = i;
+    if (!lru_tail)
+    {
+        lru_tail = i;
+    }
+}
+
+/**
+ * @brief 将条目从哈希表和 LRU 链表中移除并放回空闲链表，调用前需要持有锁
+ *
+ * @param i 条目下标
+ */
+static void remove_entry(int i)
+{
+    int *link = &buckets[entries[i].hash & (USER_CACHE_BUCKETS - 1)];
+    while (*link && *link != i)
+    {
+        link = &entries[*link].hash_next;
+    }
+    if (*link)
+    {
+        *link = entries[i].hash_next;
+    }
+    lru_unlink(i);
+    memset(&entries[i].user, 0, sizeof(entries[i].user)); // 不在内存里留下已失效的密码哈希
+    entries[i].hash_next = free_list;
+    free_list = i;
+    size--;
+}
+
+int user_cache_get(const char *user_id, struct SqlResponseUser *user_to_return, struct Permission *permission_to_return)
+{
+    if (user_id == NULL || user_id[0] == '\0')
+    {
+        return 1;
+    }
+    uint32_t hash = hash_user_id(user_id);
+
+    app_mutex_lock(&cache_lock);
+    int i = find_entry(user_id, hash);
+    if (!i)
+    {
+        stats.misses++;
+        app_mutex_unlock(&cache_lock);
+        return 1;
+    }
+    stats.hits++;
+    if (lru_head != i)
+    {
+        lru_unlink(i);
+        lru_push_front(i);
+    }
+    if (user_to_return)
+    {
+        *user_to_return = entries[i].user;
+    }
+    if (permission_to_return)
+    {
+        *permission_to_return = entries[i].permission;
+    }
+    app_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+unsigned long long user_cache_generation(void)
+{
+    app_mutex_lock(&cache_lock);
+    unsigned long long current = generation;
+    app_mutex_unlock(&cache_lock);
+    return current;
+}
+
+void user_cache_put(const struct SqlResponseUser *user, const struct Permission *permission, unsigned long long expected_generation)
+{
+    if (user == NULL || permission == NULL || user->id[0] == '\0')
+    {
+        return;
+    }
+    uint32_t hash = hash_user_id(user->id);
+
+    app_mutex_lock(&cache_lock);
+    // 读取数据库期间有用户数据被修改过，读到的可能是旧数据，放弃写入
+    if (expected_generation != generation)
+    {
+        app_mutex_unlock(&cache_lock);
+        return;
+    }
+
+    int i = find_entry(user->id, hash);
+    if (i)
+    {
+        lru_unlink(i);
+    }
+    else
+    {
+        if (free_list)
+        {
+            i = free_list;
+            free_list = entries[i].hash_next;
+        }
+        else if (allocated < USER_CACHE_CAPACITY)
+        {
+            i = ++allocated;
+        }
+        else
+        {
+            // 缓存已满，淘汰最久未使用的条目
+            int victim = lru_tail;
+            remove_entry(victim);
+            stats.evictions++;
+            i = free_list;
+            free_list = entries[i].hash_next;
+        }
+        int bucket = hash & (USER_CACHE_BUCKETS - 1);
+        entries[i].hash = hash;
+        entries[i].hash_next = buckets[bucket];
+        buckets[bucket] = i;
+        size++;
+    }
+    entries[i].user = *user;
+    entries[i].permission = *permission;
+    lru_push_front(i);
+    app_mutex_unlock(&cache_lock);
+}
+
+void user_cache_invalidate(const char *user_id)
+{
+    if (user_id == NULL)
+    {
+        return;
+    }
+    uint32_t hash = hash_user_id(user_id);
+
+    app_mutex_lock(&cache_lock);
+    generation++;
+    int i = find_entry(user_id, hash);
+    if (i)
+    {
+        remove_entry(i);
+        stats.invalidations++;
+    }
+    app_mutex_unlock(&cache_lock);
+}
+
+void user_cache_clear(void)
+{
+    app_mutex_lock(&cache_lock);
+    generation++;
+    while (lru_head)
+    {
+        remove_entry(lru_head);
+    }
+    app_mutex_unlock(&cache_lock);
+    log_message(LOGLEVEL_INFO, "用户缓存已清空");
+}
+
+int get_user_cache_stats(struct UserCacheStats *stats_to_return)
+{
+    if (stats_to_return == NULL)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 stats_to_return 为 NULL");
+        return 1;
+    }
+    app_mutex_lock(&cache_lock);
+    *stats_to_return = stats;
+    stats_to_return->size = size;
+    stats_to_return->capacity = USER_CACHE_CAPACITY;
+    app_mutex_unlock(&cache_lock);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: user_cache.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了进程内的用户信息 LRU 缓存，按照用户 ID 缓存 users 表中的整行数据
+                以及计算好的权限，减少每次请求鉴权时对 db/user.db 的访问
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了用户缓存的查询、写入、失效和统计函数
+ */
+
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include "model.h"
+
+/*** 缓存容量部分 ***/
+#define USER_CACHE_CAPACITY 1024 // 缓存的最大条目数，所有条目静态分配，内存占用固定
+#define USER_CACHE_BUCKETS 2048  // 哈希桶数量，必须为 2 的幂
+
+/**
+ * @brief 用户缓存的统计信息
+ *
+ * @details hits / misses 为命中与未命中次数，evictions 为因容量不足而淘汰的条目数，
+ *          invalidations 为因用户数据被修改、删除或新增而失效的次数，
+ *          size 为当前缓存的条目数，capacity 为最大条目数
+ */
+struct UserCacheStats
+{
+    unsigned long long hits;          // 命中次数
+    unsigned long long misses;        // 未命中次数
+    unsigned long long evictions;     // 淘汰次数
+    unsigned long long invalidations; // 失效次数
+    int size;                         // 当前条目数
+    int capacity;                     // 最大条目数
+};
+
+/**
+ * @brief 按照用户 ID 从缓存中查询用户
+ *
+ * @param user_id 用户 ID
+ * @param user_to_return 命中时返回的用户整行数据，可以为 NULL
+ * @param permission_to_return 命中时返回的用户权限，可以为 NULL
+ * @return int 命中返回0，未命中返回1
+ */
+int user_cache_get(const char *user_id, struct SqlResponseUser *user_to_return, struct Permission *permission_to_return);
+
+/**
+ * @brief 获取当前的缓存代数，在从数据库读取数据之前调用，并在写入缓存时传回
+ *
+ * @details 每次失效都会让代数加一，这样在读取数据库期间如果有并发的修改，
+ *          读到的旧数据就不会被写进缓存
+ *
+ * @return unsigned long long 当前的缓存代数
+ */
+unsigned long long user_cache_generation(void);
+
+/**
+ * @brief 将从数据库读到的用户写入缓存，缓存已满时淘汰最久未使用的条目
+ *
+ * @param user 用户整行数据
+ * @param permission 用户权限
+ * @param expected_generation 读取数据库之前通过 user_cache_generation 获取的缓存代数
+ */
+void user_cache_put(const struct SqlResponseUser *user, const struct Permission *permission, unsigned long long expected_generation);
+
+/**
+ * @brief 使指定用户的缓存失效
+ *
+ * @param user_id 用户 ID
+ */
+void user_cache_invalidate(const char *user_id);
+
+/**
+ * @brief 清空所有缓存条目，统计信息保留
+ */
+void user_cache_clear(void);
+
+/**
+ * @brief 获取缓存的统计信息
+ *
+ * @param stats_to_return 返回的统计信息
+ * @return int 成功返回0，否则返回1
+ */
+int get_user_cache_stats(struct UserCacheStats *stats_to_return);
+
+#endif
@@ -14,6 +14,10 @@ History:        暂无
         Author: 吴沛熹
         ID: GamerNoTitle
         Modification: [+] 添加了日志记录函数，避免重复造轮子
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [*] log_message 在互斥锁内写入日志，多个线程同时写日志时内容不会交错
  */
 
 #include <stdarg.h>
@@ -31,6 +35,8 @@ History:        暂无
 #define LOG_FOLDER "logs"          // 日志文件夹路径
 #define LOG_FILE "logs/latest.log" // 日志文件路径
 
+static app_mutex_t log_lock = APP_MUTEX_INITIALIZER; // 保证同一时间只有一个线程写日志文件
+
 /**
  * @brief 获取当前时间，格式化为 "YYYY-MM-DD HH:mm:SS"
  * 
@@ -61,10 +67,13 @@ void get_current_time(char *buffer, size_t size)
  * @param ... 变长参数
  */
 void log_message(const char *level, const char *format, ...) {
+    app_mutex_lock(&log_lock);
+
     // 打开日志文件以追加模式写入
     FILE *log_file = fopen(LOG_FILE, "a");
     if (log_file == NULL) { // 检查文件是否成功打开
         printf("无法打开日志文件：%s\n", strerror(errno)); // 打印错误信息到标准输出
+        app_mutex_unlock(&log_lock);
         return;
     }
 
@@ -82,4 +91,5 @@ void log_message(const char *level, const char *format, ...) {
 
     fprintf(log_file, "\n"); // 添加换行符
     fclose(log_file); // 关闭日志文件
+    app_mutex_unlock(&log_lock);
 }
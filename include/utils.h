@@ -10,6 +10,15 @@ History:        暂无
         ID: GamerNoTitle
         Modification: [+] 新建了文件，并加入了头部文件注释，说明本头文件的功能
                       [+] 加入了 get_current_time 函数，用于获取当前时间并保存为 YYYY-MM-DD HH:mm:SS 的格式
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 加入了跨平台的互斥锁封装，Windows 下使用 SRWLOCK，其他系统使用 pthread_mutex_t
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 加入了线程局部存储的封装 APP_THREAD_LOCAL
+                      [+] 补充了 C 核心的线程安全说明
  */
 
 #ifndef UTILS_H
@@ -17,6 +26,39 @@ History:        暂无
 
 #include <time.h>  // 用于获取当前时间
 
+/*** 互斥锁部分 ***/
+// 两种实现都支持静态初始化，声明时写 static app_mutex_t lock = APP_MUTEX_INITIALIZER; 即可直接使用
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK app_mutex_t;
+#define APP_MUTEX_INITIALIZER SRWLOCK_INIT
+#define app_mutex_lock(mutex) AcquireSRWLockExclusive(mutex)
+#define app_mutex_unlock(mutex) ReleaseSRWLockExclusive(mutex)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t app_mutex_t;
+#define APP_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define app_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define app_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#endif
+
+/*** 线程局部存储部分 ***/
+#if defined(_MSC_VER)
+#define APP_THREAD_LOCAL __declspec(thread)
+#else
+#define APP_THREAD_LOCAL _Thread_local
+#endif
+
+/*
+ * 线程安全说明：
+ *  - 除 initialize 之外的所有导出函数都是可重入的，可以在多个线程中同时调用，调用期间不需要持有 Python 的 GIL
+ *  - 数据库连接在每次调用内打开和关闭，不会跨线程共享；并发写入之间的互斥由 SQLite 的文件锁负责
+ *  - 用户缓存、考卷缓存、吊销列表等进程内共享数据都由各自的 app_mutex_t 保护，返回给调用者的都是数据的拷贝
+ *  - 随机数使用每个线程独立的发生器状态（见 app.c），不使用全局的 rand / srand
+ *  - log_message 在互斥锁内完成整条日志的写入，多个线程的日志不会交错
+ *  - initialize 只能在启动时、其他线程开始调用之前执行一次
+ */
+
 void get_current_time(char *buffer, size_t size);
 void log_message(const char *level, const char *format, ...);
 
@@ -0,0 +1,231 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: uuid.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件定义了原生的 UUID 生成函数，随机数来自操作系统的密码学安全随机数发生器
+                （Windows 下为 BCryptGenRandom，其他系统下为 getrandom / /dev/urandom）
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，添加了 generate_uuid 和 generate_uuid_list 函数
+                        [+] 支持 UUIDv4 和 UUIDv7，UUIDv7 在同一批次内严格递增
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] fill_random_bytes 改为对外公开，供每个线程的随机数发生器获取种子
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <bcrypt.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/random.h>
+#endif
+#include "uuid.h"
+#include "utils.h"
+
+/*** 日志等级 ***/
+#define LOGLEVEL_ERROR "ERROR" // 错误级别日志
+#define LOGLEVEL_INFO "INFO"   // 信息级别日志
+
+/*** 随机数部分 ***/
+#define UUID_BATCH_SIZE 256 // 每次从系统获取随机数时处理的 UUID 数量，256 * 16 字节 = 4KB
+
+/**
+ * @brief 从操作系统的密码学安全随机数发生器获取随机字节
+ *
+ * @param buffer 随机字节的输出缓冲区
+ * @param size 需要的随机字节数
+ * @return int 成功返回0，否则返回1
+ */
+int fill_random_bytes(unsigned char *buffer, size_t size)
+{
+#ifdef _WIN32
+    if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, buffer, (ULONG)size, BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+    {
+        log_message(LOGLEVEL_ERROR, "BCryptGenRandom 获取随机数失败");
+        return 1;
+    }
+    return 0;
+#else
+    size_t filled = 0;
+    while (filled < size)
+    {
+        ssize_t n = getrandom(buffer + filled, size - filled, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break; // 内核不支持 getrandom 时回退到 /dev/urandom
+        }
+        filled += (size_t)n;
+    }
+    if (filled == size)
+    {
+        return 0;
+    }
+
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0)
+    {
+        log_message(LOGLEVEL_ERROR, "无法打开 /dev/urandom：%s", strerror(errno));
+        return 1;
+    }
+    while (filled < size)
+    {
+        ssize_t n = read(fd, buffer + filled, size - filled);
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            log_message(LOGLEVEL_ERROR, "读取 /dev/urandom 失败：%s", strerror(errno));
+            close(fd);
+            return 1;
+        }
+        filled += (size_t)n;
+    }
+    close(fd);
+    return 0;
+#endif
+}
+
+/**
+ * @brief 获取当前的 Unix 毫秒时间戳
+ *
+ * @return uint64_t 自 1970-01-01 起的毫秒数
+ */
+static uint64_t current_unix_ms(void)
+{
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime; // 自 1601-01-01 起的 100ns 数
+    return (ticks - 116444736000000000ULL) / 10000ULL;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+#endif
+}
+
+/**
+ * @brief 将 16 字节的 UUID 格式化为 xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx 的字符串
+ *
+ * @param bytes UUID 的 16 个字节
+ * @param out 输出的字符串，长度至少为 UUID_LENGTH
+ */
+static void format_uuid(const unsigned char *bytes, char *out)
+{
+    static const char hex[] = "0123456789abcdef";
+    int pos = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        if (i == 4 || i == 6 || i == 8 || i == 10)
+        {
+            out[pos++] = '-';
+        }
+        out[pos++] = hex[bytes[i] >> 4];
+        out[pos++] = hex[bytes[i] & 0x0F];
+    }
+    out[pos] = '\0';
+}
+
+/**
+ * @brief 一次性生成多个指定版本的 UUID 字符串
+ *
+ * @param buffer 返回的 UUID 缓冲区，大小至少为 count * UUID_LENGTH
+ * @param count 需要生成的 UUID 数量
+ * @param version UUID 版本，只允许 UUID_VERSION_4 和 UUID_VERSION_7
+ * @return int 成功返回0，否则返回1
+ */
+int generate_uuid_list(char *buffer, int count, int version)
+{
+    if (buffer == NULL || count < 0)
+    {
+        log_message(LOGLEVEL_ERROR, "参数 buffer 为 NULL 或 count 非法：%d", count);
+        return 1;
+    }
+    if (version != UUID_VERSION_4 && version != UUID_VERSION_7)
+    {
+        log_message(LOGLEVEL_ERROR, "不支持的 UUID 版本：%d", version);
+        return 1;
+    }
+
+    unsigned char random_bytes[UUID_BATCH_SIZE * 16];
+    uint64_t timestamp = current_unix_ms();
+    int counter = -1; // UUIDv7 的 12 位 rand_a 作为批次内的递增计数器，-1 表示尚未初始化
+
+    for (int done = 0; done < count; done += UUID_BATCH_SIZE)
+    {
+        int batch = count - done < UUID_BATCH_SIZE ? count - done : UUID_BATCH_SIZE;
+        if (fill_random_bytes(random_bytes, (size_t)batch * 16))
+        {
+            return 1;
+        }
+
+        for (int i = 0; i < batch; i++)
+        {
+            unsigned char *bytes = random_bytes + i * 16;
+
+            if (version == UUID_VERSION_7)
+            {
+                // 计数器溢出时借用下一毫秒，保证同一批次内严格递增（RFC 9562 6.2 方法3）
+                if (counter < 0 || counter >= 0x0FFF)
+                {
+                    if (counter >= 0x0FFF)
+                    {
+                        timestamp++;
+                    }
+                    counter = ((bytes[6] << 8) | bytes[7]) & 0x07FF; // 最高位置零，给递增留出空间
+                }
+                else
+                {
+                    counter++;
+                }
+
+                bytes[0] = (unsigned char)(timestamp >> 40);
+                bytes[1] = (unsigned char)(timestamp >> 32);
+                bytes[2] = (unsigned char)(timestamp >> 24);
+                bytes[3] = (unsigned char)(timestamp >> 16);
+                bytes[4] = (unsigned char)(timestamp >> 8);
+                bytes[5] = (unsigned char)timestamp;
+                bytes[6] = (unsigned char)(0x70 | ((counter >> 8) & 0x0F)); // 版本号 7
+                bytes[7] = (unsigned char)(counter & 0xFF);
+            }
+            else
+            {
+                bytes[6] = (unsigned char)(0x40 | (bytes[6] & 0x0F)); // 版本号 4
+            }
+            bytes[8] = (unsigned char)(0x80 | (bytes[8] & 0x3F)); // RFC 4122 变体
+
+            format_uuid(bytes, buffer + (size_t)(done + i) * UUID_LENGTH);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 生成一个指定版本的 UUID 字符串
+ *
+ * @param uuid_to_return 返回的 UUID 字符串，长度至少为 UUID_LENGTH
+ * @param version UUID 版本，只允许 UUID_VERSION_4 和 UUID_VERSION_7
+ * @return int 成功返回0，否则返回1
+ */
+int generate_uuid(char *uuid_to_return, int version)
+{
+    return generate_uuid_list(uuid_to_return, 1, version);
+}
@@ -0,0 +1,62 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: uuid.h
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件声明了原生的 UUID 生成函数，支持 UUIDv4（完全随机）和 UUIDv7（按时间有序）
+Others:         暂无
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，声明了 generate_uuid 和 generate_uuid_list 函数
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 fill_random_bytes 函数的声明
+ */
+
+#ifndef UUID_H
+#define UUID_H
+
+#include <stddef.h>
+
+/*** UUID 部分 ***/
+#define UUID_LENGTH 37 // UUID 字符串长度，36 个字符再加上一个 \0
+
+/*** UUID 版本 ***/
+#define UUID_VERSION_4 4 // 完全随机的 UUID，适合用户、考试等对外暴露的ID
+#define UUID_VERSION_7 7 // 前 48 位为毫秒时间戳的 UUID，新插入的行会落在索引 B 树的末尾
+
+/**
+ * @brief 生成一个指定版本的 UUID 字符串
+ *
+ * @param uuid_to_return 返回的 UUID 字符串，长度至少为 UUID_LENGTH
+ * @param version UUID 版本，只允许 UUID_VERSION_4 和 UUID_VERSION_7
+ * @return int 成功返回0，否则返回1
+ */
+int generate_uuid(char *uuid_to_return, int version);
+
+/**
+ * @brief 一次性生成多个指定版本的 UUID 字符串
+ *
+ * @details 缓冲区按照每 UUID_LENGTH 个字节存放一个以 \0 结尾的 UUID，
+ *          随机数按批（每 256 个 UUID 一次系统调用）从操作系统的密码学安全随机数发生器获取。
+ *          生成 UUIDv7 的时候，同一批次内的 UUID 严格递增。
+ *
+ * @param buffer 返回的 UUID 缓冲区，大小至少为 count * UUID_LENGTH
+ * @param count 需要生成的 UUID 数量
+ * @param version UUID 版本，只允许 UUID_VERSION_4 和 UUID_VERSION_7
+ * @return int 成功返回0，否则返回1
+ */
+int generate_uuid_list(char *buffer, int count, int version);
+
+/**
+ * @brief 从操作系统的密码学安全随机数发生器获取随机字节
+ *
+ * @param buffer 随机字节的输出缓冲区
+ * @param size 需要的随机字节数
+ * @return int 成功返回0，否则返回1
+ */
+int fill_random_bytes(unsigned char *buffer, size_t size);
+
+#endif
@@ -4,6 +4,11 @@ import argparse
 import json
 import jwt
 import logging
+import time
+import atexit
+import signal
+import threading
+import urllib.parse
 import webbrowser
 from logging.handlers import RotatingFileHandler
 from flask import (
@@ -13,7 +18,8 @@ from flask import (
     request,
     redirect,
     make_response,
-    Response
+    Response,
+    g
 )
 import colorlog
 import re
@@ -26,11 +32,27 @@ from route.api import (
     student_get_exam_info,
     student_get_score_list,
     teacher_get_all_exams,
-    teacher_get_all_students
+    teacher_get_all_students,
+    start_background_backup,
+)
+import route.api
+from utils.database import (
+    query_user_info,
+    query_score_info,
+    query_scores_info_all,
+    has_role_permission,
+    PERM_STU_ANSWER,
+    PERM_TEA_MANAGE_EXAM,
+    set_slow_query_log,
+    set_database_location,
+    backup_databases,
+    refresh_reporting_replica,
 )
-from utils.database import query_user_info, query_score_info, query_scores_info_all
 from utils.tools import questions_xlsx_parse
 from utils.init import initialize
+from utils.auth import revoke_token, is_token_revoked, decode_token, forget_token
+from utils.metrics import get_thread_call_count
+from utils.trace import TraceWriter
 
 # 定义常量
 LOG_DIR = 'logs'
@@ -38,9 +60,9 @@ LOG_FILE = os.path.join(LOG_DIR, 'ui.log')
 EXEMPT_PATHS = [
     "/login",
     "/static/",
-    "/api/v1/general/"
+    "/api/v1/general/",
+    "/api/v1/metrics",  # 只允许本机访问，见 general_metrics
 ]
-cookie_blacklist = []  # 初始化黑名单列表
 JWT_KEY = "GamerNoTitle"  # 请替换为你的实际密钥
 
 # 创建日志目录（如果不存在）
@@ -207,15 +229,10 @@ def before_request_func():
     token = request.cookies.get("token")
     logger.info(f"Token retrieved: {token}")
 
-    # 如果token在黑名单中，重定向到登录页面
-    if token in cookie_blacklist:
-        logger.warning(f"Token {token} is in blacklist. Redirecting to /login.")
-        return redirect("/login")
-
     if token:
         try:
             # 尝试解码JWT token
-            data = jwt.decode(token, JWT_KEY, algorithms=["HS256"])
+            data = decode_token(token, JWT_KEY)
             logger.info(f"JWT decoded successfully: {data}")
         except jwt.ExpiredSignatureError:
             # 如果JWT过期，重定向到登录页面
@@ -226,6 +243,11 @@ def before_request_func():
             logger.warning("Invalid JWT. Redirecting to /login.")
             return redirect("/login")
 
+        # 如果token已经被吊销（用户已注销），重定向到登录页面
+        if is_token_revoked(data):
+            logger.warning(f"Token {token} has been revoked. Redirecting to /login.")
+            return redirect("/login")
+
         # 获取用户角色
         role = data.get("role", -1)
         logger.info(f"User role: {role}")
@@ -235,13 +257,13 @@ def before_request_func():
 
         # 角色与路径的权限控制
         if "/student/" in path.lower():
-            # 如果路径包含 'student'，要求角色为学生 (0)
-            if role != 0:
+            # 如果路径包含 'student'，要求角色拥有答题权限（学生）
+            if not has_role_permission(role, PERM_STU_ANSWER):
                 logger.warning(f"Access denied for role {role} on path {path}.")
                 return "Permission Denied!", 403
         elif "/teacher/" in path.lower():
-            # 如果路径包含 'teacher'，要求角色为教师 (1)
-            if role != 1:
+            # 如果路径包含 'teacher'，要求角色拥有管理考试权限（教师）
+            if not has_role_permission(role, PERM_TEA_MANAGE_EXAM):
                 logger.warning(f"Access denied for role {role} on path {path}.")
                 return "Permission Denied!", 403
 
@@ -314,7 +336,7 @@ def login_handler() -> Response:
     if token:
         try:
             # 尝试解码JWT token
-            data = jwt.decode(token, JWT_KEY, algorithms=["HS256"])
+            data = decode_token(token, JWT_KEY)
             if data.get("role", -1) in [0, 1]:
                 # 如果用户已登录，重定向到仪表板
                 logger.info(f"User with role {data.get('role')} already logged in. Redirecting to /dashboard.")
@@ -345,7 +367,7 @@ def render_dashboard() -> Response:
     if token:
         try:
             # 尝试解码JWT token
-            data = jwt.decode(token, JWT_KEY, algorithms=["HS256"])
+            data = decode_token(token, JWT_KEY)
             role = data.get("role", -1)
             user_id = data.get("id", "")
             logger.info(f"Decoded JWT: role={role}, user_id={user_id}")
@@ -438,7 +460,7 @@ def render_dashboard() -> Response:
 def logout_handler() -> Response:
     """
     注销用户的处理函数：
-    - 将用户的token加入黑名单。
+    - 将用户的token加入吊销列表。
     - 设置一个过期的token或默认的未登录token。
     - 返回注销成功的响应。
 
@@ -450,9 +472,15 @@ def logout_handler() -> Response:
     token = request.cookies.get("token")
     logger.info(f"Logout handler accessed. Token: {token}")
     if token:
-        # 如果token存在，将其加入黑名单
-        cookie_blacklist.append(token)
-        logger.info(f"Token {token} added to blacklist.")
+        # 如果token存在，将其加入吊销列表
+        try:
+            data = decode_token(token, JWT_KEY)
+            if revoke_token(data):
+                logger.info(f"Token {token} revoked.")
+            forget_token(token, JWT_KEY)
+        except jwt.InvalidTokenError:
+            # 无效或已过期的token本身就无法通过验证，不需要吊销
+            logger.warning("Invalid JWT during logout.")
 
     # 构建响应体
     response_body = {"success": True, "msg": "Logout successfully."}
@@ -467,16 +495,150 @@ def logout_handler() -> Response:
 
     return response
 
-def initialize_application():
+TRACE_WRITER = None  # 请求跟踪，使用 --trace 启动时创建，见 start_request_trace
+
+
+def trace_before_request():
+    """
+    记录请求的开始时间和当前线程已经调用 C 核心的次数，在所有 before_request 之前执行，耗时包含身份验证
+    """
+    g.trace_start = time.perf_counter()
+    g.trace_calls = get_thread_call_count()
+
+
+def trace_after_request(response: Response) -> Response:
+    """
+    保存响应状态码；登录请求的用户ID只能从响应新设置的 token 中得到
+    """
+    g.trace_status = response.status_code
+    for header in response.headers.getlist("Set-Cookie"):
+        if header.startswith("token="):
+            g.trace_token = header.split(";", 1)[0][len("token="):]
+    return response
+
+
+def trace_teardown_request(exception=None):
+    """
+    把请求写入跟踪文件。没有经过 after_request（处理时抛出了异常）的请求记为 500
+    """
+    start = g.pop("trace_start", None)
+    if start is None or TRACE_WRITER is None or request.path.startswith("/static/"):
+        return
+    duration = time.perf_counter() - start
+    user_id = ""
+    token = g.pop("trace_token", None) or request.cookies.get("token")
+    if token:
+        try:
+            user_id = str(decode_token(token, JWT_KEY).get("id", ""))
+        except jwt.InvalidTokenError:
+            pass
+    path = request.path
+    if request.args:
+        query = TRACE_WRITER.anonymizer.anonymize(request.args.to_dict(flat=False))
+        path += "?" + urllib.parse.urlencode(query, doseq=True)
+    body = request.get_json(silent=True) if request.is_json else None
+    TRACE_WRITER.write_request(
+        request.method,
+        request.url_rule.rule if request.url_rule is not None else request.path,
+        start,
+        duration,
+        g.pop("trace_status", 500),
+        get_thread_call_count() - g.pop("trace_calls", 0),
+        user_id,
+        path,
+        body,
+        body_omitted=body is None and bool(request.content_length),
+    )
+
+
+def start_request_trace(trace_path: str) -> None:
+    """
+    开始把每个请求记录到 trace_path（只追加的二进制文件，格式见 utils/trace.py），供 utils/replay.py 重放。
+
+    新建跟踪文件时还会用 C 核心的在线备份把三个数据库同一时刻的快照复制到 trace_path + ".snapshot"，重放从这份快照开始，
+    之后的请求（如交卷）才能得到与录制时相同的结果。内存数据库也可以这样复制到磁盘。
+    """
+    global TRACE_WRITER
+    logger = logging.getLogger(__name__)
+    TRACE_WRITER = TraceWriter(trace_path)
+    atexit.register(TRACE_WRITER.close)
+    # 默认的 SIGTERM 处理不会执行 atexit，缓冲区中最后的记录会丢失，改为正常退出
+    signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+
+    if TRACE_WRITER.created:
+        snapshot_dir = trace_path + ".snapshot"
+        if backup_databases(snapshot_dir, pages_per_step=-1, sleep_ms=0):
+            logger.info(f"Database snapshot for the request trace saved to {snapshot_dir}.")
+        else:
+            logger.warning("Failed to take the database snapshot for the request trace.")
+
+    # 插到最前面，耗时包含 before_request_func 中的身份验证
+    app.before_request_funcs.setdefault(None, []).insert(0, trace_before_request)
+    app.after_request(trace_after_request)
+    app.teardown_request(trace_teardown_request)
+    logger.info(f"Recording requests to {trace_path}.")
+
+
+def start_backup_timer(interval_minutes: float) -> None:
+    """
+    每隔 interval_minutes 分钟在线备份一次数据库，保存位置见 route.api.start_background_backup。
+    """
+    logger = logging.getLogger(__name__)
+
+    def loop():
+        while True:
+            time.sleep(interval_minutes * 60)
+            target_dir = start_background_backup()
+            if target_dir is None:
+                logger.warning("The previous backup is still running, skipping this one.")
+            else:
+                logger.info(f"Scheduled backup started, saving to {target_dir}.")
+
+    threading.Thread(target=loop, name="backup-timer", daemon=True).start()
+    logger.info(f"Backing up the databases every {interval_minutes} minutes.")
+
+
+def start_reporting_replica(interval_seconds: float) -> None:
+    """
+    开启报表副本：立即刷新一次，之后每隔 interval_seconds 秒刷新一次。
+    教师的成绩列表、成绩导出和学生列表改为读取副本，数据最多落后一个刷新间隔。
+    教师修改学生信息后会设置 route.api.REPLICA_REFRESH_REQUESTED，刷新线程被唤醒后提前刷新，不再等满间隔。
+    """
+    logger = logging.getLogger(__name__)
+    if not refresh_reporting_replica():
+        logger.warning("Failed to create the reporting replica, reports will read the live databases.")
+    route.api.REPORTING_REPLICA = True
+
+    def loop():
+        while True:
+            route.api.REPLICA_REFRESH_REQUESTED.wait(interval_seconds)
+            # 先清除信号再刷新，刷新期间再有修改时下一轮会立即再刷新一次
+            route.api.REPLICA_REFRESH_REQUESTED.clear()
+            if not refresh_reporting_replica():
+                logger.warning("Failed to refresh the reporting replica.")
+
+    threading.Thread(target=loop, name="reporting-replica", daemon=True).start()
+    logger.info(f"Refreshing the reporting replica every {interval_seconds} seconds.")
+
+
+def initialize_application(db_location: str = None) -> bool:
     """
     初始化函数：
-    - 进行必要的初始化操作，如数据库连接、加载配置等。
+    - 先设置数据库位置，在配置的位置建立文件夹和缺少的表，再进行其他初始化操作。
+    - utils.init 中的初始化函数只认识默认的 db 文件夹，指定了其他位置时不调用，以免多建一个 db 文件夹。
+
+    @param db_location 数据库位置，含义见 set_database_location
+
+    @return bool 初始化成功返回 True，否则返回 False
     """
     logger = logging.getLogger(__name__)
     logger.info("Initializing the Flask application...")
-    initialize()  # 调用你在 utils.init 中定义的初始化函数
+    if not set_database_location(db_location):
+        return False
+    if not (db_location or os.environ.get("MENTAL_DB_LOCATION")):
+        initialize()  # 调用你在 utils.init 中定义的初始化函数
     # 这里可以添加更多的初始化操作
-    pass
+    return True
 
 if __name__ == "__main__":
     # 解析命令行参数
@@ -484,6 +646,15 @@ if __name__ == "__main__":
     parser.add_argument('--host', '-H', default='0.0.0.0', help='监听的主机地址 (默认: 0.0.0.0)')
     parser.add_argument('--port', '-p', type=int, default=5000, help='监听的端口号 (默认: 5000)')
     parser.add_argument('--debug', '-d', action='store_true', help='启用调试模式')
+    parser.add_argument('--slow-query-ms', type=int, default=100, help='慢查询阈值（毫秒），负数表示不记录 (默认: 100)')
+    parser.add_argument('--explain-slow-queries', action='store_true', help='在慢查询日志中附带 EXPLAIN QUERY PLAN')
+    parser.add_argument('--db', default=None, help='数据库位置：目录路径、":memory:" 或 "memory:名称" (默认: 环境变量 MENTAL_DB_LOCATION，没有设置时为 db)')
+    parser.add_argument('--no-browser', action='store_true', help='启动后不自动打开浏览器（压力测试等无人值守场景使用）')
+    parser.add_argument('--no-reload', action='store_true', help='禁用自动重新加载器，只保留一个服务进程')
+    parser.add_argument('--trace', default=None, help='把每个请求记录到指定的跟踪文件，供 utils/replay.py 重放')
+    parser.add_argument('--reporting-interval', type=float, default=0, help='开启报表副本，每隔多少秒刷新一次，教师的报表查询读取副本，0 表示不开启 (默认: 0)')
+    parser.add_argument('--backup-interval', type=float, default=0, help='每隔多少分钟在线备份一次数据库，0 表示不定时备份 (默认: 0)')
+    parser.add_argument('--backup-dir', default='backups', help='在线备份保存的根目录 (默认: backups)')
     args = parser.parse_args()
 
     # 配置日志
@@ -491,8 +662,20 @@ if __name__ == "__main__":
     redirect_print_to_logging()
 
     # 初始化应用
-    initialize_application()
-    webbrowser.open(f"http://{args.host}:{args.port}" if args.host != "0.0.0.0" else f"http://127.0.0.1:{args.port}")
+    if not initialize_application(args.db):
+        sys.exit("无法设置数据库位置，详见 logs/latest.log")
+    set_slow_query_log(args.slow_query_ms, args.explain_slow_queries)
+    route.api.BACKUP_ROOT = args.backup_dir
+    # 开启重新加载器时只在真正处理请求的子进程中记录和定时备份
+    serving = args.no_reload or os.environ.get("WERKZEUG_RUN_MAIN") == "true"
+    if args.trace and serving:
+        start_request_trace(args.trace)
+    if args.reporting_interval > 0 and serving:
+        start_reporting_replica(args.reporting_interval)
+    if args.backup_interval > 0 and serving:
+        start_backup_timer(args.backup_interval)
+    if not args.no_browser:
+        webbrowser.open(f"http://{args.host}:{args.port}" if args.host != "0.0.0.0" else f"http://127.0.0.1:{args.port}")
     # 运行 Flask 应用，禁用重新加载器以防止日志重复
     # app.run(host=args.host, port=args.port, debug=args.debug, use_reloader=False)
-    app.run(host=args.host, port=args.port, debug=args.debug, use_reloader=True)
+    app.run(host=args.host, port=args.port, debug=args.debug, use_reloader=not args.no_reload)
@@ -17,14 +17,33 @@ from utils.database import (
     delete_question_data,
     delete_user_data,
     delete_score_data,
+    get_exam_paper,
+    render_exam_paper_json,
+    backup_databases,
+    get_backup_progress,
+    reporting_reads,
+    query_exam_stats,
+    score_rank,
+    top_scores,
+    query_class_cube,
+    insert_answer_log,
+    query_item_analysis,
 )
 from utils.app import (
     generate_question_list,
     randomize_question_list,
     traverse_question_list,
+    generate_uuid,
+    generate_uuid_list,
+    generate_question_permutation,
+    UUID_VERSION_4,
+    UUID_VERSION_7,
 )
+from utils.auth import decode_token
+from utils.metrics import render_prometheus
 from utils.tools import (
     generate_salt,
+    grade_answers,
     calculate_score,
     questions_xlsx_parse,
     students_xlsx_parser,
@@ -32,18 +51,24 @@ from utils.tools import (
     c_strlen,
     is_chinese,
 )
-from hashlib import sha512
+from hashlib import sha256, sha512
 from datetime import datetime
 import jwt
-import random
-import uuid
 import string
 import time
 import json
+import os
+import threading
 from urllib.parse import unquote_to_bytes
 
 JWT_KEY = "GamerNoTitle"
 
+REPORTING_REPLICA = False  # 是否开启了报表副本（app.py 的 --reporting-interval），开启后教师修改学生信息时立即刷新副本
+REPLICA_REFRESH_REQUESTED = threading.Event()  # 唤醒 reporting-replica 线程提前刷新副本，刷新在该线程中进行，不占用请求线程
+BACKUP_ROOT = "backups"  # 在线备份保存的根目录，每次备份保存在以时间命名的子文件夹中，可以由 app.py 的 --backup-dir 修改
+BACKUP_LOCK = threading.Lock()  # 保护 backup_claimed，检查有没有备份在进行和启动备份线程必须一起完成
+backup_claimed = False  # 是否已经有请求启动了备份，备份线程结束时清除
+
 user_api_v1 = Blueprint("user", __name__)
 
 student_api_v1 = Blueprint("student", __name__)
@@ -99,12 +124,17 @@ def general_login() -> Response:
     # 如果登录成功，生成JWT并设置到cookie中
     if body.get("success"):
         # 生成JWT，包含用户角色和ID
+        cookie_age = 604800  # 设置cookie有效期为7天（7*24*60*60秒）
         cookie = jwt.encode(
-            {"role": user.role, "id": user.id.decode(), "token": generate_salt()},
+            {
+                "role": user.role,
+                "id": user.id.decode(),
+                "token": generate_salt(),
+                "exp": int(time.time()) + cookie_age,  # 与cookie同时过期，吊销记录也以此为准
+            },
             JWT_KEY,
             algorithm="HS256",
         )
-        cookie_age = 604800  # 设置cookie有效期为7天（7*24*60*60秒）
         response.set_cookie("token", cookie, max_age=cookie_age)
 
     # 返回响应
@@ -173,7 +203,7 @@ def general_register() -> Response:
                 }
             else:
                 # 生成新用户的UUID
-                user_id = str(uuid.uuid4())
+                user_id = generate_uuid(UUID_VERSION_4)
                 # 生成随机盐值
                 salt = generate_salt()
                 # 计算密码的哈希值
@@ -210,6 +240,18 @@ def general_register() -> Response:
     return response
 
 
+@general_api_v1.route("/api/v1/metrics", methods=["GET"])
+def general_metrics() -> Response:
+    """
+    性能统计接口：
+    以 Prometheus 文本格式输出 C 核心各个导出函数的调用次数、耗时直方图、批量查询的行数和字节数，以及缓存和写冲突的统计。
+    接口不需要登录，为了不向外暴露运行情况，只允许本机访问。
+    """
+    if request.remote_addr not in ("127.0.0.1", "::1"):
+        return "Permission Denied!", 403
+    return Response(render_prometheus(), content_type="text/plain; version=0.0.4; charset=utf-8")
+
+
 @user_api_v1.route("/api/v1/user/modifyPassword", methods=["POST"])
 def user_modify_password() -> Response:
     """
@@ -354,6 +396,14 @@ def student_get_exam_info(retJSON: int = 0) -> Response | dict:
     return body if retJSON else jsonify(body)
 
 
+def question_seed(user_id: str, exam_id: str) -> int:
+    """
+    由学生 ID 和考试 ID 确定地生成随机题目顺序的种子，取值范围为 1 ~ 2^32 - 1
+    """
+    digest = sha256(f"{user_id}:{exam_id}".encode("utf-8")).digest()
+    return int.from_bytes(digest[:4], "little") or 1
+
+
 @student_api_v1.route("/api/v1/student/getExamData/<uuid:UUID>")
 def student_get_exam_data(UUID: str) -> Response:
     """
@@ -361,8 +411,19 @@ def student_get_exam_data(UUID: str) -> Response:
     根据考试的 UUID 获取考试的详细信息和相关问题列表。
     如果考试允许随机问题，则对问题进行随机排序。
     """
-    # 查询指定 UUID 的考试信息
-    exam = query_exam_info(key="id", content=str(UUID))
+    # 同一个学生重复获取同一场考试时种子不变，题目顺序和 ETag 也就不变，刷新页面可以直接返回 304
+    user_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id", "")
+    seed = question_seed(user_id, str(UUID))
+    # 优先使用 C 层预先生成的 JSON 片段，按题目顺序复制即可得到响应
+    payload, version = render_exam_paper_json(str(UUID), seed)
+    if payload is not None:
+        response = Response(payload, mimetype="application/json")
+        response.set_etag(f"{UUID}-{version}-{seed}", weak=True)
+        response.headers["Cache-Control"] = "private, no-cache"
+        return response.make_conditional(request)
+
+    # 从考卷缓存获取考试信息和题目
+    exam, paper, _ = get_exam_paper(str(UUID))
     if exam:
         # 构建成功的响应体，包含考试的元数据
         body = {
@@ -377,31 +438,18 @@ def student_get_exam_data(UUID: str) -> Response:
             },
             "data": [],
         }
-        # 查询与考试相关的所有问题，排除 ID 为空的条目
-        questions = [
-            item
-            for item in query_questions_info_all(999, key="exam_id", content=str(UUID))
-            if item.id.decode() != ""
+        # 生成原始问题列表，正确答案不能下发给学生
+        original_question_list = [
+            {key: value for key, value in item.items() if key != "correct_answer"}
+            for item in paper
         ]
-        # 遍历问题列表，生成原始问题列表
-        original_question_list = traverse_question_list(questions)
         if exam.random_question:
-            # 如果考试允许随机问题，进行 Fisher-Yates 随机洗牌
-            randomize_question_list = original_question_list.copy()
-            seed = int(time.time())
-            random.seed(seed)
+            # 如果考试允许随机问题，按照种子生成的排列打乱题目顺序
             body["metadata"]["seed"] = seed  # 将随机种子添加到元数据中
-            for index in range(len(randomize_question_list))[::-1]:
-                random_index = random.randint(0, len(questions) - 1)  # 生成随机索引
-                # 交换当前索引和随机索引的元素
-                (
-                    randomize_question_list[index],
-                    randomize_question_list[random_index],
-                ) = (
-                    randomize_question_list[random_index],
-                    randomize_question_list[index],
-                )
-            body["data"] = randomize_question_list
+            body["data"] = [
+                original_question_list[index]
+                for index in generate_question_permutation(seed, len(original_question_list))
+            ]
         else:
             # 如果不允许随机问题，直接使用原始问题列表
             body["data"] = original_question_list
@@ -436,73 +484,51 @@ def student_exam_submit() -> Response:
         data = request.json
         # 提取考试 ID、答案列表和随机种子
         exam_id: str = data.get("id")
-        answers: list[str] = map(float, data.get("answers"))
+        answers: list[float] = [float(item) for item in data.get("answers")]
         seed: int = int(data.get("seed", 0))
         # 从 JWT token 中解码获取用户 ID
-        user_id = jwt.decode(
-            request.cookies.get("token"), JWT_KEY, algorithms=["HS256"]
-        ).get("id")
-        # 查询数据库中成绩，避免重复提交刷分
-        scores = [
-            item
-            for item in query_scores_info_all(999, key="exam_id", content=exam_id)
-            if item.id.decode() != ""
-        ]
-        for score in scores:
-            if score.user_id.decode() == user_id:
-                body = {
-                    "success": False,
-                    "msg": "你已经提交过了此次考试答卷，请勿重复提交！",
-                }
-                return jsonify(body)
-        # 查询考试信息
-        exam = query_exam_info(key="id", content=exam_id)
+        user_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id")
+        # 查询数据库中成绩，避免重复提交刷分（只需要 user_id 一列）
+        scores = query_scores_info_all(999, key="exam_id", content=exam_id)
+        if scores and user_id.encode() in scores.text_column("user_id"):
+            body = {
+                "success": False,
+                "msg": "你已经提交过了此次考试答卷，请勿重复提交！",
+            }
+            return jsonify(body)
+        # 从考卷缓存获取考试信息和题目（题目带有正确答案）
+        exam, questions, _ = get_exam_paper(exam_id)
+        if not exam:
+            return jsonify({"success": False, "msg": "提交失败！未找到该考试！"})
         if seed:
-            # 如果提供了随机种子，重新生成问题列表的顺序
-            questions = [
-                item
-                for item in query_questions_info_all(
-                    999, key="exam_id", content=exam_id
-                )
-                if item.id.decode() != ""
-            ]
-            original_question_list = traverse_question_list(questions)
-            randomize_question_list = original_question_list.copy()
-            random.seed(seed)
-            for index in range(len(randomize_question_list))[::-1]:
-                random_index = random.randint(0, len(questions) - 1)  # 生成随机索引
-                # 交换当前索引和随机索引的元素
-                (
-                    randomize_question_list[index],
-                    randomize_question_list[random_index],
-                ) = (
-                    randomize_question_list[random_index],
-                    randomize_question_list[index],
-                )
-            question_list = randomize_question_list
+            # 如果提供了随机种子，按照与下发考卷时相同的排列重新生成问题列表的顺序
+            order = generate_question_permutation(seed, len(questions))
         else:
             # 如果没有提供随机种子，直接使用原始问题列表
-            question_list = [
-                {
-                    "num1": item.num1,
-                    "op": item.op,
-                    "num2": item.num2,
-                }
-                for item in query_questions_info_all(
-                    999, key="exam_id", content=exam_id
-                )
-                if item.id.decode() != ""
-            ]
-        # 计算得分
-        score = calculate_score(question_list, answers)
+            order = range(len(questions))
+        question_list = [questions[index] for index in order]
+        # 逐题判题并计算得分
+        graded = grade_answers(question_list, answers)
+        score = calculate_score(question_list, answers, graded)
         # 将成绩数据插入数据库
-        insert_score_data(
-            str(uuid.uuid4()),
+        score_id = generate_uuid(UUID_VERSION_7)
+        if not insert_score_data(
+            score_id,
             exam_id,
             user_id,
             score,
             1 if time.time() > exam.end_time else 0,  # 判断考试是否过期
-        )
+        ):
+            # 成绩没有保存时不写入答题记录，否则逐题分析会统计到一份不存在的答卷
+            return jsonify({"success": False, "msg": "提交失败！成绩保存失败，请重新提交！"})
+        # 按考卷中的原始顺序保存每道题的判题结果和答案，供逐题分析使用；保存失败时只写入日志，不影响成绩
+        correct_log = [False] * len(questions)
+        answer_log = [None] * len(questions)
+        for position, index in enumerate(order):
+            correct_log[index] = graded[position]
+            if position < len(answers):
+                answer_log[index] = answers[position]
+        insert_answer_log(score_id, exam_id, user_id, seed, correct_log, answer_log)
         # 构建成功的响应体，包含得分信息
         body = {"success": True, "msg": "提交成功！", "score": score}
     except Exception as e:
@@ -512,6 +538,21 @@ def student_exam_submit() -> Response:
     return jsonify(body)
 
 
+@student_api_v1.route("/api/v1/student/getExamRank/<uuid:UUID>")
+def student_get_exam_rank(UUID: str) -> Response:
+    """
+    获取考试排名函数：
+    返回当前用户在指定考试中的成绩、名次和百分位。
+    """
+    user_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id")
+    rank = score_rank(str(UUID), user_id)
+    if rank is None:
+        body = {"success": False, "msg": "没有找到您在这场考试中的成绩！", "data": {}}
+        return jsonify(body)
+    body = {"success": True, "msg": "获取排名成功", "data": rank}
+    return jsonify(body)
+
+
 @student_api_v1.route("/api/v1/student/getScoreList")
 def student_get_score_list(retJSON: int = 0):
     """
@@ -520,9 +561,7 @@ def student_get_score_list(retJSON: int = 0):
     如果参数 retJSON 为 1，则返回字典；否则返回 JSON 响应。
     """
     # 从 JWT token 中解码获取用户 ID
-    user_id = jwt.decode(
-        request.cookies.get("token"), JWT_KEY, algorithms=["HS256"]
-    ).get("id")
+    user_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id")
     # 查询当前用户的所有成绩记录，排除 ID 为空的条目
     scores = [
         item
@@ -686,7 +725,7 @@ def teacher_add_exam() -> Response:
         return jsonify(body)
     # try:
     # 生成新的考试UUID
-    exam_uuid = str(uuid.uuid4())
+    exam_uuid = generate_uuid(UUID_VERSION_4)
     # 插入新的考试数据到数据库
     if insert_exam_data(
         exam_id=exam_uuid,
@@ -706,9 +745,9 @@ def teacher_add_exam() -> Response:
     ):
         # 解析上传的Excel文件中的试题
         questions = questions_xlsx_parse(file.read())
-        for question in questions:
-            # 为每个试题生成唯一的UUID
-            question_uuid = str(uuid.uuid4())
+        # 一次性为所有试题生成按时间有序的UUID
+        question_uuids = generate_uuid_list(len(questions), UUID_VERSION_7)
+        for question, question_uuid in zip(questions, question_uuids):
             # 插入试题数据到数据库
             insert_question_data(
                 question_id=question_uuid,
@@ -906,8 +945,12 @@ def teacher_modify_exam() -> Response:
                                 }
                                 continue  # 继续删除其他试题
                         # 插入新的试题数据
-                        for question in new_questions:
-                            question_uuid = str(uuid.uuid4())
+                        question_uuids = generate_uuid_list(
+                            len(new_questions), UUID_VERSION_7
+                        )
+                        for question, question_uuid in zip(
+                            new_questions, question_uuids
+                        ):
                             insert_question_data(
                                 question_id=question_uuid,
                                 exam_id=exam_id,
@@ -948,12 +991,13 @@ def teacher_get_exam_scores(UUID: str) -> Response:
     返回成绩列表和考试的基本信息。
     """
     try:
-        # 查询指定考试ID的所有成绩记录，排除ID为空的条目
-        scores = [
-            score
-            for score in query_scores_info_all(999, key="exam_id", content=str(UUID))
-            if score.id.decode() != ""
-        ]
+        # 查询指定考试ID的所有成绩记录，排除ID为空的条目，开启报表副本时从副本读取，不与交卷争用数据库
+        with reporting_reads():
+            scores = [
+                score
+                for score in query_scores_info_all(999, key="exam_id", content=str(UUID))
+                if score.id.decode() != ""
+            ]
         # 查询考试的基本信息
         exam = query_exam_info(key="id", content=str(UUID))
         data = []
@@ -991,6 +1035,110 @@ def teacher_get_exam_scores(UUID: str) -> Response:
     return jsonify(body)
 
 
+@teacher_api_v1.route("/api/v1/teacher/getExamStats/<uuid:UUID>")
+def teacher_get_exam_stats(UUID: str) -> Response:
+    """
+    获取考试成绩统计函数：
+    返回考试的平均分、最低分、最高分、标准差、及格率和 0 到 100 分的分数分布，
+    统计随成绩一起维护，不需要扫描成绩表。
+    """
+    stats = query_exam_stats(str(UUID))
+    if stats is None:
+        body = {"success": False, "msg": "获取成绩统计失败！", "data": {}}
+        return jsonify(body)
+    body = {"success": True, "msg": "获取成绩统计成功", "data": stats}
+    return jsonify(body)
+
+
+@teacher_api_v1.route("/api/v1/teacher/getItemAnalysis/<uuid:UUID>")
+def teacher_get_item_analysis(UUID: str) -> Response:
+    """
+    获取逐题分析函数：
+    返回考试每道题的难度（答对率）、区分度（点二列相关系数）、没有作答的人数和最常见的错误答案，
+    题目按考卷中的顺序排列。结果按考试缓存，有新的交卷时才重新计算。
+    """
+    exam_id = str(UUID)
+    analysis = query_item_analysis(exam_id)
+    if analysis is None:
+        body = {"success": False, "msg": "获取逐题分析失败！", "data": {}}
+        return jsonify(body)
+    _, questions, _ = get_exam_paper(exam_id)
+    for item in analysis["items"]:
+        # 答题记录按考卷中的原始顺序保存，序号与考卷中的题目一一对应；考卷中已经删除的题目没有题面
+        if item["index"] < len(questions):
+            question = questions[item["index"]]
+            item.update({key: question[key] for key in ("id", "num1", "op", "num2", "correct_answer")})
+    body = {"success": True, "msg": "获取逐题分析成功", "data": analysis}
+    return jsonify(body)
+
+
+@teacher_api_v1.route("/api/v1/teacher/getLeaderboard/<uuid:UUID>")
+def teacher_get_leaderboard(UUID: str) -> Response:
+    """
+    获取考试排行榜函数：
+    返回指定考试分数最高的 k 名学生（查询参数 k，默认10，最多100），同分同名次，同分时先交卷的在前。
+    """
+    k = min(max(request.args.get("k", 10, type=int), 1), 100)
+    data = []
+    for index, score in enumerate(top_scores(str(UUID), k)):
+        user = query_user_info(key="id", content=score.user_id.decode())
+        data.append(
+            {
+                "rank": data[-1]["rank"] if data and data[-1]["score"] == score.score else index + 1,
+                "user_id": score.user_id.decode(),
+                "number": user.number if user else 0,
+                "name": user.name.decode() if user else "",
+                "score": score.score,
+                "expired": score.expired_flag,
+            }
+        )
+    body = {"success": True, "msg": "获取排行榜成功", "data": data}
+    return jsonify(body)
+
+
+@teacher_api_v1.route("/api/v1/teacher/getClassComparison/<uuid:UUID>")
+def teacher_get_class_comparison(UUID: str) -> Response:
+    """
+    获取班级对比函数：
+    返回当前教师的每个班级在指定考试中的人数、平均分、最低分、最高分、标准差、及格率和分数分布，
+    汇总随成绩一起维护，不需要扫描成绩表。
+    """
+    teacher_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id")
+    if not teacher_id:
+        body = {"success": False, "msg": "无法验证您的身份，请重新登陆！", "data": []}
+        return jsonify(body)
+    cells = query_class_cube(teacher_id, exam_id=str(UUID), with_histogram=True)
+    body = {"success": True, "msg": "获取班级对比成功", "data": cells}
+    return jsonify(body)
+
+
+@teacher_api_v1.route("/api/v1/teacher/getClassTrend")
+def teacher_get_class_trend() -> Response:
+    """
+    获取班级成绩趋势函数：
+    返回当前教师每个班级（查询参数 className 指定时只返回这个班级）历次考试的人数、平均分、标准差和及格率，
+    每个班级按考试开始时间排序。
+    """
+    teacher_id = decode_token(request.cookies.get("token"), JWT_KEY).get("id")
+    if not teacher_id:
+        body = {"success": False, "msg": "无法验证您的身份，请重新登陆！", "data": {}}
+        return jsonify(body)
+    cells = query_class_cube(teacher_id, class_name=request.args.get("className", ""))
+    exams = {exam.id.decode(): exam for exam in query_exams_info_all(999) or []}
+    data = {}
+    for cell in cells:
+        exam = exams.get(cell["exam_id"])
+        if exam is None:
+            continue  # 考试已经被删除
+        cell["exam_name"] = exam.name.decode()
+        cell["start_time"] = exam.start_time
+        data.setdefault(cell.pop("class_name"), []).append(cell)
+    for trend in data.values():
+        trend.sort(key=lambda item: item["start_time"])
+    body = {"success": True, "msg": "获取班级成绩趋势成功", "data": data}
+    return jsonify(body)
+
+
 @teacher_api_v1.route("/api/v1/teacher/addStudents", methods=["POST"])
 def teacher_add_students() -> Response:
     """
@@ -1007,7 +1155,7 @@ def teacher_add_students() -> Response:
     teacher_cookie = request.cookies
     token = teacher_cookie.get("token")
     # 解码JWT token以获取教师ID
-    token_data = jwt.decode(token, JWT_KEY, algorithms=["HS256"])
+    token_data = decode_token(token, JWT_KEY)
     teacher_id = token_data.get("id")
 
     if not teacher_id:
@@ -1078,7 +1226,7 @@ def teacher_add_students() -> Response:
                     "msg": f"班级名称的长度过长（{c_strlen(student.get('className'))} 字符），请检查输入！",
                 }
             # 生成新的用户ID和盐值
-            user_id = str(uuid.uuid4())
+            user_id = generate_uuid(UUID_VERSION_4)
             salt = generate_salt()
             password = "00000000"  # 固定新用户密码为00000000
             # 计算密码的哈希值
@@ -1172,7 +1320,7 @@ def teacher_add_students() -> Response:
                     continue
                 del tmp_user, user
                 # 生成新的用户ID和盐值
-                user_id = str(uuid.uuid4())
+                user_id = generate_uuid(UUID_VERSION_4)
                 salt = generate_salt()
                 # 计算密码的哈希值
                 hashpass = sha512((salt + student[3]).encode()).hexdigest()
@@ -1264,17 +1412,18 @@ def teacher_get_all_students(retJSON: int = 0) -> Response | dict:
     try:
         # 从JWT token中解码获取教师ID
         token = request.cookies.get("token")
-        token_data = jwt.decode(token, JWT_KEY, algorithms=["HS256"])
+        token_data = decode_token(token, JWT_KEY)
         teacher_id = token_data.get("id")
 
-        # 查询数据库中所有学生信息，限制返回数量为999条
-        students = [
-            item
-            for item in query_users_info_all(999)
-            if item.id.decode() != ""
-            and item.role == 0  # 角色为0表示学生
-            and item.belong_to.decode() == teacher_id
-        ]
+        # 查询数据库中所有学生信息，限制返回数量为999条，开启报表副本时从副本读取
+        with reporting_reads():
+            students = [
+                item
+                for item in query_users_info_all(999)
+                if item.id.decode() != ""
+                and item.role == 0  # 角色为0表示学生
+                and item.belong_to.decode() == teacher_id
+            ]
     except Exception as e:
         # 如果解码JWT或查询数据库时发生异常，返回失败响应
         body = {"success": False, "msg": f"获取学生列表失败！{e}", "data": []}
@@ -1466,7 +1615,7 @@ def teacher_export_score() -> Response:
     exam = query_exam_info(key="id", content=exam_id)
     if not exam:
         body = {"success": False, "msg": "无法找到考试信息！"}
-    token_data = jwt.decode(request.cookies.get("token"), JWT_KEY, algorithms=["HS256"])
+    token_data = decode_token(request.cookies.get("token"), JWT_KEY)
     teacher_id = token_data.get("id")
     if not teacher_id:
         body = {"success": False, "msg": "无法验证您的身份，请重新登陆！"}
@@ -1480,26 +1629,23 @@ def teacher_export_score() -> Response:
         if user.role != 1:
             body = {"success": False, "msg": "权限不足！"}
             return jsonify(body)
-    scores = [
-        item
-        for item in query_scores_info_all(999, key="exam_id", content=exam_id)
-        if item.id.decode() != ""
-    ]
-    students = [
-        item
-        for item in query_users_info_all(999, key="belong_to", content=teacher_id)
-        if item.id.decode() != ""
-    ]
+    # 导出需要扫描整张成绩表和学生表，开启报表副本时从副本读取
+    with reporting_reads():
+        scores = query_scores_info_all(999, key="exam_id", content=exam_id)
+        students = query_users_info_all(999, key="belong_to", content=teacher_id)
+    # 按列读取成绩，建立 用户ID -> (成绩, 是否逾期) 的索引，每个学生只需要查一次字典
+    score_index = {}
+    if scores:
+        for user_id, score, expired in zip(
+            scores.text_column("user_id"),
+            scores.column("score"),
+            scores.column("expired_flag"),
+        ):
+            score_index.setdefault(user_id, (score, expired))
     student_scores = []
     for student in students:
         # 获取学生成绩
-        current_score = -1
-        expired = -1
-        for score in scores:
-            if score.user_id == student.id:
-                current_score = score.score
-                expired = score.expired_flag
-                break
+        current_score, expired = score_index.get(student.id, (-1, -1))
         student_scores.append(
             {
                 "id": student.number,
@@ -1517,3 +1663,81 @@ def teacher_export_score() -> Response:
         download_name=f"{exam.name.decode()}考试成绩导出.xlsx",
         mimetype="application/vnd.openxmlformats-officedocument.spreadsheetml.sheet",
     )
+
+
+def run_backup(target_dir: str) -> None:
+    """
+    备份线程的入口：备份到 target_dir，结束后（无论成功与否）允许启动下一次备份。
+    """
+    global backup_claimed
+    try:
+        backup_databases(target_dir)
+    finally:
+        with BACKUP_LOCK:
+            backup_claimed = False
+
+
+def start_background_backup() -> str | None:
+    """
+    在后台线程中在线备份三个数据库，保存到 BACKUP_ROOT/<年月日-时分秒-毫秒-随机后缀>。
+
+    返回备份保存的文件夹；已经有备份在进行时返回 None。
+    检查和启动在 BACKUP_LOCK 下一起完成，几乎同时到达的两个请求只有一个能启动备份。
+    """
+    global backup_claimed
+    with BACKUP_LOCK:
+        if backup_claimed:
+            return None
+        progress = get_backup_progress()
+        if progress is None or progress["running"]:
+            return None
+        os.makedirs(BACKUP_ROOT, exist_ok=True)
+        now = datetime.now()
+        folder_name = f"{now.strftime('%Y%m%d-%H%M%S')}-{now.microsecond // 1000:03d}-{generate_uuid()[:8]}"
+        target_dir = os.path.join(BACKUP_ROOT, folder_name)
+        threading.Thread(target=run_backup, args=(target_dir,), name="backup", daemon=True).start()
+        backup_claimed = True
+    return target_dir
+
+
+@teacher_api_v1.route("/api/v1/teacher/backup", methods=["POST"])
+def teacher_start_backup() -> Response:
+    """
+    在线备份接口：
+    在后台开始备份三个数据库，备份期间考试照常进行，用 GET 请求同一个接口查看进度。
+    """
+    target_dir = start_background_backup()
+    if target_dir is None:
+        body = {"success": False, "msg": "已经有备份正在进行，请稍后再试！"}
+        return jsonify(body)
+    body = {"success": True, "msg": "备份已开始！", "data": {"targetDir": target_dir}}
+    return jsonify(body)
+
+
+@teacher_api_v1.route("/api/v1/teacher/backup", methods=["GET"])
+def teacher_get_backup_progress() -> Response:
+    """
+    备份进度接口：
+    返回最近一次备份的进度，以及备份期间写入操作的耗时与备份开始前的对比。
+    """
+    progress = get_backup_progress()
+    if progress is None:
+        body = {"success": False, "msg": "无法获取备份进度！"}
+        return jsonify(body)
+    body = {"success": True, "msg": "", "data": progress}
+    return jsonify(body)
+
+
+@teacher_api_v1.after_request
+def refresh_replica_after_student_change(response: Response) -> Response:
+    """
+    教师添加、删除、修改学生之后唤醒报表副本的刷新线程，学生列表很快就能看到变化，不必等到下一次定时刷新。
+    刷新副本需要复制整个数据库，放在请求线程里会拖慢教师的请求，所以这里只发出信号，立即返回。
+    """
+    if REPORTING_REPLICA and request.endpoint in (
+        "teacher.teacher_add_students",
+        "teacher.teacher_delete_students",
+        "teacher.teacher_modify_student",
+    ):
+        REPLICA_REFRESH_REQUESTED.set()
+    return response
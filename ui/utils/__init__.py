@@ -1,13 +1,41 @@
 # C语言函数调用器，在这里定义了一些函数，用于直接调用我需要的C语言代码
 
 import ctypes
+import importlib.machinery
+import importlib.util
 import os
-from ctypes import c_char_p, c_int, POINTER, c_float, c_uint
+from ctypes import c_char_p, c_int, POINTER, c_float, c_uint, c_longlong, c_ubyte
+
+
+def _load_core():
+    """
+    在当前目录查找原生核心模块 mentalcore（由 include/pymodule.c 编译），找不到或者设置了环境变量
+    MENTAL_NO_CORE=1 时返回 (None, None)
+    """
+    if os.environ.get("MENTAL_NO_CORE") == "1":
+        return None, None
+    for suffix in importlib.machinery.EXTENSION_SUFFIXES:
+        path = os.path.join(os.getcwd(), "mentalcore" + suffix)
+        if os.path.exists(path):
+            loader = importlib.machinery.ExtensionFileLoader("mentalcore", path)
+            spec = importlib.util.spec_from_file_location("mentalcore", path, loader=loader)
+            module = importlib.util.module_from_spec(spec)
+            loader.exec_module(module)
+            return module, path
+    return None, None
+
+
+# 原生核心模块，常用查询直接返回 Python 对象，没有编译时为 None
+CORE, CORE_PATH = _load_core()
 
 # dll链接
-APP_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "app.dll"))
-DATABASE_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "database.dll"))
-INITIALIZER_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "initializer.dll"))
+if CORE:
+    # 核心模块导出了所有 C 函数，其余函数也通过 ctypes 从同一个动态库调用，整个进程只有一份 SQLite 和缓存
+    APP_LIB = DATABASE_LIB = INITIALIZER_LIB = ctypes.CDLL(CORE_PATH)
+else:
+    APP_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "app.dll"))
+    DATABASE_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "database.dll"))
+    INITIALIZER_LIB = ctypes.CDLL(os.path.join(os.getcwd(), "initializer.dll"))
 
 class Permission(ctypes.Structure):
     """
@@ -222,6 +250,424 @@ class SqlResponseUser(ctypes.Structure):
         )
 
 
+class ExamPaperQuestion(ctypes.Structure):
+    """
+    表示考卷中的一道题目。
+
+    Attributes:
+        id (ctypes.c_char * 37): 题目的唯一标识符。
+        num1 (ctypes.c_int): 第一个操作数。
+        op (ctypes.c_int): 运算符，0123分别对应+-*/。
+        num2 (ctypes.c_int): 第二个操作数。
+        answer (ctypes.c_float): 预先计算好的正确答案。
+    """
+
+    _fields_ = [
+        ("id", ctypes.c_char * 37),
+        ("num1", ctypes.c_int),
+        ("op", ctypes.c_int),
+        ("num2", ctypes.c_int),
+        ("answer", ctypes.c_float),
+    ]
+
+
+COLUMNAR_MAX_INT_COLUMNS = 4  # 与 include/model.h 中的 COLUMNAR_MAX_INT_COLUMNS 保持一致
+
+
+class ColumnarResult(ctypes.Structure):
+    """
+    表示列式查询结果，由 C 函数分配，必须通过 free_columnar_result 释放。
+
+    Attributes:
+        count (ctypes.c_int): 行数。
+        text_column_count (ctypes.c_int): 文本列数量。
+        int_column_count (ctypes.c_int): 整数列数量。
+        int_columns (POINTER(ctypes.c_int32) * 4): 整数列，每列 count 个元素。
+        text_offsets (POINTER(ctypes.c_int32)): 文本列在字符串区中的偏移，共 count * text_column_count + 1 个元素。
+        strings (ctypes.c_void_p): 字符串区。
+        strings_length (ctypes.c_int): 字符串区已使用的长度。
+    """
+
+    _fields_ = [
+        ("count", ctypes.c_int),
+        ("text_column_count", ctypes.c_int),
+        ("int_column_count", ctypes.c_int),
+        ("int_columns", POINTER(ctypes.c_int32) * COLUMNAR_MAX_INT_COLUMNS),
+        ("text_offsets", POINTER(ctypes.c_int32)),
+        ("strings", ctypes.c_void_p),
+        ("strings_length", ctypes.c_int),
+        ("capacity", ctypes.c_int),
+        ("strings_capacity", ctypes.c_int),
+    ]
+
+
+class ExamCacheStats(ctypes.Structure):
+    """
+    表示考卷缓存的统计信息，字段含义与 UserCacheStats 相同。
+    """
+
+    _fields_ = [
+        ("hits", ctypes.c_ulonglong),
+        ("misses", ctypes.c_ulonglong),
+        ("evictions", ctypes.c_ulonglong),
+        ("invalidations", ctypes.c_ulonglong),
+        ("size", ctypes.c_int),
+        ("capacity", ctypes.c_int),
+    ]
+
+
+class ItemAnalysisCacheStats(ctypes.Structure):
+    """
+    表示逐题分析缓存的统计信息，字段含义与 UserCacheStats 相同，没有 invalidations（缓存按版本号失效）。
+    """
+
+    _fields_ = [
+        ("hits", ctypes.c_ulonglong),
+        ("misses", ctypes.c_ulonglong),
+        ("evictions", ctypes.c_ulonglong),
+        ("size", ctypes.c_int),
+        ("capacity", ctypes.c_int),
+    ]
+
+
+METRICS_BUCKET_COUNT = 52  # 与 include/metrics.h 中的 METRICS_BUCKET_COUNT 保持一致
+METRIC_FUNCTION_COUNT = 37  # 与 include/metrics.h 中的 METRIC_FUNCTION_COUNT 保持一致
+
+
+class FunctionMetrics(ctypes.Structure):
+    """
+    表示一个 C 函数的性能统计数据。
+
+    Attributes:
+        name (ctypes.c_char * 40): 函数名。
+        calls (ctypes.c_ulonglong): 调用次数。
+        errors (ctypes.c_ulonglong): 返回失败的次数。
+        rows (ctypes.c_ulonglong): 返回的行数（只有批量查询函数会记录）。
+        bytes (ctypes.c_ulonglong): 复制给调用者的字节数（只有批量查询函数会记录）。
+        total_ns (ctypes.c_ulonglong): 总耗时（纳秒）。
+        max_ns (ctypes.c_ulonglong): 单次调用的最大耗时（纳秒）。
+        buckets (ctypes.c_ulonglong * METRICS_BUCKET_COUNT): 耗时直方图，每个桶的调用次数（不累加）。
+    """
+
+    _fields_ = [
+        ("name", ctypes.c_char * 40),
+        ("calls", ctypes.c_ulonglong),
+        ("errors", ctypes.c_ulonglong),
+        ("rows", ctypes.c_ulonglong),
+        ("bytes", ctypes.c_ulonglong),
+        ("total_ns", ctypes.c_ulonglong),
+        ("max_ns", ctypes.c_ulonglong),
+        ("buckets", ctypes.c_ulonglong * METRICS_BUCKET_COUNT),
+    ]
+
+
+class MetricsSnapshot(ctypes.Structure):
+    """
+    表示所有 C 函数的性能统计快照。
+
+    Attributes:
+        function_count (ctypes.c_int): 函数数量。
+        bucket_count (ctypes.c_int): 每个直方图的桶数量。
+        bucket_upper_ns (ctypes.c_ulonglong * METRICS_BUCKET_COUNT): 每个桶的上界（纳秒，不含），最后一个桶没有上界。
+        functions (FunctionMetrics * METRIC_FUNCTION_COUNT): 每个函数的统计数据。
+    """
+
+    _fields_ = [
+        ("function_count", ctypes.c_int),
+        ("bucket_count", ctypes.c_int),
+        ("bucket_upper_ns", ctypes.c_ulonglong * METRICS_BUCKET_COUNT),
+        ("functions", FunctionMetrics * METRIC_FUNCTION_COUNT),
+    ]
+
+
+class DatabaseRetryStats(ctypes.Structure):
+    """
+    表示写冲突重试的统计信息。
+
+    Attributes:
+        conflicts (ctypes.c_ulonglong): 遇到过写冲突的语句数。
+        retries (ctypes.c_ulonglong): 重试的总次数。
+        busy (ctypes.c_ulonglong): 返回 SQLITE_BUSY 的次数。
+        locked (ctypes.c_ulonglong): 返回 SQLITE_LOCKED 的次数。
+        exhausted (ctypes.c_ulonglong): 重试次数用完后仍然失败的语句数。
+    """
+
+    _fields_ = [
+        ("conflicts", ctypes.c_ulonglong),
+        ("retries", ctypes.c_ulonglong),
+        ("busy", ctypes.c_ulonglong),
+        ("locked", ctypes.c_ulonglong),
+        ("exhausted", ctypes.c_ulonglong),
+    ]
+
+
+class BackupProgress(ctypes.Structure):
+    """
+    表示在线备份的进度，耗时都以纳秒为单位。
+
+    Attributes:
+        running (ctypes.c_int): 是否正在备份。
+        result (ctypes.c_int): 备份结果，-1 为还没有完成过备份，0 为成功，1 为失败。
+        current_database (ctypes.c_int): 正在复制的数据库序号。
+        database_count (ctypes.c_int): 数据库的总数。
+        started_at (ctypes.c_longlong): 开始时间（UNIX 时间戳）。
+        finished_at (ctypes.c_longlong): 结束时间（UNIX 时间戳），还没有结束时为0。
+        total_pages (ctypes.c_ulonglong): 三个数据库快照的总页数。
+        copied_pages (ctypes.c_ulonglong): 已经复制的页数。
+        steps (ctypes.c_ulonglong): 调用 sqlite3_backup_step 的次数。
+        max_step_ns (ctypes.c_ulonglong): 单步的最大耗时。
+        freeze_ns (ctypes.c_ulonglong): 取快照时挡住写入者的时长。
+        writer_calls (ctypes.c_ulonglong): 备份期间写入函数的调用次数。
+        writer_mean_ns (ctypes.c_ulonglong): 备份期间写入函数的平均耗时。
+        writer_p99_ns (ctypes.c_ulonglong): 备份期间写入函数耗时的 p99。
+        baseline_writer_calls (ctypes.c_ulonglong): 备份开始前写入函数的调用次数。
+        baseline_writer_mean_ns (ctypes.c_ulonglong): 备份开始前写入函数的平均耗时。
+        baseline_writer_p99_ns (ctypes.c_ulonglong): 备份开始前写入函数耗时的 p99。
+        target_dir (ctypes.c_char * 260): 备份保存的文件夹。
+    """
+
+    _fields_ = [
+        ("running", ctypes.c_int),
+        ("result", ctypes.c_int),
+        ("current_database", ctypes.c_int),
+        ("database_count", ctypes.c_int),
+        ("started_at", ctypes.c_longlong),
+        ("finished_at", ctypes.c_longlong),
+        ("total_pages", ctypes.c_ulonglong),
+        ("copied_pages", ctypes.c_ulonglong),
+        ("steps", ctypes.c_ulonglong),
+        ("max_step_ns", ctypes.c_ulonglong),
+        ("freeze_ns", ctypes.c_ulonglong),
+        ("writer_calls", ctypes.c_ulonglong),
+        ("writer_mean_ns", ctypes.c_ulonglong),
+        ("writer_p99_ns", ctypes.c_ulonglong),
+        ("baseline_writer_calls", ctypes.c_ulonglong),
+        ("baseline_writer_mean_ns", ctypes.c_ulonglong),
+        ("baseline_writer_p99_ns", ctypes.c_ulonglong),
+        ("target_dir", ctypes.c_char * 260),
+    ]
+
+
+class ReplicaStats(ctypes.Structure):
+    """
+    表示报表副本的统计信息。
+
+    Attributes:
+        active_slot (ctypes.c_int): 在用的一份副本，-1 为还没有刷新过。
+        refreshes (ctypes.c_ulonglong): 切换过副本的刷新次数。
+        skipped (ctypes.c_ulonglong): 源数据库没有变化、什么都没有做的刷新次数。
+        failures (ctypes.c_ulonglong): 失败的刷新次数。
+        copied_databases (ctypes.c_ulonglong): 复制过的数据库个数。
+        copied_pages (ctypes.c_ulonglong): 复制过的总页数。
+        routed_reads (ctypes.c_ulonglong): 改为读取副本的批量查询次数。
+        last_refresh_at (ctypes.c_longlong): 最近一次切换副本的时间（UNIX 时间戳）。
+        last_refresh_ns (ctypes.c_ulonglong): 最近一次刷新的耗时（纳秒）。
+        max_refresh_ns (ctypes.c_ulonglong): 单次刷新的最大耗时（纳秒）。
+    """
+
+    _fields_ = [
+        ("active_slot", ctypes.c_int),
+        ("refreshes", ctypes.c_ulonglong),
+        ("skipped", ctypes.c_ulonglong),
+        ("failures", ctypes.c_ulonglong),
+        ("copied_databases", ctypes.c_ulonglong),
+        ("copied_pages", ctypes.c_ulonglong),
+        ("routed_reads", ctypes.c_ulonglong),
+        ("last_refresh_at", ctypes.c_longlong),
+        ("last_refresh_ns", ctypes.c_ulonglong),
+        ("max_refresh_ns", ctypes.c_ulonglong),
+    ]
+
+
+EXAM_STATS_BIN_COUNT = 101  # 与 include/model.h 中的 EXAM_STATS_BIN_COUNT 保持一致
+
+
+class ExamStats(ctypes.Structure):
+    """
+    表示一场考试的成绩统计。
+
+    Attributes:
+        count (ctypes.c_longlong): 成绩条数。
+        sum (ctypes.c_longlong): 分数之和。
+        sumsq (ctypes.c_longlong): 分数平方之和。
+        pass_count (ctypes.c_longlong): 及格的成绩条数。
+        min_score (ctypes.c_int): 最低分。
+        max_score (ctypes.c_int): 最高分。
+        mean (ctypes.c_double): 平均分。
+        stddev (ctypes.c_double): 标准差。
+        pass_rate (ctypes.c_double): 及格率。
+        histogram (ctypes.c_longlong * EXAM_STATS_BIN_COUNT): 0 到 100 分每个分数的成绩条数。
+    """
+
+    _fields_ = [
+        ("count", ctypes.c_longlong),
+        ("sum", ctypes.c_longlong),
+        ("sumsq", ctypes.c_longlong),
+        ("pass_count", ctypes.c_longlong),
+        ("min_score", ctypes.c_int),
+        ("max_score", ctypes.c_int),
+        ("mean", ctypes.c_double),
+        ("stddev", ctypes.c_double),
+        ("pass_rate", ctypes.c_double),
+        ("histogram", ctypes.c_longlong * EXAM_STATS_BIN_COUNT),
+    ]
+
+
+class ScoreRank(ctypes.Structure):
+    """
+    表示一名考生在一场考试中的排名。
+
+    Attributes:
+        found (ctypes.c_int): 是否找到该考生的成绩。
+        score (ctypes.c_int): 考生的成绩（多条成绩时取最高分）。
+        rank (ctypes.c_longlong): 名次，同分同名次。
+        ties (ctypes.c_longlong): 同分的条数（包括考生自己）。
+        total (ctypes.c_longlong): 这场考试的成绩条数。
+        percentile (ctypes.c_double): 百分位（0 到 100）。
+    """
+
+    _fields_ = [
+        ("found", ctypes.c_int),
+        ("score", ctypes.c_int),
+        ("rank", ctypes.c_longlong),
+        ("ties", ctypes.c_longlong),
+        ("total", ctypes.c_longlong),
+        ("percentile", ctypes.c_double),
+    ]
+
+
+class ClassCubeCell(ctypes.Structure):
+    """
+    表示一位教师的一个班级在一场考试中的成绩汇总。
+
+    Attributes:
+        class_name (ctypes.c_char * 31): 班级。
+        exam_id (ctypes.c_char * 37): 考试ID。
+        count (ctypes.c_longlong): 成绩条数。
+        sum (ctypes.c_longlong): 分数之和。
+        sumsq (ctypes.c_longlong): 分数平方之和。
+        pass_count (ctypes.c_longlong): 及格的成绩条数。
+        min_score (ctypes.c_int): 最低分（读取直方图时才有）。
+        max_score (ctypes.c_int): 最高分（读取直方图时才有）。
+        mean (ctypes.c_double): 平均分。
+        stddev (ctypes.c_double): 标准差。
+        pass_rate (ctypes.c_double): 及格率。
+        histogram (ctypes.c_longlong * EXAM_STATS_BIN_COUNT): 0 到 100 分每个分数的成绩条数（读取直方图时才有）。
+    """
+
+    _fields_ = [
+        ("class_name", ctypes.c_char * 31),
+        ("exam_id", ctypes.c_char * 37),
+        ("count", ctypes.c_longlong),
+        ("sum", ctypes.c_longlong),
+        ("sumsq", ctypes.c_longlong),
+        ("pass_count", ctypes.c_longlong),
+        ("min_score", ctypes.c_int),
+        ("max_score", ctypes.c_int),
+        ("mean", ctypes.c_double),
+        ("stddev", ctypes.c_double),
+        ("pass_rate", ctypes.c_double),
+        ("histogram", ctypes.c_longlong * EXAM_STATS_BIN_COUNT),
+    ]
+
+
+ANSWER_LOG_MAX_QUESTIONS = 999  # 与 include/answer_log.h 中的 ANSWER_LOG_MAX_QUESTIONS 保持一致
+
+
+class AnswerLogHeader(ctypes.Structure):
+    """
+    表示一条答题记录的头部。
+
+    Attributes:
+        version (ctypes.c_int): 记录格式的版本号。
+        question_count (ctypes.c_int): 题目数量，没有找到记录时为 -1。
+        seed (ctypes.c_uint): 题目顺序的随机种子，0 表示没有打乱。
+        correct_count (ctypes.c_int): 答对的题目数量。
+        bitmap_offset (ctypes.c_int): 位图在记录中的偏移。
+    """
+
+    _fields_ = [
+        ("version", ctypes.c_int),
+        ("question_count", ctypes.c_int),
+        ("seed", ctypes.c_uint),
+        ("correct_count", ctypes.c_int),
+        ("bitmap_offset", ctypes.c_int),
+    ]
+
+
+class ItemStats(ctypes.Structure):
+    """
+    表示一道题目的逐题分析结果。
+
+    Attributes:
+        question_index (ctypes.c_int): 题目在考卷中的序号，从0开始。
+        attempts (ctypes.c_longlong): 包含这道题的答卷数量。
+        correct_count (ctypes.c_longlong): 答对的答卷数量。
+        unanswered_count (ctypes.c_longlong): 没有作答的答卷数量。
+        top_wrong_count (ctypes.c_longlong): 最常见的错误答案出现的次数。
+        p_value (ctypes.c_double): 难度，即答对率。
+        point_biserial (ctypes.c_double): 区分度，点二列相关系数。
+        top_wrong_answer (ctypes.c_float): 最常见的错误答案，没有错误答案时为 NaN。
+    """
+
+    _fields_ = [
+        ("question_index", ctypes.c_int),
+        ("attempts", ctypes.c_longlong),
+        ("correct_count", ctypes.c_longlong),
+        ("unanswered_count", ctypes.c_longlong),
+        ("top_wrong_count", ctypes.c_longlong),
+        ("p_value", ctypes.c_double),
+        ("point_biserial", ctypes.c_double),
+        ("top_wrong_answer", ctypes.c_float),
+    ]
+
+
+class ItemAnalysisSummary(ctypes.Structure):
+    """
+    表示一场考试的逐题分析汇总。
+
+    Attributes:
+        version (ctypes.c_longlong): 分析所用答题记录的版本号。
+        submission_count (ctypes.c_longlong): 参与分析的答卷数量。
+        skipped_count (ctypes.c_longlong): 被跳过的损坏答卷数量。
+        question_count (ctypes.c_int): 题目数量。
+        mean_correct (ctypes.c_double): 每份答卷平均答对的题目数量。
+        stddev_correct (ctypes.c_double): 答对的题目数量的标准差。
+    """
+
+    _fields_ = [
+        ("version", ctypes.c_longlong),
+        ("submission_count", ctypes.c_longlong),
+        ("skipped_count", ctypes.c_longlong),
+        ("question_count", ctypes.c_int),
+        ("mean_correct", ctypes.c_double),
+        ("stddev_correct", ctypes.c_double),
+    ]
+
+
+class UserCacheStats(ctypes.Structure):
+    """
+    表示用户缓存的统计信息。
+
+    Attributes:
+        hits (ctypes.c_ulonglong): 命中次数。
+        misses (ctypes.c_ulonglong): 未命中次数。
+        evictions (ctypes.c_ulonglong): 因容量不足而淘汰的条目数。
+        invalidations (ctypes.c_ulonglong): 因用户数据变化而失效的次数。
+        size (ctypes.c_int): 当前缓存的条目数。
+        capacity (ctypes.c_int): 缓存的最大条目数。
+    """
+
+    _fields_ = [
+        ("hits", ctypes.c_ulonglong),
+        ("misses", ctypes.c_ulonglong),
+        ("evictions", ctypes.c_ulonglong),
+        ("invalidations", ctypes.c_ulonglong),
+        ("size", ctypes.c_int),
+        ("capacity", ctypes.c_int),
+    ]
+
+
 class QuestionData(ctypes.Structure):
     _fields_ = [
         ("num1", c_int),  # int
@@ -310,6 +756,25 @@ DATABASE_LIB.query_scores_info_all.argtypes = [
 ]
 DATABASE_LIB.query_scores_info_all.restype = c_int
 
+DATABASE_LIB.query_scores_columnar.argtypes = [
+    c_int,
+    c_char_p,
+    c_char_p,
+    POINTER(POINTER(ColumnarResult)),
+]
+DATABASE_LIB.query_scores_columnar.restype = c_int
+
+DATABASE_LIB.query_users_columnar.argtypes = [
+    c_int,
+    c_char_p,
+    c_char_p,
+    POINTER(POINTER(ColumnarResult)),
+]
+DATABASE_LIB.query_users_columnar.restype = c_int
+
+DATABASE_LIB.free_columnar_result.argtypes = [POINTER(ColumnarResult)]
+DATABASE_LIB.free_columnar_result.restype = None
+
 DATABASE_LIB.del_user_data.argtypes = [ctypes.c_char_p]
 DATABASE_LIB.del_user_data.restype = ctypes.c_int
 
@@ -401,6 +866,120 @@ DATABASE_LIB.edit_question_data.argtypes = [
 ]
 DATABASE_LIB.edit_question_data.restype = ctypes.c_int
 
+DATABASE_LIB.has_role_permission.argtypes = [c_int, c_uint]
+DATABASE_LIB.has_role_permission.restype = c_int
+
+DATABASE_LIB.get_permission_mask.argtypes = [c_int]
+DATABASE_LIB.get_permission_mask.restype = c_uint
+
+DATABASE_LIB.revoke_token.argtypes = [c_char_p, c_longlong]
+DATABASE_LIB.revoke_token.restype = c_int
+
+DATABASE_LIB.is_token_revoked.argtypes = [c_char_p]
+DATABASE_LIB.is_token_revoked.restype = c_int
+
+DATABASE_LIB.sweep_revoked_tokens.argtypes = []
+DATABASE_LIB.sweep_revoked_tokens.restype = c_int
+
+DATABASE_LIB.count_revoked_tokens.argtypes = []
+DATABASE_LIB.count_revoked_tokens.restype = c_int
+
+DATABASE_LIB.get_exam_paper.argtypes = [
+    c_char_p,  # exam_id
+    POINTER(SqlResponseExam),  # exam_to_return
+    POINTER(ExamPaperQuestion),  # questions_to_return
+    c_int,  # length
+    POINTER(c_int),  # count_to_return
+    POINTER(ctypes.c_ulonglong),  # version_to_return
+]
+DATABASE_LIB.get_exam_paper.restype = c_int
+
+DATABASE_LIB.render_exam_paper_json.argtypes = [
+    c_char_p,  # exam_id
+    c_uint,  # seed
+    c_char_p,  # buffer
+    c_int,  # buffer_size
+    POINTER(c_int),  # length_to_return
+    POINTER(ctypes.c_ulonglong),  # version_to_return
+]
+DATABASE_LIB.render_exam_paper_json.restype = c_int
+
+DATABASE_LIB.get_exam_cache_stats.argtypes = [POINTER(ExamCacheStats)]
+DATABASE_LIB.get_exam_cache_stats.restype = c_int
+
+DATABASE_LIB.get_user_cache_stats.argtypes = [POINTER(UserCacheStats)]
+DATABASE_LIB.get_user_cache_stats.restype = c_int
+
+DATABASE_LIB.get_database_retry_stats.argtypes = [POINTER(DatabaseRetryStats)]
+DATABASE_LIB.get_database_retry_stats.restype = c_int
+
+DATABASE_LIB.set_slow_query_log.argtypes = [c_int, c_int]
+DATABASE_LIB.set_slow_query_log.restype = c_int
+
+DATABASE_LIB.backup_databases.argtypes = [c_char_p, c_int, c_int]
+DATABASE_LIB.backup_databases.restype = c_int
+
+DATABASE_LIB.get_backup_progress.argtypes = [POINTER(BackupProgress)]
+DATABASE_LIB.get_backup_progress.restype = c_int
+
+DATABASE_LIB.refresh_reporting_replica.argtypes = []
+DATABASE_LIB.refresh_reporting_replica.restype = c_int
+
+DATABASE_LIB.set_reporting_reads.argtypes = [c_int]
+DATABASE_LIB.set_reporting_reads.restype = c_int
+
+DATABASE_LIB.get_reporting_replica_stats.argtypes = [POINTER(ReplicaStats)]
+DATABASE_LIB.get_reporting_replica_stats.restype = c_int
+
+DATABASE_LIB.query_exam_stats.argtypes = [c_char_p, POINTER(ExamStats)]
+DATABASE_LIB.query_exam_stats.restype = c_int
+
+DATABASE_LIB.rebuild_exam_stats.argtypes = []
+DATABASE_LIB.rebuild_exam_stats.restype = c_int
+
+DATABASE_LIB.check_exam_stats.argtypes = [POINTER(c_int)]
+DATABASE_LIB.check_exam_stats.restype = c_int
+
+DATABASE_LIB.score_rank.argtypes = [c_char_p, c_char_p, POINTER(ScoreRank)]
+DATABASE_LIB.score_rank.restype = c_int
+
+DATABASE_LIB.top_scores.argtypes = [c_char_p, c_int, POINTER(SqlResponseScore)]
+DATABASE_LIB.top_scores.restype = c_int
+
+DATABASE_LIB.query_class_cube.argtypes = [c_char_p, c_char_p, c_char_p, c_int, POINTER(ClassCubeCell), c_int, POINTER(c_int)]
+DATABASE_LIB.query_class_cube.restype = c_int
+
+DATABASE_LIB.rebuild_class_cube.argtypes = []
+DATABASE_LIB.rebuild_class_cube.restype = c_int
+
+DATABASE_LIB.insert_answer_log.argtypes = [c_char_p, c_char_p, c_char_p, c_uint, c_int, POINTER(c_ubyte), POINTER(c_float)]
+DATABASE_LIB.insert_answer_log.restype = c_int
+
+DATABASE_LIB.query_answer_log.argtypes = [c_char_p, c_char_p, POINTER(AnswerLogHeader), POINTER(c_ubyte), POINTER(c_float), c_int]
+DATABASE_LIB.query_answer_log.restype = c_int
+
+DATABASE_LIB.query_item_analysis.argtypes = [c_char_p, POINTER(ItemAnalysisSummary), POINTER(ItemStats), c_int]
+DATABASE_LIB.query_item_analysis.restype = c_int
+
+DATABASE_LIB.get_item_analysis_cache_stats.argtypes = [POINTER(ItemAnalysisCacheStats)]
+DATABASE_LIB.get_item_analysis_cache_stats.restype = c_int
+
+# 没有核心模块时 app.dll 和 database.dll 各自有一份统计数据和数据库位置，两边都需要绑定
+for _lib in {id(APP_LIB): APP_LIB, id(DATABASE_LIB): DATABASE_LIB}.values():
+    _lib.get_metrics_snapshot.argtypes = [POINTER(MetricsSnapshot)]
+    _lib.get_metrics_snapshot.restype = c_int
+    _lib.reset_metrics.argtypes = []
+    _lib.reset_metrics.restype = None
+    _lib.metrics_thread_calls.argtypes = []
+    _lib.metrics_thread_calls.restype = ctypes.c_ulonglong
+    _lib.set_database_location.argtypes = [c_char_p]
+    _lib.set_database_location.restype = c_int
+    _lib.initialize_schema.argtypes = []
+    _lib.initialize_schema.restype = c_int
+
+DATABASE_LIB.user_cache_clear.argtypes = []
+DATABASE_LIB.user_cache_clear.restype = None
+
 APP_LIB.generate_question_list.argtypes = [c_char_p, POINTER(Question), c_int]
 APP_LIB.generate_question_list.restype = c_int
 
@@ -416,5 +995,14 @@ APP_LIB.calculate_result.restype = c_float
 APP_LIB.judge.argtypes = [c_float, c_float]
 APP_LIB.judge.restype = c_int
 
+APP_LIB.generate_question_permutation.argtypes = [c_uint, c_int, POINTER(c_int)]
+APP_LIB.generate_question_permutation.restype = c_int
+
+APP_LIB.generate_uuid.argtypes = [c_char_p, c_int]
+APP_LIB.generate_uuid.restype = c_int
+
+APP_LIB.generate_uuid_list.argtypes = [c_char_p, c_int, c_int]
+APP_LIB.generate_uuid_list.restype = c_int
+
 INITIALIZER_LIB.initialize.argtypes = []
 INITIALIZER_LIB.initialize.restype = None
\ No newline at end of file
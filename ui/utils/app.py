@@ -127,3 +127,55 @@ def calculate_result(num1: int, num2: int, op: int) -> float:
     @return float 结果
     """
     return APP_LIB.calculate_result(c_int(num1), c_int(num2), c_int(op))
+
+
+UUID_LENGTH = 37  # 与 include/uuid.h 中的 UUID_LENGTH 保持一致
+UUID_VERSION_4 = 4
+UUID_VERSION_7 = 7
+
+
+def generate_uuid_list(count: int, version: int = UUID_VERSION_7) -> list:
+    """
+    @brief 调用 C 函数 generate_uuid_list 一次性生成多个 UUID。
+
+    @param count 需要生成的 UUID 数量
+    @param version UUID 版本，UUIDv7 按时间有序，适合作为成绩、题目等高频插入表的主键
+    @return list UUID 字符串列表
+    """
+    if count <= 0:
+        return []
+    buffer = ctypes.create_string_buffer(UUID_LENGTH * count)
+    if APP_LIB.generate_uuid_list(buffer, c_int(count), c_int(version)) != 0:
+        raise Exception("Failed to generate uuid list")
+    raw = buffer.raw
+    return [
+        raw[i * UUID_LENGTH : i * UUID_LENGTH + UUID_LENGTH - 1].decode()
+        for i in range(count)
+    ]
+
+
+def generate_uuid(version: int = UUID_VERSION_4) -> str:
+    """
+    @brief 调用 C 函数 generate_uuid 生成一个 UUID。
+
+    @param version UUID 版本，默认为完全随机的 UUIDv4
+    @return str UUID 字符串
+    """
+    buffer = ctypes.create_string_buffer(UUID_LENGTH)
+    if APP_LIB.generate_uuid(buffer, c_int(version)) != 0:
+        raise Exception("Failed to generate uuid")
+    return buffer.value.decode()
+
+
+def generate_question_permutation(seed: int, count: int) -> list:
+    """
+    @brief 调用 C 函数 generate_question_permutation，由随机种子生成题目的排列顺序。
+
+    @param seed 随机种子，范围为 32 位无符号整数，0 表示不打乱顺序
+    @param count 题目数量
+    @return list 排列，第 i 个位置的题目是原题目列表中的第 list[i] 题
+    """
+    permutation = (c_int * max(count, 1))()
+    if APP_LIB.generate_question_permutation(c_uint(seed), c_int(count), permutation) != 0:
+        raise Exception("Failed to generate question permutation")
+    return list(permutation[:count])
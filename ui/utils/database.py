@@ -1,5 +1,200 @@
 from . import *
-from ctypes import c_char_p, c_int, POINTER
+from ctypes import c_char_p, c_int, c_uint, c_ubyte, c_float, POINTER
+import threading
+from contextlib import contextmanager
+
+# 权限位，与 include/model.h 中的 PERM_* 保持一致
+PERM_STU_ANSWER = 1 << 0
+PERM_STU_INSPECT_PERSONAL_INFO = 1 << 1
+PERM_STU_INSPECT_EXAM_INFO = 1 << 2
+PERM_TEA_MANAGE_EXAM = 1 << 3
+PERM_TEA_MANAGE_STUDENT = 1 << 4
+PERM_TEA_INSPECT_STUDENT_INFO = 1 << 5
+PERM_TEA_INSPECT_EXAM_SCORES = 1 << 6
+PERM_GENERAL_EDIT_INFO = 1 << 7
+
+
+# 列式查询的列定义，与 include/database.c 中 query_*_columnar 查询的列顺序一致：(文本列, 整数列, 无符号整数列)
+SCORE_COLUMNS = (("id", "exam_id", "user_id"), ("score", "expired_flag"), ())
+USER_COLUMNS = (
+    ("id", "username", "hashpass", "salt", "name", "class_name", "belong_to"),
+    ("role", "number"),
+    ("number",),
+)
+
+
+class ColumnarRow:
+    """
+    列式查询结果中的一行，按属性名读取字段，文本字段为 bytes，与 SqlResponse* 结构体的用法相同。
+    每组列定义会生成一个子类，每一列对应一个 property，避免 __getattr__ 先查找失败再回退的开销
+    """
+
+    __slots__ = ("_columns", "_index")
+
+    def __init__(self, columns, index: int):
+        self._columns = columns
+        self._index = index
+
+    def __repr__(self):
+        fields = ", ".join(
+            f"{name}={self._columns[name][self._index]!r}"
+            for name in self._columns.names
+        )
+        return f"ColumnarRow({fields})"
+
+
+def _column_property(name: str) -> property:
+    return property(lambda row: row._columns[name][row._index])
+
+
+_row_classes = {}  # 列定义到行类型的映射
+
+
+def _row_class(names: tuple) -> type:
+    """
+    @brief 获取列定义对应的行类型，第一次使用时生成
+    """
+    row_class = _row_classes.get(names)
+    if row_class is None:
+        attributes = {name: _column_property(name) for name in names}
+        attributes["__slots__"] = ()
+        row_class = _row_classes[names] = type("ColumnarRow", (ColumnarRow,), attributes)
+    return row_class
+
+
+class _ColumnarBuffer:
+    """
+    持有 C 层分配的列式查询结果，被回收时调用 free_columnar_result 释放
+    """
+
+    __slots__ = ("pointer",)
+
+    def __init__(self, pointer):
+        self.pointer = pointer
+
+    def __del__(self):
+        DATABASE_LIB.free_columnar_result(self.pointer)
+
+    def wrap(self, pointer, ctype, length: int, fmt: str) -> memoryview:
+        """
+        @brief 用 memoryview 包装 C 层的数组，memoryview 持有数组，数组持有本对象，避免内存先被释放
+        """
+        array = ctypes.cast(pointer, POINTER(ctype * length)).contents
+        array._owner = self
+        return memoryview(array).cast("B").cast(fmt)
+
+
+class _ColumnCache(dict):
+    """
+    列名到列的映射，整数列为 memoryview，文本列第一次读取时才从字符串区切分成 bytes 列表
+    """
+
+    def __init__(self, names, int_columns, text_index, offsets, strings):
+        super().__init__(int_columns)
+        self.names = names
+        self._text_index = text_index
+        self._offsets = offsets
+        self._strings = strings
+
+    def __missing__(self, name: str):
+        column = self._text_index.get(name)
+        if column is None:
+            raise KeyError(name)
+        step = len(self._text_index)
+        starts = self._offsets[column::step].tolist()
+        ends = self._offsets[column + 1 :: step].tolist()
+        if not isinstance(self._strings, bytes):
+            # 第一次读取文本列时把字符串区整体复制一次，之后对 bytes 切片比对 memoryview 切片再转换快得多
+            self._strings = self._strings.tobytes()
+        strings = self._strings
+        values = [strings[start:end] for start, end in zip(starts, ends)]
+        self[name] = values
+        return values
+
+
+class ColumnarRows:
+    """
+    列式查询结果，整数列和字符串区直接以 memoryview 包装 C 层分配的内存，不逐行逐字段复制。
+    C 层的内存在本对象以及所有通过 column 得到的 memoryview 都被回收之后才会释放。
+    """
+
+    def __init__(self, pointer, columns):
+        buffer = _ColumnarBuffer(pointer)
+        text_columns, int_columns, unsigned_columns = columns
+        result = pointer.contents
+        self.count = result.count
+        self.names = text_columns + int_columns
+        self._row_class = _row_class(self.names)
+        offsets = buffer.wrap(
+            result.text_offsets,
+            ctypes.c_int32,
+            self.count * len(text_columns) + 1,
+            "i",
+        )
+        strings = buffer.wrap(
+            ctypes.cast(result.strings, POINTER(ctypes.c_char)),
+            ctypes.c_char,
+            result.strings_length,
+            "B",
+        )
+        self._int_columns = {
+            name: buffer.wrap(
+                result.int_columns[index],
+                ctypes.c_int32,
+                self.count,
+                "I" if name in unsigned_columns else "i",
+            )
+            for index, name in enumerate(int_columns)
+        }
+        self._columns = _ColumnCache(
+            self.names,
+            self._int_columns,
+            {name: index for index, name in enumerate(text_columns)},
+            offsets,
+            strings,
+        )
+
+    def __len__(self):
+        return self.count
+
+    def __getitem__(self, index: int) -> ColumnarRow:
+        if index < 0:
+            index += self.count
+        if not 0 <= index < self.count:
+            raise IndexError("columnar row index out of range")
+        return self._row_class(self._columns, index)
+
+    def __iter__(self):
+        columns, row_class = self._columns, self._row_class
+        return (row_class(columns, index) for index in range(self.count))
+
+    def column(self, name: str) -> memoryview:
+        """
+        @brief 获取整数列，返回零拷贝的 memoryview，可以直接用于 sum、max 等计算
+        """
+        return self._int_columns[name]
+
+    def text_column(self, name: str) -> list:
+        """
+        @brief 获取文本列，返回每一行的 bytes 列表，结果会被缓存
+        """
+        return self._columns[name]
+
+
+def _query_columnar(function, length: int, key: str, content: str, columns):
+    """
+    @brief 调用 C 层的列式查询函数，返回 ColumnarRows；查询失败返回空列表
+    """
+    pointer = POINTER(ColumnarResult)()
+    result = function(
+        length,
+        key.encode() if key else None,
+        str(content).encode() if content else None,
+        ctypes.byref(pointer),
+    )
+    if result != 0 or not pointer:
+        return []
+    return ColumnarRows(pointer, columns)
 
 
 def query_user_info(key: str, content: str) -> User:
@@ -11,7 +206,11 @@ def query_user_info(key: str, content: str) -> User:
 
     @return: 如果查询成功，返回一个 User 对象，包含查询到的用户信息。
              如果查询失败，返回 None。
+             使用原生核心模块时返回 mentalcore.User，字段与 User 相同。
     """
+    if CORE:
+        return CORE.query_user_info(key, str(content))
+
     user = User()  # 创建一个 User 对象用于存储查询结果
 
     # 将字符串参数转换为 C 语言的 c_char_p 类型（即 C 中的 char*）
@@ -37,7 +236,11 @@ def query_exam_info(key: str, content: str) -> SqlResponseExam:
 
     @return: 如果查询成功，返回一个 SqlResponseExam 对象，包含查询到的考试信息。
              如果查询失败，返回 None。
+             使用原生核心模块时返回 mentalcore.Exam，字段与 SqlResponseExam 相同。
     """
+    if CORE:
+        return CORE.query_exam_info(key, str(content))
+
     exam = SqlResponseExam()  # 创建一个 SqlResponseExam 对象用于存储查询结果
 
     # 将字符串参数转换为 C 语言的 c_char_p 类型（即 C 中的 char*）
@@ -120,6 +323,9 @@ def query_exams_info_all(
 
     @return list 查询到的所有考试信息列表，若查询失败返回空列表。
     """
+    if CORE:
+        return CORE.query_exams_info_all(length, key or None, str(content) if content else None)
+
     # 创建返回结构体数组，长度为指定的查询数量
     exams_to_return = (SqlResponseExam * length)()
 
@@ -139,9 +345,7 @@ def query_exams_info_all(
         return []
 
 
-def query_users_info_all(
-    length: int, key: str = None, content: str = None
-) -> list[SqlResponseUser]:
+def query_users_info_all(length: int, key: str = None, content: str = None):
     """
     @brief 查询所有用户信息，并返回查询结果。
 
@@ -149,26 +353,33 @@ def query_users_info_all(
     @param key 要查询的条件索引
     @param content 条件索引的内容
 
-    @return list 查询到的所有用户信息列表，若查询失败返回空列表。
+    @return 查询到的用户信息序列，只包含实际查到的用户，若查询失败返回空列表。
+            按 id 查询时读取用户缓存，返回 SqlResponseUser 列表；其他情况返回列式查询结果 ColumnarRows，
+            两者的每一行都可以通过 id、username 等属性读取字段，文本字段为 bytes。
     """
-    # 创建返回结构体数组，长度为指定的查询数量
-    users_to_return = (SqlResponseUser * length)()
+    if key == "id":
+        if CORE:
+            return CORE.query_users_info_all(length, key, str(content) if content else None)
+
+        # 创建返回结构体数组，长度为指定的查询数量
+        users_to_return = (SqlResponseUser * length)()
+
+        # 调用C函数，查询用户信息（优先读取用户缓存）
+        result = DATABASE_LIB.query_users_info_all(
+            ctypes.byref(users_to_return[0]),
+            length,
+            key.encode(),
+            content.encode() if content else None,
+        )
+        if result != 0:
+            return []
+        return [user for user in users_to_return if user.id]
 
-    # 调用C函数，查询所有用户信息
-    result = DATABASE_LIB.query_users_info_all(
-        ctypes.byref(users_to_return[0]),
-        length,
-        key.encode() if key else None,
-        content.encode() if content else None,
+    # 其他查询使用列式结果，避免为每一行每一个字段创建 Python 对象
+    return _query_columnar(
+        DATABASE_LIB.query_users_columnar, length, key, content, USER_COLUMNS
     )
 
-    if result == 0:
-        # 查询成功，返回所有用户信息
-        return [user for user in users_to_return]
-    else:
-        # 查询失败，返回空列表
-        return []
-
 
 def query_questions_info_all(
     length: int, key: str = None, content: str = None
@@ -180,8 +391,11 @@ def query_questions_info_all(
     @param key 要查询的条件索引
     @param content 条件索引的内容
 
-    @return list 查询到的所有问题信息列表，若查询失败返回空列表。
+    @return list 查询到的所有问题信息列表（只包含实际查到的问题），若查询失败返回空列表。
     """
+    if CORE:
+        return CORE.query_questions_info_all(length, key or None, str(content) if content else None)
+
     # 创建返回结构体数组，长度为指定的查询数量
     questions_to_return = (SqlResponseQuestion * length)()
 
@@ -195,15 +409,13 @@ def query_questions_info_all(
 
     if result == 0:
         # 查询成功，返回所有问题信息
-        return [question for question in questions_to_return]
+        return [question for question in questions_to_return if question.id]
     else:
         # 查询失败，返回空列表
         return []
 
 
-def query_scores_info_all(
-    length: int, key: str = "", content: str = ""
-) -> list[SqlResponseScore]:
+def query_scores_info_all(length: int, key: str = "", content: str = ""):
     """
     @brief 查询所有成绩信息，并返回查询结果。
 
@@ -211,26 +423,12 @@ def query_scores_info_all(
     @param key 要查询的条件索引
     @param content 条件索引的内容
 
-    @return list 查询到的所有成绩信息列表，若查询失败返回空列表。
+    @return ColumnarRows 查询到的成绩信息（列式查询结果），只包含实际查到的成绩，若查询失败返回空列表。
     """
-    # 创建返回结构体数组，长度为指定的查询数量
-    scores_to_return = (SqlResponseScore * length)()
-
-    # 调用C函数，查询所有成绩信息
-    result = DATABASE_LIB.query_scores_info_all(
-        ctypes.byref(scores_to_return[0]),
-        length,
-        c_char_p(key.encode()),
-        c_char_p(content.encode()),
+    return _query_columnar(
+        DATABASE_LIB.query_scores_columnar, length, key, content, SCORE_COLUMNS
     )
 
-    if result == 0:
-        # 查询成功，返回所有成绩信息
-        return [score for score in scores_to_return]
-    else:
-        # 查询失败，返回空列表
-        return []
-
 
 def insert_exam_data(
     exam_id: str,
@@ -514,6 +712,546 @@ def edit_question_data(
     return 1 if not result else 0
 
 
+def has_role_permission(role, perm: int) -> bool:
+    """
+    @brief 判断某个角色是否拥有指定的全部权限，不需要查询用户
+
+    @param role 用户角色，通常来自 JWT 中的 role 字段
+    @param perm 需要的权限位，可以用 | 组合多个 PERM_*
+    @return bool 拥有返回 True，否则返回 False
+    """
+    if not isinstance(role, int):
+        return False
+    return bool(DATABASE_LIB.has_role_permission(c_int(role), c_uint(perm)))
+
+
+EXAM_PAPER_MAX_QUESTIONS = 999  # 与 include/exam_cache.h 中的 EXAM_PAPER_MAX_QUESTIONS 保持一致
+
+
+def get_exam_paper(exam_id: str):
+    """
+    @brief 获取考卷（考试信息和全部题目），优先读取 C 层的考卷缓存
+
+    @param exam_id 考试ID
+    @return tuple (SqlResponseExam, 题目列表, 版本号)，题目为包含 id、exam_id、num1、op、num2、correct_answer 的字典；
+                  考试不存在或查询失败时返回 (None, [], 0)
+    """
+    exam = SqlResponseExam()
+    questions = (ExamPaperQuestion * EXAM_PAPER_MAX_QUESTIONS)()
+    count = c_int(0)
+    version = ctypes.c_ulonglong(0)
+    result = DATABASE_LIB.get_exam_paper(
+        exam_id.encode("utf-8"),
+        ctypes.byref(exam),
+        questions,
+        EXAM_PAPER_MAX_QUESTIONS,
+        ctypes.byref(count),
+        ctypes.byref(version),
+    )
+    if result != 0 or exam.id.decode() == "":
+        return None, [], 0
+    question_list = [
+        {
+            "num1": item.num1,
+            "op": item.op,
+            "num2": item.num2,
+            "id": item.id.decode(),
+            "exam_id": exam_id,
+            "correct_answer": item.answer,
+        }
+        for item in questions[: min(count.value, EXAM_PAPER_MAX_QUESTIONS)]
+    ]
+    return exam, question_list, version.value
+
+
+_render_buffers = threading.local()  # 每个线程复用自己的渲染缓冲区
+
+
+def render_exam_paper_json(exam_id: str, seed: int = 0):
+    """
+    @brief 调用 C 函数 render_exam_paper_json，直接得到学生端获取考卷接口的 JSON 响应
+
+    @param exam_id 考试ID
+    @param seed 随机种子，考试开启了随机题目顺序时按照这个种子排列题目，范围为 32 位无符号整数
+    @return tuple (JSON 字节串, 考卷版本号)；考试不存在或渲染失败时返回 (None, 0)
+    """
+    buffer = getattr(_render_buffers, "buffer", None)
+    if buffer is None:
+        buffer = _render_buffers.buffer = ctypes.create_string_buffer(64 * 1024)
+    exam_id_c = exam_id.encode("utf-8")
+    length = c_int(0)
+    version = ctypes.c_ulonglong(0)
+    result = DATABASE_LIB.render_exam_paper_json(
+        exam_id_c, c_uint(seed), buffer, len(buffer), ctypes.byref(length), ctypes.byref(version)
+    )
+    if result != 0 and length.value > len(buffer):
+        # 缓冲区不够，按照需要的大小扩大之后再渲染一次
+        buffer = _render_buffers.buffer = ctypes.create_string_buffer(length.value * 2)
+        result = DATABASE_LIB.render_exam_paper_json(
+            exam_id_c, c_uint(seed), buffer, len(buffer), ctypes.byref(length), ctypes.byref(version)
+        )
+    if result != 0:
+        return None, 0
+    return ctypes.string_at(buffer, length.value), version.value
+
+
+def get_exam_cache_stats() -> dict:
+    """
+    @brief 获取考卷缓存的统计信息
+
+    @return dict 统计信息，字段与 get_user_cache_stats 相同。如果获取失败，返回 None。
+    """
+    stats = ExamCacheStats()
+    if DATABASE_LIB.get_exam_cache_stats(ctypes.byref(stats)) != 0:
+        return None
+    lookups = stats.hits + stats.misses
+    return {
+        "hits": stats.hits,
+        "misses": stats.misses,
+        "hit_rate": stats.hits / lookups if lookups else 0.0,
+        "evictions": stats.evictions,
+        "invalidations": stats.invalidations,
+        "size": stats.size,
+        "capacity": stats.capacity,
+    }
+
+
+def get_user_cache_stats() -> dict:
+    """
+    @brief 获取用户缓存的统计信息
+
+    @return dict 统计信息，包含命中次数、未命中次数、命中率、淘汰次数、失效次数、当前条目数和最大条目数。
+                 如果获取失败，返回 None。
+    """
+    stats = UserCacheStats()
+    if DATABASE_LIB.get_user_cache_stats(ctypes.byref(stats)) != 0:
+        return None
+    lookups = stats.hits + stats.misses
+    return {
+        "hits": stats.hits,
+        "misses": stats.misses,
+        "hit_rate": stats.hits / lookups if lookups else 0.0,
+        "evictions": stats.evictions,
+        "invalidations": stats.invalidations,
+        "size": stats.size,
+        "capacity": stats.capacity,
+    }
+
+
+def get_database_retry_stats() -> dict:
+    """
+    @brief 获取写冲突重试的统计信息
+
+    @return dict 统计信息，包含遇到写冲突的语句数、重试总次数、SQLITE_BUSY 和 SQLITE_LOCKED 的次数，
+                 以及重试用完后仍然失败的语句数。如果获取失败，返回 None。
+    """
+    stats = DatabaseRetryStats()
+    if DATABASE_LIB.get_database_retry_stats(ctypes.byref(stats)) != 0:
+        return None
+    return {
+        "conflicts": stats.conflicts,
+        "retries": stats.retries,
+        "busy": stats.busy,
+        "locked": stats.locked,
+        "exhausted": stats.exhausted,
+    }
+
+
+def set_slow_query_log(threshold_ms: int, explain: bool = False) -> bool:
+    """
+    @brief 设置慢查询日志，执行时间不少于阈值的语句会写入 logs/slow_query.log
+
+    @param threshold_ms 慢查询阈值（毫秒），小于0时关闭慢查询日志
+    @param explain 是否同时记录语句的 EXPLAIN QUERY PLAN
+
+    @return bool 设置成功返回 True，否则返回 False
+    """
+    return DATABASE_LIB.set_slow_query_log(threshold_ms, 1 if explain else 0) == 0
+
+
+def set_database_location(location: str = None) -> bool:
+    """
+    @brief 设置数据库的位置，并在新位置建立缺少的表
+
+    @param location 目录路径（可以指向 tmpfs）、":memory:" 或 "memory:名称"（共享缓存的内存数据库），
+                    为 None 时使用环境变量 MENTAL_DB_LOCATION，没有设置时使用默认的 db 文件夹
+
+    @return bool 设置成功返回 True，否则返回 False
+
+    @details 只能在启动时、开始处理请求之前调用。没有核心模块时 app.dll 和 database.dll 各自保存数据库位置，两边都需要设置
+    """
+    encoded = location.encode("utf-8") if location else None
+    for lib in {id(APP_LIB): APP_LIB, id(DATABASE_LIB): DATABASE_LIB}.values():
+        if lib.set_database_location(encoded) != 0 or lib.initialize_schema() != 0:
+            return False
+    return True
+
+
+def backup_databases(target_dir: str, pages_per_step: int = 64, sleep_ms: int = 10) -> bool:
+    """
+    @brief 在线备份三个数据库到 target_dir，备份期间可以照常读写
+
+    @param target_dir 备份保存的文件夹，不存在时创建
+    @param pages_per_step 每一步复制的页数
+    @param sleep_ms 两步之间暂停的毫秒数
+
+    @return bool 备份成功返回 True，否则返回 False（包括已经有备份在进行的情况）
+
+    @details 调用会一直阻塞到备份完成，通常应在后台线程中调用，用 get_backup_progress 查看进度
+    """
+    return DATABASE_LIB.backup_databases(target_dir.encode("utf-8"), pages_per_step, sleep_ms) == 0
+
+
+def get_backup_progress() -> dict:
+    """
+    @brief 获取最近一次备份的进度
+
+    @return dict 备份进度，耗时换算为毫秒。writer_* 为备份期间写入函数的调用情况，baseline_* 为备份开始前的调用情况。
+                 如果获取失败，返回 None。
+    """
+    progress = BackupProgress()
+    if DATABASE_LIB.get_backup_progress(ctypes.byref(progress)) != 0:
+        return None
+    return {
+        "running": bool(progress.running),
+        "result": {-1: None, 0: "success"}.get(progress.result, "failed"),
+        "currentDatabase": progress.current_database,
+        "databaseCount": progress.database_count,
+        "startedAt": progress.started_at,
+        "finishedAt": progress.finished_at,
+        "totalPages": progress.total_pages,
+        "copiedPages": progress.copied_pages,
+        "steps": progress.steps,
+        "maxStepMs": progress.max_step_ns / 1e6,
+        "freezeMs": progress.freeze_ns / 1e6,
+        "writer": {
+            "calls": progress.writer_calls,
+            "meanMs": progress.writer_mean_ns / 1e6,
+            "p99Ms": progress.writer_p99_ns / 1e6,
+        },
+        "baseline": {
+            "calls": progress.baseline_writer_calls,
+            "meanMs": progress.baseline_writer_mean_ns / 1e6,
+            "p99Ms": progress.baseline_writer_p99_ns / 1e6,
+        },
+        "targetDir": progress.target_dir.decode("utf-8", errors="replace"),
+    }
+
+
+def refresh_reporting_replica() -> bool:
+    """
+    @brief 刷新报表副本，只复制 score.db 和 user.db 中自上次刷新以来发生过变化的数据库
+
+    @return bool 刷新成功（包括不需要刷新）返回 True，否则返回 False
+    """
+    return DATABASE_LIB.refresh_reporting_replica() == 0
+
+
+@contextmanager
+def reporting_reads():
+    """
+    @brief 在 with 语句块中，当前线程的成绩、用户批量查询（query_scores_info_all、query_users_info_all）读取报表副本
+
+    @details 报表副本还没有刷新过时仍然读取源数据库。副本中的数据最多落后一个刷新间隔，
+             只适合教师查看成绩、导出报表这类不要求实时的读取，不能用于判断用户是否存在等需要最新数据的场合
+    """
+    previous = DATABASE_LIB.set_reporting_reads(1)
+    try:
+        yield
+    finally:
+        DATABASE_LIB.set_reporting_reads(previous)
+
+
+def get_reporting_replica_stats() -> dict:
+    """
+    @brief 获取报表副本的统计信息
+
+    @return dict 统计信息，包含在用的副本、刷新和跳过的次数、复制的数据库个数和页数、读取副本的查询次数，
+                 以及最近一次刷新的时间和耗时。如果获取失败，返回 None。
+    """
+    stats = ReplicaStats()
+    if DATABASE_LIB.get_reporting_replica_stats(ctypes.byref(stats)) != 0:
+        return None
+    return {
+        "active_slot": stats.active_slot,
+        "refreshes": stats.refreshes,
+        "skipped": stats.skipped,
+        "failures": stats.failures,
+        "copied_databases": stats.copied_databases,
+        "copied_pages": stats.copied_pages,
+        "routed_reads": stats.routed_reads,
+        "last_refresh_at": stats.last_refresh_at,
+        "last_refresh_ns": stats.last_refresh_ns,
+        "max_refresh_ns": stats.max_refresh_ns,
+    }
+
+
+def query_exam_stats(exam_id: str) -> dict:
+    """
+    @brief 查询一场考试的成绩统计，耗时与成绩条数无关
+
+    @param exam_id 考试ID
+
+    @return dict 统计，包含成绩条数、平均分、最低分、最高分、标准差、及格人数、及格率，
+                 以及 0 到 100 分每个分数的人数（histogram）。没有成绩时各项均为0。如果查询失败，返回 None。
+    """
+    stats = ExamStats()
+    if DATABASE_LIB.query_exam_stats(exam_id.encode("utf-8"), ctypes.byref(stats)) != 0:
+        return None
+    return {
+        "count": stats.count,
+        "mean": stats.mean,
+        "min": stats.min_score,
+        "max": stats.max_score,
+        "stddev": stats.stddev,
+        "pass_count": stats.pass_count,
+        "pass_rate": stats.pass_rate,
+        "histogram": list(stats.histogram),
+    }
+
+
+def rebuild_exam_stats() -> bool:
+    """
+    @brief 由成绩表重新计算所有考试的成绩统计
+
+    @return bool 成功返回 True，否则返回 False
+    """
+    return DATABASE_LIB.rebuild_exam_stats() == 0
+
+
+def check_exam_stats() -> int:
+    """
+    @brief 检查成绩统计与成绩表是否一致，不一致的考试ID写入日志
+
+    @return int 统计不一致的考试数量，检查失败时返回 -1
+    """
+    mismatches = c_int(0)
+    if DATABASE_LIB.check_exam_stats(ctypes.byref(mismatches)) != 0:
+        return -1
+    return mismatches.value
+
+
+def score_rank(exam_id: str, user_id: str) -> dict:
+    """
+    @brief 查询考生在一场考试中的名次和百分位，耗时与这场考试的成绩条数无关
+
+    @param exam_id 考试ID
+    @param user_id 考生的用户ID
+
+    @return dict 排名，包含成绩、名次（同分同名次）、同分人数、总人数和百分位；考生没有成绩或者查询失败时返回 None
+    """
+    rank = ScoreRank()
+    if DATABASE_LIB.score_rank(exam_id.encode("utf-8"), user_id.encode("utf-8"), ctypes.byref(rank)) != 0 or not rank.found:
+        return None
+    return {
+        "score": rank.score,
+        "rank": rank.rank,
+        "ties": rank.ties,
+        "total": rank.total,
+        "percentile": rank.percentile,
+    }
+
+
+def top_scores(exam_id: str, k: int) -> list:
+    """
+    @brief 查询一场考试分数最高的 k 条成绩，同分时先交卷的在前，耗时只与 k 有关
+
+    @param exam_id 考试ID
+    @param k 最多返回的条数
+
+    @return list 成绩列表，每项为 SqlResponseScore，查询失败时返回空列表
+    """
+    if k <= 0:
+        return []
+    scores = (SqlResponseScore * k)()
+    if DATABASE_LIB.top_scores(exam_id.encode("utf-8"), k, scores) != 0:
+        return []
+    return [item for item in scores if item.id]
+
+
+def query_class_cube(teacher_id: str, class_name: str = "", exam_id: str = "", with_histogram: bool = False) -> list:
+    """
+    @brief 查询一位教师各个班级在各场考试中的成绩汇总，汇总随成绩一起维护，耗时与成绩条数无关
+
+    @param teacher_id 教师ID
+    @param class_name 只查询这个班级，为空时查询所有班级
+    @param exam_id 只查询这场考试，为空时查询所有考试
+    @param with_histogram 是否同时返回最低分、最高分和 0 到 100 分的分数分布
+
+    @return list 按班级、考试ID排序的单元格，每项为包含班级、考试ID、人数、平均分、标准差、及格人数、及格率的字典，
+                 with_histogram 时还包含 min、max 和 histogram。查询失败时返回空列表
+    """
+    length = 256
+    count = c_int(0)
+    while True:
+        cells = (ClassCubeCell * length)()
+        if (
+            DATABASE_LIB.query_class_cube(
+                teacher_id.encode("utf-8"),
+                class_name.encode("utf-8"),
+                exam_id.encode("utf-8"),
+                1 if with_histogram else 0,
+                cells,
+                length,
+                ctypes.byref(count),
+            )
+            != 0
+        ):
+            return []
+        if count.value < length:
+            break
+        length *= 4  # 数组被填满，可能还有没有读到的单元格，加大数组重新查询
+
+    result = []
+    for cell in cells[: count.value]:
+        item = {
+            "class_name": cell.class_name.decode("utf-8", errors="ignore"),
+            "exam_id": cell.exam_id.decode(),
+            "count": cell.count,
+            "mean": cell.mean,
+            "stddev": cell.stddev,
+            "pass_count": cell.pass_count,
+            "pass_rate": cell.pass_rate,
+        }
+        if with_histogram:
+            item["min"] = cell.min_score
+            item["max"] = cell.max_score
+            item["histogram"] = list(cell.histogram)
+        result.append(item)
+    return result
+
+
+def rebuild_class_cube() -> bool:
+    """
+    @brief 由用户表和成绩表重新计算所有班级统计，在外部直接修改了 db/user.db 之后调用
+
+    @return bool 成功返回 True，否则返回 False
+    """
+    return DATABASE_LIB.rebuild_class_cube() == 0
+
+
+def insert_answer_log(score_id: str, exam_id: str, user_id: str, seed: int, correct: list, answers: list) -> int:
+    """
+    @brief 保存一次交卷的答题记录，答对的题目只记一位，答错的题目才保存答案
+
+    @param score_id 这次交卷的成绩ID
+    @param exam_id 考试ID
+    @param user_id 答题的用户ID
+    @param seed 题目顺序的随机种子，0 表示没有打乱
+    @param correct 每道题是否答对，按考卷中的原始顺序
+    @param answers 每道题的答案，按考卷中的原始顺序，None 表示没有作答
+
+    @return int 成功返回0，否则返回1
+    """
+    count = len(correct)
+    if count != len(answers) or count > ANSWER_LOG_MAX_QUESTIONS:
+        return 1
+    correct_array = (c_ubyte * count)(*(1 if item else 0 for item in correct))
+    answer_array = (c_float * count)(*(float("nan") if item is None else item for item in answers))
+    return DATABASE_LIB.insert_answer_log(
+        score_id.encode("utf-8"),
+        exam_id.encode("utf-8"),
+        user_id.encode("utf-8"),
+        seed,
+        count,
+        correct_array,
+        answer_array,
+    )
+
+
+def query_answer_log(exam_id: str, score_id: str):
+    """
+    @brief 读取一次交卷的答题记录
+
+    @param exam_id 考试ID
+    @param score_id 成绩ID
+
+    @return dict 包含随机种子、题目数量、答对数量，以及按考卷原始顺序排列的 correct 和 answers 列表的字典，
+                 answers 中答对和没有作答的题目为 None；没有找到记录或者读取失败时返回 None
+    """
+    header = AnswerLogHeader()
+    correct = (c_ubyte * ANSWER_LOG_MAX_QUESTIONS)()
+    answers = (c_float * ANSWER_LOG_MAX_QUESTIONS)()
+    if (
+        DATABASE_LIB.query_answer_log(
+            exam_id.encode("utf-8"), score_id.encode("utf-8"), ctypes.byref(header), correct, answers, ANSWER_LOG_MAX_QUESTIONS
+        )
+        != 0
+        or header.question_count < 0
+    ):
+        return None
+    count = header.question_count
+    return {
+        "seed": header.seed,
+        "question_count": count,
+        "correct_count": header.correct_count,
+        "correct": [bool(item) for item in correct[:count]],
+        "answers": [None if item != item else item for item in answers[:count]],  # NaN 不等于自身
+    }
+
+
+def query_item_analysis(exam_id: str):
+    """
+    @brief 获取一场考试的逐题分析，考试没有新的答题记录时直接返回缓存的结果
+
+    @param exam_id 考试ID
+
+    @return dict 包含版本号、答卷数量、题目数量、平均答对题数及其标准差的字典，items 为按考卷原始顺序排列的逐题结果，
+                 每项包含难度 p_value、区分度 point_biserial 和最常见的错误答案（没有时为 None）；读取失败时返回 None
+    """
+    summary = ItemAnalysisSummary()
+    items = (ItemStats * ANSWER_LOG_MAX_QUESTIONS)()
+    if DATABASE_LIB.query_item_analysis(exam_id.encode("utf-8"), ctypes.byref(summary), items, ANSWER_LOG_MAX_QUESTIONS) != 0:
+        return None
+    return {
+        "version": summary.version,
+        "submission_count": summary.submission_count,
+        "skipped_count": summary.skipped_count,
+        "question_count": summary.question_count,
+        "mean_correct": summary.mean_correct,
+        "stddev_correct": summary.stddev_correct,
+        "items": [
+            {
+                "index": item.question_index,
+                "attempts": item.attempts,
+                "correct_count": item.correct_count,
+                "unanswered_count": item.unanswered_count,
+                "p_value": item.p_value,
+                "point_biserial": item.point_biserial,
+                "top_wrong_answer": None if item.top_wrong_count == 0 else item.top_wrong_answer,
+                "top_wrong_count": item.top_wrong_count,
+            }
+            for item in items[: summary.question_count]
+        ],
+    }
+
+
+def get_item_analysis_cache_stats() -> dict:
+    """
+    @brief 获取逐题分析缓存的统计信息
+
+    @return dict 统计信息，包含命中次数、未命中次数、命中率、淘汰次数、当前大小和容量。如果获取失败，返回 None。
+    """
+    stats = ItemAnalysisCacheStats()
+    if DATABASE_LIB.get_item_analysis_cache_stats(ctypes.byref(stats)) != 0:
+        return None
+    lookups = stats.hits + stats.misses
+    return {
+        "hits": stats.hits,
+        "misses": stats.misses,
+        "hit_rate": stats.hits / lookups if lookups else 0.0,
+        "evictions": stats.evictions,
+        "size": stats.size,
+        "capacity": stats.capacity,
+    }
+
+def clear_user_cache() -> None:
+    """
+    @brief 清空用户缓存，在外部直接修改了 db/user.db 之后调用
+    """
+    DATABASE_LIB.user_cache_clear()
+
+
 if __name__ == "__main__":
 
     def test_query_user_info():
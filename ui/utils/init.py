@@ -1,4 +1,7 @@
-from . import INITIALIZER_LIB
+from . import INITIALIZER_LIB, CORE
 
 def initialize() -> None:
-    INITIALIZER_LIB.initialize()
\ No newline at end of file
+    if CORE:
+        CORE.initialize()
+    else:
+        INITIALIZER_LIB.initialize()
\ No newline at end of file
@@ -0,0 +1,144 @@
+from . import *
+from .database import (
+    get_database_retry_stats,
+    get_exam_cache_stats,
+    get_user_cache_stats,
+    get_reporting_replica_stats,
+    get_item_analysis_cache_stats,
+)
+import ctypes
+
+
+def get_metrics_snapshot() -> dict:
+    """
+    @brief 获取 C 核心所有导出函数的性能统计
+
+    @details 没有核心模块时 app.dll 和 database.dll 各自记录自己被调用的函数，这里把两边的数据相加。
+
+    @return dict 包含 bucket_upper_seconds（每个桶的上界，最后一个为 inf）和 functions（函数名 -> 统计数据）。
+                 如果获取失败，返回 None。
+    """
+    bucket_upper_seconds = None
+    functions = {}
+    for lib in {id(APP_LIB): APP_LIB, id(DATABASE_LIB): DATABASE_LIB}.values():
+        snapshot = MetricsSnapshot()
+        if lib.get_metrics_snapshot(ctypes.byref(snapshot)) != 0:
+            return None
+        if bucket_upper_seconds is None:
+            bucket_upper_seconds = [
+                snapshot.bucket_upper_ns[i] / 1e9 for i in range(snapshot.bucket_count - 1)
+            ] + [float("inf")]
+        for i in range(snapshot.function_count):
+            item = snapshot.functions[i]
+            name = item.name.decode()
+            merged = functions.setdefault(
+                name,
+                {
+                    "calls": 0,
+                    "errors": 0,
+                    "rows": 0,
+                    "bytes": 0,
+                    "total_ns": 0,
+                    "max_ns": 0,
+                    "buckets": [0] * snapshot.bucket_count,
+                },
+            )
+            merged["calls"] += item.calls
+            merged["errors"] += item.errors
+            merged["rows"] += item.rows
+            merged["bytes"] += item.bytes
+            merged["total_ns"] += item.total_ns
+            merged["max_ns"] = max(merged["max_ns"], item.max_ns)
+            for b in range(snapshot.bucket_count):
+                merged["buckets"][b] += item.buckets[b]
+    return {"bucket_upper_seconds": bucket_upper_seconds, "functions": functions}
+
+
+def reset_metrics() -> None:
+    """
+    @brief 清空 C 核心的性能统计
+    """
+    for lib in {id(APP_LIB): APP_LIB, id(DATABASE_LIB): DATABASE_LIB}.values():
+        lib.reset_metrics()
+
+
+def get_thread_call_count() -> int:
+    """
+    @brief 获取当前线程累计调用 C 核心函数的次数，请求前后的差值即为该请求的调用次数
+
+    @return int 当前线程的累计调用次数，没有核心模块时为 app.dll 和 database.dll 两边之和
+    """
+    return sum(lib.metrics_thread_calls() for lib in {id(APP_LIB): APP_LIB, id(DATABASE_LIB): DATABASE_LIB}.values())
+
+
+def render_prometheus() -> str:
+    """
+    @brief 将性能统计、缓存统计和写冲突重试统计输出为 Prometheus 文本格式
+
+    @details 从未被调用过的函数不输出。直方图的 _count 取各个桶之和，与 +Inf 桶保持一致。
+
+    @return str Prometheus 文本格式（0.0.4）的统计数据
+    """
+    lines = []
+    snapshot = get_metrics_snapshot()
+    if snapshot:
+        called = {name: item for name, item in snapshot["functions"].items() if item["calls"]}
+        les = [
+            "+Inf" if upper == float("inf") else repr(upper) for upper in snapshot["bucket_upper_seconds"]
+        ]
+
+        lines.append("# HELP mentalcore_call_duration_seconds C 核心导出函数的耗时")
+        lines.append("# TYPE mentalcore_call_duration_seconds histogram")
+        for name, item in called.items():
+            cumulative = 0
+            for le, count in zip(les, item["buckets"]):
+                cumulative += count
+                lines.append(f'mentalcore_call_duration_seconds_bucket{{function="{name}",le="{le}"}} {cumulative}')
+            lines.append(f'mentalcore_call_duration_seconds_sum{{function="{name}"}} {item["total_ns"] / 1e9!r}')
+            lines.append(f'mentalcore_call_duration_seconds_count{{function="{name}"}} {cumulative}')
+
+        for metric, key, kind, help_text in (
+            ("mentalcore_call_errors_total", "errors", "counter", "C 核心导出函数返回失败的次数"),
+            ("mentalcore_rows_returned_total", "rows", "counter", "批量查询返回的行数"),
+            ("mentalcore_bytes_copied_total", "bytes", "counter", "批量查询复制给调用者的字节数"),
+            ("mentalcore_call_duration_max_seconds", "max_ns", "gauge", "C 核心导出函数单次调用的最大耗时"),
+        ):
+            lines.append(f"# HELP {metric} {help_text}")
+            lines.append(f"# TYPE {metric} {kind}")
+            for name, item in called.items():
+                value = item[key] / 1e9 if key == "max_ns" else item[key]
+                lines.append(f'{metric}{{function="{name}"}} {value!r}')
+
+    caches = (
+        ("user", get_user_cache_stats()),
+        ("exam", get_exam_cache_stats()),
+        ("item_analysis", get_item_analysis_cache_stats()),
+    )
+    for cache, stats in caches:
+        if not stats:
+            continue
+        for key in ("hits", "misses", "evictions", "invalidations"):
+            if key not in stats:
+                continue  # 逐题分析缓存按版本号失效，没有 invalidations
+            lines.append(f"# TYPE mentalcore_{cache}_cache_{key}_total counter")
+            lines.append(f"mentalcore_{cache}_cache_{key}_total {stats[key]}")
+        lines.append(f"# TYPE mentalcore_{cache}_cache_size gauge")
+        lines.append(f"mentalcore_{cache}_cache_size {stats['size']}")
+
+    retry = get_database_retry_stats()
+    if retry:
+        for key in ("conflicts", "retries", "busy", "locked", "exhausted"):
+            lines.append(f"# TYPE mentalcore_write_{key}_total counter")
+            lines.append(f"mentalcore_write_{key}_total {retry[key]}")
+
+    replica = get_reporting_replica_stats()
+    if replica:
+        for key in ("refreshes", "skipped", "failures", "copied_pages", "routed_reads"):
+            lines.append(f"# TYPE mentalcore_replica_{key}_total counter")
+            lines.append(f"mentalcore_replica_{key}_total {replica[key]}")
+        lines.append("# TYPE mentalcore_replica_last_refresh_timestamp_seconds gauge")
+        lines.append(f"mentalcore_replica_last_refresh_timestamp_seconds {replica['last_refresh_at']}")
+        lines.append("# TYPE mentalcore_replica_last_refresh_duration_seconds gauge")
+        lines.append(f"mentalcore_replica_last_refresh_duration_seconds {replica['last_refresh_ns'] / 1e9!r}")
+
+    return "\n".join(lines) + "\n"
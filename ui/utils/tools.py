@@ -57,24 +57,39 @@ def c_strlen(s):
     return length
 
 
-def calculate_score(question_list: list, user_answer_list: list) -> int:
+def grade_answers(question_list: list, user_answer_list: list) -> list[bool]:
+    """
+    @brief 逐题判断用户答案是否正确。
+
+    @param question_list 问题列表
+    @param user_answer_list 用户答案列表，比问题列表短时缺少的题目视为答错
+    @return list[bool] 与问题列表一一对应的判题结果
+    """
+    result = [False] * len(question_list)
+    for index, (question, answer) in enumerate(zip(question_list, user_answer_list)):
+        # 考卷缓存中的题目已经带有正确答案，不需要重新计算
+        correct_answer = question.get("correct_answer")
+        if correct_answer is None:
+            correct_answer = calculate_result(
+                question.get("num1"), question.get("num2"), question.get("op")
+            )
+        result[index] = bool(judge(correct_answer, answer))
+    return result
+
+
+def calculate_score(question_list: list, user_answer_list: list, graded: list[bool] = None) -> int:
     """
     @brief 计算用户得分。
 
     @param question_list 问题列表
     @param user_answer_list 用户答案列表
+    @param graded 已经由 grade_answers 得到的判题结果，为 None 时重新判题
     @return int 得分
     """
+    if graded is None:
+        graded = grade_answers(question_list, user_answer_list)
     # 计算总分
-    right_count = 0
-    for question, answer in zip(question_list, user_answer_list):
-        if judge(
-            calculate_result(
-                question.get("num1"), question.get("num2"), question.get("op")
-            ),
-            answer,
-        ):
-            right_count += 1
+    right_count = sum(graded)
     score = right_count/len(question_list) * 100
     
     return int(score)  # 分数只能是整数，否则数据库存储方面存储后会出问题
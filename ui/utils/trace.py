@@ -0,0 +1,255 @@
+# 请求跟踪文件的读写，记录线上的真实请求，之后可以用 utils/replay.py 在新版本上按原来的节奏重放
+#
+# 本模块只使用标准库，不依赖 C 核心，重放工具直接按文件路径加载它
+
+import hashlib
+import hmac
+import json
+import os
+import threading
+import time
+
+# 文件以 MAGIC 开头，之后是一条接一条的记录，每条记录的第一个字节为记录类型，整数都是无符号 LEB128 变长编码
+MAGIC = b"MATRACE\x01"
+RECORD_SESSION = ord("S")  # 一次服务器运行的开始：墙上时间（微秒）。之后的路由编号和时间偏移都相对于这个会话
+RECORD_ROUTE = ord("R")  # 路由定义：路由编号、"方法 路由规则"
+RECORD_REQUEST = ord("Q")  # 请求：路由编号、开始偏移、耗时、状态码、C 调用次数、标志、用户ID、路径、请求体
+
+FLAG_JSON_BODY = 1  # 请求体为（匿名化后的）JSON
+FLAG_BODY_OMITTED = 2  # 请求带有非 JSON 的请求体（如上传的文件），没有记录，重放时跳过
+
+# 这些字段的值涉及个人信息，记录前替换为同样长度的假名。假名由每个会话随机生成、从不落盘的密钥计算，
+# 同一会话内同一个值总是得到同一个假名，重放时注册、添加学生等请求之间的关系仍然成立，但无法还原原值
+SENSITIVE_KEYS = {
+    "username",
+    "password",
+    "newPassword",
+    "originalPassword",
+    "resetPassword",
+    "name",
+    "className",
+    "number",
+}
+_PSEUDONYM_ALPHABET = "abcdefghijklmnopqrstuvwxyz0123456789"
+
+
+def encode_varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def decode_varint(data: bytes, pos: int) -> tuple:
+    """
+    @return tuple (值, 下一个位置)
+    """
+    result = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        result |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return result, pos
+        shift += 7
+
+
+def _encode_bytes(value: bytes) -> bytes:
+    return encode_varint(len(value)) + value
+
+
+class Anonymizer:
+    """
+    @brief 把请求参数中的敏感字段替换为假名，保持类型和长度不变
+    """
+
+    def __init__(self):
+        self.key = os.urandom(32)
+
+    def pseudonym(self, value):
+        """
+        @brief 计算一个标量的假名：整数和纯数字的字符串替换为同样位数的数字，其他字符串替换为同样长度的小写字母和数字
+        """
+        if isinstance(value, bool) or not isinstance(value, (int, str)):
+            return value
+        digest = hmac.new(self.key, repr(value).encode("utf-8"), hashlib.sha256).digest()
+        if isinstance(value, int):
+            return int.from_bytes(digest, "big") % (10 ** len(str(abs(value)))) or 1
+        while len(digest) < len(value):
+            digest += hashlib.sha256(digest).digest()
+        alphabet = "0123456789" if value.isdigit() else _PSEUDONYM_ALPHABET
+        return "".join(alphabet[b % len(alphabet)] for b in digest[: len(value)])
+
+    def anonymize(self, value, sensitive: bool = False):
+        """
+        @brief 递归地匿名化 JSON 值，sensitive 表示当前值位于敏感字段之下
+        """
+        if isinstance(value, dict):
+            return {k: self.anonymize(v, sensitive or k in SENSITIVE_KEYS) for k, v in value.items()}
+        if isinstance(value, list):
+            return [self.anonymize(v, sensitive) for v in value]
+        return self.pseudonym(value) if sensitive else value
+
+
+class TraceWriter:
+    """
+    @brief 只追加的二进制请求跟踪文件，多个线程可以同时写入
+
+    @details 文件已经存在时在末尾开始一个新的会话。记录先写入内存缓冲区，每 flush_every 条或者 flush_interval 秒
+             写入一次磁盘，close 时写入剩下的记录
+    """
+
+    def __init__(self, path: str, flush_every: int = 256, flush_interval: float = 1.0):
+        self.path = path
+        self.lock = threading.Lock()
+        self.anonymizer = Anonymizer()
+        self.routes = {}
+        self.buffer = bytearray()
+        self.pending = 0
+        self.flush_every = flush_every
+        self.flush_interval = flush_interval
+        self.last_flush = time.monotonic()
+        self.created = not os.path.exists(path) or os.path.getsize(path) == 0
+        self.file = open(path, "ab")
+        if self.created:
+            self.file.write(MAGIC)
+        self.base = time.perf_counter()
+        self.buffer += bytes([RECORD_SESSION]) + encode_varint(time.time_ns() // 1000)
+        self._flush()
+
+    def offset_us(self, perf_counter_value: float) -> int:
+        return max(0, int((perf_counter_value - self.base) * 1e6))
+
+    def write_request(self, method: str, rule: str, start: float, duration: float, status: int, c_calls: int,
+                      user_id: str, path: str, body, body_omitted: bool = False) -> None:
+        """
+        @brief 记录一个请求
+
+        @param method HTTP 方法
+        @param rule 匹配到的路由规则（如 /api/v1/student/getExamData/<exam_id>），没有匹配时为路径本身
+        @param start 请求开始时 time.perf_counter() 的值
+        @param duration 请求耗时（秒）
+        @param status 响应状态码
+        @param c_calls 请求期间调用 C 核心函数的次数
+        @param user_id 发起请求的用户ID，未登录时为空字符串
+        @param path 请求路径（含匿名化后的查询字符串）
+        @param body 请求的 JSON 内容，没有时为 None
+        @param body_omitted 请求带有没有记录的非 JSON 请求体
+        """
+        flags = FLAG_BODY_OMITTED if body_omitted else 0
+        body_bytes = b""
+        if body is not None:
+            flags |= FLAG_JSON_BODY
+            body_bytes = json.dumps(self.anonymizer.anonymize(body), ensure_ascii=False, separators=(",", ":")).encode()
+
+        key = f"{method} {rule}"
+        with self.lock:
+            route_id = self.routes.get(key)
+            if route_id is None:
+                route_id = self.routes[key] = len(self.routes)
+                self.buffer += bytes([RECORD_ROUTE]) + encode_varint(route_id) + _encode_bytes(key.encode())
+            self.buffer += (
+                bytes([RECORD_REQUEST])
+                + encode_varint(route_id)
+                + encode_varint(self.offset_us(start))
+                + encode_varint(int(duration * 1e6))
+                + encode_varint(status)
+                + encode_varint(c_calls)
+                + encode_varint(flags)
+                + _encode_bytes(user_id.encode())
+                + _encode_bytes(path.encode())
+                + _encode_bytes(body_bytes)
+            )
+            self.pending += 1
+            if self.pending >= self.flush_every or time.monotonic() - self.last_flush >= self.flush_interval:
+                self._flush()
+
+    def _flush(self) -> None:
+        self.file.write(self.buffer)
+        self.file.flush()
+        self.buffer.clear()
+        self.pending = 0
+        self.last_flush = time.monotonic()
+
+    def close(self) -> None:
+        with self.lock:
+            if not self.file.closed:
+                self._flush()
+                self.file.close()
+
+
+def read_trace(path: str) -> list:
+    """
+    @brief 读取跟踪文件
+
+    @details 服务器异常退出时最后一条记录可能不完整，读到不完整的记录时停止
+
+    @return list 会话列表，每个会话为 {"wall_time_us": 会话开始的墙上时间, "requests": [请求字典, ...]}，
+                 请求字典包含 method、rule、offset_us、duration_us、status、c_calls、flags、user_id、path、body（bytes）
+    """
+    with open(path, "rb") as file:
+        data = file.read()
+    if not data.startswith(MAGIC):
+        raise ValueError(f"{path} 不是请求跟踪文件")
+
+    sessions = []
+    routes = {}
+    pos = len(MAGIC)
+    try:
+        while pos < len(data):
+            kind = data[pos]
+            pos += 1
+            if kind == RECORD_SESSION:
+                wall_time_us, pos = decode_varint(data, pos)
+                sessions.append({"wall_time_us": wall_time_us, "requests": []})
+                routes = {}
+            elif kind == RECORD_ROUTE:
+                route_id, pos = decode_varint(data, pos)
+                length, pos = decode_varint(data, pos)
+                if pos + length > len(data):
+                    break
+                routes[route_id] = data[pos : pos + length].decode()
+                pos += length
+            elif kind == RECORD_REQUEST:
+                fields = []
+                for _ in range(6):
+                    value, pos = decode_varint(data, pos)
+                    fields.append(value)
+                blobs = []
+                for _ in range(3):
+                    length, pos = decode_varint(data, pos)
+                    if pos + length > len(data):
+                        raise IndexError
+                    blobs.append(data[pos : pos + length])
+                    pos += length
+                method, rule = routes[fields[0]].split(" ", 1)
+                sessions[-1]["requests"].append(
+                    {
+                        "method": method,
+                        "rule": rule,
+                        "offset_us": fields[1],
+                        "duration_us": fields[2],
+                        "status": fields[3],
+                        "c_calls": fields[4],
+                        "flags": fields[5],
+                        "user_id": blobs[0].decode(),
+                        "path": blobs[1].decode(),
+                        "body": blobs[2],
+                    }
+                )
+            else:
+                raise ValueError(f"{path} 在偏移 {pos - 1} 处有未知的记录类型 {kind}")
+    except IndexError:
+        pass  # 文件末尾不完整的记录
+    return sessions
+
+
+def is_trace_file(path: str) -> bool:
+    with open(path, "rb") as file:
+        return file.read(len(MAGIC)) == MAGIC
@@ -0,0 +1,684 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: benchmark.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件是 C 核心的基准测试程序，在合成数据上逐个测量 app.h 和 database.h 中导出函数的
+                每次调用耗时（ns/op）、每次调用的内存分配次数（allocs/op）以及耗时分位数，结果以 JSON 格式输出，便于比较不同版本
+Others:         编译方法见仓库根目录的 bench.sh。统计内存分配依赖链接器的 --wrap 选项（GCC / MinGW），
+                编译时定义 BENCH_COUNT_ALLOCATIONS 并传入 -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free 才会统计，
+                否则 allocs_per_op 和 bytes_per_op 输出为 null
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了合成数据的生成、分批计时、内存分配统计以及 JSON 格式的结果输出
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 --db 选项，可以把数据库放到 tmpfs 或内存数据库中，把存储的开销与计算的开销分开测量
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 get_permission、has_permission、has_role_permission 的测量，学生和教师交替
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#define chdir _chdir
+#define access _access
+#define make_directory(path) _mkdir(path)
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#define make_directory(path) mkdir((path), 0755)
+#endif
+#include "../include/app.h"
+#include "../include/database.h"
+#include "../include/metrics.h"
+#include "../include/model.h"
+#include "../include/uuid.h"
+
+void initialize(); // 定义在 utils/initializer.c 中
+
+/*** 计时部分 ***/
+#define BENCH_DEFAULT_MIN_TIME_MS 300 // 每个函数至少测量多长时间
+#define BENCH_WARMUP_TIME_MS 30       // 预热时间，同时用来估计单次调用的耗时
+#define BENCH_TARGET_SAMPLE_NS 2000   // 每个样本至少持续的时间，快速函数会把多次调用合成一个样本，减小计时本身的误差
+#define BENCH_MAX_SAMPLES 200000      // 每个函数最多记录的样本数
+
+/*** 合成数据部分 ***/
+#define BENCH_DEFAULT_DIR "bench_data"  // 默认的工作目录，基准测试会在其中新建 db 和 logs 文件夹
+#define BENCH_TEACHERS 10               // 教师数量
+#define BENCH_STUDENTS 1000             // 学生数量
+#define BENCH_EXAMS 50                  // 考试数量
+#define BENCH_QUESTIONS_PER_EXAM 20     // 每场考试的题目数量
+#define BENCH_SCORES_PER_STUDENT 5      // 每个学生的成绩数量
+
+/**************************** 内存分配统计部分开始 ****************************/
+
+static atomic_ullong allocation_count; // 累计的内存分配次数
+static atomic_ullong allocation_bytes; // 累计申请的字节数
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+
+void *__wrap_malloc(size_t size)
+{
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocation_bytes, size, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocation_bytes, count * size, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocation_bytes, size, memory_order_relaxed);
+    return __real_realloc(pointer, size);
+}
+
+void __wrap_free(void *pointer)
+{
+    __real_free(pointer);
+}
+#endif
+
+/**************************** 内存分配统计部分结束 ****************************/
+
+/**************************** 合成数据部分开始 ****************************/
+
+/**
+ * @brief 合成数据中各类记录的ID，基准测试从中挑选查询条件
+ */
+struct BenchData
+{
+    char teacher_ids[BENCH_TEACHERS][UUID_LENGTH];
+    char student_ids[BENCH_STUDENTS][UUID_LENGTH];
+    char exam_ids[BENCH_EXAMS][UUID_LENGTH];
+    char question_ids[BENCH_EXAMS * BENCH_QUESTIONS_PER_EXAM][UUID_LENGTH];
+    char score_ids[BENCH_STUDENTS * BENCH_SCORES_PER_STUDENT][UUID_LENGTH];
+    char student_usernames[BENCH_STUDENTS][25];
+};
+
+static struct BenchData data;     // 合成数据，全局变量避免占用过多栈空间
+static uint64_t data_random_state; // 生成合成数据用的随机数发生器状态，固定种子使每次运行的数据相同
+
+/**
+ * @brief 生成合成数据用的伪随机数（xorshift64*）
+ *
+ * @param bound 上界（不含）
+ * @return int [0, bound) 之间的随机数
+ */
+static int data_random(int bound)
+{
+    data_random_state ^= data_random_state >> 12;
+    data_random_state ^= data_random_state << 25;
+    data_random_state ^= data_random_state >> 27;
+    return (int)((data_random_state * 0x2545F4914F6CDD1DULL >> 33) % (uint64_t)bound);
+}
+
+/**
+ * @brief 通过导出的插入函数生成合成数据
+ *
+ * @return int 成功返回0，否则返回1
+ */
+static int seed_bench_data(void)
+{
+    static const char hashpass[] = "0000000000000000000000000000000000000000000000000000000000000000"
+                                   "0000000000000000000000000000000000000000000000000000000000000000";
+    data_random_state = 0x9E3779B97F4A7C15ULL;
+
+    for (int i = 0; i < BENCH_TEACHERS; i++)
+    {
+        char username[25];
+        char name[46];
+        snprintf(username, sizeof(username), "teacher%d", i);
+        snprintf(name, sizeof(name), "教师%d", i);
+        if (generate_uuid(data.teacher_ids[i], UUID_VERSION_4) ||
+            insert_user_data(data.teacher_ids[i], username, hashpass, "0000000000000000", 1, name, "", 10000 + i, ""))
+        {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < BENCH_STUDENTS; i++)
+    {
+        char name[46];
+        char class_name[31];
+        snprintf(data.student_usernames[i], sizeof(data.student_usernames[i]), "student%d", i);
+        snprintf(name, sizeof(name), "学生%d", i);
+        snprintf(class_name, sizeof(class_name), "班级%d", i % BENCH_TEACHERS);
+        if (generate_uuid(data.student_ids[i], UUID_VERSION_4) ||
+            insert_user_data(data.student_ids[i], data.student_usernames[i], hashpass, "0000000000000000", 0, name,
+                             class_name, 20000 + i, data.teacher_ids[i % BENCH_TEACHERS]))
+        {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < BENCH_EXAMS; i++)
+    {
+        char name[91];
+        snprintf(name, sizeof(name), "基准测试考试%d", i);
+        if (generate_uuid(data.exam_ids[i], UUID_VERSION_4) ||
+            insert_exam_data(data.exam_ids[i], name, 1700000000 + i * 86400, 1700000000 + i * 86400 + 3600, i % 2, i % 3 == 0))
+        {
+            return 1;
+        }
+        for (int q = 0; q < BENCH_QUESTIONS_PER_EXAM; q++)
+        {
+            char *question_id = data.question_ids[i * BENCH_QUESTIONS_PER_EXAM + q];
+            if (generate_uuid(question_id, UUID_VERSION_4) ||
+                insert_question_data(question_id, data.exam_ids[i], data_random(100), data_random(4), 1 + data_random(99)))
+            {
+                return 1;
+            }
+        }
+    }
+
+    for (int i = 0; i < BENCH_STUDENTS * BENCH_SCORES_PER_STUDENT; i++)
+    {
+        if (generate_uuid(data.score_ids[i], UUID_VERSION_4) ||
+            insert_score_data(data.score_ids[i], data.exam_ids[data_random(BENCH_EXAMS)],
+                              data.student_ids[i % BENCH_STUDENTS], data_random(101), data_random(10) == 0))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**************************** 合成数据部分结束 ****************************/
+
+/**************************** 被测函数部分开始 ****************************/
+
+static volatile float float_sink; // 防止编译器把没有使用的返回值优化掉
+static volatile int int_sink;     // 同上，用于返回 int 的函数
+
+static int bench_calculate_result(int i)
+{
+    float_sink = calculate_result(i & 0xFF, 1 + (i & 0x3F), i & 3);
+    return 0;
+}
+
+static int bench_judge(int i)
+{
+    judge((float)(i & 0xFF) / 7.0f, (float)(i & 0xFF) / 7.0f + (float)(i & 1) * 0.01f); // 返回值是判题结果，不是错误码
+    return 0;
+}
+
+static int bench_generate_question_permutation(int i)
+{
+    int permutation[BENCH_QUESTIONS_PER_EXAM];
+    return generate_question_permutation((unsigned int)i + 1, BENCH_QUESTIONS_PER_EXAM, permutation);
+}
+
+static int bench_generate_question_list(int i)
+{
+    struct Question head;
+    int rc = generate_question_list(data.exam_ids[i % BENCH_EXAMS], &head, BENCH_QUESTIONS_PER_EXAM);
+    free_question_list(head.next_question); // 头节点由调用者提供，只释放后面的节点
+    return rc;
+}
+
+static struct Question *randomize_source; // randomize_question_list 的输入链表，在测量之前生成
+
+static int bench_randomize_question_list(int i)
+{
+    struct Question head;
+    (void)i;
+    int rc = randomize_question_list(&head, randomize_source);
+    free_question_list(head.next_question);
+    return rc;
+}
+
+static struct User permission_users[2]; // 权限检查用的一名学生和一名教师，由 query_user_info 读出，在测量之前准备
+
+static int bench_get_permission(int i)
+{
+    struct Permission permission = get_permission(permission_users[i & 1]);
+    int_sink = permission.stu_answer + permission.tea_manage_exam;
+    return 0;
+}
+
+static int bench_has_permission(int i)
+{
+    int_sink = has_permission(&permission_users[i & 1], PERM_STU_ANSWER);
+    return 0;
+}
+
+static int bench_has_role_permission(int i)
+{
+    int_sink = has_role_permission(i & 1, PERM_TEA_MANAGE_EXAM);
+    return 0;
+}
+
+static int bench_open_database(int i)
+{
+    sqlite3 *db = NULL;
+    (void)i;
+    int rc = open_database("db/examination.db", &db);
+    sqlite3_close(db);
+    return rc;
+}
+
+static int bench_query_user_info_by_id(int i)
+{
+    struct User user;
+    return query_user_info("id", data.student_ids[i % BENCH_STUDENTS], &user);
+}
+
+static int bench_query_user_info_by_username(int i)
+{
+    struct User user;
+    return query_user_info("username", data.student_usernames[i % BENCH_STUDENTS], &user);
+}
+
+static int bench_query_exam_info(int i)
+{
+    struct SqlResponseExam exam;
+    return query_exam_info("id", data.exam_ids[i % BENCH_EXAMS], &exam);
+}
+
+static int bench_query_question_info(int i)
+{
+    struct SqlResponseQuestion question;
+    return query_question_info("id", data.question_ids[i % (BENCH_EXAMS * BENCH_QUESTIONS_PER_EXAM)], &question);
+}
+
+static int bench_query_score_info(int i)
+{
+    struct SqlResponseScore score;
+    return query_score_info("user_id", data.student_ids[i % BENCH_STUDENTS], &score);
+}
+
+static int bench_query_exams_info_all(int i)
+{
+    static struct SqlResponseExam exams[BENCH_EXAMS];
+    (void)i;
+    return query_exams_info_all(exams, BENCH_EXAMS, "", "");
+}
+
+static int bench_query_questions_info_all(int i)
+{
+    struct SqlResponseQuestion questions[BENCH_QUESTIONS_PER_EXAM];
+    return query_questions_info_all(questions, BENCH_QUESTIONS_PER_EXAM, "exam_id", data.exam_ids[i % BENCH_EXAMS]);
+}
+
+static int bench_query_scores_info_all(int i)
+{
+    struct SqlResponseScore scores[BENCH_SCORES_PER_STUDENT];
+    return query_scores_info_all(scores, BENCH_SCORES_PER_STUDENT, "user_id", data.student_ids[i % BENCH_STUDENTS]);
+}
+
+static int bench_query_users_info_all(int i)
+{
+    static struct SqlResponseUser users[BENCH_STUDENTS];
+    (void)i;
+    return query_users_info_all(users, BENCH_STUDENTS, "", "");
+}
+
+static int bench_query_scores_columnar(int i)
+{
+    struct ColumnarResult *result = NULL;
+    (void)i;
+    int rc = query_scores_columnar(BENCH_STUDENTS * BENCH_SCORES_PER_STUDENT, "", "", &result);
+    free_columnar_result(result);
+    return rc;
+}
+
+static int bench_query_users_columnar(int i)
+{
+    struct ColumnarResult *result = NULL;
+    (void)i;
+    int rc = query_users_columnar(BENCH_STUDENTS, "", "", &result);
+    free_columnar_result(result);
+    return rc;
+}
+
+static int bench_insert_score_data(int i)
+{
+    char score_id[UUID_LENGTH];
+    generate_uuid(score_id, UUID_VERSION_4);
+    return insert_score_data(score_id, data.exam_ids[i % BENCH_EXAMS], data.student_ids[i % BENCH_STUDENTS], i % 101, 0);
+}
+
+static int bench_edit_score_data(int i)
+{
+    int index = i % (BENCH_STUDENTS * BENCH_SCORES_PER_STUDENT);
+    return edit_score_data(data.score_ids[index], data.exam_ids[index % BENCH_EXAMS],
+                               data.student_ids[index % BENCH_STUDENTS], i % 101, 0);
+}
+
+/**
+ * @brief 一个被测函数
+ */
+struct Benchmark
+{
+    const char *name;         // 输出到结果中的名字
+    int (*function)(int i);   // 执行一次调用，i 为调用序号，用于轮换参数，失败时返回非0
+};
+
+static const struct Benchmark BENCHMARKS[] = {
+    {"calculate_result", bench_calculate_result},
+    {"judge", bench_judge},
+    {"generate_question_permutation", bench_generate_question_permutation},
+    {"generate_question_list", bench_generate_question_list},
+    {"randomize_question_list", bench_randomize_question_list},
+    {"get_permission", bench_get_permission},
+    {"has_permission", bench_has_permission},
+    {"has_role_permission", bench_has_role_permission},
+    {"open_database", bench_open_database},
+    {"query_user_info/id", bench_query_user_info_by_id},
+    {"query_user_info/username", bench_query_user_info_by_username},
+    {"query_exam_info", bench_query_exam_info},
+    {"query_question_info", bench_query_question_info},
+    {"query_score_info", bench_query_score_info},
+    {"query_exams_info_all", bench_query_exams_info_all},
+    {"query_questions_info_all", bench_query_questions_info_all},
+    {"query_scores_info_all", bench_query_scores_info_all},
+    {"query_users_info_all", bench_query_users_info_all},
+    {"query_scores_columnar", bench_query_scores_columnar},
+    {"query_users_columnar", bench_query_users_columnar},
+    {"insert_score_data", bench_insert_score_data},
+    {"edit_score_data", bench_edit_score_data},
+};
+
+/**************************** 被测函数部分结束 ****************************/
+
+/**************************** 测量部分开始 ****************************/
+
+/**
+ * @brief 一个函数的测量结果
+ */
+struct BenchResult
+{
+    unsigned long long operations; // 测量期间的调用次数
+    unsigned long long errors;     // 测量期间返回失败的次数
+    double ns_per_op;              // 平均每次调用的耗时
+    double allocs_per_op;          // 平均每次调用的内存分配次数
+    double bytes_per_op;           // 平均每次调用申请的字节数
+    double p50_ns;                 // 耗时的 50% 分位数
+    double p90_ns;                 // 耗时的 90% 分位数
+    double p99_ns;                 // 耗时的 99% 分位数
+    double max_ns;                 // 耗时的最大值
+};
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief 取已排序样本的分位数（最近秩法）
+ *
+ * @param samples 升序排列的样本
+ * @param count 样本数量
+ * @param quantile 分位数，取值 (0, 1]
+ * @return double 分位数对应的样本
+ */
+static double percentile(const double *samples, int count, double quantile)
+{
+    int rank = (int)(quantile * count + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    if (rank > count)
+    {
+        rank = count;
+    }
+    return samples[rank - 1];
+}
+
+/**
+ * @brief 测量一个函数
+ *
+ * @details 先预热并估计单次调用的耗时，然后把若干次调用合成一个至少持续 BENCH_TARGET_SAMPLE_NS 的样本，
+ *          分位数是样本内的平均耗时的分位数。耗时在微秒以上的函数每个样本只有一次调用，分位数就是单次调用的分位数
+ *
+ * @param benchmark 被测函数
+ * @param min_time_ms 至少测量多长时间
+ * @param samples 样本缓冲区，长度至少为 BENCH_MAX_SAMPLES
+ * @param result_to_return 返回的测量结果
+ */
+static void run_benchmark(const struct Benchmark *benchmark, int min_time_ms, double *samples, struct BenchResult *result_to_return)
+{
+    int i = 0;
+    uint64_t start = metrics_now_ns();
+    uint64_t warmup_end = start + (uint64_t)BENCH_WARMUP_TIME_MS * 1000000ULL;
+    while (metrics_now_ns() < warmup_end || i < 3)
+    {
+        benchmark->function(i++);
+    }
+    double estimate_ns = (double)(metrics_now_ns() - start) / i;
+    int batch = estimate_ns >= BENCH_TARGET_SAMPLE_NS ? 1 : (int)(BENCH_TARGET_SAMPLE_NS / estimate_ns) + 1;
+
+    unsigned long long allocations_before = atomic_load_explicit(&allocation_count, memory_order_relaxed);
+    unsigned long long bytes_before = atomic_load_explicit(&allocation_bytes, memory_order_relaxed);
+    int sample_count = 0;
+    unsigned long long errors = 0;
+    uint64_t total_ns = 0;
+    uint64_t deadline = metrics_now_ns() + (uint64_t)min_time_ms * 1000000ULL;
+    do
+    {
+        uint64_t sample_start = metrics_now_ns();
+        for (int b = 0; b < batch; b++)
+        {
+            errors += benchmark->function(i++) != 0;
+        }
+        uint64_t elapsed = metrics_now_ns() - sample_start;
+        total_ns += elapsed;
+        samples[sample_count++] = (double)elapsed / batch;
+    } while (sample_count < BENCH_MAX_SAMPLES && metrics_now_ns() < deadline);
+
+    unsigned long long operations = (unsigned long long)sample_count * (unsigned long long)batch;
+    qsort(samples, (size_t)sample_count, sizeof(double), compare_double);
+    result_to_return->operations = operations;
+    result_to_return->errors = errors;
+    result_to_return->ns_per_op = (double)total_ns / (double)operations;
+    result_to_return->allocs_per_op =
+        (double)(atomic_load_explicit(&allocation_count, memory_order_relaxed) - allocations_before) / (double)operations;
+    result_to_return->bytes_per_op =
+        (double)(atomic_load_explicit(&allocation_bytes, memory_order_relaxed) - bytes_before) / (double)operations;
+    result_to_return->p50_ns = percentile(samples, sample_count, 0.50);
+    result_to_return->p90_ns = percentile(samples, sample_count, 0.90);
+    result_to_return->p99_ns = percentile(samples, sample_count, 0.99);
+    result_to_return->max_ns = samples[sample_count - 1];
+}
+
+/**************************** 测量部分结束 ****************************/
+
+/**
+ * @brief 打印用法
+ *
+ * @param program 程序名
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "用法: %s [--output FILE] [--dir DIR] [--db LOCATION] [--min-time MS] [--filter TEXT]\n"
+            "  --output FILE   JSON 结果的输出文件，默认输出到标准输出\n"
+            "  --dir DIR       工作目录，必须不存在或者不包含 db 文件夹，默认为 %s\n"
+            "  --db LOCATION   数据库位置：空目录（如 tmpfs 上的目录）、:memory: 或 memory:名称，\n"
+            "                  默认使用环境变量 MENTAL_DB_LOCATION，没有设置时为工作目录下的 db 文件夹\n"
+            "  --min-time MS   每个函数至少测量的毫秒数，默认为 %d\n"
+            "  --filter TEXT   只测量名字中包含 TEXT 的函数\n",
+            program, BENCH_DEFAULT_DIR, BENCH_DEFAULT_MIN_TIME_MS);
+}
+
+/**
+ * @brief 基准测试入口
+ *
+ * @return int 成功返回0，否则返回1
+ */
+int main(int argc, char **argv)
+{
+    const char *output_path = NULL;
+    const char *work_dir = BENCH_DEFAULT_DIR;
+    const char *db_location = NULL;
+    const char *filter = NULL;
+    int min_time_ms = BENCH_DEFAULT_MIN_TIME_MS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+        {
+            work_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc)
+        {
+            db_location = argv[++i];
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+        {
+            min_time_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // 输出文件相对于启动时的目录，需要在切换工作目录之前打开
+    FILE *output = stdout;
+    if (output_path != NULL && (output = fopen(output_path, "w")) == NULL)
+    {
+        fprintf(stderr, "无法打开输出文件 '%s'：%s\n", output_path, strerror(errno));
+        return 1;
+    }
+
+    if (access(work_dir, 0) != 0 && make_directory(work_dir) != 0)
+    {
+        fprintf(stderr, "无法创建工作目录 '%s'：%s\n", work_dir, strerror(errno));
+        return 1;
+    }
+    if (chdir(work_dir) != 0)
+    {
+        fprintf(stderr, "无法进入工作目录 '%s'：%s\n", work_dir, strerror(errno));
+        return 1;
+    }
+    if (access("db", 0) == 0)
+    {
+        fprintf(stderr, "工作目录 '%s' 中已经存在 db 文件夹，请先删除，以免合成数据与已有数据混在一起\n", work_dir);
+        return 1;
+    }
+
+    initialize();
+    if (set_database_location(db_location) || initialize_schema())
+    {
+        fprintf(stderr, "无法在指定位置建立数据库，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    set_slow_query_log(-1, 0);
+    fprintf(stderr, "正在生成合成数据……\n");
+    if (seed_bench_data())
+    {
+        fprintf(stderr, "生成合成数据失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+
+    randomize_source = (struct Question *)calloc(1, sizeof(struct Question));
+    if (randomize_source == NULL || generate_question_list(data.exam_ids[0], randomize_source, BENCH_QUESTIONS_PER_EXAM))
+    {
+        fprintf(stderr, "生成题目链表失败\n");
+        return 1;
+    }
+
+    if (query_user_info("id", data.student_ids[0], &permission_users[0]) ||
+        query_user_info("id", data.teacher_ids[0], &permission_users[1]))
+    {
+        fprintf(stderr, "读取权限检查用的用户失败\n");
+        return 1;
+    }
+
+    double *samples = (double *)malloc(sizeof(double) * BENCH_MAX_SAMPLES);
+    if (samples == NULL)
+    {
+        fprintf(stderr, "内存分配失败\n");
+        return 1;
+    }
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+    const int count_allocations = 1;
+#else
+    const int count_allocations = 0;
+#endif
+
+    // 记录数据库是否在内存中，磁盘（包括 tmpfs）与内存上的结果不能直接比较
+    const char *resolved_location = db_location != NULL ? db_location : getenv("MENTAL_DB_LOCATION");
+    int in_memory = resolved_location != NULL && (strcmp(resolved_location, ":memory:") == 0 ||
+                                                  strcmp(resolved_location, "file::memory:") == 0 ||
+                                                  strncmp(resolved_location, "memory:", 7) == 0);
+
+    fprintf(output, "{\n  \"min_time_ms\": %d,\n  \"allocations_counted\": %s,\n  \"storage\": \"%s\",\n", min_time_ms,
+            count_allocations ? "true" : "false", in_memory ? "memory" : "disk");
+    fprintf(output, "  \"dataset\": {\"teachers\": %d, \"students\": %d, \"exams\": %d, \"questions_per_exam\": %d, \"scores\": %d},\n",
+            BENCH_TEACHERS, BENCH_STUDENTS, BENCH_EXAMS, BENCH_QUESTIONS_PER_EXAM, BENCH_STUDENTS * BENCH_SCORES_PER_STUDENT);
+    fprintf(output, "  \"results\": [");
+
+    int first = 1;
+    for (size_t b = 0; b < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); b++)
+    {
+        const struct Benchmark *benchmark = &BENCHMARKS[b];
+        if (filter != NULL && strstr(benchmark->name, filter) == NULL)
+        {
+            continue;
+        }
+
+        struct BenchResult result;
+        run_benchmark(benchmark, min_time_ms, samples, &result);
+        fprintf(stderr, "%-32s %12.1f ns/op  p50 %10.1f  p99 %10.1f  %8.2f allocs/op  %llu errors\n", benchmark->name,
+                result.ns_per_op, result.p50_ns, result.p99_ns, result.allocs_per_op, result.errors);
+
+        fprintf(output, "%s\n    {\"name\": \"%s\", \"operations\": %llu, \"errors\": %llu, \"ns_per_op\": %.1f, ",
+                first ? "" : ",", benchmark->name, result.operations, result.errors, result.ns_per_op);
+        if (count_allocations)
+        {
+            fprintf(output, "\"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f, ", result.allocs_per_op, result.bytes_per_op);
+        }
+        else
+        {
+            fprintf(output, "\"allocs_per_op\": null, \"bytes_per_op\": null, ");
+        }
+        fprintf(output, "\"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f}",
+                result.p50_ns, result.p90_ns, result.p99_ns, result.max_ns);
+        first = 0;
+    }
+    fprintf(output, "\n  ]\n}\n");
+
+    free(samples);
+    free_question_list(randomize_source);
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}
@@ -0,0 +1,898 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: generator.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件是合成数据生成工具，按照 include/schema.h 中的表结构生成 db/user.db、db/examination.db 和 db/score.db，
+                用于在生产规模的数据上做压力测试和基准测试
+Others:         编译方法：gcc -O2 utils/generator.c include/answer_log.c lib/sqlite3.c -o generator（没有 lib/sqlite3.c 时改为链接 -lsqlite3）
+                同一个种子和同一组参数总是生成完全相同的数据库，ID 也由种子生成，不使用系统随机数。
+                所有用户的密码都是 00000000
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了可复现的合成数据生成，支持配置每位教师的学生数、每场考试的题目数、
+                            参加考试的比例和成绩分布，每个数据库在一个事务内批量写入
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 成绩写入完成后一次性计算成绩统计表，再建立维护统计的触发器，批量写入时不逐条触发
+    3.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 成绩写入完成后建立 scores 表的索引
+    4.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 成绩写入完成后附加用户数据库，一次性计算班级统计，再建立维护班级统计的触发器
+    5.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 成绩数据库中同时建立答题记录表 answer_log 以及同步它的触发器
+    6.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 --answer-logs 选项，为每条成绩生成答题记录，成绩由答对的题目数量得到
+                        [+] 成绩数据库中同时建立答题记录版本表 answer_log_versions 以及维护它的触发器
+    7.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [*] --dir 指定的输出目录不存在时先创建
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#define access _access
+#define chdir _chdir
+#define make_directory(path) _mkdir(path)
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#define make_directory(path) mkdir((path), 0755)
+#endif
+#include "../include/schema.h"
+#include "../include/answer_log.h"
+#include "../lib/sqlite3.h"
+
+/*** 默认参数部分 ***/
+// 默认参数生成 50 位教师、20000 名学生、2000 场考试、200000 道题目和约 1000000 条成绩
+#define GENERATOR_DEFAULT_SEED 20241218ULL       // 默认随机种子
+#define GENERATOR_DEFAULT_TEACHERS 50            // 教师数量
+#define GENERATOR_DEFAULT_STUDENTS_PER_TEACHER 400 // 每位教师的学生数量
+#define GENERATOR_DEFAULT_EXAMS 2000             // 考试数量
+#define GENERATOR_DEFAULT_QUESTIONS_PER_EXAM 100 // 每场考试的题目数量
+#define GENERATOR_DEFAULT_SUBMISSION_RATE 0.025  // 每名学生参加每场考试的概率
+#define GENERATOR_DEFAULT_SCORE_MEAN 75.0        // 成绩的均值
+#define GENERATOR_DEFAULT_SCORE_STDDEV 15.0      // 成绩的标准差
+#define GENERATOR_DEFAULT_EXPIRED_RATE 0.05      // 逾期作答的比例
+
+/*** 答题记录部分 ***/
+#define GENERATOR_UNANSWERED_RATE 0.1  // 答错的题目中没有作答的比例
+#define GENERATOR_DISTRACTOR_RATE 0.5  // 作答但答错的题目中给出这道题的典型错误答案的比例
+
+/*** 数据部分 ***/
+#define GENERATOR_PASSWORD "00000000" // 所有生成用户的密码
+#define GENERATOR_SALT "MentalGenerator0" // 所有生成用户共用的盐，16 个字符
+// sha512(GENERATOR_SALT + GENERATOR_PASSWORD)，与 ui/route/api.py 中的密码校验方式一致
+#define GENERATOR_HASHPASS "ca84585bc3ac67e838ab19c572f15c266573a1209add19d52ed329013e81cd6f" \
+                           "ae460eb918d405608e96b4706026ddc3dd9cb4880aea0214b24e0ba695168fc6"
+#define GENERATOR_BASE_TIME_MS 1725148800000ULL // UUIDv7 的起始时间戳以及历史考试的起始时间（2024-09-01 00:00:00 UTC）
+#define GENERATOR_EXAM_SPAN_SECONDS (365 * 86400) // 历史考试均匀分布在起始时间之后的一年内
+#define GENERATOR_EXAM_DURATION_SECONDS 3600      // 每场历史考试持续的时间
+#define UUID_LENGTH 37                            // UUID 字符串长度，36 个字符再加上一个 \0
+
+/**
+ * @brief 生成参数
+ */
+struct GeneratorOptions
+{
+    const char *dir;               // 输出目录，数据库写入其中的 db 文件夹
+    uint64_t seed;                 // 随机种子
+    int teachers;                  // 教师数量
+    int students_min;              // 每位教师的最少学生数量
+    int students_max;              // 每位教师的最多学生数量
+    int exams;                     // 考试数量
+    int questions_min;             // 每场考试的最少题目数量
+    int questions_max;             // 每场考试的最多题目数量
+    double submission_rate;        // 每名学生参加每场考试的概率
+    double score_mean;             // 成绩的均值
+    double score_stddev;           // 成绩的标准差
+    double expired_rate;           // 逾期作答的比例
+    int active_exam;               // 是否把最后一场考试设为正在进行
+    int answer_logs;               // 是否为每条成绩生成答题记录
+    int force;                     // 数据库已经存在时是否覆盖
+};
+
+/**************************** 随机数部分开始 ****************************/
+
+static uint64_t random_state; // 随机数发生器状态，由种子初始化
+
+/**
+ * @brief 生成下一个 64 位伪随机数（splitmix64）
+ *
+ * @return uint64_t 伪随机数
+ */
+static uint64_t random_next(void)
+{
+    uint64_t z = (random_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief 生成 [0, 1) 之间均匀分布的随机数
+ *
+ * @return double 随机数
+ */
+static double random_uniform(void)
+{
+    return (double)(random_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief 生成 [low, high] 之间均匀分布的随机整数
+ *
+ * @param low 下界
+ * @param high 上界（含）
+ * @return int 随机整数
+ */
+static int random_range(int low, int high)
+{
+    return low + (int)(random_next() % (uint64_t)(high - low + 1));
+}
+
+/**
+ * @brief 生成正态分布的随机数（Box-Muller 变换）
+ *
+ * @param mean 均值
+ * @param stddev 标准差
+ * @return double 随机数
+ */
+static double random_normal(double mean, double stddev)
+{
+    double u1 = 1.0 - random_uniform(); // 取值 (0, 1]，避免 log(0)
+    double u2 = random_uniform();
+    return mean + stddev * sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static uint64_t uuid_sequence; // 已生成的 UUID 数量
+
+/**
+ * @brief 由种子生成一个 UUIDv7 字符串
+ *
+ * @details 时间戳从 GENERATOR_BASE_TIME_MS 开始，每 4096 个 UUID 加一毫秒，同一毫秒内 rand_a 字段为序号，
+ *          所以生成的 UUID 严格递增，插入时总是落在主键 B 树的末尾；其余 62 位来自种子
+ *
+ * @param uuid_to_return 返回的 UUID 字符串，长度至少为 UUID_LENGTH
+ */
+static void generate_seeded_uuid7(char *uuid_to_return)
+{
+    uint64_t timestamp = GENERATOR_BASE_TIME_MS + (uuid_sequence >> 12);
+    uint64_t high = (timestamp << 16) | 0x7000ULL | (uuid_sequence & 0xFFFULL);
+    uint64_t low = (random_next() & 0x3FFFFFFFFFFFFFFFULL) | 0x8000000000000000ULL;
+    uuid_sequence++;
+    snprintf(uuid_to_return, UUID_LENGTH, "%08x-%04x-%04x-%04x-%012llx",
+             (unsigned int)(high >> 32), (unsigned int)((high >> 16) & 0xFFFF), (unsigned int)(high & 0xFFFF),
+             (unsigned int)(low >> 48), (unsigned long long)(low & 0xFFFFFFFFFFFFULL));
+}
+
+/**************************** 随机数部分结束 ****************************/
+
+/**************************** 批量写入部分开始 ****************************/
+
+/**
+ * @brief 获取当前时间，用于统计生成耗时
+ *
+ * @return double 秒数，只有差值有意义
+ */
+static double now_seconds(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief 创建数据库并开始批量写入
+ *
+ * @details 生成的数据库是全新的，写入失败时直接删除重新生成即可，所以关闭回滚日志和同步，并在一个事务内写入所有数据
+ *
+ * @param path 数据库路径
+ * @param schemas 建表语句，以 NULL 结尾
+ * @param db_to_return 返回的数据库连接
+ * @return int 成功返回0，否则返回1
+ */
+static int begin_bulk_load(const char *path, const char *const *schemas, sqlite3 **db_to_return)
+{
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "无法打开数据库 '%s'：%s\n", path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    if (sqlite3_exec(db, "PRAGMA journal_mode = OFF; PRAGMA synchronous = OFF; PRAGMA locking_mode = EXCLUSIVE; "
+                         "PRAGMA cache_size = -65536;",
+                     NULL, NULL, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "无法设置数据库 '%s'：%s\n", path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    for (int i = 0; schemas[i] != NULL; i++)
+    {
+        if (sqlite3_exec(db, schemas[i], NULL, NULL, NULL) != SQLITE_OK)
+        {
+            fprintf(stderr, "无法在数据库 '%s' 中建表：%s\n", path, sqlite3_errmsg(db));
+            sqlite3_close(db);
+            return 1;
+        }
+    }
+    if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "无法开始事务：%s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    *db_to_return = db;
+    return 0;
+}
+
+/**
+ * @brief 提交批量写入的事务并关闭数据库
+ *
+ * @param db 数据库连接
+ * @return int 成功返回0，否则返回1
+ */
+static int end_bulk_load(sqlite3 *db)
+{
+    int rc = sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    if (rc != SQLITE_OK)
+    {
+        fprintf(stderr, "无法提交事务：%s\n", sqlite3_errmsg(db));
+    }
+    sqlite3_close(db);
+    return rc != SQLITE_OK;
+}
+
+/**
+ * @brief 执行一条绑定好参数的插入语句，并重置以便下一次绑定
+ *
+ * @param db 数据库连接
+ * @param stmt 插入语句
+ * @return int 成功返回0，否则返回1
+ */
+static int step_insert(sqlite3 *db, sqlite3_stmt *stmt)
+{
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE)
+    {
+        fprintf(stderr, "插入数据失败：%s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+    return 0;
+}
+
+/**************************** 批量写入部分结束 ****************************/
+
+/**************************** 数据生成部分开始 ****************************/
+
+/**
+ * @brief 生成教师和学生，写入 db/user.db
+ *
+ * @param options 生成参数
+ * @param student_ids_to_return 返回的学生ID数组，由调用者释放
+ * @param student_count_to_return 返回的学生数量
+ * @return int 成功返回0，否则返回1
+ */
+static int generate_users(const struct GeneratorOptions *options, char (**student_ids_to_return)[UUID_LENGTH], int *student_count_to_return)
+{
+    static const char *const schemas[] = {SCHEMA_USERS, NULL};
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+
+    // 先确定每位教师的学生数量，才能一次分配学生ID数组
+    int *students_per_teacher = (int *)malloc(sizeof(int) * (size_t)options->teachers);
+    if (students_per_teacher == NULL)
+    {
+        fprintf(stderr, "内存分配失败\n");
+        return 1;
+    }
+    int student_count = 0;
+    for (int t = 0; t < options->teachers; t++)
+    {
+        students_per_teacher[t] = random_range(options->students_min, options->students_max);
+        student_count += students_per_teacher[t];
+    }
+    char(*student_ids)[UUID_LENGTH] = malloc(sizeof(*student_ids) * (size_t)(student_count > 0 ? student_count : 1));
+    if (student_ids == NULL)
+    {
+        fprintf(stderr, "内存分配失败\n");
+        free(students_per_teacher);
+        return 1;
+    }
+
+    if (begin_bulk_load(USER_DB, schemas, &db) ||
+        sqlite3_prepare_v2(db, "INSERT INTO users (id, username, hashpass, salt, role, name, class_name, number, belong_to) "
+                               "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+                           -1, &stmt, NULL) != SQLITE_OK)
+    {
+        if (db != NULL)
+        {
+            fprintf(stderr, "准备插入语句失败：%s\n", sqlite3_errmsg(db));
+            sqlite3_close(db);
+        }
+        free(students_per_teacher);
+        free(student_ids);
+        return 1;
+    }
+
+    int rc = 0;
+    int student = 0;
+    for (int t = 0; t < options->teachers && rc == 0; t++)
+    {
+        char teacher_id[UUID_LENGTH];
+        char username[25];
+        char name[46];
+        char class_name[31];
+        generate_seeded_uuid7(teacher_id);
+        snprintf(username, sizeof(username), "t%04d", t);
+        snprintf(name, sizeof(name), "教师%04d", t);
+        snprintf(class_name, sizeof(class_name), "%d班", t + 1);
+
+        sqlite3_bind_text(stmt, 1, teacher_id, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, username, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, GENERATOR_HASHPASS, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, GENERATOR_SALT, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 5, 1);
+        sqlite3_bind_text(stmt, 6, name, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 7, "", -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 8, 10000 + t);
+        sqlite3_bind_text(stmt, 9, "", -1, SQLITE_STATIC);
+        rc = step_insert(db, stmt);
+
+        for (int s = 0; s < students_per_teacher[t] && rc == 0; s++, student++)
+        {
+            generate_seeded_uuid7(student_ids[student]);
+            snprintf(username, sizeof(username), "s%06d", student);
+            snprintf(name, sizeof(name), "学生%06d", student);
+            sqlite3_bind_text(stmt, 1, student_ids[student], -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, username, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 5, 0);
+            sqlite3_bind_text(stmt, 6, name, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 7, class_name, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 8, 20240000 + student);
+            sqlite3_bind_text(stmt, 9, teacher_id, -1, SQLITE_TRANSIENT);
+            rc = step_insert(db, stmt);
+        }
+    }
+    sqlite3_finalize(stmt);
+    rc |= end_bulk_load(db);
+    free(students_per_teacher);
+
+    if (rc)
+    {
+        free(student_ids);
+        return 1;
+    }
+    *student_ids_to_return = student_ids;
+    *student_count_to_return = student_count;
+    return 0;
+}
+
+/**
+ * @brief 生成考试和题目，写入 db/examination.db
+ *
+ * @param options 生成参数
+ * @param exam_ids 返回的考试ID数组，长度为 options->exams
+ * @param questions_per_exam 返回每场考试的题目数量，长度为 options->exams
+ * @param question_count_to_return 返回的题目数量
+ * @return int 成功返回0，否则返回1
+ */
+static int generate_exams(const struct GeneratorOptions *options, char (*exam_ids)[UUID_LENGTH], int *questions_per_exam,
+                          long long *question_count_to_return)
+{
+    static const char *const schemas[] = {SCHEMA_EXAMINATIONS, SCHEMA_QUESTIONS, NULL};
+    sqlite3 *db = NULL;
+    sqlite3_stmt *exam_stmt = NULL;
+    sqlite3_stmt *question_stmt = NULL;
+
+    if (begin_bulk_load(EXAMINATION_DB, schemas, &db))
+    {
+        return 1;
+    }
+    if (sqlite3_prepare_v2(db, "INSERT INTO examinations (id, name, start_time, end_time, allow_answer_when_expired, random_question) "
+                               "VALUES (?, ?, ?, ?, ?, ?);",
+                           -1, &exam_stmt, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "INSERT INTO questions (id, exam_id, num1, op, num2) VALUES (?, ?, ?, ?, ?);", -1, &question_stmt, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "准备插入语句失败：%s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(exam_stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    int rc = 0;
+    long long question_count = 0;
+    long long base_time = (long long)(GENERATOR_BASE_TIME_MS / 1000);
+    for (int e = 0; e < options->exams && rc == 0; e++)
+    {
+        char name[91];
+        long long start_time = base_time + (long long)e * GENERATOR_EXAM_SPAN_SECONDS / options->exams;
+        long long end_time = start_time + GENERATOR_EXAM_DURATION_SECONDS;
+        int allow_answer_when_expired = random_uniform() < 0.5;
+        int random_question = random_uniform() < 0.5;
+        if (options->active_exam && e == options->exams - 1)
+        {
+            // 正在进行的考试：一小时前开始，七天后结束，供压力测试提交答案
+            start_time = (long long)time(NULL) - 3600;
+            end_time = start_time + 3600 + 7 * 86400;
+            allow_answer_when_expired = 1;
+            random_question = 0;
+        }
+        generate_seeded_uuid7(exam_ids[e]);
+        snprintf(name, sizeof(name), "口算练习%04d", e + 1);
+
+        sqlite3_bind_text(exam_stmt, 1, exam_ids[e], -1, SQLITE_STATIC);
+        sqlite3_bind_text(exam_stmt, 2, name, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(exam_stmt, 3, start_time);
+        sqlite3_bind_int64(exam_stmt, 4, end_time);
+        sqlite3_bind_int(exam_stmt, 5, allow_answer_when_expired);
+        sqlite3_bind_int(exam_stmt, 6, random_question);
+        rc = step_insert(db, exam_stmt);
+
+        int questions = random_range(options->questions_min, options->questions_max);
+        questions_per_exam[e] = questions;
+        for (int q = 0; q < questions && rc == 0; q++)
+        {
+            char question_id[UUID_LENGTH];
+            int op = random_range(0, 3);
+            int num2 = random_range(1, 99); // 除数不能为0
+            int num1 = op == 3 ? num2 * random_range(0, 9) : random_range(0, 99); // 除法题目保证整除
+            generate_seeded_uuid7(question_id);
+            sqlite3_bind_text(question_stmt, 1, question_id, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(question_stmt, 2, exam_ids[e], -1, SQLITE_STATIC);
+            sqlite3_bind_int(question_stmt, 3, num1);
+            sqlite3_bind_int(question_stmt, 4, op);
+            sqlite3_bind_int(question_stmt, 5, num2);
+            rc = step_insert(db, question_stmt);
+            question_count++;
+        }
+    }
+    sqlite3_finalize(exam_stmt);
+    sqlite3_finalize(question_stmt);
+    rc |= end_bulk_load(db);
+    *question_count_to_return = question_count;
+    return rc;
+}
+
+/**
+ * @brief 生成成绩，写入 db/score.db
+ *
+ * @details 每名学生以 submission_rate 的概率参加每场考试，成绩服从截断到 [0, 100] 的正态分布。
+ *          开启 answer_logs 时同时生成答题记录：每道题有一个服从标准正态分布的难度 d，
+ *          学生由成绩的正态分布得到答对率 p，每道题以 1 / (1 + exp(d - logit(p))) 的概率答对，
+ *          成绩按答对的题目数量计算（与 calculate_score 相同），答题记录不打乱题目顺序
+ *
+ * @param options 生成参数
+ * @param exam_ids 考试ID数组
+ * @param questions_per_exam 每场考试的题目数量
+ * @param student_ids 学生ID数组
+ * @param student_count 学生数量
+ * @param score_count_to_return 返回的成绩数量
+ * @return int 成功返回0，否则返回1
+ */
+static int generate_scores(const struct GeneratorOptions *options, char (*exam_ids)[UUID_LENGTH], const int *questions_per_exam,
+                           char (*student_ids)[UUID_LENGTH], int student_count, long long *score_count_to_return)
+{
+    static const char *const schemas[] = {SCHEMA_SCORES, SCHEMA_EXAM_STATS, SCHEMA_EXAM_SCORE_HISTOGRAM,
+                                          SCHEMA_CLASS_MEMBERS, SCHEMA_CLASS_CUBE, SCHEMA_CLASS_CUBE_HISTOGRAM,
+                                          SCHEMA_ANSWER_LOG, SCHEMA_ANSWER_LOG_VERSIONS, NULL};
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_stmt *log_stmt = NULL;
+
+    if (begin_bulk_load(SCORES_DB, schemas, &db))
+    {
+        return 1;
+    }
+    if (sqlite3_prepare_v2(db, "INSERT INTO scores (id, exam_id, user_id, score, expired_flag) VALUES (?, ?, ?, ?, ?);",
+                           -1, &stmt, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "INSERT INTO answer_log (exam_id, score_id, user_id, record) VALUES (?, ?, ?, ?);",
+                           -1, &log_stmt, NULL) != SQLITE_OK)
+    {
+        fprintf(stderr, "准备插入语句失败：%s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return 1;
+    }
+
+    // 答题记录用的临时数组，题目数量不超过 ANSWER_LOG_MAX_QUESTIONS
+    double *difficulties = malloc(sizeof(double) * ANSWER_LOG_MAX_QUESTIONS);
+    float *distractors = malloc(sizeof(float) * ANSWER_LOG_MAX_QUESTIONS);
+    unsigned char *correct = malloc(ANSWER_LOG_MAX_QUESTIONS);
+    float *answers = malloc(sizeof(float) * ANSWER_LOG_MAX_QUESTIONS);
+    unsigned char *record = malloc(ANSWER_LOG_MAX_RECORD_SIZE);
+    int rc = difficulties == NULL || distractors == NULL || correct == NULL || answers == NULL || record == NULL;
+    if (rc)
+    {
+        fprintf(stderr, "内存分配失败\n");
+    }
+
+    long long score_count = 0;
+    for (int e = 0; e < options->exams && rc == 0; e++)
+    {
+        int questions = questions_per_exam[e] < ANSWER_LOG_MAX_QUESTIONS ? questions_per_exam[e] : ANSWER_LOG_MAX_QUESTIONS;
+        int with_log = options->answer_logs && questions > 0;
+        if (with_log)
+        {
+            for (int q = 0; q < questions; q++)
+            {
+                difficulties[q] = random_normal(0, 1);
+                // 正确答案都是整数，带 .5 的典型错误答案一定是错的
+                distractors[q] = (float)random_range(0, 99) + 0.5f;
+            }
+        }
+        for (int s = 0; s < student_count && rc == 0; s++)
+        {
+            if (random_uniform() >= options->submission_rate)
+            {
+                continue;
+            }
+            char score_id[UUID_LENGTH];
+            int score = (int)lround(random_normal(options->score_mean, options->score_stddev));
+            score = score < 0 ? 0 : (score > 100 ? 100 : score);
+            int length = 0;
+            if (with_log)
+            {
+                double p = score < 1 ? 0.01 : (score > 99 ? 0.99 : score / 100.0);
+                double ability = log(p / (1 - p));
+                int right = 0;
+                for (int q = 0; q < questions; q++)
+                {
+                    correct[q] = random_uniform() < 1 / (1 + exp(difficulties[q] - ability));
+                    right += correct[q];
+                    if (correct[q])
+                    {
+                        answers[q] = NAN;
+                    }
+                    else if (random_uniform() < GENERATOR_UNANSWERED_RATE)
+                    {
+                        answers[q] = NAN;
+                    }
+                    else
+                    {
+                        answers[q] = random_uniform() < GENERATOR_DISTRACTOR_RATE ? distractors[q] : (float)random_range(100, 199) + 0.5f;
+                    }
+                }
+                score = right * 100 / questions;
+                rc = answer_log_encode(0, questions, correct, answers, record, ANSWER_LOG_MAX_RECORD_SIZE, &length);
+            }
+            generate_seeded_uuid7(score_id);
+            sqlite3_bind_text(stmt, 1, score_id, -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, exam_ids[e], -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 3, student_ids[s], -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 4, score);
+            sqlite3_bind_int(stmt, 5, random_uniform() < options->expired_rate);
+            rc = rc || step_insert(db, stmt);
+            if (rc == 0 && with_log)
+            {
+                sqlite3_bind_text(log_stmt, 1, exam_ids[e], -1, SQLITE_STATIC);
+                sqlite3_bind_text(log_stmt, 2, score_id, -1, SQLITE_TRANSIENT);
+                sqlite3_bind_text(log_stmt, 3, student_ids[s], -1, SQLITE_STATIC);
+                sqlite3_bind_blob(log_stmt, 4, record, length, SQLITE_TRANSIENT);
+                rc = step_insert(db, log_stmt);
+            }
+            score_count++;
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_finalize(log_stmt);
+    free(difficulties);
+    free(distractors);
+    free(correct);
+    free(answers);
+    free(record);
+    // 索引和统计表在所有成绩写入之后一次性建立，之后的写入由触发器维护
+    if (rc == 0 && (sqlite3_exec(db, SCHEMA_SCORES_INDEXES, NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SQL_REBUILD_EXAM_STATS, NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SCHEMA_EXAM_STATS_TRIGGERS, NULL, NULL, NULL) != SQLITE_OK))
+    {
+        fprintf(stderr, "无法计算成绩统计：%s\n", sqlite3_errmsg(db));
+        rc = 1;
+    }
+    // 班级统计需要用户表中的班级，ATTACH 不能在事务中执行，所以先提交成绩再附加用户数据库
+    if (rc == 0 && (sqlite3_exec(db, "COMMIT; ATTACH DATABASE '" USER_DB "' AS user_db; BEGIN;", NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SQL_REBUILD_CLASS_CUBE, NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SCHEMA_CLASS_CUBE_TRIGGERS, NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SCHEMA_ANSWER_LOG_TRIGGERS, NULL, NULL, NULL) != SQLITE_OK ||
+                    sqlite3_exec(db, SCHEMA_ANSWER_LOG_VERSION_TRIGGERS, NULL, NULL, NULL) != SQLITE_OK))
+    {
+        fprintf(stderr, "无法计算班级统计：%s\n", sqlite3_errmsg(db));
+        rc = 1;
+    }
+    rc |= end_bulk_load(db);
+    *score_count_to_return = score_count;
+    return rc;
+}
+
+/**************************** 数据生成部分结束 ****************************/
+
+/**************************** 命令行部分开始 ****************************/
+
+/**
+ * @brief 打印用法
+ *
+ * @param program 程序名
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "用法: %s [选项]\n"
+            "  --dir DIR                       输出目录，不存在时创建，数据库写入 DIR/db，默认为当前目录\n"
+            "  --seed N                        随机种子，默认为 %llu\n"
+            "  --teachers N                    教师数量，默认为 %d\n"
+            "  --students-per-teacher N|MIN-MAX 每位教师的学生数量，默认为 %d\n"
+            "  --exams N                       考试数量，默认为 %d\n"
+            "  --questions-per-exam N|MIN-MAX  每场考试的题目数量，默认为 %d\n"
+            "  --submission-rate P             每名学生参加每场考试的概率，默认为 %g\n"
+            "  --score-mean M                  成绩的均值，默认为 %g\n"
+            "  --score-stddev S                成绩的标准差，默认为 %g\n"
+            "  --expired-rate P                逾期作答的比例，默认为 %g\n"
+            "  --active-exam                   把最后一场考试设为正在进行（一小时前开始，七天后结束）\n"
+            "  --answer-logs                   为每条成绩生成答题记录，成绩由答对的题目数量得到\n"
+            "  --force                         覆盖已经存在的数据库\n",
+            program, (unsigned long long)GENERATOR_DEFAULT_SEED, GENERATOR_DEFAULT_TEACHERS,
+            GENERATOR_DEFAULT_STUDENTS_PER_TEACHER, GENERATOR_DEFAULT_EXAMS, GENERATOR_DEFAULT_QUESTIONS_PER_EXAM,
+            GENERATOR_DEFAULT_SUBMISSION_RATE, GENERATOR_DEFAULT_SCORE_MEAN, GENERATOR_DEFAULT_SCORE_STDDEV,
+            GENERATOR_DEFAULT_EXPIRED_RATE);
+}
+
+/**
+ * @brief 解析 N 或 MIN-MAX 形式的范围参数
+ *
+ * @param text 参数文本
+ * @param min_to_return 返回的下界
+ * @param max_to_return 返回的上界
+ * @return int 成功返回0，否则返回1
+ */
+static int parse_range(const char *text, int *min_to_return, int *max_to_return)
+{
+    int low = 0;
+    int high = 0;
+    int matched = sscanf(text, "%d-%d", &low, &high);
+    if (matched == 1)
+    {
+        high = low;
+    }
+    if (matched < 1 || low < 0 || high < low)
+    {
+        return 1;
+    }
+    *min_to_return = low;
+    *max_to_return = high;
+    return 0;
+}
+
+/**
+ * @brief 删除已经存在的数据库文件及其日志文件
+ *
+ * @param path 数据库路径
+ */
+static void remove_database(const char *path)
+{
+    char buffer[300];
+    remove(path);
+    snprintf(buffer, sizeof(buffer), "%s-wal", path);
+    remove(buffer);
+    snprintf(buffer, sizeof(buffer), "%s-shm", path);
+    remove(buffer);
+    snprintf(buffer, sizeof(buffer), "%s-journal", path);
+    remove(buffer);
+}
+
+/**
+ * @brief 数据生成工具入口
+ *
+ * @return int 成功返回0，否则返回1
+ */
+int main(int argc, char **argv)
+{
+    struct GeneratorOptions options = {
+        ".",
+        GENERATOR_DEFAULT_SEED,
+        GENERATOR_DEFAULT_TEACHERS,
+        GENERATOR_DEFAULT_STUDENTS_PER_TEACHER,
+        GENERATOR_DEFAULT_STUDENTS_PER_TEACHER,
+        GENERATOR_DEFAULT_EXAMS,
+        GENERATOR_DEFAULT_QUESTIONS_PER_EXAM,
+        GENERATOR_DEFAULT_QUESTIONS_PER_EXAM,
+        GENERATOR_DEFAULT_SUBMISSION_RATE,
+        GENERATOR_DEFAULT_SCORE_MEAN,
+        GENERATOR_DEFAULT_SCORE_STDDEV,
+        GENERATOR_DEFAULT_EXPIRED_RATE,
+        0,
+        0,
+        0,
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int bad = 0;
+        if (strcmp(argv[i], "--active-exam") == 0)
+        {
+            options.active_exam = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--answer-logs") == 0)
+        {
+            options.answer_logs = 1;
+            continue;
+        }
+        if (strcmp(argv[i], "--force") == 0)
+        {
+            options.force = 1;
+            continue;
+        }
+        if (value == NULL)
+        {
+            bad = 1;
+        }
+        else if (strcmp(argv[i], "--dir") == 0)
+        {
+            options.dir = value;
+        }
+        else if (strcmp(argv[i], "--seed") == 0)
+        {
+            options.seed = strtoull(value, NULL, 10);
+        }
+        else if (strcmp(argv[i], "--teachers") == 0)
+        {
+            options.teachers = atoi(value);
+            bad = options.teachers < 0;
+        }
+        else if (strcmp(argv[i], "--students-per-teacher") == 0)
+        {
+            bad = parse_range(value, &options.students_min, &options.students_max);
+        }
+        else if (strcmp(argv[i], "--exams") == 0)
+        {
+            options.exams = atoi(value);
+            bad = options.exams < 0;
+        }
+        else if (strcmp(argv[i], "--questions-per-exam") == 0)
+        {
+            bad = parse_range(value, &options.questions_min, &options.questions_max);
+        }
+        else if (strcmp(argv[i], "--submission-rate") == 0)
+        {
+            options.submission_rate = atof(value);
+            bad = options.submission_rate < 0 || options.submission_rate > 1;
+        }
+        else if (strcmp(argv[i], "--score-mean") == 0)
+        {
+            options.score_mean = atof(value);
+        }
+        else if (strcmp(argv[i], "--score-stddev") == 0)
+        {
+            options.score_stddev = atof(value);
+            bad = options.score_stddev < 0;
+        }
+        else if (strcmp(argv[i], "--expired-rate") == 0)
+        {
+            options.expired_rate = atof(value);
+            bad = options.expired_rate < 0 || options.expired_rate > 1;
+        }
+        else
+        {
+            bad = 1;
+        }
+        if (bad)
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (access(options.dir, 0) != 0 && make_directory(options.dir) != 0)
+    {
+        fprintf(stderr, "无法创建输出目录 '%s'：%s\n", options.dir, strerror(errno));
+        return 1;
+    }
+    if (chdir(options.dir) != 0)
+    {
+        fprintf(stderr, "无法进入输出目录 '%s'：%s\n", options.dir, strerror(errno));
+        return 1;
+    }
+    if (access(DB_FOLDER, 0) != 0 && make_directory(DB_FOLDER) != 0)
+    {
+        fprintf(stderr, "无法创建文件夹 '%s'：%s\n", DB_FOLDER, strerror(errno));
+        return 1;
+    }
+    const char *databases[] = {USER_DB, EXAMINATION_DB, SCORES_DB};
+    for (int i = 0; i < 3; i++)
+    {
+        if (access(databases[i], 0) == 0)
+        {
+            if (!options.force)
+            {
+                fprintf(stderr, "数据库 '%s' 已经存在，使用 --force 覆盖\n", databases[i]);
+                return 1;
+            }
+            remove_database(databases[i]);
+        }
+    }
+
+    random_state = options.seed;
+    uuid_sequence = 0;
+
+    char(*exam_ids)[UUID_LENGTH] = malloc(sizeof(*exam_ids) * (size_t)(options.exams > 0 ? options.exams : 1));
+    int *questions_per_exam = malloc(sizeof(int) * (size_t)(options.exams > 0 ? options.exams : 1));
+    char(*student_ids)[UUID_LENGTH] = NULL;
+    int student_count = 0;
+    long long question_count = 0;
+    long long score_count = 0;
+    if (exam_ids == NULL || questions_per_exam == NULL)
+    {
+        fprintf(stderr, "内存分配失败\n");
+        free(exam_ids);
+        free(questions_per_exam);
+        return 1;
+    }
+
+    double start = now_seconds();
+    if (generate_users(&options, &student_ids, &student_count))
+    {
+        free(exam_ids);
+        free(questions_per_exam);
+        return 1;
+    }
+    double users_done = now_seconds();
+    fprintf(stderr, "用户：%d 位教师，%d 名学生，耗时 %.2f 秒\n", options.teachers, student_count, users_done - start);
+
+    if (generate_exams(&options, exam_ids, questions_per_exam, &question_count))
+    {
+        free(exam_ids);
+        free(questions_per_exam);
+        free(student_ids);
+        return 1;
+    }
+    double exams_done = now_seconds();
+    fprintf(stderr, "考试：%d 场考试，%lld 道题目，耗时 %.2f 秒\n", options.exams, question_count, exams_done - users_done);
+
+    if (generate_scores(&options, exam_ids, questions_per_exam, student_ids, student_count, &score_count))
+    {
+        free(exam_ids);
+        free(questions_per_exam);
+        free(student_ids);
+        return 1;
+    }
+    double scores_done = now_seconds();
+    fprintf(stderr, "成绩：%lld 条，耗时 %.2f 秒\n", score_count, scores_done - exams_done);
+    fprintf(stderr, "全部完成，共耗时 %.2f 秒，所有用户的密码都是 %s\n", scores_done - start, GENERATOR_PASSWORD);
+
+    if (options.active_exam && options.exams > 0)
+    {
+        // 标准输出只输出正在进行的考试ID，便于脚本读取
+        printf("%s\n", exam_ids[options.exams - 1]);
+    }
+
+    free(exam_ids);
+    free(questions_per_exam);
+    free(student_ids);
+    return 0;
+}
+
+/**************************** 命令行部分结束 ****************************/
@@ -25,27 +25,60 @@ History:        暂无
         Author: 吴沛熹
         ID: GamerNoTitle
         Modification: [*] 对 questions 数据库的 num1 和 num2 列重新采用int类型存储
+    4.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [*] io.h、direct.h 和 windows.h 只在 Windows 下引入，其他系统使用 unistd.h 和 sys/stat.h 中的 access、mkdir
+                      [*] 定义 INITIALIZER_NO_MAIN 时不编译调试用的 main，便于与其他程序（如基准测试）一起链接
+    5.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [*] 建表语句和数据库路径挪入 include/schema.h，与数据生成工具 utils/generator.c 共用
+    6.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 成绩数据库中同时建立成绩统计表 exam_stats、exam_score_histogram 以及维护它们的触发器
+    7.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 成绩数据库中同时建立 scores 表的排名索引和按用户查找的索引
+    8.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 成绩数据库中同时建立班级统计表 class_members、class_cube、class_cube_histogram 以及维护它们的触发器
+    9.  Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 成绩数据库中同时建立答题记录表 answer_log 以及同步它的触发器
+    10. Date:   2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification: [+] 成绩数据库中同时建立答题记录版本表 answer_log_versions 以及维护它的触发器
  */
 
 #include "../lib/sqlite3.h"
-#include <io.h>
-#include <direct.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#ifdef _WIN32
+#include <io.h>
+#include <direct.h>
 #include <windows.h>
-
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#define _access access                    // POSIX 下的同名函数没有下划线前缀
+#define _mkdir(path) mkdir((path), 0755) // POSIX 下的 mkdir 需要指定权限
+#endif
+
+#include "../include/schema.h" // 建表语句和数据库路径
 #include "../include/utils.h" // 引入自己写的头文件utils.h，来调用里面已经写好的一些trick函数
 
 /*** 文件读取等级 ***/
 #define ACCESS_EXIST_MODE 0 // 访问模式，0为是否存在，在_access函数中使用
 #define ACCESS_RW_MODE 6    // 访问模式，6代表是否有读写权限（读取为2，写入为4），在_access函数中使用
 
-/*** 数据库部分 ***/
-#define DB_FOLDER "db"                     // 数据库保存文件夹名
-#define EXAMINATION_DB "db/examination.db" // 考试数据库
-#define SCORES_DB "db/score.db"            // 成绩数据库
-#define USER_DB "db/user.db"               // 用户数据库
-
 /*** 日志部分 ***/
 #define LOG_FOLDER "logs"                  // 日志文件夹路径
 #define LOG_FILE "logs/initialization.log" // 日志文件路径
@@ -140,45 +173,24 @@ void initialize()
             fprintf(log_file, "%s [%s]: 文件夹 '%s' 创建成功。\n", current_time, LOGLEVEL_INFO, DB_FOLDER); // 创建成功的时候，写入日志
             fprintf(log_file, "%s [%s]: 正在尝试初始化数据库。\n", current_time, LOGLEVEL_INFO);
             fprintf(log_file, "%s [%s]: 正在初始化考试数据库。\n", current_time, LOGLEVEL_INFO);
-            char examination_init_command[] = "CREATE TABLE examinations(\n"
-                                              "id TEXT PRIMARY KEY   NOT NULL,\n"         // 考试ID，UUID，唯一键
-                                              "name TEXT             NOT NULL,\n"         // 考次名称
-                                              "start_time INTEGER        NOT NULL,\n"         // 考试的开始时间，时间戳
-                                              "end_time INTEGER          NOT NULL,\n"         // 考试的结束时间，时间戳
-                                              "allow_answer_when_expired INTEGER NOT NULL,\n" // 是否允许逾期作答
-                                              "random_question INTEGER   NOT NULL\n"          // 是否开启问题乱序
-                                              ");\n";
-            initialize_database(EXAMINATION_DB, examination_init_command, log_file);
-            char questions_init_command[] = "CREATE TABLE questions(\n"
-                                            "id TEXT PRIMARY KEY    NOT NULL,\n" // 问题ID，UUID，唯一键
-                                            "exam_id TEXT           NOT NULL,\n" // 问题作用的考试ID，对应上面考次的UUID
-                                            "num1 INTEGER           NOT NULL,\n"     // 第一个操作数字
-                                            "op INTEGER             NOT NULL,\n" // 运算符，0123对应加减乘除
-                                            "num2 INTEGER           NOT NULL\n"      // 第二个操作数字
-                                            ");\n";
-            initialize_database(EXAMINATION_DB, questions_init_command, log_file);
+            initialize_database(EXAMINATION_DB, SCHEMA_EXAMINATIONS, log_file);
+            initialize_database(EXAMINATION_DB, SCHEMA_QUESTIONS, log_file);
             fprintf(log_file, "%s [%s]: 正在初始化成绩数据库。\n", current_time, LOGLEVEL_INFO);
-            char scores_init_command[] = "CREATE TABLE scores(\n"
-                                         "id TEXT PRIMARY KEY    NOT NULL,\n" // 成绩ID，UUID，唯一键
-                                         "exam_id TEXT           NOT NULL,\n" // 考试ID，对应上面考次的UUID
-                                         "user_id TEXT           NOT NULL,\n" // 用户ID，成绩所对应的用户的UUID
-                                         "score INTEGER          NOT NULL,\n" // 成绩
-                                         "expired_flag INTEGER   NOT NULL\n"  // 是否逾期作答，01分别代表否、是
-                                         ");\n";
-            initialize_database(SCORES_DB, scores_init_command, log_file);
+            initialize_database(SCORES_DB, SCHEMA_SCORES, log_file);
+            initialize_database(SCORES_DB, SCHEMA_SCORES_INDEXES, log_file);
+            initialize_database(SCORES_DB, SCHEMA_EXAM_STATS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_EXAM_SCORE_HISTOGRAM, log_file);
+            initialize_database(SCORES_DB, SCHEMA_EXAM_STATS_TRIGGERS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_CLASS_MEMBERS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_CLASS_CUBE, log_file);
+            initialize_database(SCORES_DB, SCHEMA_CLASS_CUBE_HISTOGRAM, log_file);
+            initialize_database(SCORES_DB, SCHEMA_CLASS_CUBE_TRIGGERS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_ANSWER_LOG, log_file);
+            initialize_database(SCORES_DB, SCHEMA_ANSWER_LOG_TRIGGERS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_ANSWER_LOG_VERSIONS, log_file);
+            initialize_database(SCORES_DB, SCHEMA_ANSWER_LOG_VERSION_TRIGGERS, log_file);
             fprintf(log_file, "%s [%s]: 正在初始化用户数据库。\n", current_time, LOGLEVEL_INFO);
-            char users_init_command[] = "CREATE TABLE users(\n"
-                                        "id TEXT PRIMARY KEY        NOT NULL,\n" // 用户ID，UUID，唯一键
-                                        "username TEXT              NOT NULL,\n" // 用户名，范围为[a-zA-Z0-9]{3, 24}
-                                        "hashpass TEXT              NOT NULL,\n" // 哈希后的密码
-                                        "salt TEXT                  NOT NULL,\n" // 盐
-                                        "role INTEGER               NOT NULL,\n" // 用户角色
-                                        "name TEXT                  NOT NULL,\n" // 用户姓名
-                                        "class_name TEXT,\n"                     // 用户班级
-                                        "number INTEGER             NOT NULL,\n" // 用户学号/工号
-                                        "belong_to TEXT\n"                       // (仅学生) 属于哪一位老师，填入老师的UUID
-                                        ");\n";
-            initialize_database(USER_DB, users_init_command, log_file);
+            initialize_database(USER_DB, SCHEMA_USERS, log_file);
         }
         else
         {
@@ -205,9 +217,13 @@ void initialize()
  *
  * @return int 程序运行结束状态
  */
+#ifndef INITIALIZER_NO_MAIN
 int main()
 {
+#ifdef _WIN32
     SetConsoleOutputCP(65001);
+#endif
     initialize();
     return 0;
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,392 @@
+"""
+@file loadtest.py
+@brief 考试日的端到端压力测试，只使用 Python 标准库，可以完全离线运行
+
+@details 模拟一场考试的流量：
+         1. 学生和教师通过 /api/v1/general/login 登录
+         2. 学生获取考试信息（getExamInfo）和考卷（getExamData）
+         3. 所有学生在同一时刻（模拟考试的 end_time）集中提交答卷（examSubmit）
+         4. 提交期间教师不断轮询考试成绩（getExamScores）
+         按路由统计吞吐量、p50/p99/p999 延迟和错误率，可以与保存的基线比较，退化超过容差时以非0状态退出。
+
+         使用方法：
+         1. 编译 C 核心（build.sh）和数据生成工具（utils/generator.c），把动态库放到工作目录中
+         2. 在工作目录中生成数据：generator --dir WORKDIR --active-exam
+         3. python utils/loadtest.py --workdir WORKDIR --output result.json --save-baseline baseline.json
+         4. 之后每次修改都运行 python utils/loadtest.py --workdir WORKDIR --baseline baseline.json
+"""
+
+import argparse
+import http.client
+import json
+import math
+import os
+import sqlite3
+import subprocess
+import sys
+import threading
+import time
+import urllib.parse
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+APP_SCRIPT = os.path.join(REPO_ROOT, "ui", "app.py")
+
+PASSWORD = "00000000"  # utils/generator.c 生成的所有用户的密码
+OPERATORS = {0: lambda a, b: a + b, 1: lambda a, b: a - b, 2: lambda a, b: a * b, 3: lambda a, b: a / b}
+
+
+class Recorder:
+    """
+    @brief 线程安全地记录每个请求的路由、延迟和是否出错
+    """
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.samples = {}  # 路由 -> [(完成时间, 延迟秒数, 是否出错)]
+
+    def add(self, route: str, finished: float, latency: float, failed: bool) -> None:
+        with self.lock:
+            self.samples.setdefault(route, []).append((finished, latency, failed))
+
+
+class Client:
+    """
+    @brief 一个虚拟用户，保存自己的登录凭据，每个请求使用一个新的连接（与开发服务器的 HTTP/1.0 行为一致）
+    """
+
+    def __init__(self, base_url: str, recorder: Recorder, timeout: float):
+        parsed = urllib.parse.urlparse(base_url)
+        self.host = parsed.hostname
+        self.port = parsed.port or 80
+        self.recorder = recorder
+        self.timeout = timeout
+        self.token = None
+
+    def request(self, route: str, method: str, path: str, body: dict = None, expect_success: bool = True):
+        """
+        @brief 发送一个请求并记录延迟
+
+        @param route 统计用的路由名，不含具体的 UUID
+        @param method HTTP 方法
+        @param path 请求路径
+        @param body JSON 请求体
+        @param expect_success 响应是否应当包含 "success": true，为 False 时只检查状态码
+
+        @return dict | None 解析后的 JSON 响应，失败时返回 None
+        """
+        headers = {"Content-Type": "application/json"}
+        if self.token:
+            headers["Cookie"] = f"token={self.token}"
+        payload = json.dumps(body).encode() if body is not None else None
+        start = time.perf_counter()
+        failed = True
+        data = None
+        try:
+            connection = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+            connection.request(method, path, body=payload, headers=headers)
+            response = connection.getresponse()
+            raw = response.read()
+            for header, value in response.getheaders():
+                if header.lower() == "set-cookie" and value.startswith("token="):
+                    self.token = value.split(";", 1)[0][len("token="):]
+            connection.close()
+            if response.status in (200, 304):
+                data = json.loads(raw) if raw else {}
+                failed = expect_success and not data.get("success", False)
+        except (OSError, http.client.HTTPException, ValueError):
+            data = None
+        finished = time.perf_counter()
+        self.recorder.add(route, finished, finished - start, failed)
+        return None if failed else data
+
+
+def load_scenario_data(db_dir: str, students: int, teachers: int) -> tuple:
+    """
+    @brief 从合成数据库中挑选参加压力测试的考试、学生和教师
+
+    @details 考试取当前正在进行的考试（生成数据时使用 --active-exam），学生只挑选还没有提交过这场考试的，
+             这样同一份数据可以连续运行多次
+
+    @return tuple (考试ID, 学生用户名列表, 教师用户名列表)
+    """
+    now = int(time.time())
+    with sqlite3.connect(f"file:{os.path.join(db_dir, 'examination.db')}?mode=ro", uri=True) as connection:
+        row = connection.execute(
+            "SELECT id FROM examinations WHERE start_time <= ? AND end_time > ? ORDER BY start_time DESC LIMIT 1;",
+            (now, now),
+        ).fetchone()
+    if row is None:
+        raise SystemExit("没有正在进行的考试，请使用 generator --active-exam 重新生成数据")
+    exam_id = row[0]
+
+    with sqlite3.connect(f"file:{os.path.join(db_dir, 'score.db')}?mode=ro", uri=True) as connection:
+        submitted = {r[0] for r in connection.execute("SELECT user_id FROM scores WHERE exam_id = ?;", (exam_id,))}
+    with sqlite3.connect(f"file:{os.path.join(db_dir, 'user.db')}?mode=ro", uri=True) as connection:
+        student_rows = connection.execute("SELECT id, username FROM users WHERE role = 0 ORDER BY number;").fetchall()
+        teacher_rows = connection.execute("SELECT username FROM users WHERE role = 1 ORDER BY number LIMIT ?;", (teachers,)).fetchall()
+    student_names = [username for user_id, username in student_rows if user_id not in submitted][:students]
+    if len(student_names) < students:
+        raise SystemExit(f"只有 {len(student_names)} 名学生还没有提交这场考试，请重新生成数据或减少 --students")
+    return exam_id, student_names, [r[0] for r in teacher_rows]
+
+
+def solve(question: dict) -> float:
+    """
+    @brief 计算一道题的正确答案，与 C 核心的 calculate_result 一致（除法保留两位小数）
+    """
+    result = OPERATORS[question["op"]](question["num1"], question["num2"])
+    return round(result, 2)
+
+
+def run_in_threads(target, items: list, concurrency: int) -> None:
+    """
+    @brief 用固定数量的线程处理 items 中的每一项
+    """
+    lock = threading.Lock()
+    iterator = iter(items)
+
+    def worker():
+        while True:
+            with lock:
+                item = next(iterator, None)
+            if item is None:
+                return
+            target(item)
+
+    threads = [threading.Thread(target=worker) for _ in range(min(concurrency, len(items)))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+
+def run_scenario(args, base_url: str, recorder: Recorder) -> float:
+    """
+    @brief 运行一次考试日场景
+
+    @return float 场景的总耗时（秒）
+    """
+    exam_id, student_names, teacher_names = load_scenario_data(
+        os.path.join(args.workdir, "db"), args.students, args.teachers
+    )
+    students = {name: Client(base_url, recorder, args.timeout) for name in student_names}
+    teachers = {name: Client(base_url, recorder, args.timeout) for name in teacher_names}
+    papers = {}
+    scenario_start = time.perf_counter()
+
+    # 第一阶段：所有人登录
+    def login(item):
+        name, client = item
+        client.request("login", "POST", "/api/v1/general/login", {"username": name, "password": PASSWORD})
+
+    run_in_threads(login, list(students.items()) + list(teachers.items()), args.concurrency)
+
+    # 第二阶段：学生获取考试信息和考卷，并算好答案
+    def fetch_paper(item):
+        name, client = item
+        client.request("getExamInfo", "GET", "/api/v1/student/getExamInfo")
+        paper = client.request("getExamData", "GET", f"/api/v1/student/getExamData/{exam_id}")
+        if paper is not None:
+            answers = [solve(question) for question in paper.get("data", [])]
+            if answers and args.wrong_rate > 0:
+                # 按题号而不是随机数决定答错哪些题，结果可以复现
+                for index in range(0, len(answers), max(1, int(1 / args.wrong_rate))):
+                    answers[index] += 1
+            papers[name] = (answers, paper.get("metadata", {}).get("seed", 0))
+
+    run_in_threads(fetch_paper, list(students.items()), args.concurrency)
+
+    # 第三阶段：模拟 end_time 时刻的集中交卷，同时教师轮询成绩
+    submitting = [name for name in student_names if name in papers]
+    barrier = threading.Barrier(len(submitting) + 1) if submitting else None
+    burst_done = threading.Event()
+
+    def submit(name):
+        answers, seed = papers[name]
+        barrier.wait()
+        students[name].request(
+            "examSubmit", "POST", "/api/v1/student/examSubmit", {"id": exam_id, "answers": answers, "seed": seed}
+        )
+
+    def poll(client):
+        while not burst_done.is_set():
+            client.request("getExamScores", "GET", f"/api/v1/teacher/getExamScores/{exam_id}")
+            burst_done.wait(args.poll_interval)
+
+    pollers = [threading.Thread(target=poll, args=(client,)) for client in teachers.values()]
+    submitters = [threading.Thread(target=submit, args=(name,)) for name in submitting]
+    for thread in pollers + submitters:
+        thread.start()
+    if barrier is not None:
+        time.sleep(args.burst_delay)  # 让教师先轮询一会儿，然后所有学生同时交卷
+        barrier.wait()
+    for thread in submitters:
+        thread.join()
+    burst_done.set()
+    for thread in pollers:
+        thread.join()
+
+    return time.perf_counter() - scenario_start
+
+
+def percentile(sorted_values: list, quantile: float) -> float:
+    """
+    @brief 最近秩法取分位数
+    """
+    if not sorted_values:
+        return 0.0
+    rank = max(1, math.ceil(quantile * len(sorted_values)))
+    return sorted_values[min(rank, len(sorted_values)) - 1]
+
+
+def summarize(recorder: Recorder, duration: float) -> dict:
+    """
+    @brief 按路由汇总吞吐量、延迟分位数和错误率
+
+    @details 每个路由的吞吐量为请求数除以该路由第一个到最后一个请求完成的时间跨度，
+             集中交卷这种短时间的突发流量也能得到有意义的数值
+    """
+    routes = {}
+    for route, samples in sorted(recorder.samples.items()):
+        latencies = sorted(latency for _, latency, _ in samples)
+        errors = sum(1 for _, _, failed in samples if failed)
+        finished = [finished for finished, _, _ in samples]
+        window = max(finished) - min(finished) + latencies[0] if len(samples) > 1 else latencies[0]
+        routes[route] = {
+            "requests": len(samples),
+            "errors": errors,
+            "error_rate": errors / len(samples),
+            "throughput_rps": len(samples) / window if window > 0 else 0.0,
+            "p50_ms": percentile(latencies, 0.50) * 1000,
+            "p99_ms": percentile(latencies, 0.99) * 1000,
+            "p999_ms": percentile(latencies, 0.999) * 1000,
+            "max_ms": latencies[-1] * 1000,
+        }
+    total = sum(route["requests"] for route in routes.values())
+    return {
+        "duration_s": duration,
+        "requests": total,
+        "throughput_rps": total / duration if duration > 0 else 0.0,
+        "routes": routes,
+    }
+
+
+def compare_with_baseline(result: dict, baseline: dict, tolerance: float, error_tolerance: float) -> list:
+    """
+    @brief 与基线比较，返回退化项的说明列表，列表为空表示没有退化
+
+    @details 延迟（p50/p99）不能超过基线的 (1 + tolerance) 倍，吞吐量不能低于基线的 (1 - tolerance) 倍，
+             错误率不能比基线高出 error_tolerance 以上。p999 样本太少、波动太大，只输出不比较
+    """
+    regressions = []
+    for route, base in baseline.get("routes", {}).items():
+        current = result["routes"].get(route)
+        if current is None:
+            regressions.append(f"{route}: 本次运行没有请求")
+            continue
+        for key in ("p50_ms", "p99_ms"):
+            if current[key] > base[key] * (1 + tolerance):
+                regressions.append(f"{route}: {key} {current[key]:.2f} > 基线 {base[key]:.2f} × {1 + tolerance:g}")
+        if current["throughput_rps"] < base["throughput_rps"] * (1 - tolerance):
+            regressions.append(
+                f"{route}: throughput_rps {current['throughput_rps']:.1f} < 基线 {base['throughput_rps']:.1f} × {1 - tolerance:g}"
+            )
+        if current["error_rate"] > base["error_rate"] + error_tolerance:
+            regressions.append(f"{route}: error_rate {current['error_rate']:.3%} > 基线 {base['error_rate']:.3%} + {error_tolerance:.1%}")
+    return regressions
+
+
+def start_server(args) -> subprocess.Popen:
+    """
+    @brief 在工作目录中启动 Flask 服务器，等待它可以接受请求
+
+    @details 服务器从工作目录加载动态库和 db 文件夹，关闭自动打开浏览器和自动重载
+    """
+    log = open(os.path.join(args.workdir, "loadtest_server.log"), "w")
+    server = subprocess.Popen(
+        [sys.executable, APP_SCRIPT, "--host", "127.0.0.1", "--port", str(args.port), "--no-browser", "--no-reload"],
+        cwd=args.workdir,
+        stdout=log,
+        stderr=subprocess.STDOUT,
+    )
+    deadline = time.time() + args.startup_timeout
+    while time.time() < deadline:
+        if server.poll() is not None:
+            raise SystemExit(f"服务器启动失败，详见 {log.name}")
+        try:
+            connection = http.client.HTTPConnection("127.0.0.1", args.port, timeout=1)
+            connection.request("GET", "/login")
+            connection.getresponse().read()
+            connection.close()
+            return server
+        except OSError:
+            time.sleep(0.2)
+    server.terminate()
+    raise SystemExit(f"服务器在 {args.startup_timeout} 秒内没有启动，详见 {log.name}")
+
+
+def print_report(result: dict) -> None:
+    print(f"总计 {result['requests']} 个请求，耗时 {result['duration_s']:.2f} 秒，{result['throughput_rps']:.1f} req/s")
+    print(f"{'路由':<16}{'请求数':>8}{'错误率':>9}{'req/s':>10}{'p50 ms':>10}{'p99 ms':>10}{'p999 ms':>10}")
+    for route, stats in result["routes"].items():
+        print(
+            f"{route:<16}{stats['requests']:>8}{stats['error_rate']:>9.2%}{stats['throughput_rps']:>10.1f}"
+            f"{stats['p50_ms']:>10.2f}{stats['p99_ms']:>10.2f}{stats['p999_ms']:>10.2f}"
+        )
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="考试日场景的端到端压力测试")
+    parser.add_argument("--workdir", required=True, help="包含动态库和 db 文件夹的工作目录（由 generator --active-exam 生成数据）")
+    parser.add_argument("--base-url", help="已经在运行的服务器地址，不指定时在工作目录中自动启动服务器")
+    parser.add_argument("--port", type=int, default=5055, help="自动启动服务器时使用的端口 (默认: 5055)")
+    parser.add_argument("--students", type=int, default=200, help="参加考试的学生数量 (默认: 200)")
+    parser.add_argument("--teachers", type=int, default=5, help="轮询成绩的教师数量 (默认: 5)")
+    parser.add_argument("--concurrency", type=int, default=32, help="登录和获取考卷阶段的并发数 (默认: 32)")
+    parser.add_argument("--wrong-rate", type=float, default=0.1, help="学生答错的题目比例 (默认: 0.1)")
+    parser.add_argument("--poll-interval", type=float, default=0.2, help="教师轮询成绩的间隔秒数 (默认: 0.2)")
+    parser.add_argument("--burst-delay", type=float, default=1.0, help="集中交卷前教师先轮询的秒数 (默认: 1.0)")
+    parser.add_argument("--timeout", type=float, default=30.0, help="单个请求的超时秒数 (默认: 30)")
+    parser.add_argument("--startup-timeout", type=float, default=30.0, help="等待服务器启动的秒数 (默认: 30)")
+    parser.add_argument("--output", help="把结果保存为 JSON 文件")
+    parser.add_argument("--baseline", help="与之比较的基线 JSON 文件，退化时以状态 1 退出")
+    parser.add_argument("--save-baseline", help="把本次结果保存为基线")
+    parser.add_argument("--tolerance", type=float, default=0.25, help="延迟和吞吐量允许的相对退化 (默认: 0.25)")
+    parser.add_argument("--error-tolerance", type=float, default=0.01, help="错误率允许的绝对增加 (默认: 0.01)")
+    args = parser.parse_args()
+    args.workdir = os.path.abspath(args.workdir)
+
+    server = None
+    base_url = args.base_url
+    if base_url is None:
+        server = start_server(args)
+        base_url = f"http://127.0.0.1:{args.port}"
+    try:
+        recorder = Recorder()
+        duration = run_scenario(args, base_url, recorder)
+    finally:
+        if server is not None:
+            server.terminate()
+            server.wait()
+
+    result = summarize(recorder, duration)
+    print_report(result)
+    for path in (args.output, args.save_baseline):
+        if path:
+            with open(path, "w", encoding="utf-8") as file:
+                json.dump(result, file, ensure_ascii=False, indent=2)
+
+    if args.baseline:
+        with open(args.baseline, encoding="utf-8") as file:
+            regressions = compare_with_baseline(result, json.load(file), args.tolerance, args.error_tolerance)
+        if regressions:
+            print("与基线相比出现退化：")
+            for line in regressions:
+                print(f"  {line}")
+            return 1
+        print("没有超过基线容差的退化")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
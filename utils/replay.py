@@ -0,0 +1,316 @@
+"""
+@file replay.py
+@brief 重放 ui/app.py --trace 录制的请求跟踪，并比较两次运行的延迟分布，只使用 Python 标准库
+
+@details 用法：
+         1. 录制：python ui/app.py --trace exam_day.trace（新建跟踪文件时数据库快照保存在 exam_day.trace.snapshot）
+         2. 重放：python utils/replay.py run --trace exam_day.trace --workdir WORKDIR --output new.json
+            WORKDIR 中需要有新版本编译出的动态库，重放会把快照复制到 WORKDIR/db 并在其中启动服务器。
+            --speed 1 按录制时的节奏发送请求，--speed 0 尽可能快地发送，同一用户的请求始终按原来的顺序依次发送
+         3. 比较：python utils/replay.py diff old.json new.json，old 和 new 也可以直接是跟踪文件（服务器端的耗时和 C 调用次数）
+
+         跟踪文件中的用户名、密码等字段已经匿名化。重放时在快照的副本里把所有用户的密码重置为同一个已知密码，
+         登录请求按记录的用户ID找回用户名后重新登录，其余请求使用该用户最近一次登录得到的凭据
+"""
+
+import argparse
+import hashlib
+import http.client
+import importlib.util
+import json
+import os
+import shutil
+import sqlite3
+import sys
+import threading
+import time
+from types import SimpleNamespace
+
+from loadtest import percentile, start_server
+
+REPO_ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# 直接按路径加载 ui/utils/trace.py，不经过 ui/utils/__init__.py（它会加载 C 核心的动态库）
+_spec = importlib.util.spec_from_file_location("request_trace", os.path.join(REPO_ROOT, "ui", "utils", "trace.py"))
+request_trace = importlib.util.module_from_spec(_spec)
+_spec.loader.exec_module(request_trace)
+
+REPLAY_PASSWORD = "Replay00"  # 重放时所有用户的密码
+REPLAY_SALT = "MentalReplay0000"  # 重放时所有用户的盐
+LOGIN_PATH = "/api/v1/general/login"
+
+
+def prepare_database(snapshot_dir: str, workdir: str, force: bool) -> dict:
+    """
+    @brief 把快照复制到 workdir/db，并把所有用户的密码重置为 REPLAY_PASSWORD
+
+    @return dict 用户ID -> 用户名
+    """
+    db_dir = os.path.join(workdir, "db")
+    if os.path.exists(db_dir):
+        if not force:
+            raise SystemExit(f"{db_dir} 已经存在，使用 --force 覆盖")
+        shutil.rmtree(db_dir)
+    shutil.copytree(snapshot_dir, db_dir)
+
+    hashpass = hashlib.sha512((REPLAY_SALT + REPLAY_PASSWORD).encode()).hexdigest()
+    with sqlite3.connect(os.path.join(db_dir, "user.db")) as connection:
+        connection.execute("UPDATE users SET salt = ?, hashpass = ?;", (REPLAY_SALT, hashpass))
+        return dict(connection.execute("SELECT id, username FROM users;").fetchall())
+
+
+class ReplayClient:
+    """
+    @brief 一个用户的会话，保存该用户最近一次登录得到的凭据
+    """
+
+    def __init__(self, host: str, port: int, timeout: float):
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self.token = None
+
+    def send(self, method: str, path: str, body: bytes):
+        """
+        @return tuple (状态码, 耗时秒数)，连接失败时状态码为0
+        """
+        headers = {"Content-Type": "application/json"} if body else {}
+        if self.token:
+            headers["Cookie"] = f"token={self.token}"
+        start = time.perf_counter()
+        status = 0
+        try:
+            connection = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+            connection.request(method, path, body=body or None, headers=headers)
+            response = connection.getresponse()
+            response.read()
+            status = response.status
+            for header, value in response.getheaders():
+                if header.lower() == "set-cookie" and value.startswith("token="):
+                    self.token = value.split(";", 1)[0][len("token="):]
+            connection.close()
+        except (OSError, http.client.HTTPException):
+            pass
+        return status, time.perf_counter() - start
+
+    def login(self, username: str):
+        body = json.dumps({"username": username, "password": REPLAY_PASSWORD}).encode()
+        return self.send("POST", LOGIN_PATH, body)
+
+
+def replay(sessions: list, usernames: dict, args) -> tuple:
+    """
+    @brief 重放所有会话，会话之间依次进行，会话内部按用户分组并发
+
+    @return tuple (每个路由的样本 {路由: [(延迟秒数, 状态码是否与录制时一致)]}, 跳过的请求数, 最大的发送延后秒数)
+    """
+    samples = {}
+    lock = threading.Lock()
+    skipped = 0
+    max_lag = 0.0
+
+    for session in sessions:
+        groups = {}
+        for record in session["requests"]:
+            if record["flags"] & request_trace.FLAG_BODY_OMITTED:
+                skipped += 1
+                continue
+            groups.setdefault(record["user_id"], []).append(record)
+        queue = sorted(groups.items(), key=lambda item: item[1][0]["offset_us"])
+        queue_lock = threading.Lock()
+        session_start = time.perf_counter()
+
+        def worker():
+            nonlocal max_lag
+            while True:
+                with queue_lock:
+                    if not queue:
+                        return
+                    user_id, records = queue.pop(0)
+                client = ReplayClient("127.0.0.1", args.port, args.timeout)
+                username = usernames.get(user_id)
+                for record in records:
+                    if args.speed > 0:
+                        due = session_start + record["offset_us"] / 1e6 / args.speed
+                        delay = due - time.perf_counter()
+                        if delay > 0:
+                            time.sleep(delay)
+                        else:
+                            with lock:
+                                max_lag = max(max_lag, -delay)
+                    if record["path"] == LOGIN_PATH and username is not None:
+                        status, latency = client.login(username)
+                    else:
+                        if user_id and client.token is None and username is not None:
+                            client.login(username)  # 录制开始前已经登录的用户，先补一次登录，不计入统计
+                        status, latency = client.send(record["method"], record["path"], record["body"])
+                    key = f"{record['method']} {record['rule']}"
+                    with lock:
+                        samples.setdefault(key, []).append((latency, status == record["status"]))
+
+        threads = [threading.Thread(target=worker) for _ in range(min(args.concurrency, len(queue)))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+    return samples, skipped, max_lag
+
+
+def summarize_latencies(latencies_ms: list) -> dict:
+    ordered = sorted(latencies_ms)
+    return {
+        "requests": len(ordered),
+        "mean_ms": sum(ordered) / len(ordered) if ordered else 0.0,
+        "p50_ms": percentile(ordered, 0.50),
+        "p90_ms": percentile(ordered, 0.90),
+        "p99_ms": percentile(ordered, 0.99),
+        "p999_ms": percentile(ordered, 0.999),
+        "max_ms": ordered[-1] if ordered else 0.0,
+    }
+
+
+def command_run(args) -> int:
+    args.workdir = os.path.abspath(args.workdir)
+    snapshot_dir = args.snapshot or args.trace + ".snapshot"
+    if not os.path.isdir(snapshot_dir):
+        raise SystemExit(f"找不到数据库快照 {snapshot_dir}，请用 --snapshot 指定")
+    sessions = request_trace.read_trace(args.trace)
+    usernames = prepare_database(snapshot_dir, args.workdir, args.force)
+
+    server = start_server(SimpleNamespace(workdir=args.workdir, port=args.port, startup_timeout=args.startup_timeout))
+    started = time.perf_counter()
+    try:
+        samples, skipped, max_lag = replay(sessions, usernames, args)
+    finally:
+        server.terminate()
+        server.wait()
+    duration = time.perf_counter() - started
+
+    routes = {}
+    for key, items in sorted(samples.items()):
+        latencies = [latency * 1000 for latency, _ in items]
+        routes[key] = summarize_latencies(latencies)
+        routes[key]["status_mismatches"] = sum(1 for _, matched in items if not matched)
+        routes[key]["latencies_ms"] = latencies
+    result = {
+        "trace": os.path.abspath(args.trace),
+        "speed": args.speed,
+        "duration_s": duration,
+        "skipped": skipped,
+        "max_lag_s": max_lag,
+        "routes": routes,
+    }
+
+    print(f"重放 {sum(r['requests'] for r in routes.values())} 个请求，跳过 {skipped} 个，耗时 {duration:.2f} 秒")
+    if args.speed > 0:
+        print(f"最多比录制时的节奏延后 {max_lag * 1000:.1f} 毫秒发送")
+    for key, stats in routes.items():
+        print(
+            f"  {key:<60}{stats['requests']:>7}  p50 {stats['p50_ms']:8.2f}  p99 {stats['p99_ms']:8.2f}  "
+            f"状态不一致 {stats['status_mismatches']}"
+        )
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as file:
+            json.dump(result, file, ensure_ascii=False)
+    return 0
+
+
+def load_distributions(path: str) -> dict:
+    """
+    @brief 读取一次运行的延迟分布，可以是重放结果（客户端测得的延迟）或跟踪文件（服务器端的耗时）
+
+    @return dict 路由 -> {"latencies_ms": [...], "c_calls": [...] 或 None}
+    """
+    if request_trace.is_trace_file(path):
+        routes = {}
+        for session in request_trace.read_trace(path):
+            for record in session["requests"]:
+                entry = routes.setdefault(f"{record['method']} {record['rule']}", {"latencies_ms": [], "c_calls": []})
+                entry["latencies_ms"].append(record["duration_us"] / 1000)
+                entry["c_calls"].append(record["c_calls"])
+        return routes
+    with open(path, encoding="utf-8") as file:
+        result = json.load(file)
+    return {key: {"latencies_ms": stats["latencies_ms"], "c_calls": None} for key, stats in result["routes"].items()}
+
+
+def ks_statistic(a: list, b: list) -> float:
+    """
+    @brief 两个样本的 Kolmogorov-Smirnov 统计量，即两条经验分布函数之间的最大距离，0 表示分布相同，1 表示完全不重叠
+    """
+    a = sorted(a)
+    b = sorted(b)
+    i = j = 0
+    distance = 0.0
+    while i < len(a) and j < len(b):
+        value = min(a[i], b[j])
+        while i < len(a) and a[i] <= value:
+            i += 1
+        while j < len(b) and b[j] <= value:
+            j += 1
+        distance = max(distance, abs(i / len(a) - j / len(b)))
+    return distance
+
+
+def command_diff(args) -> int:
+    old = load_distributions(args.old)
+    new = load_distributions(args.new)
+    regressions = []
+    print(f"{'路由':<56}{'样本':>12}{'p50 ms':>20}{'p99 ms':>20}{'KS':>7}{'C 调用':>14}")
+    for key in sorted(set(old) | set(new)):
+        if key not in old or key not in new:
+            print(f"{key:<56}  只出现在{'新' if key in new else '旧'}的运行中")
+            continue
+        a = sorted(old[key]["latencies_ms"])
+        b = sorted(new[key]["latencies_ms"])
+        p50 = (percentile(a, 0.5), percentile(b, 0.5))
+        p99 = (percentile(a, 0.99), percentile(b, 0.99))
+        ks = ks_statistic(a, b)
+        calls = ""
+        if old[key]["c_calls"] is not None and new[key]["c_calls"] is not None:
+            calls = f"{sum(old[key]['c_calls']) / len(a):.1f}→{sum(new[key]['c_calls']) / len(b):.1f}"
+        print(
+            f"{key:<56}{len(a):>6}/{len(b):<5}{p50[0]:>9.2f}→{p50[1]:<9.2f}{p99[0]:>9.2f}→{p99[1]:<9.2f}{ks:>7.3f}{calls:>14}"
+        )
+        # 样本太少时分位数和 KS 统计量都不可靠，不参与判断
+        if args.max_ratio is not None and min(len(a), len(b)) >= args.min_samples:
+            for name, (before, after) in (("p50", p50), ("p99", p99)):
+                if before > 0 and after / before > args.max_ratio:
+                    regressions.append(f"{key}: {name} {before:.2f} → {after:.2f} ms")
+    if regressions:
+        print("延迟退化超过允许的倍数：")
+        for line in regressions:
+            print(f"  {line}")
+        return 1
+    return 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="重放请求跟踪并比较延迟分布")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+
+    run = subparsers.add_parser("run", help="在新版本上重放跟踪文件")
+    run.add_argument("--trace", required=True, help="ui/app.py --trace 录制的跟踪文件")
+    run.add_argument("--snapshot", help="数据库快照目录 (默认: 跟踪文件名 + .snapshot)")
+    run.add_argument("--workdir", required=True, help="包含待测版本动态库的工作目录，快照会复制到其中的 db 文件夹")
+    run.add_argument("--force", action="store_true", help="覆盖工作目录中已有的 db 文件夹")
+    run.add_argument("--speed", type=float, default=1.0, help="重放速度倍数，0 表示尽可能快 (默认: 1)")
+    run.add_argument("--concurrency", type=int, default=256, help="同时重放的用户数，用户更多时后面的用户会比录制时延后 (默认: 256)")
+    run.add_argument("--port", type=int, default=5056, help="服务器端口 (默认: 5056)")
+    run.add_argument("--timeout", type=float, default=30.0, help="单个请求的超时秒数 (默认: 30)")
+    run.add_argument("--startup-timeout", type=float, default=30.0, help="等待服务器启动的秒数 (默认: 30)")
+    run.add_argument("--output", help="把结果（包含每个请求的延迟）保存为 JSON 文件，供 diff 使用")
+
+    diff = subparsers.add_parser("diff", help="比较两次运行的延迟分布")
+    diff.add_argument("old", help="旧的运行：重放结果 JSON 或跟踪文件")
+    diff.add_argument("new", help="新的运行：重放结果 JSON 或跟踪文件")
+    diff.add_argument("--max-ratio", type=float, help="p50 或 p99 超过旧值的多少倍时以状态 1 退出")
+    diff.add_argument("--min-samples", type=int, default=20, help="参与判断的路由至少需要的样本数 (默认: 20)")
+
+    args = parser.parse_args()
+    return command_run(args) if args.command == "run" else command_diff(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,817 @@
+/*
+Copyright © GamerNoTitle 2024. All rights reserved.
+File name: stress_test.c
+Author: 吴沛熹      ID: GamerNoTitle    Version: v1.0   Date: 2026/10/18
+Description:    本文件是 C 核心的并发压力测试程序，有两种负载：
+                混合负载：多个线程同时对同一份合成数据执行混合的查询、交卷、修改（使缓存失效）和写日志操作，
+                检查导出函数在多线程下没有返回错误，用来验证 utils.h 中线程安全说明的各项保证；
+                并发交卷（--writers）：大量写线程在屏障处等齐后同时交卷，可以分散到多个进程中，检查写冲突全部由重试消化。
+                两种负载最后都核对数据库新增的成绩条数与成功交卷的次数，一条都不能丢
+Others:         编译方法见仓库根目录的 bench.sh（./bench.sh --stress），默认使用 -fsanitize=thread 编译，
+                ThreadSanitizer 发现数据竞争时会打印报告并以非0退出码结束。
+                多进程交卷在访问数据库之前 fork，子进程不会继承父进程打开的 SQLite 连接，只支持 POSIX 系统
+History:        暂无
+    1.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 新建了本文件，实现了合成数据的生成、32 个线程的混合负载以及交卷数量的核对
+    2.  Date: 2026/10/18
+        Author: 吴沛熹
+        ID: GamerNoTitle
+        Modification:   [+] 添加了 --writers、--submissions 和 --processes 选项，在一个或多个进程中同时交卷
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#define chdir _chdir
+#define access _access
+#define make_directory(path) _mkdir(path)
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#define make_directory(path) mkdir((path), 0755)
+#endif
+#include "../include/app.h"
+#include "../include/database.h"
+#include "../include/exam_cache.h"
+#include "../include/model.h"
+#include "../include/utils.h"
+#include "../include/uuid.h"
+
+void initialize(); // 定义在 utils/initializer.c 中
+
+/*** 负载部分 ***/
+#define STRESS_DEFAULT_THREADS 32     // 默认的线程数量
+#define STRESS_MAX_THREADS 256        // 最多的线程数量
+#define STRESS_DEFAULT_ITERATIONS 500 // 每个线程默认执行的操作次数，ThreadSanitizer 下每个操作要慢一个数量级
+#define STRESS_MAX_WRITERS 4096       // 并发交卷时最多的写线程数量（所有进程合计）
+#define STRESS_MAX_PROCESSES 64       // 并发交卷时最多的进程数量
+#define STRESS_DEFAULT_SUBMISSIONS 5  // 并发交卷时每个写线程默认的交卷次数
+
+/*** 合成数据部分 ***/
+#define STRESS_DEFAULT_DIR "stress_data" // 默认的工作目录，压力测试会在其中新建 db 和 logs 文件夹
+#define STRESS_TEACHERS 4                // 教师数量
+#define STRESS_STUDENTS 200              // 学生数量
+#define STRESS_EXAMS 8                   // 考试数量
+#define STRESS_QUESTIONS_PER_EXAM 20     // 每场考试的题目数量
+#define STRESS_HASHPASS "0000000000000000000000000000000000000000000000000000000000000000" \
+                        "0000000000000000000000000000000000000000000000000000000000000000" // 合成用户的密码哈希
+#define STRESS_SALT "0000000000000000" // 合成用户的盐
+
+/*** 操作部分 ***/
+#define STRESS_OPERATION_COUNT 13 // 操作的种类数，与 OPERATION_NAMES 的长度一致
+
+/*** 日志等级 ***/
+#define LOGLEVEL_INFO "INFO" // 信息级别日志
+
+/**************************** 合成数据部分开始 ****************************/
+
+/**
+ * @brief 合成数据中各类记录的ID和字段，工作线程从中挑选操作的对象
+ */
+struct StressData
+{
+    char teacher_ids[STRESS_TEACHERS][UUID_LENGTH];
+    char student_ids[STRESS_STUDENTS][UUID_LENGTH];
+    char student_usernames[STRESS_STUDENTS][25];
+    char student_names[STRESS_STUDENTS][46];
+    char student_classes[STRESS_STUDENTS][31];
+    char exam_ids[STRESS_EXAMS][UUID_LENGTH];
+    char question_ids[STRESS_EXAMS * STRESS_QUESTIONS_PER_EXAM][UUID_LENGTH];
+    int question_operands[STRESS_EXAMS * STRESS_QUESTIONS_PER_EXAM][3]; // 每道题目的 num1、op、num2
+};
+
+static struct StressData data; // 合成数据，生成之后只读
+
+/**
+ * @brief 伪随机数（xorshift64*），每个线程使用自己的状态
+ *
+ * @param state 发生器状态，不能为0
+ * @param bound 上界（不含）
+ * @return int [0, bound) 之间的随机数
+ */
+static int stress_random(uint64_t *state, int bound)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (int)((*state * 0x2545F4914F6CDD1DULL >> 33) % (uint64_t)bound);
+}
+
+/**
+ * @brief 生成合成数据的ID和字段，不访问数据库，多进程交卷时在 fork 之前调用，子进程直接继承
+ *
+ * @return int 成功返回0，否则返回1
+ */
+static int prepare_stress_data(void)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+    for (int i = 0; i < STRESS_TEACHERS; i++)
+    {
+        if (generate_uuid(data.teacher_ids[i], UUID_VERSION_4))
+        {
+            return 1;
+        }
+    }
+    for (int i = 0; i < STRESS_STUDENTS; i++)
+    {
+        snprintf(data.student_usernames[i], sizeof(data.student_usernames[i]), "student%d", i);
+        snprintf(data.student_names[i], sizeof(data.student_names[i]), "学生%d", i);
+        snprintf(data.student_classes[i], sizeof(data.student_classes[i]), "班级%d", i % STRESS_TEACHERS);
+        if (generate_uuid(data.student_ids[i], UUID_VERSION_4))
+        {
+            return 1;
+        }
+    }
+    for (int i = 0; i < STRESS_EXAMS; i++)
+    {
+        if (generate_uuid(data.exam_ids[i], UUID_VERSION_4))
+        {
+            return 1;
+        }
+        for (int q = 0; q < STRESS_QUESTIONS_PER_EXAM; q++)
+        {
+            int index = i * STRESS_QUESTIONS_PER_EXAM + q;
+            int *operands = data.question_operands[index];
+            operands[0] = stress_random(&state, 100);
+            operands[1] = stress_random(&state, 4);
+            operands[2] = 1 + stress_random(&state, 99);
+            if (generate_uuid(data.question_ids[index], UUID_VERSION_4))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 通过导出的插入函数写入合成数据，考试的时间覆盖现在，所有考试都开启随机题目顺序
+ *
+ * @return int 成功返回0，否则返回1
+ */
+static int seed_stress_data(void)
+{
+    for (int i = 0; i < STRESS_TEACHERS; i++)
+    {
+        char username[25];
+        char name[46];
+        snprintf(username, sizeof(username), "teacher%d", i);
+        snprintf(name, sizeof(name), "教师%d", i);
+        if (insert_user_data(data.teacher_ids[i], username, STRESS_HASHPASS, STRESS_SALT, 1, name, "", 10000 + i, ""))
+        {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < STRESS_STUDENTS; i++)
+    {
+        if (insert_user_data(data.student_ids[i], data.student_usernames[i], STRESS_HASHPASS, STRESS_SALT, 0, data.student_names[i],
+                             data.student_classes[i], 20000 + i, data.teacher_ids[i % STRESS_TEACHERS]))
+        {
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < STRESS_EXAMS; i++)
+    {
+        char name[91];
+        snprintf(name, sizeof(name), "压力测试考试%d", i);
+        if (insert_exam_data(data.exam_ids[i], name, 0, 2000000000, 0, 1))
+        {
+            return 1;
+        }
+        for (int q = 0; q < STRESS_QUESTIONS_PER_EXAM; q++)
+        {
+            int index = i * STRESS_QUESTIONS_PER_EXAM + q;
+            const int *operands = data.question_operands[index];
+            if (insert_question_data(data.question_ids[index], data.exam_ids[i], operands[0], operands[1], operands[2]))
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 统计数据库中的成绩条数
+ *
+ * @param count_to_return 返回的成绩条数
+ * @return int 成功返回0，否则返回1
+ */
+static int count_scores(int *count_to_return)
+{
+    struct ColumnarResult *result = NULL;
+    if (query_scores_columnar(INT32_MAX, "", "", &result))
+    {
+        return 1;
+    }
+    *count_to_return = result->count;
+    free_columnar_result(result);
+    return 0;
+}
+
+/**************************** 合成数据部分结束 ****************************/
+
+/**************************** 工作线程部分开始 ****************************/
+
+/**
+ * @brief 一个工作线程的参数和统计结果
+ */
+struct StressWorker
+{
+    pthread_t thread;                          // 线程句柄
+    int index;                                 // 线程序号，用来生成随机数种子
+    int iterations;                            // 要执行的操作次数
+    long long calls[STRESS_OPERATION_COUNT];   // 每种操作执行的次数
+    long long errors[STRESS_OPERATION_COUNT];  // 每种操作返回错误的次数
+    long long submitted;                       // 成功交卷的次数
+    long long render_fallbacks;                // render_exam_paper_json 失败后改用 get_exam_paper 的次数
+};
+
+/**
+ * @brief 各种操作的名字，下标与 run_operation 返回的操作序号一致
+ */
+static const char *const OPERATION_NAMES[STRESS_OPERATION_COUNT] = {
+    "query_user_info(id)",
+    "query_user_info(username)",
+    "render_exam_paper_json",
+    "get_exam_paper",
+    "generate_question_list",
+    "generate_question_permutation",
+    "query_scores_info_all",
+    "query_exam_stats",
+    "query_scores_columnar",
+    "edit_user_data",
+    "edit_question_data",
+    "log_message",
+    "insert_score_data",
+};
+
+static pthread_barrier_t start_barrier; // 所有线程创建完成后一起开始，使各线程的操作尽量重叠
+
+/**
+ * @brief 执行一次随机选择的操作
+ *
+ * @param worker 当前线程
+ * @param state 当前线程的随机数发生器状态
+ * @param buffer 渲染考卷用的缓冲区
+ * @param buffer_size 缓冲区大小
+ * @param operation_to_return 返回执行的操作在 OPERATION_NAMES 中的序号
+ * @return int 操作成功返回0，否则返回1
+ */
+static int run_operation(struct StressWorker *worker, uint64_t *state, char *buffer, int buffer_size, int *operation_to_return)
+{
+    int student = stress_random(state, STRESS_STUDENTS);
+    int exam = stress_random(state, STRESS_EXAMS);
+    int choice = stress_random(state, 100);
+
+    if (choice < 15)
+    {
+        *operation_to_return = 0;
+        struct User user;
+        return query_user_info("id", data.student_ids[student], &user);
+    }
+    if (choice < 20)
+    {
+        *operation_to_return = 1;
+        struct User user;
+        return query_user_info("username", data.student_usernames[student], &user);
+    }
+    if (choice < 35)
+    {
+        *operation_to_return = 2;
+        int length = 0;
+        if (render_exam_paper_json(data.exam_ids[exam], (unsigned int)stress_random(state, 1 << 30) + 1, buffer, buffer_size, &length, NULL) == 0)
+        {
+            return 0;
+        }
+        // 渲染期间考卷连续被修改时会返回失败，接口层此时改为用 get_exam_paper 的结果逐个字段编码，这里也一样
+        worker->render_fallbacks++;
+        struct SqlResponseExam paper_exam;
+        int count = 0;
+        return get_exam_paper(data.exam_ids[exam], &paper_exam, NULL, 0, &count, NULL);
+    }
+    if (choice < 42)
+    {
+        *operation_to_return = 3;
+        struct SqlResponseExam paper_exam;
+        struct ExamPaperQuestion questions[STRESS_QUESTIONS_PER_EXAM];
+        int count = 0;
+        return get_exam_paper(data.exam_ids[exam], &paper_exam, questions, STRESS_QUESTIONS_PER_EXAM, &count, NULL);
+    }
+    if (choice < 46)
+    {
+        *operation_to_return = 4;
+        struct Question head;
+        struct Question shuffled;
+        int rc = generate_question_list(data.exam_ids[exam], &head, STRESS_QUESTIONS_PER_EXAM);
+        if (rc == 0)
+        {
+            rc = randomize_question_list(&shuffled, &head);
+            free_question_list(shuffled.next_question); // 头节点由调用者提供，只释放后面的节点
+        }
+        free_question_list(head.next_question);
+        return rc;
+    }
+    if (choice < 50)
+    {
+        *operation_to_return = 5;
+        int permutation[STRESS_QUESTIONS_PER_EXAM];
+        return generate_question_permutation((unsigned int)stress_random(state, 1 << 30) + 1, STRESS_QUESTIONS_PER_EXAM, permutation);
+    }
+    if (choice < 56)
+    {
+        *operation_to_return = 6;
+        struct SqlResponseScore scores[16];
+        return query_scores_info_all(scores, 16, "user_id", data.student_ids[student]);
+    }
+    if (choice < 59)
+    {
+        *operation_to_return = 7;
+        struct ExamStats stats;
+        return query_exam_stats(data.exam_ids[exam], &stats);
+    }
+    if (choice < 61)
+    {
+        *operation_to_return = 8;
+        struct ColumnarResult *result = NULL;
+        int rc = query_scores_columnar(64, "exam_id", data.exam_ids[exam], &result);
+        free_columnar_result(result);
+        return rc;
+    }
+    if (choice < 63)
+    {
+        *operation_to_return = 9;
+        // 写回相同的内容，只为了让用户缓存失效
+        return edit_user_data(data.student_ids[student], data.student_usernames[student], STRESS_HASHPASS, STRESS_SALT, 0,
+                              data.student_names[student], data.student_classes[student], 20000 + student,
+                              data.teacher_ids[student % STRESS_TEACHERS]);
+    }
+    if (choice < 64)
+    {
+        *operation_to_return = 10;
+        // 写回相同的题目，只为了让考卷缓存失效
+        int index = exam * STRESS_QUESTIONS_PER_EXAM + stress_random(state, STRESS_QUESTIONS_PER_EXAM);
+        const int *operands = data.question_operands[index];
+        return edit_question_data(data.question_ids[index], data.exam_ids[exam], operands[0], operands[1], operands[2]);
+    }
+    if (choice < 66)
+    {
+        *operation_to_return = 11;
+        log_message(LOGLEVEL_INFO, "压力测试线程 %d 写入日志", worker->index);
+        return 0;
+    }
+
+    char score_id[UUID_LENGTH];
+    *operation_to_return = 12;
+    if (generate_uuid(score_id, UUID_VERSION_7) ||
+        insert_score_data(score_id, data.exam_ids[exam], data.student_ids[student], stress_random(state, 101), 0))
+    {
+        return 1;
+    }
+    worker->submitted++;
+    return 0;
+}
+
+/**
+ * @brief 工作线程入口
+ *
+ * @param argument 指向 struct StressWorker
+ * @return void* 总是返回 NULL
+ */
+static void *stress_worker(void *argument)
+{
+    struct StressWorker *worker = argument;
+    uint64_t state = 0x9E3779B97F4A7C15ULL * (uint64_t)(worker->index + 1);
+    char *buffer = malloc(64 * 1024);
+    if (buffer == NULL)
+    {
+        worker->errors[0] = worker->iterations;
+        return NULL;
+    }
+
+    pthread_barrier_wait(&start_barrier);
+    for (int i = 0; i < worker->iterations; i++)
+    {
+        int operation = 0;
+        int rc = run_operation(worker, &state, buffer, 64 * 1024, &operation);
+        worker->calls[operation]++;
+        worker->errors[operation] += rc != 0;
+    }
+    free(buffer);
+    return NULL;
+}
+
+/**************************** 工作线程部分结束 ****************************/
+
+/**
+ * @brief 建立数据库并写入合成数据，需要先调用 prepare_stress_data
+ *
+ * @param work_dir 工作目录，只用于提示
+ * @param scores_to_return 返回写入合成数据之后的成绩条数
+ * @return int 成功返回0，否则返回1
+ */
+static int setup_database(const char *work_dir, int *scores_to_return)
+{
+    initialize();
+    if (set_database_location(NULL) || initialize_schema())
+    {
+        fprintf(stderr, "无法建立数据库，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    set_slow_query_log(-1, 0);
+    fprintf(stderr, "正在生成合成数据……\n");
+    if (seed_stress_data() || count_scores(scores_to_return))
+    {
+        fprintf(stderr, "生成合成数据失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 运行混合负载
+ *
+ * @param work_dir 工作目录，只用于提示
+ * @param thread_count 线程数量
+ * @param iterations 每个线程执行的操作次数
+ * @return int 所有操作成功且交卷数量一致时返回0，否则返回1
+ */
+static int run_mixed_test(const char *work_dir, int thread_count, int iterations)
+{
+    int scores_before = 0;
+    if (setup_database(work_dir, &scores_before))
+    {
+        return 1;
+    }
+
+    static struct StressWorker workers[STRESS_MAX_THREADS];
+    pthread_barrier_init(&start_barrier, NULL, (unsigned int)thread_count + 1);
+    for (int i = 0; i < thread_count; i++)
+    {
+        workers[i].index = i;
+        workers[i].iterations = iterations;
+        if (pthread_create(&workers[i].thread, NULL, stress_worker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "创建第 %d 个线程失败\n", i);
+            return 1;
+        }
+    }
+    fprintf(stderr, "%d 个线程各执行 %d 次操作……\n", thread_count, iterations);
+    pthread_barrier_wait(&start_barrier);
+
+    long long calls[STRESS_OPERATION_COUNT] = {0};
+    long long errors[STRESS_OPERATION_COUNT] = {0};
+    long long submitted = 0;
+    long long render_fallbacks = 0;
+    for (int i = 0; i < thread_count; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        for (int k = 0; k < STRESS_OPERATION_COUNT; k++)
+        {
+            calls[k] += workers[i].calls[k];
+            errors[k] += workers[i].errors[k];
+        }
+        submitted += workers[i].submitted;
+        render_fallbacks += workers[i].render_fallbacks;
+    }
+    pthread_barrier_destroy(&start_barrier);
+
+    int scores_after = 0;
+    if (count_scores(&scores_after))
+    {
+        fprintf(stderr, "统计成绩条数失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    long long total_errors = 0;
+    for (int k = 0; k < STRESS_OPERATION_COUNT; k++)
+    {
+        fprintf(stderr, "%-32s %8lld 次  出错 %lld 次\n", OPERATION_NAMES[k], calls[k], errors[k]);
+        total_errors += errors[k];
+    }
+    fprintf(stderr, "render_exam_paper_json 因考卷被修改而改用 get_exam_paper %lld 次\n", render_fallbacks);
+    long long lost = submitted - (scores_after - scores_before);
+    fprintf(stderr, "交卷成功 %lld 次，数据库新增成绩 %d 条，丢失 %lld 条\n", submitted, scores_after - scores_before, lost);
+    if (total_errors != 0 || lost != 0)
+    {
+        fprintf(stderr, "压力测试失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    fprintf(stderr, "压力测试通过\n");
+    return 0;
+}
+
+/**************************** 并发交卷部分开始 ****************************/
+
+/**
+ * @brief 一个写线程的参数和统计结果
+ */
+struct StressWriter
+{
+    pthread_t thread; // 线程句柄
+    int index;        // 写线程在所有进程中的统一序号，决定交卷的学生和考试
+    int submissions;  // 要交卷的次数
+    int succeeded;    // 成功交卷的次数
+};
+
+static pthread_barrier_t writer_barrier; // 本进程的写线程全部创建完成后一起开始交卷
+
+/**
+ * @brief 写线程入口
+ *
+ * @param argument 指向 struct StressWriter
+ * @return void* 总是返回 NULL
+ */
+static void *stress_writer(void *argument)
+{
+    struct StressWriter *writer = argument;
+    const char *exam_id = data.exam_ids[writer->index % STRESS_EXAMS];
+    const char *user_id = data.student_ids[writer->index % STRESS_STUDENTS];
+
+    pthread_barrier_wait(&writer_barrier);
+    for (int i = 0; i < writer->submissions; i++)
+    {
+        char score_id[UUID_LENGTH];
+        if (generate_uuid(score_id, UUID_VERSION_7) == 0 &&
+            insert_score_data(score_id, exam_id, user_id, (writer->index + i) % 101, 0) == 0)
+        {
+            writer->succeeded++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在当前进程中启动一组写线程，等齐之后同时交卷，结束后打印本进程的结果和写冲突重试的统计
+ *
+ * @param process 进程序号，只用于提示
+ * @param first_index 第一个写线程的统一序号
+ * @param count 写线程数量
+ * @param submissions 每个写线程交卷的次数
+ * @return long long 成功交卷的次数，创建线程失败时返回-1
+ */
+static long long run_writers(int process, int first_index, int count, int submissions)
+{
+    struct StressWriter *writers = calloc((size_t)count, sizeof(struct StressWriter));
+    if (writers == NULL)
+    {
+        fprintf(stderr, "进程 %d：为写线程分配内存失败\n", process);
+        return -1;
+    }
+    // 屏障的计数包含本线程，线程没有全部创建成功时直接退出，不会有线程永远等在屏障上
+    pthread_barrier_init(&writer_barrier, NULL, (unsigned int)count + 1);
+    for (int i = 0; i < count; i++)
+    {
+        writers[i].index = first_index + i;
+        writers[i].submissions = submissions;
+        if (pthread_create(&writers[i].thread, NULL, stress_writer, &writers[i]) != 0)
+        {
+            fprintf(stderr, "进程 %d：创建第 %d 个写线程失败\n", process, i);
+            exit(1);
+        }
+    }
+    pthread_barrier_wait(&writer_barrier);
+
+    long long succeeded = 0;
+    for (int i = 0; i < count; i++)
+    {
+        pthread_join(writers[i].thread, NULL);
+        succeeded += writers[i].succeeded;
+    }
+    pthread_barrier_destroy(&writer_barrier);
+    free(writers);
+
+    struct DatabaseRetryStats retry;
+    memset(&retry, 0, sizeof(retry));
+    get_database_retry_stats(&retry);
+    fprintf(stderr, "进程 %d：%d 个写线程成功交卷 %lld / %lld 次；写冲突 %llu 次，重试 %llu 次（BUSY %llu，LOCKED %llu），重试用完 %llu 次\n",
+            process, count, succeeded, (long long)count * submissions, retry.conflicts, retry.retries, retry.busy, retry.locked,
+            retry.exhausted);
+    return succeeded;
+}
+
+/**
+ * @brief 运行并发交卷：writers 个写线程平均分到 processes 个进程中，每个写线程交卷 submissions 次
+ *
+ * @details 子进程在父进程访问数据库之前 fork，阻塞在管道上，父进程写完合成数据之后向管道写入放行的字节，
+ *          各进程几乎同时开始；父进程建库失败时直接关闭管道，子进程读到文件结尾后退出。
+ *          父进程自己也承担一份写线程，最后等待所有子进程结束，再核对成绩条数
+ *
+ * @param work_dir 工作目录，只用于提示
+ * @param writers 写线程总数
+ * @param submissions 每个写线程交卷的次数
+ * @param processes 进程数量
+ * @return int 所有交卷都成功且没有丢失时返回0，否则返回1
+ */
+static int run_writer_test(const char *work_dir, int writers, int submissions, int processes)
+{
+    int failed_processes = 0;
+#ifdef _WIN32
+    if (processes > 1)
+    {
+        fprintf(stderr, "多进程交卷只支持 POSIX 系统，Windows 下请使用 --processes 1\n");
+        return 1;
+    }
+#else
+    int release_pipe[2];
+    pid_t children[STRESS_MAX_PROCESSES];
+    if (processes > 1 && pipe(release_pipe) != 0)
+    {
+        fprintf(stderr, "创建管道失败：%s\n", strerror(errno));
+        return 1;
+    }
+    for (int p = 1; p < processes; p++)
+    {
+        int first_index = p * (writers / processes) + (p < writers % processes ? p : writers % processes);
+        int count = writers / processes + (p < writers % processes);
+        children[p] = fork();
+        if (children[p] < 0)
+        {
+            fprintf(stderr, "创建第 %d 个子进程失败：%s\n", p, strerror(errno));
+            return 1;
+        }
+        if (children[p] == 0)
+        {
+            char go;
+            close(release_pipe[1]);
+            if (read(release_pipe[0], &go, 1) != 1 || set_database_location(NULL))
+            {
+                _exit(1);
+            }
+            _exit(run_writers(p, first_index, count, submissions) == (long long)count * submissions ? 0 : 1);
+        }
+    }
+    if (processes > 1)
+    {
+        close(release_pipe[0]);
+    }
+#endif
+
+    int scores_before = 0;
+    int setup_failed = setup_database(work_dir, &scores_before);
+#ifndef _WIN32
+    if (processes > 1)
+    {
+        char go[STRESS_MAX_PROCESSES] = {0};
+        if (!setup_failed && write(release_pipe[1], go, (size_t)(processes - 1)) != processes - 1)
+        {
+            fprintf(stderr, "放行子进程失败：%s\n", strerror(errno));
+            setup_failed = 1;
+        }
+        close(release_pipe[1]);
+    }
+#endif
+    if (setup_failed)
+    {
+        return 1;
+    }
+
+    fprintf(stderr, "%d 个进程中的 %d 个写线程同时交卷，每个写线程 %d 次……\n", processes, writers, submissions);
+    int own_count = writers / processes + (0 < writers % processes);
+    if (run_writers(0, 0, own_count, submissions) != (long long)own_count * submissions)
+    {
+        failed_processes++;
+    }
+#ifndef _WIN32
+    for (int p = 1; p < processes; p++)
+    {
+        int status = 0;
+        if (waitpid(children[p], &status, 0) != children[p] || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            failed_processes++;
+        }
+    }
+#endif
+
+    int scores_after = 0;
+    if (count_scores(&scores_after))
+    {
+        fprintf(stderr, "统计成绩条数失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    long long expected = (long long)writers * submissions;
+    long long lost = expected - (scores_after - scores_before);
+    fprintf(stderr, "应交卷 %lld 次，数据库新增成绩 %d 条，丢失 %lld 条，有交卷失败的进程 %d 个\n", expected,
+            scores_after - scores_before, lost, failed_processes);
+    if (failed_processes != 0 || lost != 0)
+    {
+        fprintf(stderr, "并发交卷测试失败，详见 %s/logs/latest.log\n", work_dir);
+        return 1;
+    }
+    fprintf(stderr, "并发交卷测试通过\n");
+    return 0;
+}
+
+/**************************** 并发交卷部分结束 ****************************/
+
+/**
+ * @brief 打印用法
+ *
+ * @param program 程序名
+ */
+static void print_usage(const char *program)
+{
+    fprintf(stderr,
+            "用法: %s [--dir DIR] [--threads N] [--iterations N]\n"
+            "      %s [--dir DIR] --writers N [--submissions N] [--processes N]\n"
+            "  --dir DIR          工作目录，必须不存在或者不包含 db 文件夹，默认为 %s\n"
+            "  --threads N        混合负载的线程数量，最多 %d，默认为 %d\n"
+            "  --iterations N     混合负载每个线程执行的操作次数，默认为 %d\n"
+            "  --writers N        改为并发交卷，写线程总数，最多 %d\n"
+            "  --submissions N    并发交卷时每个写线程的交卷次数，默认为 %d\n"
+            "  --processes N      并发交卷时把写线程平均分到 N 个进程中，最多 %d，默认为 1（只支持 POSIX 系统）\n",
+            program, program, STRESS_DEFAULT_DIR, STRESS_MAX_THREADS, STRESS_DEFAULT_THREADS, STRESS_DEFAULT_ITERATIONS,
+            STRESS_MAX_WRITERS, STRESS_DEFAULT_SUBMISSIONS, STRESS_MAX_PROCESSES);
+}
+
+/**
+ * @brief 压力测试入口
+ *
+ * @return int 测试通过返回0，否则返回1
+ */
+int main(int argc, char **argv)
+{
+    const char *work_dir = STRESS_DEFAULT_DIR;
+    int thread_count = STRESS_DEFAULT_THREADS;
+    int iterations = STRESS_DEFAULT_ITERATIONS;
+    int writers = 0;
+    int submissions = STRESS_DEFAULT_SUBMISSIONS;
+    int processes = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+        {
+            work_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            thread_count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--writers") == 0 && i + 1 < argc)
+        {
+            writers = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--submissions") == 0 && i + 1 < argc)
+        {
+            submissions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc)
+        {
+            processes = atoi(argv[++i]);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (thread_count < 1 || thread_count > STRESS_MAX_THREADS || iterations < 1 || writers < 0 || writers > STRESS_MAX_WRITERS ||
+        submissions < 1 || processes < 1 || processes > STRESS_MAX_PROCESSES || (writers > 0 && processes > writers))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (access(work_dir, 0) != 0 && make_directory(work_dir) != 0)
+    {
+        fprintf(stderr, "无法创建工作目录 '%s'：%s\n", work_dir, strerror(errno));
+        return 1;
+    }
+    if (chdir(work_dir) != 0)
+    {
+        fprintf(stderr, "无法进入工作目录 '%s'：%s\n", work_dir, strerror(errno));
+        return 1;
+    }
+    if (access("db", 0) == 0)
+    {
+        fprintf(stderr, "工作目录 '%s' 中已经存在 db 文件夹，请先删除，以免合成数据与已有数据混在一起\n", work_dir);
+        return 1;
+    }
+    if (prepare_stress_data())
+    {
+        fprintf(stderr, "生成合成数据的ID失败\n");
+        return 1;
+    }
+
+    if (writers > 0)
+    {
+        return run_writer_test(work_dir, writers, submissions, processes);
+    }
+    return run_mixed_test(work_dir, thread_count, iterations);
+}